@@ -9,9 +9,11 @@
 #ifndef OPENMVG_CAMERAS_CAMERA_INTRINSICS_HPP
 #define OPENMVG_CAMERAS_CAMERA_INTRINSICS_HPP
 
+#include <memory>
 #include <vector>
 
 #include "openMVG/cameras/Camera_Common.hpp"
+#include "openMVG/cameras/Camera_Undistortion_Map.hpp"
 #include "openMVG/geometry/pose3.hpp"
 #include "openMVG/numeric/numeric.h"
 #include "openMVG/stl/hash.hpp"
@@ -199,6 +201,74 @@ struct IntrinsicBase : public Clonable<IntrinsicBase>
   */
   virtual Vec2 get_d_pixel( const Vec2& p ) const = 0;
 
+  /**
+  * @brief Return the un-distorted pixels of a set of distorted pixels
+  * @param points Input distorted pixels (one per column)
+  * @return Points without distortion
+  */
+  Mat2X get_ud_pixels( const Mat2X& points ) const
+  {
+    Mat2X ud_points( 2, points.cols() );
+    for ( Mat2X::Index i = 0; i < points.cols(); ++i )
+    {
+      ud_points.col( i ) = this->get_ud_pixel( points.col( i ) );
+    }
+    return ud_points;
+  }
+
+  /**
+  * @brief Return the distorted pixels of a set of pixels
+  * @param points Input pixels (one per column)
+  * @return Distorted pixels
+  */
+  Mat2X get_d_pixels( const Mat2X& points ) const
+  {
+    Mat2X d_points( 2, points.cols() );
+    for ( Mat2X::Index i = 0; i < points.cols(); ++i )
+    {
+      d_points.col( i ) = this->get_d_pixel( points.col( i ) );
+    }
+    return d_points;
+  }
+
+  /**
+  * @brief Precompute a dense undistortion lookup table over the image domain.
+  * Once built, get_ud_pixel uses a bilinear interpolation of the table refined
+  * by a Newton step instead of the iterative remove_disto solver.
+  * The table is dropped by updateFromParams since the distortion may change.
+  * @param grid_step Spacing (in pixel) between two consecutive grid nodes
+  * @retval true if the table has been built
+  * @retval false if the camera has no distortion or an empty image domain
+  */
+  bool build_undistortion_map( unsigned int grid_step = 8 )
+  {
+    undistortion_map_.reset();
+    if ( !this->have_disto() || w_ == 0 || h_ == 0 )
+    {
+      return false;
+    }
+    undistortion_map_ = std::make_shared<const Undistortion_Map>(
+      w_, h_, grid_step,
+      [this]( const Vec2 & p ) { return this->cam2ima( this->remove_disto( this->ima2cam( p ) ) ); } );
+    return true;
+  }
+
+  /**
+  * @brief Release the undistortion lookup table (if any)
+  */
+  void clear_undistortion_map()
+  {
+    undistortion_map_.reset();
+  }
+
+  /**
+  * @brief Tell if an undistortion lookup table is available
+  */
+  bool have_undistortion_map() const
+  {
+    return static_cast<bool>( undistortion_map_ );
+  }
+
   /**
   * @brief Normalize a given unit pixel error to the camera plane
   * @param value Error in image plane
@@ -243,6 +313,35 @@ struct IntrinsicBase : public Clonable<IntrinsicBase>
       stl::hash_combine( seed , param );
     return seed;
   }
+
+protected:
+
+  /**
+  * @brief Compute the un-distorted pixel thanks to the undistortion lookup table
+  * @param p Input distorted pixel
+  * @param[out] ud_p Point without distortion
+  * @retval true if the lookup table covers p
+  * @retval false if there is no table or p is outside of it (use remove_disto)
+  */
+  bool get_ud_pixel_from_map( const Vec2& p, Vec2 & ud_p ) const
+  {
+    if ( !undistortion_map_ || !undistortion_map_->interpolate( p, ud_p ) )
+    {
+      return false;
+    }
+    // Newton polish step on get_d_pixel(ud_p) = p
+    // (the Jacobian of the distortion is computed by forward differences)
+    static const double h = 1e-4;
+    const Vec2 d_p = this->get_d_pixel( ud_p );
+    Eigen::Matrix2d jacobian;
+    jacobian.col( 0 ) = ( this->get_d_pixel( ud_p + Vec2( h, 0. ) ) - d_p ) / h;
+    jacobian.col( 1 ) = ( this->get_d_pixel( ud_p + Vec2( 0., h ) ) - d_p ) / h;
+    ud_p -= jacobian.inverse() * ( d_p - p );
+    return true;
+  }
+
+  /// Optional undistortion lookup table (shared between the clones)
+  std::shared_ptr<const Undistortion_Map> undistortion_map_;
 };
 
 
@@ -178,6 +178,11 @@ class Pinhole_Intrinsic_Brown_T2 : public Pinhole_Intrinsic
     */
     Vec2 get_ud_pixel( const Vec2& p ) const override
     {
+      Vec2 ud_p;
+      if ( get_ud_pixel_from_map( p, ud_p ) )
+      {
+        return ud_p;
+      }
       return cam2ima( remove_disto( ima2cam( p ) ) );
     }
 
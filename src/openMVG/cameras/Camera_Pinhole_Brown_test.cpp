@@ -20,6 +20,7 @@ TEST(Cameras_Brown, disto_undisto_T2) {
     -0.054, 0.014, 0.006, 0.001, -0.001);
 
   Test_camera(cam);
+  Test_camera_undistortion_map(cam);
 }
 
 /* ************************************************************************* */
@@ -19,6 +19,7 @@ TEST(Cameras_Fisheye, disto_undisto_Fisheye) {
                                       -0.054, 0.014, 0.006, 0.011); // K1, K2, K3, K4
 
   Test_camera(cam);
+  Test_camera_undistortion_map(cam);
 }
 
 /* ************************************************************************* */
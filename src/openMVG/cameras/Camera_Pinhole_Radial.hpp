@@ -225,6 +225,11 @@ class Pinhole_Intrinsic_Radial_K1 : public Pinhole_Intrinsic
     */
     Vec2 get_ud_pixel( const Vec2& p ) const override
     {
+      Vec2 ud_p;
+      if ( get_ud_pixel_from_map( p, ud_p ) )
+      {
+        return ud_p;
+      }
       return cam2ima( remove_disto( ima2cam( p ) ) );
     }
 
@@ -434,6 +439,11 @@ class Pinhole_Intrinsic_Radial_K3 : public Pinhole_Intrinsic
     */
     Vec2 get_ud_pixel( const Vec2& p ) const override
     {
+      Vec2 ud_p;
+      if ( get_ud_pixel_from_map( p, ud_p ) )
+      {
+        return ud_p;
+      }
       return cam2ima( remove_disto( ima2cam( p ) ) );
     }
 
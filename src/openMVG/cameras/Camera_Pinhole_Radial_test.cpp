@@ -20,6 +20,7 @@ TEST(Cameras_Radial, disto_undisto_K1) {
     0.1);
 
   Test_camera(cam);
+  Test_camera_undistortion_map(cam);
 }
 
 TEST(Cameras_Radial, disto_undisto_K3) {
@@ -29,6 +30,7 @@ TEST(Cameras_Radial, disto_undisto_K3) {
     -0.245539, 0.255195, 0.163773);
 
   Test_camera(cam);
+  Test_camera_undistortion_map(cam);
 }
 
 /* ************************************************************************* */
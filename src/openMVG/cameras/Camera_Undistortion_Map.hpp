@@ -0,0 +1,129 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_CAMERAS_CAMERA_UNDISTORTION_MAP_HPP
+#define OPENMVG_CAMERAS_CAMERA_UNDISTORTION_MAP_HPP
+
+#include <algorithm>
+#include <cmath>
+
+#include "openMVG/numeric/eigen_alias_definition.hpp"
+
+namespace openMVG
+{
+namespace cameras
+{
+
+/**
+* @brief Dense lookup table that stores the undistorted position of the nodes
+* of a regular grid laid over the distorted image domain.
+*
+* The undistorted position of any pixel inside the image domain is then
+* obtained by bilinear interpolation of the four surrounding nodes, and can be
+* refined by a Newton step (see IntrinsicBase::get_ud_pixel_from_map).
+*/
+class Undistortion_Map
+{
+  public:
+
+    /**
+    * @brief Constructor
+    * @param w Width of the image domain
+    * @param h Height of the image domain
+    * @param grid_step Spacing (in pixel) between two consecutive grid nodes
+    * @param undistort Functor returning the undistorted pixel of a distorted pixel
+    */
+    template <typename UndistortFunctor>
+    Undistortion_Map
+    (
+      unsigned int w,
+      unsigned int h,
+      unsigned int grid_step,
+      const UndistortFunctor & undistort
+    )
+    : step_( grid_step > 0 ? grid_step : 1 ),
+      cols_( static_cast<int>( std::ceil( w / step_ ) ) + 1 ),
+      rows_( static_cast<int>( std::ceil( h / step_ ) ) + 1 ),
+      w_( w ),
+      h_( h ),
+      nodes_( 2, cols_ * rows_ )
+    {
+      for ( int y = 0; y < rows_; ++y )
+      {
+        for ( int x = 0; x < cols_; ++x )
+        {
+          nodes_.col( y * cols_ + x ) = undistort( Vec2( x * step_, y * step_ ) );
+        }
+      }
+    }
+
+    /**
+    * @brief Interpolate the undistorted position of a distorted pixel
+    * @param p Distorted pixel
+    * @param[out] ud Interpolated undistorted pixel
+    * @retval true if p lies inside the grid and the surrounding nodes are valid
+    * @retval false if p lies outside the grid (the caller must use the exact solver)
+    */
+    bool interpolate
+    (
+      const Vec2 & p,
+      Vec2 & ud
+    ) const
+    {
+      if ( !( p( 0 ) >= 0. && p( 1 ) >= 0. && p( 0 ) <= w_ && p( 1 ) <= h_ ) )
+      {
+        return false;
+      }
+
+      const double gx = p( 0 ) / step_, gy = p( 1 ) / step_;
+      const int x0 = std::min( static_cast<int>( gx ), cols_ - 2 );
+      const int y0 = std::min( static_cast<int>( gy ), rows_ - 2 );
+      const double dx = gx - x0, dy = gy - y0;
+
+      const int idx = y0 * cols_ + x0;
+      const Vec2
+        n00 = nodes_.col( idx ),
+        n10 = nodes_.col( idx + 1 ),
+        n01 = nodes_.col( idx + cols_ ),
+        n11 = nodes_.col( idx + cols_ + 1 );
+
+      // Some models (i.e fisheye) can be undefined far from the image center
+      if ( !( n00.allFinite() && n10.allFinite() && n01.allFinite() && n11.allFinite() ) )
+      {
+        return false;
+      }
+
+      const Vec2 top = n00 + dx * ( n10 - n00 );
+      const Vec2 bottom = n01 + dx * ( n11 - n01 );
+      ud = top + dy * ( bottom - top );
+      return true;
+    }
+
+    /**
+    * @brief Spacing (in pixel) between two consecutive grid nodes
+    */
+    double grid_step() const
+    {
+      return step_;
+    }
+
+  private:
+    /// Spacing between two consecutive nodes
+    double step_;
+    /// Number of node along the x and the y axis
+    int cols_, rows_;
+    /// Image domain covered by the grid
+    double w_, h_;
+    /// Undistorted pixel position of the grid nodes (row major node ordering)
+    Mat2X nodes_;
+};
+
+} // namespace cameras
+} // namespace openMVG
+
+#endif // #ifndef OPENMVG_CAMERAS_CAMERA_UNDISTORTION_MAP_HPP
@@ -55,3 +55,37 @@
     EXPECT_FALSE(CheiralityTest(cam(ptImage), geometry::Pose3{}, -cam(ptImage)));\
   } \
 }
+
+// Macro used to check the undistortion lookup table of an OpenMVG Camera
+//
+// - Build the lookup table of a copy of the camera
+// - Check that the interpolated undistortion matches the exact one
+//   and that it is a precise inverse of the distortion function
+// - Check that updating the parameters invalidates the lookup table
+#define Test_camera_undistortion_map(cam) \
+{ \
+  auto cam_map = cam; \
+  EXPECT_EQ(cam.have_disto(), cam_map.build_undistortion_map(8)); \
+  EXPECT_EQ(cam.have_disto(), cam_map.have_undistortion_map()); \
+ \
+  std::default_random_engine gen; \
+  std::uniform_real_distribution<> \
+    rand_x(0, cam.w()), \
+    rand_y(0, cam.h()); \
+ \
+  static const int nb_sampled_pts = 1000; \
+  Mat2X pts(2, nb_sampled_pts); \
+  for (int i = 0; i < nb_sampled_pts; ++i) \
+  { \
+    pts.col(i) << rand_x(gen), rand_y(gen); \
+  } \
+  const Mat2X ud_pts = cam_map.get_ud_pixels(pts); \
+  for (int i = 0; i < nb_sampled_pts; ++i) \
+  { \
+    EXPECT_MATRIX_NEAR( cam.get_ud_pixel(pts.col(i)), ud_pts.col(i), 1e-4); \
+    EXPECT_MATRIX_NEAR( pts.col(i), cam.get_d_pixel(ud_pts.col(i)), 1e-6); \
+  } \
+ \
+  EXPECT_TRUE(cam_map.updateFromParams(cam.getParams())); \
+  EXPECT_FALSE(cam_map.have_undistortion_map()); \
+}
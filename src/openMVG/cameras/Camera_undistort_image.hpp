@@ -9,8 +9,16 @@
 #ifndef OPENMVG_CAMERAS_CAMERA_UNDISTORT_IMAGE_HPP
 #define OPENMVG_CAMERAS_CAMERA_UNDISTORT_IMAGE_HPP
 
-#include <limits>
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#ifdef OPENMVG_USE_OPENMP
+#include <omp.h>
+#endif
 
 #include "openMVG/cameras/Camera_Intrinsics.hpp"
 #include "openMVG/image/image_container.hpp"
@@ -44,7 +52,7 @@ void UndistortImage(
     image_ud.resize( imageIn.Width(), imageIn.Height(), true, fillcolor );
     const image::Sampler2d<image::SamplerLinear> sampler;
 #ifdef OPENMVG_USE_OPENMP
-    #pragma omp parallel for
+    #pragma omp parallel for if (!omp_in_parallel())
 #endif
     for ( int j = 0; j < imageIn.Height(); ++j )
       for ( int i = 0; i < imageIn.Width(); ++i )
@@ -61,6 +69,287 @@ void UndistortImage(
   }
 }
 
+/**
+* @brief Precomputed undistortion remapping of an image domain.
+*
+* For each pixel of the undistorted image the position of the distorted pixel
+* to sample is stored as a fixed-point offset (1/32 pixel precision) relative
+* to the pixel itself. If an offset does not fit in the int16 range (i.e. a
+* displacement larger than ~1023 pixels: strong distortion of a large image),
+* the absolute float positions are stored instead.
+* The map is computed once per intrinsic and can then be applied to every image
+* sharing this intrinsic without calling the virtual distortion functions again.
+*
+* The map computation and its application are multithreaded, unless they are
+* called from a parallel region (only one level of parallelism is used).
+*/
+class Undistortion_Remap
+{
+  public:
+
+    /// Number of fractional bits of the fixed-point offsets
+    static const int kFractionalBits = 5;
+    /// Fixed-point scale of the offsets
+    static const int kScale = 1 << kFractionalBits;
+
+    /**
+    * @brief Constructor
+    * @param cam Intrinsic parameter used to undistort the images
+    */
+    explicit Undistortion_Remap( const IntrinsicBase * cam )
+    : width_( cam->w() ),
+      height_( cam->h() )
+    {
+      // Distorted position of each pixel (NaN if it is out of the image domain)
+      std::vector<float> positions(
+        2 * static_cast<size_t>( width_ ) * height_, std::numeric_limits<float>::quiet_NaN() );
+      // Rows whose offsets fit in the fixed-point range
+      std::vector<char> row_fits( height_, 1 );
+#ifdef OPENMVG_USE_OPENMP
+      #pragma omp parallel for schedule(dynamic) if (!omp_in_parallel())
+#endif
+      for ( int j = 0; j < height_; ++j )
+      {
+        float * row_positions = &positions[ 2 * static_cast<size_t>( j ) * width_ ];
+        for ( int i = 0; i < width_; ++i )
+        {
+          // compute coordinates with distortion
+          const Vec2 disto_pix = cam->get_d_pixel( Vec2( i, j ) );
+          // keep pixel if it is in the image domain
+          if ( !disto_pix.allFinite() ||
+               disto_pix( 0 ) <= -1. || disto_pix( 0 ) >= width_ ||
+               disto_pix( 1 ) <= -1. || disto_pix( 1 ) >= height_ )
+          {
+            continue;
+          }
+          row_positions[ 2 * i ] = static_cast<float>( disto_pix( 0 ) );
+          row_positions[ 2 * i + 1 ] = static_cast<float>( disto_pix( 1 ) );
+          if ( std::abs( std::round( ( disto_pix( 0 ) - i ) * kScale ) ) >= kMaxOffset ||
+               std::abs( std::round( ( disto_pix( 1 ) - j ) * kScale ) ) >= kMaxOffset )
+          {
+            row_fits[ j ] = 0;
+          }
+        }
+      }
+
+      if ( std::find( row_fits.cbegin(), row_fits.cend(), 0 ) != row_fits.cend() )
+      {
+        // Some offsets are out of the int16 range: keep the float positions
+        positions_ = std::move( positions );
+        return;
+      }
+
+      offsets_.assign( positions.size(), int16_t( kInvalidOffset ) );
+#ifdef OPENMVG_USE_OPENMP
+      #pragma omp parallel for schedule(dynamic) if (!omp_in_parallel())
+#endif
+      for ( int j = 0; j < height_; ++j )
+      {
+        const size_t row = 2 * static_cast<size_t>( j ) * width_;
+        for ( int i = 0; i < width_; ++i )
+        {
+          const float x = positions[ row + 2 * i ], y = positions[ row + 2 * i + 1 ];
+          if ( std::isnan( x ) )
+          {
+            continue;
+          }
+          offsets_[ row + 2 * i ] = static_cast<int16_t>( std::round( ( x - i ) * kScale ) );
+          offsets_[ row + 2 * i + 1 ] = static_cast<int16_t>( std::round( ( y - j ) * kScale ) );
+        }
+      }
+    }
+
+    /**
+    * @brief Width of the remapped image domain
+    */
+    int Width() const
+    {
+      return width_;
+    }
+
+    /**
+    * @brief Height of the remapped image domain
+    */
+    int Height() const
+    {
+      return height_;
+    }
+
+    /**
+    * @brief Return true if the positions are stored as fixed-point offsets,
+    *  false if they are stored as float positions (large displacements)
+    */
+    bool IsFixedPoint() const
+    {
+      return positions_.empty();
+    }
+
+    /**
+    * @brief Apply the remapping to an image (bilinear sampling)
+    * @param imageIn Input image (must have the size of the remapped domain)
+    * @param[out] image_ud Output undistorted image
+    * @param fillcolor color used to fill pixels where no input pixel is found
+    * @retval true if the image has been remapped
+    * @retval false if the image size does not match the remapped domain
+    */
+    template <typename Image>
+    bool operator()
+    (
+      const Image & imageIn,
+      Image & image_ud,
+      typename Image::Tpixel fillcolor = typename Image::Tpixel( 0 )
+    ) const
+    {
+      if ( imageIn.Width() != width_ || imageIn.Height() != height_ )
+      {
+        return false;
+      }
+
+      image_ud.resize( width_, height_, true, fillcolor );
+      if ( IsFixedPoint() )
+      {
+        Remap( imageIn, image_ud,
+          [this]( const size_t index, const int i, const int j, double & x, double & y )
+          {
+            if ( offsets_[ index ] == kInvalidOffset )
+            {
+              return false;
+            }
+            // the fixed-point offsets are exact in double precision
+            x = i + static_cast<double>( offsets_[ index ] ) / kScale;
+            y = j + static_cast<double>( offsets_[ index + 1 ] ) / kScale;
+            return true;
+          } );
+      }
+      else
+      {
+        Remap( imageIn, image_ud,
+          [this]( const size_t index, const int, const int, double & x, double & y )
+          {
+            if ( std::isnan( positions_[ index ] ) )
+            {
+              return false;
+            }
+            x = positions_[ index ];
+            y = positions_[ index + 1 ];
+            return true;
+          } );
+      }
+      return true;
+    }
+
+  private:
+
+    /**
+    * @brief Bilinear sampling of the input image at the remapped positions
+    * @param position bool(index, i, j, x, y) distorted position of the (i, j)
+    *  pixel (index is the position of the pixel in the maps)
+    */
+    template <typename Image, typename PositionFunctor>
+    void Remap
+    (
+      const Image & imageIn,
+      Image & image_ud,
+      const PositionFunctor & position
+    ) const
+    {
+      using Tpixel = typename Image::Tpixel;
+      using RealPixelT = image::RealPixel<Tpixel>;
+      using real_type = typename RealPixelT::real_type;
+
+      const image::Sampler2d<image::SamplerLinear> sampler;
+
+      // Process the image by tiles in order to keep the sampled input
+      // pixels in cache
+      const int nb_tile_x = ( width_ + kTileWidth - 1 ) / kTileWidth;
+      const int nb_tile_y = ( height_ + kTileHeight - 1 ) / kTileHeight;
+#ifdef OPENMVG_USE_OPENMP
+      #pragma omp parallel for schedule(dynamic) if (!omp_in_parallel())
+#endif
+      for ( int tile = 0; tile < nb_tile_x * nb_tile_y; ++tile )
+      {
+        const int
+          x_begin = ( tile % nb_tile_x ) * kTileWidth,
+          y_begin = ( tile / nb_tile_x ) * kTileHeight,
+          x_end = std::min( x_begin + kTileWidth, width_ ),
+          y_end = std::min( y_begin + kTileHeight, height_ );
+
+        for ( int j = y_begin; j < y_end; ++j )
+        {
+          const size_t row = 2 * static_cast<size_t>( j ) * width_;
+          for ( int i = x_begin; i < x_end; ++i )
+          {
+            // position of the distorted pixel
+            double x, y;
+            if ( !position( row + 2 * i, i, j, x, y ) )
+            {
+              continue;
+            }
+            const int
+              x0 = static_cast<int>( std::floor( x ) ),
+              y0 = static_cast<int>( std::floor( y ) );
+
+            if ( x0 < 0 || y0 < 0 || x0 + 1 >= width_ || y0 + 1 >= height_ )
+            {
+              // border pixel, use the generic sampler (handle partial support)
+              image_ud( j, i ) = sampler( imageIn,
+                static_cast<float>( y ), static_cast<float>( x ) );
+              continue;
+            }
+
+            const double
+              wx = x - x0,
+              wy = y - y0;
+
+            const real_type top(
+              RealPixelT::convert_to_real( imageIn( y0, x0 ) ) * ( 1. - wx ) +
+              RealPixelT::convert_to_real( imageIn( y0, x0 + 1 ) ) * wx );
+            const real_type bottom(
+              RealPixelT::convert_to_real( imageIn( y0 + 1, x0 ) ) * ( 1. - wx ) +
+              RealPixelT::convert_to_real( imageIn( y0 + 1, x0 + 1 ) ) * wx );
+            const real_type res( top * ( 1. - wy ) + bottom * wy );
+            image_ud( j, i ) = RealPixelT::convert_from_real( res );
+          }
+        }
+      }
+    }
+
+    /// Offset value used for pixels that have no distorted counterpart
+    static const int16_t kInvalidOffset = std::numeric_limits<int16_t>::lowest();
+    /// Maximal absolute offset (in fixed-point) that can be stored
+    static const int kMaxOffset = std::numeric_limits<int16_t>::max();
+    /// Tile size used to apply the remapping
+    static const int kTileWidth = 128;
+    static const int kTileHeight = 32;
+
+    /// Size of the remapped image domain
+    int width_, height_;
+    /// Interleaved (dx, dy) fixed-point offsets, row major
+    std::vector<int16_t> offsets_;
+    /// Interleaved (x, y) float positions, row major (used if the offsets
+    ///  do not fit in the fixed-point range, NaN for the invalid pixels)
+    std::vector<float> positions_;
+};
+
+/**
+* @brief  Undistort an image thanks to a precomputed remapping
+* @param imageIn Input image
+* @param remap Precomputed undistortion remapping (see Undistortion_Remap)
+* @param[out] image_ud Output undistorted image
+* @param fillcolor color used to fill pixels where no input pixel is found
+* @retval true if the image has been undistorted
+* @retval false if the image size does not match the remapping
+*/
+template <typename Image>
+bool UndistortImage(
+  const Image& imageIn,
+  const Undistortion_Remap & remap,
+  Image & image_ud,
+  typename Image::Tpixel fillcolor = typename Image::Tpixel( 0 ) )
+{
+  return remap( imageIn, image_ud, fillcolor );
+}
+
 /**
 * @brief  Undistort an image according a given camera & its distortion model
 * @param imageIn Input image
@@ -122,7 +411,7 @@ void UndistortImageResized(
     const image::Sampler2d<image::SamplerLinear> sampler;
 
 #ifdef OPENMVG_USE_OPENMP
-    #pragma omp parallel for
+    #pragma omp parallel for if (!omp_in_parallel())
 #endif
     for ( int j = 0; j < real_size_y; ++j )
       for ( int i = 0; i < real_size_x; ++i )
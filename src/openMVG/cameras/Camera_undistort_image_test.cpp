@@ -0,0 +1,109 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/cameras/Camera_Pinhole_Brown.hpp"
+#include "openMVG/cameras/Camera_Pinhole_Radial.hpp"
+#include "openMVG/cameras/Camera_undistort_image.hpp"
+#include "openMVG/image/image_container.hpp"
+#include "openMVG/image/pixel_types.hpp"
+
+#include "testing/testing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace openMVG;
+using namespace openMVG::cameras;
+using namespace openMVG::image;
+
+// Build a smooth synthetic image (so bilinear sampling errors stay small)
+template <typename T>
+Image<T> SyntheticImage(int w, int h)
+{
+  Image<T> image(w, h);
+  for (int j = 0; j < h; ++j)
+    for (int i = 0; i < w; ++i)
+      image(j, i) = T(static_cast<unsigned char>(127.5 + 127.5 * std::sin(i / 7.0) * std::cos(j / 11.0)));
+  return image;
+}
+
+// Return the maximal pixel difference between the on the fly undistortion
+// and the precomputed remapping (limited by the fixed-point precision)
+template <typename Image_T>
+double RemapMaxDifference(const IntrinsicBase & cam, const Image_T & image)
+{
+  Image_T image_ud, image_ud_remap;
+  UndistortImage(image, &cam, image_ud);
+
+  const Undistortion_Remap remap(&cam);
+  if (!UndistortImage(image, remap, image_ud_remap) ||
+      image_ud.Width() != image_ud_remap.Width() ||
+      image_ud.Height() != image_ud_remap.Height())
+  {
+    return std::numeric_limits<double>::max();
+  }
+
+  double max_diff = 0.0;
+  for (int j = 0; j < image_ud.Height(); ++j)
+    for (int i = 0; i < image_ud.Width(); ++i)
+    {
+      const double diff =
+        (image_ud(j, i).template cast<double>()
+         - image_ud_remap(j, i).template cast<double>()).cwiseAbs().maxCoeff();
+      max_diff = std::max(max_diff, diff);
+    }
+  return max_diff;
+}
+
+TEST(Cameras_undistort_image, remap_RGB_Radial) {
+
+  const Pinhole_Intrinsic_Radial_K3 cam(320, 240, 300, 160, 120,
+    // K1, K2, K3
+    -0.245539, 0.255195, 0.163773);
+
+  EXPECT_TRUE(RemapMaxDifference(cam, SyntheticImage<RGBColor>(cam.w(), cam.h())) <= 2.0);
+}
+
+TEST(Cameras_undistort_image, remap_large_displacement) {
+
+  // Strong distortion of a wide image: displacements larger than the
+  // fixed-point offsets range (~1023 pixels), the float positions are used
+  const Pinhole_Intrinsic_Radial_K1 cam(2400, 200, 1200, 1200, 100,
+    // K1
+    -0.9);
+
+  const Undistortion_Remap remap(&cam);
+  EXPECT_FALSE(remap.IsFixedPoint());
+  EXPECT_TRUE(RemapMaxDifference(cam, SyntheticImage<RGBColor>(cam.w(), cam.h())) <= 2.0);
+
+  const Pinhole_Intrinsic_Radial_K1 cam_small(320, 240, 300, 160, 120, -0.245539);
+  EXPECT_TRUE(Undistortion_Remap(&cam_small).IsFixedPoint());
+}
+
+TEST(Cameras_undistort_image, remap_RGB_Brown) {
+
+  const Pinhole_Intrinsic_Brown_T2 cam(320, 240, 300, 160, 120,
+    // K1, K2, K3, T1, T2
+    -0.054, 0.014, 0.006, 0.001, -0.001);
+
+  EXPECT_TRUE(RemapMaxDifference(cam, SyntheticImage<RGBColor>(cam.w(), cam.h())) <= 2.0);
+}
+
+TEST(Cameras_undistort_image, remap_size_mismatch) {
+
+  const Pinhole_Intrinsic_Radial_K1 cam(320, 240, 300, 160, 120, 0.1);
+  const Undistortion_Remap remap(&cam);
+
+  Image<RGBColor> image_ud;
+  EXPECT_FALSE(UndistortImage(SyntheticImage<RGBColor>(100, 100), remap, image_ud));
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
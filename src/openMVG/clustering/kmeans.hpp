@@ -10,10 +10,15 @@
 #define _OPENMVG_CLUSTERING_K_MEANS_HPP_
 
 #include "openMVG/clustering/kmeans_trait.hpp"
+#include "openMVG/matching/metric.hpp"
 #include "openMVG/numeric/eigen_alias_definition.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <limits>
+#include <numeric>
 #include <random>
+#include <utility>
 #include <vector>
 
 namespace openMVG
@@ -221,6 +226,591 @@ void KMeans( const std::vector< DataType > & source_data,
   while( changed && id_iteration < max_nb_iteration );
 }
 
+//--
+// KMeans on a contiguous (row major) matrix of points
+//--
+
+/**
+* @brief Row major matrix storing one point (or one center) per row
+* (i.e a set of descriptors)
+*/
+template< typename Scalar >
+using KMeansMatrix = Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+/**
+* @brief Parameters of the KMeans on a matrix of points
+*/
+struct KMeansMatrixParams
+{
+  /// Maximum number of iteration (of full or mini-batch assignment)
+  uint32_t max_nb_iteration = 100;
+  /// Size of the mini-batches (larger point sets are clustered by mini-batch)
+  uint32_t batch_size = 10000;
+  /// Number of points sampled to seed the centers (kmeans++)
+  uint32_t seeding_sample_size = 100000;
+  /// Stop the mini-batch iterations once the centers move less than this value
+  float tolerance = 0.f;
+  /// Random seed
+  uint64_t seed = std::mt19937_64::default_seed;
+};
+
+namespace internal
+{
+
+/// Get a point of the matrix as a float array (converted in buffer if required)
+template< typename T >
+inline const float * PointAsFloat( const KMeansMatrix<T> & data,
+                                   const uint32_t id_pt,
+                                   Eigen::RowVectorXf & buffer )
+{
+  buffer = data.row( id_pt ).template cast<float>();
+  return buffer.data();
+}
+
+inline const float * PointAsFloat( const KMeansMatrix<float> & data,
+                                   const uint32_t id_pt,
+                                   Eigen::RowVectorXf & )
+{
+  return data.row( id_pt ).data();
+}
+
+/// Squared L2 distance (AVX2 for 128 dimensions if enabled)
+inline float SquaredL2( const float * a, const float * b, const size_t size )
+{
+  return matching::L2<float>()( a, b, size );
+}
+
+/**
+* @brief Find the nearest and the second nearest centers of a point
+* @param pt Query point
+* @param centers Centers (one per row)
+* @param[out] nearest_center Id of the nearest center
+* @param[out] nearest_dist Distance to the nearest center
+* @param[out] second_dist Distance to the second nearest center
+*/
+inline void NearestCenters( const float * pt,
+                            const KMeansMatrix<float> & centers,
+                            uint32_t & nearest_center,
+                            float & nearest_dist,
+                            float & second_dist )
+{
+  float best = std::numeric_limits<float>::max();
+  float second = std::numeric_limits<float>::max();
+  nearest_center = 0;
+  for( uint32_t id_center = 0; id_center < centers.rows(); ++id_center )
+  {
+    const float d = SquaredL2( pt, centers.row( id_center ).data(), centers.cols() );
+    if( d < best )
+    {
+      second = best;
+      best = d;
+      nearest_center = id_center;
+    }
+    else if( d < second )
+    {
+      second = d;
+    }
+  }
+  nearest_dist = std::sqrt( best );
+  second_dist = std::sqrt( second );
+}
+
+/**
+* @brief Group the points by center (counting sort)
+* @param assignment Center id of each point
+* @param nb_center Number of centers
+* @param[out] begin Points of the center c are order[begin[c]..begin[c+1]-1]
+* @param[out] order Point indexes sorted by center
+*/
+inline void GroupByCenter( const std::vector<uint32_t> & assignment,
+                           const uint32_t nb_center,
+                           std::vector<uint32_t> & begin,
+                           std::vector<uint32_t> & order )
+{
+  begin.assign( nb_center + 1, 0 );
+  for( const uint32_t id_center : assignment )
+  {
+    ++begin[id_center + 1];
+  }
+  std::partial_sum( begin.begin(), begin.end(), begin.begin() );
+  std::vector<uint32_t> pos( begin.begin(), begin.end() - 1 );
+  order.resize( assignment.size() );
+  for( uint32_t i = 0; i < assignment.size(); ++i )
+  {
+    order[pos[assignment[i]]++] = i;
+  }
+}
+
+/**
+* @brief Kmeans++ seeding (the distance updates are computed in parallel)
+* @param data Input points
+* @param ids Points to sample from
+* @param nb_cluster Number of centers
+* @param rng Random generator
+* @param[out] centers Seeded centers
+*/
+template< typename T, typename RngType >
+void KMeansPlusPlusSeeding( const KMeansMatrix<T> & data,
+                            const std::vector<uint32_t> & ids,
+                            const uint32_t nb_cluster,
+                            RngType & rng,
+                            KMeansMatrix<float> & centers )
+{
+  centers.resize( nb_cluster, data.cols() );
+
+  std::uniform_int_distribution<size_t> distrib_first( 0, ids.size() - 1 );
+  centers.row( 0 ) = data.row( ids[distrib_first( rng )] ).template cast<float>();
+
+  // Squared distance of the points to the nearest center
+  std::vector<float> dists( ids.size(), std::numeric_limits<float>::max() );
+  for( uint32_t id_center = 1; id_center < nb_cluster; ++id_center )
+  {
+    // Update the distances with the last added center only
+    double sum_dist = 0.0;
+    #pragma omp parallel reduction(+:sum_dist)
+    {
+      Eigen::RowVectorXf buffer;
+      #pragma omp for
+      for( int i = 0; i < static_cast<int>( ids.size() ); ++i )
+      {
+        const float * pt = PointAsFloat( data, ids[i], buffer );
+        dists[i] = std::min( dists[i],
+          SquaredL2( pt, centers.row( id_center - 1 ).data(), data.cols() ) );
+        sum_dist += dists[i];
+      }
+    }
+
+    // Sample a point with a probability Di / \sum Di
+    size_t id_sample;
+    if( sum_dist > 0.0 )
+    {
+      std::discrete_distribution<size_t> distrib_c( dists.cbegin(), dists.cend() );
+      id_sample = distrib_c( rng );
+    }
+    else // All the points are already centers
+    {
+      id_sample = distrib_first( rng );
+    }
+    centers.row( id_center ) = data.row( ids[id_sample] ).template cast<float>();
+  }
+}
+
+/**
+* @brief Standard Lloyd kmeans with Hamerly bounds
+* The distance to the assigned center (upper bound) and to the second nearest
+* center (lower bound) of each point are updated with the centers drift, and
+* the nearest center search is skipped while the upper bound is below the lower
+* bound (the assignment cannot change).
+* @param data Input points
+* @param ids Points to cluster
+* @param[in,out] centers Seeded centers, then final centers
+* @param[out] assignment Center of each point of ids
+* @param max_nb_iteration Maximum number of iteration
+*/
+template< typename T >
+void KMeansHamerly( const KMeansMatrix<T> & data,
+                    const std::vector<uint32_t> & ids,
+                    KMeansMatrix<float> & centers,
+                    std::vector<uint32_t> & assignment,
+                    const uint32_t max_nb_iteration )
+{
+  const uint32_t nb_center = centers.rows();
+  const int nb_pt = static_cast<int>( ids.size() );
+  std::vector<float> upper( nb_pt ), lower( nb_pt );
+  assignment.resize( nb_pt );
+
+  #pragma omp parallel
+  {
+    Eigen::RowVectorXf buffer;
+    #pragma omp for
+    for( int i = 0; i < nb_pt; ++i )
+    {
+      NearestCenters( PointAsFloat( data, ids[i], buffer ), centers,
+                      assignment[i], upper[i], lower[i] );
+    }
+  }
+
+  std::vector<uint32_t> begin, order;
+  std::vector<float> drift( nb_center );
+  for( uint32_t id_iteration = 0; id_iteration < max_nb_iteration; ++id_iteration )
+  {
+    // Move the centers to the center of mass of their points
+    GroupByCenter( assignment, nb_center, begin, order );
+    #pragma omp parallel for
+    for( int id_center = 0; id_center < static_cast<int>( nb_center ); ++id_center )
+    {
+      drift[id_center] = 0.f;
+      if( begin[id_center] == begin[id_center + 1] )
+      {
+        continue; // Empty cluster: keep its center
+      }
+      Eigen::RowVectorXd sum = Eigen::RowVectorXd::Zero( data.cols() );
+      for( uint32_t k = begin[id_center]; k < begin[id_center + 1]; ++k )
+      {
+        sum += data.row( ids[order[k]] ).template cast<double>();
+      }
+      const Eigen::RowVectorXf new_center =
+        ( sum / ( begin[id_center + 1] - begin[id_center] ) ).cast<float>();
+      drift[id_center] = ( new_center - centers.row( id_center ) ).norm();
+      centers.row( id_center ) = new_center;
+    }
+    const float max_drift = *std::max_element( drift.cbegin(), drift.cend() );
+    if( max_drift == 0.f )
+    {
+      break;
+    }
+
+    // Update the bounds and the assignments
+    bool changed = false;
+    #pragma omp parallel
+    {
+      Eigen::RowVectorXf buffer;
+      #pragma omp for reduction(||:changed)
+      for( int i = 0; i < nb_pt; ++i )
+      {
+        upper[i] += drift[assignment[i]];
+        lower[i] -= max_drift;
+        if( upper[i] <= lower[i] )
+        {
+          continue;
+        }
+        const float * pt = PointAsFloat( data, ids[i], buffer );
+        // Tighten the upper bound
+        upper[i] = std::sqrt( SquaredL2( pt, centers.row( assignment[i] ).data(), data.cols() ) );
+        if( upper[i] <= lower[i] )
+        {
+          continue;
+        }
+        const uint32_t previous_center = assignment[i];
+        NearestCenters( pt, centers, assignment[i], upper[i], lower[i] );
+        changed = changed || ( assignment[i] != previous_center );
+      }
+    }
+    if( !changed )
+    {
+      break;
+    }
+  }
+}
+
+/**
+* @brief Mini-batch kmeans [Sculley 2010, "Web-scale k-means clustering"]
+* Each iteration assigns a random batch of points to their nearest center, and
+* moves each center to the running mean of all its assigned points.
+* @param data Input points
+* @param ids Points to cluster
+* @param[in,out] centers Seeded centers, then final centers
+* @param params Batch size, number of iterations and tolerance
+* @param rng Random generator
+*/
+template< typename T, typename RngType >
+void KMeansMiniBatch( const KMeansMatrix<T> & data,
+                      const std::vector<uint32_t> & ids,
+                      KMeansMatrix<float> & centers,
+                      const KMeansMatrixParams & params,
+                      RngType & rng )
+{
+  const uint32_t nb_center = centers.rows();
+  const int batch_size = static_cast<int>( params.batch_size );
+  std::uniform_int_distribution<size_t> distrib( 0, ids.size() - 1 );
+
+  // Number of points assigned so far to each center
+  std::vector<uint64_t> counts( nb_center, 0 );
+  std::vector<uint32_t> batch( batch_size ), batch_assignment( batch_size );
+  std::vector<uint32_t> begin, order;
+  std::vector<float> drift( nb_center );
+  for( uint32_t id_iteration = 0; id_iteration < params.max_nb_iteration; ++id_iteration )
+  {
+    for( auto & id_pt : batch )
+    {
+      id_pt = ids[distrib( rng )];
+    }
+
+    // Assign the batch to the nearest centers
+    #pragma omp parallel
+    {
+      Eigen::RowVectorXf buffer;
+      float nearest_dist, second_dist;
+      #pragma omp for
+      for( int i = 0; i < batch_size; ++i )
+      {
+        NearestCenters( PointAsFloat( data, batch[i], buffer ), centers,
+                        batch_assignment[i], nearest_dist, second_dist );
+      }
+    }
+
+    // Update the centers (running mean of their assigned points)
+    GroupByCenter( batch_assignment, nb_center, begin, order );
+    #pragma omp parallel for
+    for( int id_center = 0; id_center < static_cast<int>( nb_center ); ++id_center )
+    {
+      drift[id_center] = 0.f;
+      const uint32_t nb_assigned = begin[id_center + 1] - begin[id_center];
+      if( nb_assigned == 0 )
+      {
+        continue;
+      }
+      Eigen::RowVectorXd sum =
+        centers.row( id_center ).template cast<double>() * static_cast<double>( counts[id_center] );
+      for( uint32_t k = begin[id_center]; k < begin[id_center + 1]; ++k )
+      {
+        sum += data.row( batch[order[k]] ).template cast<double>();
+      }
+      counts[id_center] += nb_assigned;
+      const Eigen::RowVectorXf new_center = ( sum / counts[id_center] ).cast<float>();
+      drift[id_center] = ( new_center - centers.row( id_center ) ).norm();
+      centers.row( id_center ) = new_center;
+    }
+    if( *std::max_element( drift.cbegin(), drift.cend() ) <= params.tolerance )
+    {
+      break;
+    }
+  }
+}
+
+/**
+* @brief Cluster a subset of points: mini-batch kmeans for the large subsets,
+*  standard kmeans (with Hamerly bounds) otherwise.
+* @param data Input points
+* @param ids Points to cluster
+* @param nb_cluster Number of clusters (must be <= ids.size())
+* @param params KMeans parameters
+* @param rng Random generator
+* @param[out] assignment Center of each point of ids
+* @param[out] centers Centers of the clusters
+*/
+template< typename T, typename RngType >
+void KMeansSubset( const KMeansMatrix<T> & data,
+                   const std::vector<uint32_t> & ids,
+                   const uint32_t nb_cluster,
+                   const KMeansMatrixParams & params,
+                   RngType & rng,
+                   std::vector<uint32_t> & assignment,
+                   KMeansMatrix<float> & centers )
+{
+  // Seed the centers on a random sample of the points
+  const uint32_t seeding_sample_size = std::max( params.seeding_sample_size, nb_cluster );
+  if( ids.size() > seeding_sample_size )
+  {
+    std::vector<uint32_t> sample( seeding_sample_size );
+    std::uniform_int_distribution<size_t> distrib( 0, ids.size() - 1 );
+    for( auto & id_pt : sample )
+    {
+      id_pt = ids[distrib( rng )];
+    }
+    KMeansPlusPlusSeeding( data, sample, nb_cluster, rng, centers );
+  }
+  else
+  {
+    KMeansPlusPlusSeeding( data, ids, nb_cluster, rng, centers );
+  }
+
+  if( ids.size() > params.batch_size )
+  {
+    KMeansMiniBatch( data, ids, centers, params, rng );
+    // Final assignment of all the points
+    assignment.resize( ids.size() );
+    #pragma omp parallel
+    {
+      Eigen::RowVectorXf buffer;
+      float nearest_dist, second_dist;
+      #pragma omp for
+      for( int i = 0; i < static_cast<int>( ids.size() ); ++i )
+      {
+        NearestCenters( PointAsFloat( data, ids[i], buffer ), centers,
+                        assignment[i], nearest_dist, second_dist );
+      }
+    }
+  }
+  else
+  {
+    KMeansHamerly( data, ids, centers, assignment, params.max_nb_iteration );
+  }
+}
+
+} // namespace internal
+
+/**
+* @brief Compute kmeans clustering of a matrix of points (one point per row)
+* @param source_data Input data (i.e descriptors)
+* @param[out] cluster_assignment index for each point in the input set to a specified cluster
+* @param[out] centers Centers of the clusters (one per row)
+* @param nb_cluster requested number of cluster in the output
+* @param params KMeans parameters
+* @note The centers are seeded by kmeans++. If there is more points than the
+*  batch size, the mini-batch kmeans is used, else the standard kmeans
+*  (accelerated by Hamerly bounds).
+*/
+template< typename T >
+void KMeans( const KMeansMatrix<T> & source_data,
+             std::vector< uint32_t > & cluster_assignment,
+             KMeansMatrix<float> & centers,
+             const uint32_t nb_cluster,
+             const KMeansMatrixParams & params = KMeansMatrixParams() )
+{
+  if( source_data.rows() == 0 || nb_cluster == 0 )
+  {
+    return;
+  }
+  std::mt19937_64 rng( params.seed );
+  std::vector<uint32_t> ids( source_data.rows() );
+  std::iota( ids.begin(), ids.end(), 0 );
+  internal::KMeansSubset( source_data, ids,
+    std::min<uint32_t>( nb_cluster, source_data.rows() ),
+    params, rng, cluster_assignment, centers );
+}
+
+/**
+* @brief Hierarchical kmeans tree (vocabulary tree [Nister 2006])
+* Each node is split in (at most) branching children by kmeans of its points,
+* up to the requested depth. The leaves are the words of the vocabulary.
+*/
+class KMeansTree
+{
+  public:
+
+    /**
+    * @brief Build the tree
+    * @param data Input points (i.e descriptors, one per row)
+    * @param branching Number of children of a node
+    * @param depth Number of levels of the tree (branching^depth leaves at most)
+    * @param params KMeans parameters used to split the nodes
+    */
+    template< typename T >
+    void Build( const KMeansMatrix<T> & data,
+                const uint32_t branching,
+                const uint32_t depth,
+                const KMeansMatrixParams & params = KMeansMatrixParams() )
+    {
+      dimension_ = data.cols();
+      centers_.clear();
+      first_child_.clear();
+      nb_children_.clear();
+      word_id_.clear();
+
+      // Root node
+      centers_.push_back( Eigen::RowVectorXf::Zero( dimension_ ) );
+      first_child_.push_back( 0 );
+      nb_children_.push_back( 0 );
+
+      // Nodes to split, with their points
+      std::vector<std::pair<uint32_t, std::vector<uint32_t>>> level( 1 );
+      level[0].first = 0;
+      level[0].second.resize( data.rows() );
+      std::iota( level[0].second.begin(), level[0].second.end(), 0 );
+
+      for( uint32_t id_level = 0; id_level < depth && !level.empty(); ++id_level )
+      {
+        // Split the nodes of the level (in parallel if there are many of them)
+        std::vector<KMeansMatrix<float>> centers( level.size() );
+        std::vector<std::vector<uint32_t>> assignment( level.size() );
+        #pragma omp parallel for schedule(dynamic) if (level.size() > 1)
+        for( int id_node = 0; id_node < static_cast<int>( level.size() ); ++id_node )
+        {
+          const std::vector<uint32_t> & ids = level[id_node].second;
+          if( ids.size() <= branching )
+          {
+            continue; // Leaf
+          }
+          std::mt19937_64 rng( params.seed + level[id_node].first );
+          internal::KMeansSubset( data, ids, branching, params, rng,
+                                  assignment[id_node], centers[id_node] );
+        }
+
+        // Add the children nodes (sequentially to keep a deterministic ordering)
+        std::vector<std::pair<uint32_t, std::vector<uint32_t>>> next_level;
+        for( size_t id_node = 0; id_node < level.size(); ++id_node )
+        {
+          if( centers[id_node].rows() == 0 )
+          {
+            continue;
+          }
+          const uint32_t node = level[id_node].first;
+          first_child_[node] = centers_.size();
+          nb_children_[node] = centers[id_node].rows();
+          const size_t first_next = next_level.size();
+          for( uint32_t id_child = 0; id_child < centers[id_node].rows(); ++id_child )
+          {
+            next_level.emplace_back( centers_.size(), std::vector<uint32_t>() );
+            centers_.push_back( centers[id_node].row( id_child ) );
+            first_child_.push_back( 0 );
+            nb_children_.push_back( 0 );
+          }
+          const std::vector<uint32_t> & ids = level[id_node].second;
+          for( size_t i = 0; i < ids.size(); ++i )
+          {
+            next_level[first_next + assignment[id_node][i]].second.push_back( ids[i] );
+          }
+        }
+        level = std::move( next_level );
+      }
+
+      // Number the leaves
+      word_id_.resize( centers_.size(), std::numeric_limits<uint32_t>::max() );
+      nb_words_ = 0;
+      for( size_t node = 0; node < centers_.size(); ++node )
+      {
+        if( nb_children_[node] == 0 )
+        {
+          word_id_[node] = nb_words_++;
+        }
+      }
+    }
+
+    /**
+    * @brief Find the word (leaf) of a point by descending the tree
+    * @param pt Query point (dimension values)
+    * @return The word id
+    */
+    template< typename T >
+    uint32_t Quantize( const T * pt ) const
+    {
+      Eigen::RowVectorXf buffer =
+        Eigen::Map<const Eigen::Matrix<T, 1, Eigen::Dynamic>>( pt, dimension_ ).template cast<float>();
+      uint32_t node = 0;
+      while( nb_children_[node] > 0 )
+      {
+        uint32_t nearest = first_child_[node];
+        float min_dist = std::numeric_limits<float>::max();
+        for( uint32_t child = first_child_[node]; child < first_child_[node] + nb_children_[node]; ++child )
+        {
+          const float d = internal::SquaredL2( buffer.data(), centers_[child].data(), dimension_ );
+          if( d < min_dist )
+          {
+            min_dist = d;
+            nearest = child;
+          }
+        }
+        node = nearest;
+      }
+      return word_id_[node];
+    }
+
+    /// Number of words (leaves) of the tree
+    uint32_t NbWords() const
+    {
+      return nb_words_;
+    }
+
+    /// Number of nodes of the tree
+    uint32_t NbNodes() const
+    {
+      return centers_.size();
+    }
+
+  private:
+
+    /// Dimension of the points
+    uint32_t dimension_ = 0;
+    /// Center of each node
+    std::vector<Eigen::RowVectorXf> centers_;
+    /// Children of a node are [first_child_, first_child_ + nb_children_)
+    std::vector<uint32_t> first_child_, nb_children_;
+    /// Word id of the leaves
+    std::vector<uint32_t> word_id_;
+    uint32_t nb_words_ = 0;
+};
+
 } // namespace clustering
 } // namespace openMVG
 
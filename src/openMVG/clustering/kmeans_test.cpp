@@ -321,6 +321,93 @@ TEST( clustering, threeClustersEigenVec )
   }
 }
 
+// Check that the points of each generated cluster share the same label
+// (and that the clusters have different labels)
+static bool CheckMatrixLabels( const std::vector<uint32_t> & ids )
+{
+  std::vector<uint32_t> cluster_ids;
+  int counter = 0;
+  for (const auto nb_point_in_cluster : POINTS_PER_CLUSTER)
+  {
+    const uint32_t id_to_check = ids[counter];
+    for (int i = 0; i < nb_point_in_cluster; ++i, ++counter)
+    {
+      if (ids[counter] != id_to_check)
+        return false;
+    }
+    cluster_ids.push_back(id_to_check);
+  }
+  std::sort(cluster_ids.begin(), cluster_ids.end());
+  return std::unique(cluster_ids.begin(), cluster_ids.end()) == cluster_ids.end();
+}
+
+TEST( clustering, threeClustersMatrix )
+{
+  const int dimension = 128;
+  Mat mat_centers;
+  const KMeansMatrix<float> pts =
+    InitRandom3ClusterDataset(mat_centers, dimension).transpose().cast<float>();
+
+  // Standard kmeans (Hamerly bounds) and mini-batch kmeans
+  for (const uint32_t batch_size : {100000u, 500u})
+  {
+    KMeansMatrixParams params;
+    params.batch_size = batch_size;
+    params.seeding_sample_size = 1000;
+
+    std::vector<uint32_t> ids;
+    KMeansMatrix<float> centers;
+    KMeans(pts, ids, centers, NB_CLUSTER, params);
+
+    EXPECT_EQ(NB_CLUSTER, centers.rows());
+    EXPECT_EQ(pts.rows(), ids.size());
+    EXPECT_TRUE(CheckMatrixLabels(ids));
+    for (int i = 0; i < NB_CLUSTER; ++i)
+    {
+      const Vec center = mat_centers.col(i);
+      const Vec found = centers.row(ids[i * NB_POINT]).transpose().cast<double>();
+      EXPECT_NEAR(0.0, (center - found).lpNorm<Eigen::Infinity>(), 0.25);
+    }
+  }
+}
+
+TEST( clustering, threeClustersMatrixUint8 )
+{
+  const int dimension = 128;
+  Mat mat_centers;
+  const KMeansMatrix<uint8_t> pts =
+    (InitRandom3ClusterDataset(mat_centers, dimension).transpose().array() * 10 + 100)
+    .cast<uint8_t>();
+
+  std::vector<uint32_t> ids;
+  KMeansMatrix<float> centers;
+  KMeans(pts, ids, centers, NB_CLUSTER);
+
+  EXPECT_EQ(NB_CLUSTER, centers.rows());
+  EXPECT_TRUE(CheckMatrixLabels(ids));
+}
+
+TEST( clustering, kmeansTree )
+{
+  const int dimension = 128;
+  Mat mat_centers;
+  const KMeansMatrix<float> pts =
+    InitRandom3ClusterDataset(mat_centers, dimension).transpose().cast<float>();
+
+  KMeansMatrixParams params;
+  params.batch_size = 2000;
+  KMeansTree tree;
+  tree.Build(pts, NB_CLUSTER, 2, params);
+  EXPECT_EQ(NB_CLUSTER * NB_CLUSTER, tree.NbWords());
+  EXPECT_EQ(1 + NB_CLUSTER + NB_CLUSTER * NB_CLUSTER, tree.NbNodes());
+
+  // The points of a generated cluster are in the same first level node
+  std::vector<uint32_t> ids(pts.rows());
+  for (int i = 0; i < pts.rows(); ++i)
+    ids[i] = tree.Quantize(pts.row(i).data()) / NB_CLUSTER;
+  EXPECT_TRUE(CheckMatrixLabels(ids));
+}
+
 /* ************************************************************************* */
 int main()
 {
@@ -16,6 +16,7 @@
 //- Date: November 2013.
 //- Conference: CVMP.
 
+#include <algorithm>
 #include <numeric>
 #include <limits>
 #include <set>
@@ -67,13 +68,67 @@ static void cdf(const std::vector<T> & vec_df, std::vector<T> & vec_cdf)
       vec_cdf[i] = vec_cdf[i] + vec_cdf[i-1];
 }
 
+// Compute the positions of the 10 quantiles (5%, 15%, ..., 95%) of a histogram
+template<typename T>
+static void quantilePositions(const std::vector<T> & vec_df, std::vector<double> & vec_position)
+{
+  const size_t nBuckets = vec_df.size();
+
+  // Normalize histogram
+  std::vector<double> ndf(nBuckets);
+  normalizeHisto(vec_df, ndf);
+
+  // Compute cumulative distribution functions (cdf)
+  std::vector<double> cdf_df(nBuckets);
+  cdf(ndf, cdf_df);
+
+  const double incrementPourcentile = 1./10.;
+  double currentPourcentile = 5./100.;
+
+  vec_position.clear();
+  vec_position.reserve(1.0/incrementPourcentile);
+  while (currentPourcentile < 1.0)
+  {
+    const std::vector<double>::const_iterator iterF =
+      std::lower_bound(cdf_df.begin(), cdf_df.end(), currentPourcentile);
+    vec_position.push_back(std::distance(cdf_df.cbegin(), iterF));
+
+    currentPourcentile += incrementPourcentile;
+  }
+}
+
 }; // namespace histogram
 
+// The quantiles of a pair of histograms (the only data used by the alignment).
+// Reducing the histograms of an edge as soon as they are computed keeps the
+//  linear program data small (20 values per edge).
+struct relativeColorQuantileEdge
+{
+  size_t I,J;
+  std::vector<double> quantileI, quantileJ;
+
+  relativeColorQuantileEdge() = default;
+
+  relativeColorQuantileEdge(
+    size_t i, size_t j,
+    const std::vector<size_t> & histogramI,
+    const std::vector<size_t> & histogramJ):
+      I(i), J(j)
+  {
+    histogram::quantilePositions(histogramI, quantileI);
+    histogram::quantilePositions(histogramJ, quantileJ);
+  }
+
+  explicit relativeColorQuantileEdge(const relativeColorHistogramEdge & edge):
+    relativeColorQuantileEdge(edge.I, edge.J, edge.histoI, edge.histoJ)
+  { }
+};
+
 // Implementation of the formula (1) of [1] with 10 quantiles.
 //-- L_infinity alignment of pair of histograms over a graph thanks to a linear program.
 static void Encode_histo_relation(
     const size_t nImage,
-    const std::vector<relativeColorHistogramEdge > & vec_relativeHistograms,
+    const std::vector<relativeColorQuantileEdge > & vec_relativeQuantiles,
     const std::vector<size_t> & vec_indexToFix,
     sRMat & A, Vec & C,
     std::vector<linearProgramming::LP_Constraints::eLP_SIGN> & vec_sign,
@@ -81,7 +136,7 @@ static void Encode_histo_relation(
     std::vector<std::pair<double,double>> & vec_bounds)
 {
   const size_t Nima = (size_t) nImage;
-  const size_t Nrelative = vec_relativeHistograms.size();
+  const size_t Nrelative = vec_relativeQuantiles.size();
 
 # define GVAR(i) (2*(i))
 # define OFFSETVAR(i) (2*(i)+1)
@@ -124,100 +179,76 @@ static void Encode_histo_relation(
   vec_costs[GAMMAVAR] = 1.0;
   //--
 
-  size_t rowPos = 0;
-  double incrementPourcentile = 1./ static_cast<double>(nbQuantile);
+  // Fill the constraint matrix in one pass (5 coefficients per row)
+  std::vector<Eigen::Triplet<double>> vec_triplets;
+  vec_triplets.reserve(Nconstraint * 5);
 
-  for (size_t i = 0; i < Nrelative; ++i)
+  size_t rowPos = 0;
+  for (const relativeColorQuantileEdge & edge : vec_relativeQuantiles)
   {
-    std::vector<relativeColorHistogramEdge>::const_iterator iter = vec_relativeHistograms.begin();
-    std::advance(iter, i);
-
-    const relativeColorHistogramEdge & edge = *iter;
-
-    //-- compute the two cumulated and normalized histogram
-
-    const std::vector<size_t> & vec_histoI = edge.histoI;
-    const std::vector<size_t> & vec_histoJ = edge.histoJ;
-
-    const size_t nBuckets = vec_histoI.size();
-
-    // Normalize histogram
-    std::vector<double> ndf_I(nBuckets), ndf_J(nBuckets);
-    histogram::normalizeHisto(vec_histoI, ndf_I);
-    histogram::normalizeHisto(vec_histoJ, ndf_J);
-
-    // Compute cumulative distribution functions (cdf)
-    std::vector<double> cdf_I(nBuckets), cdf_J(nBuckets);
-    histogram::cdf(ndf_I, cdf_I);
-    histogram::cdf(ndf_J, cdf_J);
-
-    double currentPourcentile = 5./100.;
-
-    //-- Compute pourcentile and their positions
-    std::vector<double> vec_pourcentilePositionI, vec_pourcentilePositionJ;
-    vec_pourcentilePositionI.reserve(1.0/incrementPourcentile);
-    vec_pourcentilePositionJ.reserve(1.0/incrementPourcentile);
-
-    std::vector<double>::const_iterator cdf_I_IterBegin = cdf_I.begin();
-    std::vector<double>::const_iterator cdf_J_IterBegin = cdf_J.begin();
-    while (currentPourcentile < 1.0)
-    {
-      std::vector<double>::const_iterator iterFI = std::lower_bound(cdf_I.begin(), cdf_I.end(), currentPourcentile);
-      const size_t positionI = std::distance(cdf_I_IterBegin, iterFI);
-
-      std::vector<double>::const_iterator iterFJ = std::lower_bound(cdf_J.begin(), cdf_J.end(), currentPourcentile);
-      const size_t positionJ = std::distance(cdf_J_IterBegin, iterFJ);
-
-      vec_pourcentilePositionI.push_back(positionI);
-      vec_pourcentilePositionJ.push_back(positionJ);
-
-      currentPourcentile += incrementPourcentile;
-    }
-
     //-- Add the constraints:
     // pos * ga + offa - pos * gb - offb <= gamma
     // pos * ga + offa - pos * gb - offb >= - gamma
 
-    for (size_t k = 0; k < vec_pourcentilePositionI.size(); ++k)
+    for (size_t k = 0; k < edge.quantileI.size(); ++k)
     {
-      A.coeffRef(rowPos, GVAR(edge.I)) = vec_pourcentilePositionI[k];
-      A.coeffRef(rowPos, OFFSETVAR(edge.I)) = 1.0;
-
-      A.coeffRef(rowPos, GVAR(edge.J)) = - vec_pourcentilePositionJ[k];
-      A.coeffRef(rowPos, OFFSETVAR(edge.J)) = - 1.0;
-
-      // - gamma (side change)
-      A.coeffRef(rowPos, GAMMAVAR) = -1;
-      // <= gamma
-      vec_sign[rowPos] = linearProgramming::LP_Constraints::LP_LESS_OR_EQUAL;
-      C(rowPos) = 0;
-      ++rowPos;
-
-      A.coeffRef(rowPos, GVAR(edge.I)) = vec_pourcentilePositionI[k];
-      A.coeffRef(rowPos, OFFSETVAR(edge.I)) = 1.0;
-
-      A.coeffRef(rowPos, GVAR(edge.J)) = - vec_pourcentilePositionJ[k];
-      A.coeffRef(rowPos, OFFSETVAR(edge.J)) = - 1.0;
-
-      // + gamma (side change)
-      A.coeffRef(rowPos, GAMMAVAR) = 1;
-      // >= - gamma
-      vec_sign[rowPos] = linearProgramming::LP_Constraints::LP_GREATER_OR_EQUAL;
-      C(rowPos) = 0;
-      ++rowPos;
+      for (const double gamma_sign : {-1.0, 1.0})
+      {
+        vec_triplets.emplace_back(rowPos, GVAR(edge.I), edge.quantileI[k]);
+        vec_triplets.emplace_back(rowPos, OFFSETVAR(edge.I), 1.0);
+
+        vec_triplets.emplace_back(rowPos, GVAR(edge.J), - edge.quantileJ[k]);
+        vec_triplets.emplace_back(rowPos, OFFSETVAR(edge.J), - 1.0);
+
+        // -/+ gamma (side change)
+        vec_triplets.emplace_back(rowPos, GAMMAVAR, gamma_sign);
+        // <= gamma or >= - gamma
+        vec_sign[rowPos] = (gamma_sign < 0)
+          ? linearProgramming::LP_Constraints::LP_LESS_OR_EQUAL
+          : linearProgramming::LP_Constraints::LP_GREATER_OR_EQUAL;
+        C(rowPos) = 0;
+        ++rowPos;
+      }
     }
   }
+  A.setFromTriplets(vec_triplets.begin(), vec_triplets.end());
 #undef GVAR
 #undef OFFSETVAR
 #undef GAMMAVAR
 }
 
+static void Encode_histo_relation(
+    const size_t nImage,
+    const std::vector<relativeColorHistogramEdge > & vec_relativeHistograms,
+    const std::vector<size_t> & vec_indexToFix,
+    sRMat & A, Vec & C,
+    std::vector<linearProgramming::LP_Constraints::eLP_SIGN> & vec_sign,
+    std::vector<double> & vec_costs,
+    std::vector<std::pair<double,double>> & vec_bounds)
+{
+  const std::vector<relativeColorQuantileEdge> vec_relativeQuantiles(
+    vec_relativeHistograms.begin(), vec_relativeHistograms.end());
+  Encode_histo_relation(
+    nImage, vec_relativeQuantiles, vec_indexToFix,
+    A, C, vec_sign, vec_costs, vec_bounds);
+}
+
 struct ConstraintBuilder_GainOffset
 {
   ConstraintBuilder_GainOffset(
     const std::vector<relativeColorHistogramEdge > & vec_relativeHistograms,
     const std::vector<size_t> & vec_indexToFix):
-    _vec_relative(vec_relativeHistograms),
+    ConstraintBuilder_GainOffset(
+      std::vector<relativeColorQuantileEdge>(
+        vec_relativeHistograms.begin(), vec_relativeHistograms.end()),
+      vec_indexToFix)
+  {
+  }
+
+  ConstraintBuilder_GainOffset(
+    std::vector<relativeColorQuantileEdge > vec_relativeQuantiles,
+    const std::vector<size_t> & vec_indexToFix):
+    _vec_relative(std::move(vec_relativeQuantiles)),
     _vec_indexToFix(vec_indexToFix)
   {
     //Count the number of images
@@ -253,7 +284,7 @@ struct ConstraintBuilder_GainOffset
   }
   // Internal data
   size_t _Nima;
-  const std::vector<relativeColorHistogramEdge> & _vec_relative;
+  const std::vector<relativeColorQuantileEdge> _vec_relative;
   const std::vector<size_t> & _vec_indexToFix;
 };
 
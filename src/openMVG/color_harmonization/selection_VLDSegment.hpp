@@ -9,10 +9,12 @@
 #ifndef OPENMVG_COLOR_HARMONIZATION_SELECTION_VLDSEGMENT_HPP
 #define OPENMVG_COLOR_HARMONIZATION_SELECTION_VLDSEGMENT_HPP
 
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "openMVG/color_harmonization/selection_interface.hpp"
+#include "openMVG/image/image_cache.hpp"
 #include "openMVG/matching/kvld/kvld.h"
 #include "openMVG/matching/kvld/kvld_draw.h"
 
@@ -26,10 +28,12 @@ class commonDataByPair_VLDSegment  : public commonDataByPair
                                const std::string & sRightImage,
                                const std::vector<matching::IndMatch>& vec_PutativeMatches,
                                const std::vector<features::SIOPointFeature >& vec_featsL,
-                               const std::vector<features::SIOPointFeature >& vec_featsR):
+                               const std::vector<features::SIOPointFeature >& vec_featsR,
+                               image::ImageCache * image_cache = nullptr):
            commonDataByPair( sLeftImage, sRightImage ),
            _vec_featsL( vec_featsL ), _vec_featsR( vec_featsR ),
-           _vec_PutativeMatches( vec_PutativeMatches )
+           _vec_PutativeMatches( vec_PutativeMatches ),
+           _image_cache( image_cache )
   {}
 
   ~commonDataByPair_VLDSegment() override = default;
@@ -48,12 +52,25 @@ class commonDataByPair_VLDSegment  : public commonDataByPair
   {
     std::vector<matching::IndMatch> vec_KVLDMatches;
 
-    image::Image<unsigned char> imageL, imageR;
-    image::ReadImage( _sLeftImage.c_str(), &imageL );
-    image::ReadImage( _sRightImage.c_str(), &imageR );
-
-    image::Image<float> imgA ( imageL.GetMat().cast<float>() );
-    image::Image<float> imgB(imageR.GetMat().cast<float>());
+    image::Image<float> imgA, imgB;
+    if (_image_cache)
+    {
+      const std::shared_ptr<const image::Image<unsigned char>>
+        imageL = _image_cache->Get<unsigned char>( _sLeftImage ),
+        imageR = _image_cache->Get<unsigned char>( _sRightImage );
+      if (!imageL || !imageR)
+        return false;
+      imgA = image::Image<float>( imageL->GetMat().cast<float>() );
+      imgB = image::Image<float>( imageR->GetMat().cast<float>() );
+    }
+    else
+    {
+      image::Image<unsigned char> imageL, imageR;
+      image::ReadImage( _sLeftImage.c_str(), &imageL );
+      image::ReadImage( _sRightImage.c_str(), &imageR );
+      imgA = image::Image<float>( imageL.GetMat().cast<float>() );
+      imgB = image::Image<float>( imageR.GetMat().cast<float>() );
+    }
 
     std::vector<Pair> matchesFiltered, matchesPair;
 
@@ -69,6 +86,9 @@ class commonDataByPair_VLDSegment  : public commonDataByPair
     // gvld-consistancy matrix, intitialized to -1,  >0 consistancy value, -1=unknow, -2=false
     std::vector<bool> valide( _vec_PutativeMatches.size(), true );// indices of match in the initial matches, if true at the end of KVLD, a match is kept.
 
+    // The scale-spaces are computed once for all the KVLD iterations
+    const ImageScale scaleA( imgA ), scaleB( imgB );
+
     size_t it_num = 0;
     KvldParameters kvldparameters;//initial parameters of KVLD
     //kvldparameters.K = 5;
@@ -76,7 +96,7 @@ class commonDataByPair_VLDSegment  : public commonDataByPair
       it_num < 5 &&
       kvldparameters.inlierRate >
       KVLD(
-        imgA, imgB,
+        scaleA, scaleB,
         _vec_featsL, _vec_featsR,
         matchesPair, matchesFiltered,
         vec_score, E, valide, kvldparameters ) )
@@ -110,9 +130,12 @@ class commonDataByPair_VLDSegment  : public commonDataByPair
 
 private:
   // Left and Right features
-  std::vector<features::SIOPointFeature > _vec_featsL, _vec_featsR;
+  // (referenced data, shared with the other pairs of the images)
+  const std::vector<features::SIOPointFeature > & _vec_featsL, & _vec_featsR;
   // Left and Right corresponding index (putatives matches)
-  std::vector<matching::IndMatch> _vec_PutativeMatches;
+  const std::vector<matching::IndMatch> & _vec_PutativeMatches;
+  // Optional store of the decoded images
+  image::ImageCache * _image_cache;
 };
 
 }  // namespace color_harmonization
@@ -62,9 +62,10 @@ public:
 
 private:
   size_t _radius;
-  std::vector<matching::IndMatch> _vec_PutativeMatches;
-  std::vector<features::SIOPointFeature> _vec_featsL;
-  std::vector<features::SIOPointFeature> _vec_featsR;
+  // (referenced data, shared with the other pairs of the images)
+  const std::vector<matching::IndMatch> & _vec_PutativeMatches;
+  const std::vector<features::SIOPointFeature> & _vec_featsL;
+  const std::vector<features::SIOPointFeature> & _vec_featsR;
 };
 
 }  // namespace color_harmonization
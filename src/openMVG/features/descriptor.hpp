@@ -177,27 +177,37 @@ inline bool saveDescsToFile(
 }
 
 
-/// Read descriptors from file (in binary mode)
+/// Read descriptors from a stream (in binary mode)
 template<typename DescriptorsT >
-inline bool loadDescsFromBinFile(
-  const std::string & sfileNameDescs,
+inline bool loadDescsFromBinStream(
+  std::istream & stream,
   DescriptorsT & vec_desc)
 {
   using VALUE = typename DescriptorsT::value_type;
 
   vec_desc.clear();
-  std::ifstream fileIn(sfileNameDescs.c_str(), std::ios::in | std::ios::binary);
-  if (!fileIn.is_open())
-    return false;
-  //Read the number of descriptor in the file
+  //Read the number of descriptor in the stream
   std::size_t cardDesc = 0;
-  fileIn.read(reinterpret_cast<char*>(&cardDesc), sizeof(std::size_t));
+  stream.read(reinterpret_cast<char*>(&cardDesc), sizeof(std::size_t));
   vec_desc.resize(cardDesc);
   for (auto & it :vec_desc) {
-    fileIn.read(reinterpret_cast<char*>(it.data()),
+    stream.read(reinterpret_cast<char*>(it.data()),
       VALUE::static_size*sizeof(typename VALUE::bin_type));
   }
-  const bool bOk = !fileIn.bad();
+  return !stream.bad();
+}
+
+/// Read descriptors from file (in binary mode)
+template<typename DescriptorsT >
+inline bool loadDescsFromBinFile(
+  const std::string & sfileNameDescs,
+  DescriptorsT & vec_desc)
+{
+  vec_desc.clear();
+  std::ifstream fileIn(sfileNameDescs.c_str(), std::ios::in | std::ios::binary);
+  if (!fileIn.is_open())
+    return false;
+  const bool bOk = loadDescsFromBinStream(fileIn, vec_desc);
   fileIn.close();
   return bOk;
 }
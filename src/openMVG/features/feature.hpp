@@ -141,6 +141,20 @@ protected:
   float l1_, l2_, phi_, a_, b_, c_;
 };
 
+/// Read feats from a stream
+template<typename FeaturesT >
+static bool loadFeatsFromStream(
+  std::istream & stream,
+  FeaturesT & vec_feat)
+{
+  vec_feat.clear();
+  std::copy(
+    std::istream_iterator<typename FeaturesT::value_type >(stream),
+    std::istream_iterator<typename FeaturesT::value_type >(),
+    std::back_inserter(vec_feat));
+  return !stream.bad();
+}
+
 /// Read feats from file
 template<typename FeaturesT >
 static bool loadFeatsFromFile(
@@ -154,11 +168,7 @@ static bool loadFeatsFromFile(
   {
     return false;
   }
-  std::copy(
-    std::istream_iterator<typename FeaturesT::value_type >(fileIn),
-    std::istream_iterator<typename FeaturesT::value_type >(),
-    std::back_inserter(vec_feat));
-  const bool bOk = !fileIn.bad();
+  const bool bOk = loadFeatsFromStream(fileIn, vec_feat);
   fileIn.close();
   return bOk;
 }
@@ -14,6 +14,7 @@
 #include <fstream>
 #include <iostream>
 #include <iterator>
+#include <sstream>
 #include <vector>
 
 using namespace openMVG;
@@ -129,6 +130,43 @@ TEST(descriptorIO, BINARY) {
   }
 }
 
+//Test the loading of features and binary descriptors from memory streams
+TEST(featureIO, STREAM) {
+  Feats_T vec_feats;
+  Descs_T vec_descs;
+  for (int i = 0; i < CARD; ++i)
+  {
+    vec_feats.emplace_back(i, i*2, i*3, i*4);
+    Desc_T desc;
+    for (int j = 0; j < DESC_LENGTH; ++j)
+      desc[j] = i*DESC_LENGTH+j;
+    vec_descs.emplace_back(desc);
+  }
+
+  EXPECT_TRUE(saveFeatsToFile("tempFeatsStream.feat", vec_feats));
+  EXPECT_TRUE(saveDescsToBinFile("tempDescsStream.desc", vec_descs));
+
+  std::ifstream featsFile("tempFeatsStream.feat");
+  std::ifstream descsFile("tempDescsStream.desc", std::ios::binary);
+  std::stringstream featsStream, descsStream;
+  featsStream << featsFile.rdbuf();
+  descsStream << descsFile.rdbuf();
+
+  Feats_T vec_feats_read;
+  Descs_T vec_descs_read;
+  EXPECT_TRUE(loadFeatsFromStream(featsStream, vec_feats_read));
+  EXPECT_TRUE(loadDescsFromBinStream(descsStream, vec_descs_read));
+  EXPECT_EQ(CARD, vec_feats_read.size());
+  EXPECT_EQ(CARD, vec_descs_read.size());
+
+  for (int i = 0; i < CARD; ++i)
+  {
+    EXPECT_EQ(vec_feats[i], vec_feats_read[i]);
+    for (int j = 0; j < DESC_LENGTH; ++j)
+      EXPECT_EQ(vec_descs[i][j], vec_descs_read[i][j]);
+  }
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
@@ -0,0 +1,220 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_FEATURES_PQ_REGIONS_HPP
+#define OPENMVG_FEATURES_PQ_REGIONS_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
+
+#include "openMVG/features/descriptor.hpp"
+#include "openMVG/features/regions.hpp"
+#include "openMVG/matching/product_quantizer.hpp"
+
+namespace openMVG {
+namespace features {
+
+/// Base class of the regions whose descriptors are stored as product
+/// quantization codes (independent of the feature and descriptor types).
+/// DescriptorRawData() returns the codes (DescriptorLength() bytes per region).
+class PQ_Regions_Base : public Regions
+{
+public:
+
+  explicit PQ_Regions_Base
+  (
+    std::shared_ptr<const matching::ProductQuantizer> quantizer = nullptr
+  ): quantizer_(quantizer)
+  {}
+
+  /// The quantizer used to encode the descriptors
+  const std::shared_ptr<const matching::ProductQuantizer> & Quantizer() const
+  {
+    return quantizer_;
+  }
+
+  /// Mutable and non-mutable codes getters.
+  inline std::vector<uint8_t> & Codes() { return codes_; }
+  inline const std::vector<uint8_t> & Codes() const { return codes_; }
+
+  bool IsScalar() const override {return true;}
+  bool IsBinary() const override {return false;}
+  size_t DescriptorLength() const override
+  {
+    return quantizer_ ? quantizer_->CodeSize() : 0;
+  }
+
+  const void * DescriptorRawData() const override { return codes_.data(); }
+
+  // Return the squared L2 distance between two descriptors (symmetric distance)
+  double SquaredDescriptorDistance(size_t i, const Regions * regions, size_t j) const override
+  {
+    assert(i < RegionCount());
+    assert(regions);
+    assert(j < regions->RegionCount());
+
+    const PQ_Regions_Base * regionsPQ = dynamic_cast<const PQ_Regions_Base *>(regions);
+    const size_t code_size = DescriptorLength();
+    return quantizer_->SymmetricDistance(&codes_[i * code_size], &regionsPQ->codes_[j * code_size]);
+  }
+
+protected:
+  std::shared_ptr<const matching::ProductQuantizer> quantizer_;
+  std::vector<uint8_t> codes_; // region descriptions (product quantization codes)
+};
+
+/**
+ * @brief Regions whose descriptors are encoded by a product quantizer.
+ * The descriptor files are the ones of the Scalar_Regions<FeatT, T, L>: the
+ * descriptors are encoded while they are read, so only the codes are kept in
+ * memory (i.e 16 bytes instead of 128 for a SIFT descriptor with a 16 bytes code).
+ */
+template<typename FeatT, typename T, size_t L>
+class PQ_Regions : public PQ_Regions_Base
+{
+public:
+
+  //-- Type alias
+  //--
+
+  /// Region type
+  using FeatureT = FeatT;
+  /// Region descriptor (of the descriptor files)
+  using DescriptorT = Descriptor<T, L>;
+
+  /// Container for multiple regions
+  using FeatsT = std::vector<FeatureT>;
+
+  //-- Class functions
+  //--
+
+  explicit PQ_Regions
+  (
+    std::shared_ptr<const matching::ProductQuantizer> quantizer = nullptr
+  ): PQ_Regions_Base(quantizer)
+  {}
+
+  std::string Type_id() const override {return std::string("PQ_") + typeid(T).name();}
+
+  /// Read the regions and encode their descriptors.
+  bool Load(
+    const std::string& sfileNameFeats,
+    const std::string& sfileNameDescs) override
+  {
+    std::ifstream fileFeats(sfileNameFeats.c_str());
+    std::ifstream fileDescs(sfileNameDescs.c_str(), std::ios::in | std::ios::binary);
+    if (!fileFeats.is_open() || !fileDescs.is_open())
+      return false;
+    return Load(fileFeats, fileDescs);
+  }
+
+  bool Load(
+    std::istream& streamFeats,
+    std::istream& streamDescs) override
+  {
+    if (!quantizer_ || quantizer_->Dimension() != static_cast<int>(L))
+    {
+      std::cerr << "Invalid product quantizer for the regions" << std::endl;
+      return false;
+    }
+    if (!loadFeatsFromStream(streamFeats, vec_feats_))
+      return false;
+
+    // Read and encode the descriptors one by one
+    const size_t code_size = DescriptorLength();
+    std::size_t cardDesc = 0;
+    streamDescs.read(reinterpret_cast<char*>(&cardDesc), sizeof(std::size_t));
+    codes_.resize(cardDesc * code_size);
+    DescriptorT desc;
+    for (std::size_t i = 0; i < cardDesc && streamDescs; ++i)
+    {
+      streamDescs.read(reinterpret_cast<char*>(desc.data()), L * sizeof(T));
+      quantizer_->Encode(desc.data(), &codes_[i * code_size]);
+    }
+    return !streamDescs.bad();
+  }
+
+  /// Export the regions and their decoded (approximated) descriptors.
+  bool Save(
+    const std::string& sfileNameFeats,
+    const std::string& sfileNameDescs) const override
+  {
+    if (!quantizer_)
+      return false;
+    const size_t code_size = DescriptorLength();
+    std::vector<DescriptorT, Eigen::aligned_allocator<DescriptorT>> descs(RegionCount());
+    std::vector<float> decoded(L);
+    for (size_t i = 0; i < descs.size(); ++i)
+    {
+      quantizer_->Decode(&codes_[i * code_size], decoded.data());
+      for (size_t j = 0; j < L; ++j)
+        descs[i][j] = std::is_integral<T>::value
+          ? static_cast<T>(std::round(decoded[j])) : static_cast<T>(decoded[j]);
+    }
+    return saveFeatsToFile(sfileNameFeats, vec_feats_)
+          & saveDescsToBinFile(sfileNameDescs, descs);
+  }
+
+  bool LoadFeatures(const std::string& sfileNameFeats) override
+  {
+    return loadFeatsFromFile(sfileNameFeats, vec_feats_);
+  }
+
+  bool LoadFeatures(std::istream& streamFeats) override
+  {
+    return loadFeatsFromStream(streamFeats, vec_feats_);
+  }
+
+  PointFeatures GetRegionsPositions() const override
+  {
+    return {vec_feats_.cbegin(), vec_feats_.cend()};
+  }
+
+  Vec2 GetRegionPosition(size_t i) const override
+  {
+    return Vec2f(vec_feats_[i].coords()).cast<double>();
+  }
+
+  /// Return the number of defined regions
+  size_t RegionCount() const override {return vec_feats_.size();}
+
+  /// Mutable and non-mutable FeatureT getters.
+  inline FeatsT & Features() { return vec_feats_; }
+  inline const FeatsT & Features() const { return vec_feats_; }
+
+  Regions * EmptyClone() const override
+  {
+    return new PQ_Regions(quantizer_);
+  }
+
+  /// Add the Inth region to another Region container
+  void CopyRegion(size_t i, Regions * region_container) const override
+  {
+    assert(i < vec_feats_.size());
+    const size_t code_size = DescriptorLength();
+    PQ_Regions<FeatT, T, L> * regionsT = static_cast<PQ_Regions<FeatT, T, L> *>(region_container);
+    regionsT->vec_feats_.push_back(vec_feats_[i]);
+    regionsT->codes_.insert(regionsT->codes_.end(),
+      codes_.cbegin() + i * code_size, codes_.cbegin() + (i + 1) * code_size);
+  }
+
+private:
+  //--
+  //-- internal data
+  FeatsT vec_feats_; // region features
+};
+
+} // namespace features
+} // namespace openMVG
+
+#endif // OPENMVG_FEATURES_PQ_REGIONS_HPP
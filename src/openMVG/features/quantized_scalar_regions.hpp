@@ -0,0 +1,127 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_FEATURES_QUANTIZED_SCALAR_REGIONS_HPP
+#define OPENMVG_FEATURES_QUANTIZED_SCALAR_REGIONS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+#include "openMVG/features/scalar_regions.hpp"
+
+namespace openMVG {
+namespace features {
+
+/**
+ * @brief Scalar regions whose descriptors are stored in a more compact type
+ * than the one of their descriptor files (i.e float descriptors stored as
+ * unsigned char or half float).
+ * The descriptors are converted while they are loaded:
+ *   value = SrcT_value * scale + offset (rounded and clamped for the integer types)
+ * The matchers work on the converted descriptors (the L2 distances are the
+ *  ones of the source descriptors scaled by scale^2).
+ */
+template<typename FeatT, typename SrcT, typename T, size_t L>
+class Quantized_Scalar_Regions : public Scalar_Regions<FeatT, T, L>
+{
+public:
+  using Base = Scalar_Regions<FeatT, T, L>;
+  /// Descriptor type of the files
+  using SourceDescriptorT = Descriptor<SrcT, L>;
+
+  /// Default conversion: [-0.5, 0.5] is mapped to [0, 255] for the unsigned char
+  ///  (i.e normalized descriptors), the values are kept for the floating types
+  explicit Quantized_Scalar_Regions
+  (
+    float scale = std::is_integral<T>::value ? 255.f : 1.f,
+    float offset = std::is_integral<T>::value ? 128.f : 0.f
+  ): scale_(scale), offset_(offset)
+  {}
+
+  float Scale() const { return scale_; }
+  float Offset() const { return offset_; }
+
+  bool Load(
+    const std::string& sfileNameFeats,
+    const std::string& sfileNameDescs) override
+  {
+    std::ifstream fileFeats(sfileNameFeats.c_str());
+    std::ifstream fileDescs(sfileNameDescs.c_str(), std::ios::in | std::ios::binary);
+    if (!fileFeats.is_open() || !fileDescs.is_open())
+      return false;
+    return Load(fileFeats, fileDescs);
+  }
+
+  bool Load(
+    std::istream& streamFeats,
+    std::istream& streamDescs) override
+  {
+    if (!loadFeatsFromStream(streamFeats, this->Features()))
+      return false;
+
+    // Read and convert the descriptors one by one
+    std::size_t cardDesc = 0;
+    streamDescs.read(reinterpret_cast<char*>(&cardDesc), sizeof(std::size_t));
+    this->Descriptors().resize(cardDesc);
+    SourceDescriptorT source;
+    for (auto & desc : this->Descriptors())
+    {
+      streamDescs.read(reinterpret_cast<char*>(source.data()), L * sizeof(SrcT));
+      for (size_t i = 0; i < L; ++i)
+        desc[i] = Convert(static_cast<float>(source[i]) * scale_ + offset_);
+    }
+    return !streamDescs.bad();
+  }
+
+  /// Export the regions and their descriptors converted back to the source type
+  bool Save(
+    const std::string& sfileNameFeats,
+    const std::string& sfileNameDescs) const override
+  {
+    std::vector<SourceDescriptorT, Eigen::aligned_allocator<SourceDescriptorT>> descs;
+    descs.reserve(this->Descriptors().size());
+    for (const auto & desc : this->Descriptors())
+    {
+      SourceDescriptorT source;
+      for (size_t i = 0; i < L; ++i)
+        source[i] = static_cast<SrcT>((static_cast<float>(desc[i]) - offset_) / scale_);
+      descs.emplace_back(source);
+    }
+    return saveFeatsToFile(sfileNameFeats, this->Features())
+          & saveDescsToBinFile(sfileNameDescs, descs);
+  }
+
+  Regions * EmptyClone() const override
+  {
+    return new Quantized_Scalar_Regions(scale_, offset_);
+  }
+
+private:
+
+  template <typename U = T>
+  static typename std::enable_if<std::is_integral<U>::value, U>::type Convert(float value)
+  {
+    return static_cast<U>(std::min<float>(std::max<float>(std::round(value),
+      std::numeric_limits<U>::lowest()), std::numeric_limits<U>::max()));
+  }
+
+  template <typename U = T>
+  static typename std::enable_if<!std::is_integral<U>::value, U>::type Convert(float value)
+  {
+    return static_cast<U>(value);
+  }
+
+  float scale_, offset_;
+};
+
+} // namespace features
+} // namespace openMVG
+
+#endif // OPENMVG_FEATURES_QUANTIZED_SCALAR_REGIONS_HPP
@@ -40,6 +40,14 @@ public:
   virtual bool LoadFeatures(
     const std::string& sfileNameFeats) = 0;
 
+  // Same as the file versions, from streams (i.e. files already read in memory)
+  virtual bool Load(
+    std::istream& streamFeats,
+    std::istream& streamDescs) = 0;
+
+  virtual bool LoadFeatures(
+    std::istream& streamFeats) = 0;
+
   //--
   //- Basic description of a descriptor [Type, Length]
   //--
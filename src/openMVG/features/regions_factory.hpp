@@ -10,6 +10,8 @@
 #define OPENMVG_FEATURES_REGIONS_FACTORY_HPP
 
 #include "openMVG/features/binary_regions.hpp"
+#include "openMVG/features/pq_regions.hpp"
+#include "openMVG/features/quantized_scalar_regions.hpp"
 #include "openMVG/features/scalar_regions.hpp"
 
 namespace openMVG {
@@ -25,6 +27,20 @@ using AKAZE_Liop_Regions = Scalar_Regions<SIOPointFeature, unsigned char, 144>;
 /// Define the AKAZE Keypoint (with a binary descriptor saved in an uchar array)
 using AKAZE_Binary_Regions = Binary_Regions<SIOPointFeature, 64>;
 
+//--
+// Compact descriptor storage (the descriptor files are the ones of the above regions)
+//--
+
+/// AKAZE float descriptors stored as unsigned char (4x less memory)
+using AKAZE_Float_Uchar_Regions = Quantized_Scalar_Regions<SIOPointFeature, float, unsigned char, 64>;
+/// AKAZE float descriptors stored as half float (2x less memory)
+using AKAZE_Float_Half_Regions = Quantized_Scalar_Regions<SIOPointFeature, float, Eigen::half, 64>;
+
+/// Product quantized descriptors (code size bytes per descriptor)
+using SIFT_PQ_Regions = PQ_Regions<SIOPointFeature, unsigned char, 128>;
+using AKAZE_Float_PQ_Regions = PQ_Regions<SIOPointFeature, float, 64>;
+using AKAZE_Liop_PQ_Regions = PQ_Regions<SIOPointFeature, unsigned char, 144>;
+
 } // namespace features
 } // namespace openMVG
 
@@ -32,5 +48,7 @@ EIGEN_DEFINE_STL_VECTOR_SPECIALIZATION_INITIALIZER_LIST(openMVG::features::SIFT_
 EIGEN_DEFINE_STL_VECTOR_SPECIALIZATION_INITIALIZER_LIST(openMVG::features::AKAZE_Float_Regions)
 EIGEN_DEFINE_STL_VECTOR_SPECIALIZATION_INITIALIZER_LIST(openMVG::features::AKAZE_Liop_Regions)
 EIGEN_DEFINE_STL_VECTOR_SPECIALIZATION_INITIALIZER_LIST(openMVG::features::AKAZE_Binary_Regions)
+EIGEN_DEFINE_STL_VECTOR_SPECIALIZATION_INITIALIZER_LIST(openMVG::features::AKAZE_Float_Uchar_Regions)
+EIGEN_DEFINE_STL_VECTOR_SPECIALIZATION_INITIALIZER_LIST(openMVG::features::AKAZE_Float_Half_Regions)
 
 #endif // OPENMVG_FEATURES_REGIONS_FACTORY_HPP
@@ -68,6 +68,19 @@ public:
     return loadFeatsFromFile(sfileNameFeats, vec_feats_);
   }
 
+  bool Load(
+    std::istream& streamFeats,
+    std::istream& streamDescs) override
+  {
+    return loadFeatsFromStream(streamFeats, vec_feats_)
+          & loadDescsFromBinStream(streamDescs, vec_descs_);
+  }
+
+  bool LoadFeatures(std::istream& streamFeats) override
+  {
+    return loadFeatsFromStream(streamFeats, vec_feats_);
+  }
+
   PointFeatures GetRegionsPositions() const override
   {
     return {vec_feats_.cbegin(), vec_feats_.cend()};
@@ -11,12 +11,16 @@
 
 #include <lemon/connectivity.h>
 #include <lemon/list_graph.h>
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
 #include <limits>
 #include <map>
 #include <set>
 #include <utility>
+#include <vector>
 
-#include "openMVG/graph/graph_builder.hpp"
+#include "openMVG/graph/csr_graph.hpp"
 #include "openMVG/tracks/union_find.hpp"
 #include "openMVG/types.hpp"
 
@@ -54,6 +58,164 @@ std::map<IndexT, std::set<lemon::ListGraph::Node>>  exportGraphToMapSubgraphs
   return map_subgraphs;
 }
 
+/**
+* @brief Compute the connected components of a graph (thanks to an union-find)
+* @param[in] graph Input graph
+* @param[out] node_components The connected component index of each node
+*   (dense node index)
+* @return The number of connected components
+* @note The connected components are indexed by descending largest node id,
+*   as lemon::connectedComponents does on an indexedGraph (its nodes are
+*   listed in reverse insertion order).
+*/
+inline std::size_t ConnectedComponents
+(
+  const CsrGraph & graph,
+  std::vector<uint32_t> & node_components
+)
+{
+  const std::size_t node_count = graph.NodeCount();
+
+  UnionFind uf;
+  uf.InitSets(node_count);
+  for (std::size_t node = 0; node < node_count; ++node)
+  {
+    for (const CsrGraph::NodeIndex neighbor : graph.Neighbors(node))
+    {
+      if (node < neighbor)
+        uf.Union(node, neighbor);
+    }
+  }
+
+  // Index the components from the node with the largest id
+  const uint32_t kUnlabeled = std::numeric_limits<uint32_t>::max();
+  std::vector<uint32_t> root_components(node_count, kUnlabeled);
+  node_components.resize(node_count);
+  uint32_t component_count = 0;
+  for (std::size_t node = node_count; node-- > 0; )
+  {
+    const unsigned int root = uf.Find(node);
+    if (root_components[root] == kUnlabeled)
+      root_components[root] = component_count++;
+    node_components[node] = root_components[root];
+  }
+  return component_count;
+}
+
+/**
+* @brief Remove the bridges (cut edges) of a graph. The connected components
+*  of the resulting graph are the bi-edge connected components of the graph.
+* The bridges are found thanks to an iterative Tarjan depth first search.
+* @param[in] graph Input graph
+* @param[out] bridge_count The number of removed edges (optional)
+* @return The graph without its bridges (the nodes are kept)
+*/
+inline CsrGraph RemoveBridges
+(
+  const CsrGraph & graph,
+  std::size_t * bridge_count = nullptr
+)
+{
+  using NodeIndex = CsrGraph::NodeIndex;
+  const std::size_t node_count = graph.NodeCount();
+  const NodeIndex kNoParent = std::numeric_limits<NodeIndex>::max();
+
+  // Discovery time (0 for unvisited nodes) and lowest reachable discovery time
+  std::vector<std::size_t> discovery(node_count, 0), low(node_count, 0);
+  std::vector<std::pair<NodeIndex, NodeIndex>> bridges;
+
+  struct DfsFrame
+  {
+    NodeIndex node;
+    NodeIndex parent;
+    std::size_t next_neighbor;
+  };
+  std::vector<DfsFrame> stack;
+  std::size_t time = 0;
+  for (std::size_t root = 0; root < node_count; ++root)
+  {
+    if (discovery[root] != 0)
+      continue;
+    discovery[root] = low[root] = ++time;
+    stack.push_back({static_cast<NodeIndex>(root), kNoParent, 0});
+    while (!stack.empty())
+    {
+      DfsFrame & frame = stack.back();
+      const CsrGraph::NodeRange neighbors = graph.Neighbors(frame.node);
+      if (frame.next_neighbor < neighbors.size())
+      {
+        const NodeIndex node = frame.node;
+        const NodeIndex neighbor = neighbors.begin()[frame.next_neighbor++];
+        if (neighbor == frame.parent) // There is no parallel edge
+          continue;
+        if (discovery[neighbor] == 0)
+        {
+          discovery[neighbor] = low[neighbor] = ++time;
+          stack.push_back({neighbor, node, 0});
+        }
+        else
+        {
+          low[node] = std::min(low[node], discovery[neighbor]);
+        }
+      }
+      else
+      {
+        const NodeIndex node = frame.node, parent = frame.parent;
+        stack.pop_back();
+        if (parent != kNoParent)
+        {
+          low[parent] = std::min(low[parent], low[node]);
+          // The subtree of node is only connected to parent through this edge
+          if (low[node] > discovery[parent])
+            bridges.emplace_back(std::min(node, parent), std::max(node, parent));
+        }
+      }
+    }
+  }
+  if (bridge_count)
+    *bridge_count = bridges.size();
+  if (bridges.empty())
+    return graph;
+
+  std::sort(bridges.begin(), bridges.end());
+  Pair_Vec kept_edges;
+  kept_edges.reserve(graph.EdgeCount() - bridges.size());
+  for (std::size_t node = 0; node < node_count; ++node)
+  {
+    for (const NodeIndex neighbor : graph.Neighbors(node))
+    {
+      if (node < neighbor &&
+          !std::binary_search(bridges.cbegin(), bridges.cend(),
+            std::make_pair(static_cast<NodeIndex>(node), neighbor)))
+      {
+        kept_edges.emplace_back(graph.NodeId(node), graph.NodeId(neighbor));
+      }
+    }
+  }
+  return CsrGraph(graph.NodeIds(), kept_edges);
+}
+
+/**
+* @brief Export the node ids of each CC (Connected Component) in a map
+* @param graph Input graph
+* @return Connected component of input graph (indexed as ConnectedComponents)
+*/
+inline std::map<IndexT, std::set<IndexT>> exportGraphToMapSubgraphs
+(
+  const CsrGraph & graph
+)
+{
+  std::vector<uint32_t> node_components;
+  ConnectedComponents(graph, node_components);
+
+  std::map<IndexT, std::set<IndexT>> map_subgraphs;
+  for (std::size_t node = 0; node < node_components.size(); ++node)
+  {
+    map_subgraphs[node_components[node]].insert(graph.NodeId(node));
+  }
+  return map_subgraphs;
+}
+
 /**
 * @brief Computes nodeIds that belongs to the largest bi-edge connected component
 * @param edges List of edges
@@ -69,45 +231,26 @@ std::set<IndexT> CleanGraph_KeepLargestBiEdge_Nodes
   // - remove not biedge connected component,
   // - keep the largest connected component.
 
-  graph::indexedGraph putativeGraph(edges);
-  using Graph = indexedGraph::GraphT;
-
   // Remove not bi-edge connected edges
-  using EdgeMapAlias = Graph::EdgeMap<bool>;
-  EdgeMapAlias cutMap( putativeGraph.g );
-
-  if ( lemon::biEdgeConnectedCutEdges( putativeGraph.g, cutMap ) > 0 )
-  {
-    // Some edges must be removed because they don't follow the biEdge condition.
-    using EdgeIterator = Graph::EdgeIt;
-    EdgeIterator itEdge( putativeGraph.g );
-    for ( EdgeMapAlias::MapIt it( cutMap ); it != lemon::INVALID; ++it, ++itEdge )
-    {
-      if ( *it )
-      {
-        putativeGraph.g.erase( itEdge );  // remove the not bi-edge element
-      }
-    }
-  }
+  const CsrGraph putativeGraph = RemoveBridges(CsrGraph(edges));
 
   // Graph is bi-edge connected, but still many connected components can exist
   // Keep only the nodes belonging to the largest Bi-edge component
   std::set<IndexT> largestBiEdgeCC;
 
-  const int connectedComponentCount = lemon::countConnectedComponents( putativeGraph.g );
+  const std::map<openMVG::IndexT, std::set<openMVG::IndexT>> map_subgraphs =
+    exportGraphToMapSubgraphs( putativeGraph );
   std::cout << "\n" << "CleanGraph_KeepLargestBiEdge_Nodes():: => connected Component: "
-            << connectedComponentCount << std::endl;
-  if ( connectedComponentCount >= 1 )
+            << map_subgraphs.size() << std::endl;
+  if ( !map_subgraphs.empty() )
   {
     // Keep only the largest connected component
     // - list all CC size
     // - export node that belong to the largest CC
 
-    const std::map<IndexT, std::set<Graph::Node> > map_subgraphs = exportGraphToMapSubgraphs<Graph, IndexT>( putativeGraph.g );
     size_t count = std::numeric_limits<size_t>::min();
-    typename std::map<IndexT, std::set<Graph::Node> >::const_iterator iterLargestCC = map_subgraphs.end();
-    for (typename std::map<IndexT, std::set<Graph::Node> >::const_iterator iter = map_subgraphs.begin();
-         iter != map_subgraphs.end(); ++iter )
+    auto iterLargestCC = map_subgraphs.cend();
+    for (auto iter = map_subgraphs.cbegin(); iter != map_subgraphs.cend(); ++iter )
     {
       if (iter->second.size() > count)
       {
@@ -118,14 +261,9 @@ std::set<IndexT> CleanGraph_KeepLargestBiEdge_Nodes
     }
 
     //-- Keep only the nodes that are in the largest CC
-    if (iterLargestCC != map_subgraphs.end())
+    if (iterLargestCC != map_subgraphs.cend())
     {
-      const std::set<lemon::ListGraph::Node> & ccSet = iterLargestCC->second;
-      for (const auto & iter2 : ccSet)
-      {
-        const IndexT Id = (*putativeGraph.node_map_id)[iter2];
-        largestBiEdgeCC.insert(Id);
-      }
+      largestBiEdgeCC.insert(iterLargestCC->second.cbegin(), iterLargestCC->second.cend());
     }
   }
 
@@ -10,6 +10,7 @@
 #include <chrono>
 #include <iostream>
 #include <random>
+#include <set>
 #include <vector>
 
 #include "CppUnitLite/TestHarness.h"
@@ -176,6 +177,77 @@ TEST(Subgraphs, CC_Subgraph_CC_count) {
   }
 }
 
+/// Compare the CsrGraph connected components and bridges to the lemon ones
+TEST(CsrGraph, CC_BiEdge_vs_lemon) {
+
+  using namespace openMVG;
+
+  std::mt19937 random_generator(std::mt19937::default_seed);
+  for (const double edge_probability : {0.01, 0.02, 0.05})
+  {
+    // Random sparse graph on non contiguous node ids
+    const int node_count = 200;
+    std::bernoulli_distribution edge_distribution(edge_probability);
+    Pair_Set pairs;
+    for (int i = 0; i < node_count; ++i)
+      for (int j = i + 1; j < node_count; ++j)
+        if (edge_distribution(random_generator))
+          pairs.insert({3 * i + 1, 3 * j + 1});
+
+    graph::indexedGraph lemon_graph(pairs);
+    const graph::CsrGraph csr_graph(pairs);
+    EXPECT_EQ(lemon::countNodes(lemon_graph.g), csr_graph.NodeCount());
+
+    // Connected components (and their indexes)
+    {
+      const auto lemon_subgraphs =
+        graph::exportGraphToMapSubgraphs<lemon::ListGraph, IndexT>(lemon_graph.g);
+      const auto csr_subgraphs = graph::exportGraphToMapSubgraphs(csr_graph);
+      EXPECT_EQ(lemon_subgraphs.size(), csr_subgraphs.size());
+      bool same_subgraphs = lemon_subgraphs.size() == csr_subgraphs.size();
+      for (const auto & subgraph : lemon_subgraphs)
+      {
+        std::set<IndexT> node_ids;
+        for (const auto & node : subgraph.second)
+          node_ids.insert((*lemon_graph.node_map_id)[node]);
+        same_subgraphs &= csr_subgraphs.count(subgraph.first) &&
+          csr_subgraphs.at(subgraph.first) == node_ids;
+      }
+      EXPECT_TRUE(same_subgraphs);
+    }
+
+    // Bridges
+    {
+      lemon::ListGraph::EdgeMap<bool> cutMap(lemon_graph.g);
+      const int lemon_bridge_count = lemon::biEdgeConnectedCutEdges(lemon_graph.g, cutMap);
+      std::size_t bridge_count = 0;
+      const graph::CsrGraph biedge_graph = graph::RemoveBridges(csr_graph, &bridge_count);
+      EXPECT_EQ(lemon_bridge_count, bridge_count);
+      EXPECT_EQ(csr_graph.NodeCount(), biedge_graph.NodeCount());
+      EXPECT_EQ(csr_graph.EdgeCount() - bridge_count, biedge_graph.EdgeCount());
+      EXPECT_EQ(lemon::countBiEdgeConnectedComponents(lemon_graph.g),
+        graph::exportGraphToMapSubgraphs(biedge_graph).size());
+    }
+  }
+}
+
+/// Test the nodes of the largest bi-edge connected component
+// 0-1-2-3  4-5-6  7-8
+// |/   |/
+// 9    10
+TEST(Subgraphs, KeepLargestBiEdge_Nodes) {
+
+  using namespace openMVG;
+
+  const Pair_Set pairs = {
+    {0, 1}, {1, 2}, {2, 3}, {0, 9}, {1, 9}, {2, 10}, {3, 10},
+    {4, 5}, {5, 6}, {7, 8}};
+  const std::set<IndexT> nodes =
+    graph::CleanGraph_KeepLargestBiEdge_Nodes<Pair_Set, IndexT>(pairs);
+  // Both triangles have the same size, the one with the largest id is kept
+  EXPECT_TRUE((std::set<IndexT>{2, 3, 10}) == nodes);
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
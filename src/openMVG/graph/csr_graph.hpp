@@ -0,0 +1,234 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_GRAPH_CSR_GRAPH_HPP
+#define OPENMVG_GRAPH_CSR_GRAPH_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "openMVG/types.hpp"
+
+namespace openMVG
+{
+namespace graph
+{
+
+namespace internal
+{
+/// Edge of an iterable pair container (i.e. Pair_Set, std::vector<Pair>)
+template <typename T>
+inline std::pair<IndexT, IndexT> EdgeOf( const std::pair<T, T> & pair )
+{
+  return {static_cast<IndexT>(pair.first), static_cast<IndexT>(pair.second)};
+}
+
+/// Edge of a container indexed by pair (i.e. PairWiseMatches)
+template <typename T>
+inline std::pair<IndexT, IndexT> EdgeOf( const std::pair<const Pair, T> & pair_it )
+{
+  return pair_it.first;
+}
+} // namespace internal
+
+/**
+* @brief Compact undirected graph stored as a compressed sparse row (CSR)
+*  adjacency:
+*  - the node ids are remapped to dense indexes [0, NodeCount()[ (the dense
+*    index order is the ascending node id order),
+*  - the neighbors of a node are stored contiguously and sorted by ascending
+*    dense index.
+* Duplicated edges (in any direction) and self loops are discarded.
+*/
+class CsrGraph
+{
+public:
+  /// Dense node index
+  using NodeIndex = uint32_t;
+
+  /// Contiguous range of dense node indexes
+  struct NodeRange
+  {
+    const NodeIndex * begin() const { return begin_; }
+    const NodeIndex * end() const { return end_; }
+    std::size_t size() const { return end_ - begin_; }
+    bool empty() const { return begin_ == end_; }
+
+    const NodeIndex * begin_;
+    const NodeIndex * end_;
+  };
+
+  CsrGraph() : offsets_(1, 0) {}
+
+  /**
+  * @brief Build the graph from a list of edges
+  * @param pairs A container of pairs (i.e. Pair_Set) or a container indexed
+  *   by pairs (i.e. PairWiseMatches)
+  */
+  template <typename IterablePairs>
+  explicit CsrGraph( const IterablePairs & pairs )
+  {
+    std::vector<std::pair<IndexT, IndexT>> edges;
+    for (const auto & pair_it : pairs)
+    {
+      const std::pair<IndexT, IndexT> edge = internal::EdgeOf( pair_it );
+      if (edge.first != edge.second)
+        edges.emplace_back(std::min(edge.first, edge.second),
+                           std::max(edge.first, edge.second));
+    }
+    Build( edges );
+  }
+
+  /**
+  * @brief Build the graph from the node ids and a list of edges
+  * @param nodes The node ids (isolated nodes are kept)
+  * @param pairs The edges (their nodes must belong to nodes)
+  */
+  template <typename IterableNodes, typename IterablePairs>
+  CsrGraph( const IterableNodes & nodes, const IterablePairs & pairs )
+  {
+    node_ids_.assign(nodes.begin(), nodes.end());
+    std::sort(node_ids_.begin(), node_ids_.end());
+    node_ids_.erase(std::unique(node_ids_.begin(), node_ids_.end()), node_ids_.end());
+
+    std::vector<std::pair<IndexT, IndexT>> edges;
+    for (const auto & pair_it : pairs)
+    {
+      const std::pair<IndexT, IndexT> edge = internal::EdgeOf( pair_it );
+      if (edge.first != edge.second)
+        edges.emplace_back(std::min(edge.first, edge.second),
+                           std::max(edge.first, edge.second));
+    }
+    Build( edges, false );
+  }
+
+  /// Number of nodes
+  std::size_t NodeCount() const { return node_ids_.size(); }
+
+  /// Number of (undirected) edges
+  std::size_t EdgeCount() const { return neighbors_.size() / 2; }
+
+  /// Node id of a dense node index
+  IndexT NodeId( NodeIndex node ) const { return node_ids_[node]; }
+
+  /// The node ids (sorted)
+  const std::vector<IndexT> & NodeIds() const { return node_ids_; }
+
+  /**
+  * @brief Dense node index of a node id
+  * @param[in] node_id The node id
+  * @param[out] node The dense node index
+  * @return true if the node id belongs to the graph
+  */
+  bool FindNode( IndexT node_id, NodeIndex & node ) const
+  {
+    const auto it = std::lower_bound(node_ids_.cbegin(), node_ids_.cend(), node_id);
+    if (it == node_ids_.cend() || *it != node_id)
+      return false;
+    node = static_cast<NodeIndex>(it - node_ids_.cbegin());
+    return true;
+  }
+
+  /// Number of neighbors of a node
+  std::size_t Degree( NodeIndex node ) const
+  {
+    return offsets_[node + 1] - offsets_[node];
+  }
+
+  /// The sorted neighbors of a node
+  NodeRange Neighbors( NodeIndex node ) const
+  {
+    return {neighbors_.data() + offsets_[node], neighbors_.data() + offsets_[node + 1]};
+  }
+
+  /// Return true if the two nodes are connected (logarithmic complexity)
+  bool HasEdge( NodeIndex node1, NodeIndex node2 ) const
+  {
+    const NodeRange range = Neighbors( node1 );
+    return std::binary_search(range.begin(), range.end(), node2);
+  }
+
+private:
+
+  /// Build the CSR arrays from the (min, max) node id edges
+  void Build
+  (
+    std::vector<std::pair<IndexT, IndexT>> & edges,
+    bool list_nodes = true
+  )
+  {
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    if (list_nodes)
+    {
+      node_ids_.clear();
+      node_ids_.reserve(edges.size() * 2);
+      for (const auto & edge : edges)
+      {
+        node_ids_.push_back(edge.first);
+        node_ids_.push_back(edge.second);
+      }
+      std::sort(node_ids_.begin(), node_ids_.end());
+      node_ids_.erase(std::unique(node_ids_.begin(), node_ids_.end()), node_ids_.end());
+      node_ids_.shrink_to_fit();
+    }
+
+    // Remap the edges to the dense node indexes and count the degrees.
+    // Use a lookup table if the node ids are almost contiguous.
+    std::vector<NodeIndex> lookup_table;
+    if (!node_ids_.empty() && node_ids_.back() < 4 * node_ids_.size() + 1024)
+    {
+      lookup_table.resize(node_ids_.back() + 1);
+      for (std::size_t node = 0; node < node_ids_.size(); ++node)
+        lookup_table[node_ids_[node]] = static_cast<NodeIndex>(node);
+    }
+    const auto dense_index = [this, &lookup_table]( IndexT node_id )
+    {
+      if (!lookup_table.empty())
+        return lookup_table[node_id];
+      return static_cast<NodeIndex>(
+        std::lower_bound(node_ids_.cbegin(), node_ids_.cend(), node_id)
+        - node_ids_.cbegin());
+    };
+    offsets_.assign(node_ids_.size() + 1, 0);
+    for (auto & edge : edges)
+    {
+      edge = {dense_index(edge.first), dense_index(edge.second)};
+      ++offsets_[edge.first + 1];
+      ++offsets_[edge.second + 1];
+    }
+    for (std::size_t i = 1; i < offsets_.size(); ++i)
+      offsets_[i] += offsets_[i - 1];
+
+    // Since the edges are sorted, filling the adjacency of both edge nodes
+    //  in the edge order yields sorted neighbor lists:
+    //  - the (u, node) edges come first, sorted by u < node,
+    //  - then the (node, v) edges, sorted by v > node.
+    neighbors_.resize(offsets_.back());
+    std::vector<std::size_t> cursors(offsets_.cbegin(), offsets_.cend() - 1);
+    for (const auto & edge : edges)
+    {
+      neighbors_[cursors[edge.first]++] = edge.second;
+      neighbors_[cursors[edge.second]++] = edge.first;
+    }
+  }
+
+  /// Node ids of the dense node indexes
+  std::vector<IndexT> node_ids_;
+  /// Neighbors of the node n are in [offsets_[n], offsets_[n+1][
+  std::vector<std::size_t> offsets_;
+  std::vector<NodeIndex> neighbors_;
+};
+
+} // namespace graph
+} // namespace openMVG
+
+#endif // OPENMVG_GRAPH_CSR_GRAPH_HPP
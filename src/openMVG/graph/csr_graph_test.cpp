@@ -0,0 +1,85 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/graph/csr_graph.hpp"
+#include "openMVG/matching/indMatch.hpp"
+
+#include "CppUnitLite/TestHarness.h"
+#include "testing/testing.h"
+
+#include <vector>
+
+using namespace openMVG;
+using namespace openMVG::graph;
+
+TEST(CsrGraph, Empty) {
+  const CsrGraph graph;
+  EXPECT_EQ(0, graph.NodeCount());
+  EXPECT_EQ(0, graph.EdgeCount());
+
+  const CsrGraph graph_from_pairs((Pair_Set()));
+  EXPECT_EQ(0, graph_from_pairs.NodeCount());
+  EXPECT_EQ(0, graph_from_pairs.EdgeCount());
+}
+
+TEST(CsrGraph, Pairs) {
+  // Duplicated edges (in both directions) and self loops are discarded
+  const std::vector<std::pair<int, int>> pairs =
+    {{10, 2}, {2, 10}, {10, 7}, {7, 7}, {2, 7}, {7, 40}, {10, 2}};
+  const CsrGraph graph(pairs);
+
+  EXPECT_EQ(4, graph.NodeCount());
+  EXPECT_EQ(4, graph.EdgeCount());
+  // Dense indexes follow the ascending node ids
+  EXPECT_EQ(2, graph.NodeId(0));
+  EXPECT_EQ(7, graph.NodeId(1));
+  EXPECT_EQ(10, graph.NodeId(2));
+  EXPECT_EQ(40, graph.NodeId(3));
+
+  CsrGraph::NodeIndex node;
+  EXPECT_TRUE(graph.FindNode(7, node));
+  EXPECT_EQ(1, node);
+  EXPECT_FALSE(graph.FindNode(8, node));
+
+  // Sorted neighbors
+  const std::vector<CsrGraph::NodeIndex> neighbors(
+    graph.Neighbors(1).begin(), graph.Neighbors(1).end());
+  EXPECT_EQ(3, graph.Degree(1));
+  EXPECT_TRUE((std::vector<CsrGraph::NodeIndex>{0, 2, 3}) == neighbors);
+  EXPECT_EQ(1, graph.Degree(3));
+  EXPECT_TRUE(graph.HasEdge(0, 2));
+  EXPECT_TRUE(graph.HasEdge(2, 0));
+  EXPECT_FALSE(graph.HasEdge(0, 3));
+}
+
+TEST(CsrGraph, PairWiseMatches) {
+  matching::PairWiseMatches matches;
+  matches[{0, 1}] = {{0, 0}};
+  matches[{1, 2}] = {{0, 0}, {1, 1}};
+  matches[{5, 2}] = {{0, 0}};
+
+  const CsrGraph graph(matches);
+  EXPECT_EQ(4, graph.NodeCount());
+  EXPECT_EQ(3, graph.EdgeCount());
+  EXPECT_TRUE(graph.HasEdge(2, 3)); // (2, 5)
+}
+
+TEST(CsrGraph, IsolatedNodes) {
+  const std::vector<IndexT> nodes = {0, 1, 2, 3};
+  const Pair_Set pairs = {{0, 2}};
+  const CsrGraph graph(nodes, pairs);
+  EXPECT_EQ(4, graph.NodeCount());
+  EXPECT_EQ(1, graph.EdgeCount());
+  EXPECT_EQ(0, graph.Degree(1));
+  EXPECT_TRUE(graph.Neighbors(3).empty());
+  EXPECT_TRUE(graph.HasEdge(2, 0));
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
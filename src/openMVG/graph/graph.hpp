@@ -13,6 +13,7 @@
 #include <lemon/list_graph.h>
 
 #include "openMVG/graph/connectedComponent.hpp"
+#include "openMVG/graph/csr_graph.hpp"
 #include "openMVG/graph/graph_builder.hpp"
 #include "openMVG/graph/graph_graphviz_export.hpp"
 #include "openMVG/graph/triplet_finder.hpp"
@@ -21,6 +21,8 @@
 #include "TargetConditionals.h"
 #endif
 
+#include "openMVG/graph/csr_graph.hpp"
+#include "openMVG/graph/graph_builder.hpp"
 #include "openMVG/types.hpp"
 
 namespace openMVG {
@@ -59,6 +61,42 @@ inline bool exportToGraphvizFormat_Nodal
       << " n" << (*graph.node_map_id)[graph.g.v(e)] << '\n';
   }
 
+  os << "}" << std::endl;
+  return os.good();
+}
+
+    /**
+    * @brief Export an Image connection graph
+    *   to graphviz file format.
+    * @param g Graph to export
+    * @param os stream where graph is exported
+    * @retval true If export is correct
+    * @retval false If export is incorrect
+    */
+inline bool exportToGraphvizFormat_Nodal
+(
+  const CsrGraph & graph,
+  std::ostream & os
+)
+{
+  os << "graph 1 {" << std::endl;
+  os << "node [shape=circle]" << std::endl;
+
+  //-- Export graph edges (just a link between the nodes)
+  for (std::size_t node = 0; node < graph.NodeCount(); ++node)
+  {
+    for (const CsrGraph::NodeIndex neighbor : graph.Neighbors(node))
+    {
+      if (node < neighbor)
+      {
+        os
+          << " n" << graph.NodeId(node)
+          << " -- "
+          << " n" << graph.NodeId(neighbor) << '\n';
+      }
+    }
+  }
+
   os << "}" << std::endl;
   return os.good();
 }
@@ -66,12 +104,13 @@ inline bool exportToGraphvizFormat_Nodal
   /**
   * @brief Export a graph and generate it using graphviz
   * @param sfile File in which graph is exported
-  * @param graph Graph to export
+  * @param graph Graph to export (indexedGraph or CsrGraph)
   */
+template <typename GraphT>
 inline void exportToGraphvizData
 (
   const std::string& sfile,
-  const indexedGraph & graph
+  const GraphT & graph
 )
 {
   // Export the graph as a DOT (graph description language) file
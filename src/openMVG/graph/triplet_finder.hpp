@@ -11,12 +11,12 @@
 
 #include <algorithm>
 #include <array>
+#include <cstdint>
 #include <ostream>
-#include <set>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "openMVG/graph/csr_graph.hpp"
 #include "openMVG/types.hpp"
 
 namespace openMVG
@@ -97,69 +97,157 @@ struct Triplet
 };
 
 /**
-* @brief Return triplets contained in the graph build from IterablePairs
-* @param[in] pairs A list of pairs
-* @param[out] triplets List of triplet found in graph
+* @brief Return the triplets (triangles) contained in a graph
+* @param[in] graph The graph
+* @param[out] triplets List of triplet found in graph, sorted by ascending
+*   (i, j, k) node ids (with i < j < k)
 * @return boolean return true if some triplet are found
+*
+* The edges are oriented from the lower to the higher (degree, index) node.
+* Each triangle is then listed once from its lowest node u by merging the
+* sorted oriented neighbors of u and of its oriented neighbors v.
+* Since the oriented degrees are bounded by sqrt(2 * #edges), the complexity
+* is O(#edges^1.5). The nodes are processed in parallel.
 **/
-template <typename IterablePairs, class TTripletContainer>
+template <class TTripletContainer>
 bool ListTriplets
 (
-  const IterablePairs & pairs,
+  const CsrGraph & graph,
   TTripletContainer & triplets
 )
 {
+  using NodeIndex = CsrGraph::NodeIndex;
   triplets.clear();
 
-  // Build an adjacency list corresponding to the edge list
-  std::unordered_map<IndexT, std::set<IndexT>> adjacency_list;
-  for (const auto & edge : pairs)
+  // Rank the nodes by ascending degree
+  const std::size_t node_count = graph.NodeCount();
+  std::vector<NodeIndex> node_order(node_count);
+  for (std::size_t node = 0; node < node_count; ++node)
+    node_order[node] = static_cast<NodeIndex>(node);
+  std::sort(node_order.begin(), node_order.end(),
+    [&graph](NodeIndex a, NodeIndex b)
+    {
+      const std::size_t degree_a = graph.Degree(a), degree_b = graph.Degree(b);
+      return degree_a < degree_b || (degree_a == degree_b && a < b);
+    });
+  std::vector<NodeIndex> node_rank(node_count);
+  for (std::size_t rank = 0; rank < node_count; ++rank)
+    node_rank[node_order[rank]] = static_cast<NodeIndex>(rank);
+
+  // Oriented adjacency: the higher rank neighbors (sorted by node index)
+  std::vector<std::size_t> offsets(node_count + 1, 0);
+  std::vector<NodeIndex> neighbors;
+  neighbors.reserve(graph.EdgeCount());
+  for (std::size_t node = 0; node < node_count; ++node)
   {
-    adjacency_list[edge.first].insert(edge.second);
-    adjacency_list[edge.second].insert(edge.first);
+    for (const NodeIndex neighbor : graph.Neighbors(node))
+    {
+      if (node_rank[neighbor] > node_rank[node])
+        neighbors.push_back(neighbor);
+    }
+    offsets[node + 1] = neighbors.size();
   }
 
-  std::vector<IndexT> node_candidate_for_triplet;
-
-  // List the pair and find all triplets thanks to the adjacency list
-  for (const auto & edge_it : pairs)
+  // List the triangles (as sorted dense node indexes)
+  std::vector<std::array<NodeIndex, 3>> triangles;
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel
+#endif
   {
-    // Find any targeting edge that contains the first and the second node index
-    const auto & node1_edges = adjacency_list.find(edge_it.first)->second;
-    const auto & node2_edges = adjacency_list.find(edge_it.second)->second;
-
-    // Compute the intersection between the two adjacency lists to find
-    //  triplets (it will list the nodes that are connected to the first and
-    //  second)
-    node_candidate_for_triplet.clear();
-    std::set_intersection(node1_edges.cbegin(),
-                          node1_edges.cend(),
-                          node2_edges.cbegin(),
-                          node2_edges.cend(),
-                          std::back_inserter(node_candidate_for_triplet));
-    // Add a triplet
-    for (const auto & node_index_it : node_candidate_for_triplet)
+    std::vector<std::array<NodeIndex, 3>> local_triangles;
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp for schedule(dynamic, 64)
+#endif
+    for (int u = 0; u < static_cast<int>(node_count); ++u)
     {
-      std::array<IndexT, 3> triplet_indexes {{
-        static_cast<IndexT>(edge_it.first),
-        static_cast<IndexT>(edge_it.second),
-        node_index_it}};
-      // sort the triplet indexes as i<j<k (monotonic ascending sorting)
-      std::sort(triplet_indexes.begin(), triplet_indexes.end());
-      triplets.emplace_back(triplet_indexes[0],
-                            triplet_indexes[1],
-                            triplet_indexes[2]);
+      const NodeIndex * u_begin = neighbors.data() + offsets[u];
+      const NodeIndex * u_end = neighbors.data() + offsets[u + 1];
+      for (const NodeIndex * v_it = u_begin; v_it != u_end; ++v_it)
+      {
+        // Merge the sorted oriented neighbors of u and v
+        const NodeIndex * it_u = u_begin;
+        const NodeIndex * it_v = neighbors.data() + offsets[*v_it];
+        const NodeIndex * v_end = neighbors.data() + offsets[*v_it + 1];
+        while (it_u != u_end && it_v != v_end)
+        {
+          if (*it_u < *it_v)
+            ++it_u;
+          else if (*it_v < *it_u)
+            ++it_v;
+          else
+          {
+            std::array<NodeIndex, 3> triangle {{
+              static_cast<NodeIndex>(u), *v_it, *it_u}};
+            std::sort(triangle.begin(), triangle.end());
+            local_triangles.push_back(triangle);
+            ++it_u;
+            ++it_v;
+          }
+        }
+      }
     }
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp critical
+#endif
+    triangles.insert(triangles.end(), local_triangles.cbegin(), local_triangles.cend());
+  }
+
+  // Sort the triplets, the listing does not depend on the thread count:
+  //  bucket the triangles by their first node, then sort the buckets.
+  std::vector<std::size_t> bucket_offsets(node_count + 1, 0);
+  for (const auto & triangle : triangles)
+    ++bucket_offsets[triangle[0] + 1];
+  for (std::size_t node = 0; node < node_count; ++node)
+    bucket_offsets[node + 1] += bucket_offsets[node];
+  std::vector<uint64_t> bucket_keys(triangles.size());
+  {
+    std::vector<std::size_t> cursors(bucket_offsets.cbegin(), bucket_offsets.cend() - 1);
+    for (const auto & triangle : triangles)
+      bucket_keys[cursors[triangle[0]]++] =
+        (static_cast<uint64_t>(triangle[1]) << 32) | triangle[2];
+  }
+  triangles.clear();
+  triangles.shrink_to_fit();
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for schedule(dynamic, 64)
+#endif
+  for (int node = 0; node < static_cast<int>(node_count); ++node)
+  {
+    std::sort(bucket_keys.begin() + bucket_offsets[node],
+              bucket_keys.begin() + bucket_offsets[node + 1]);
+  }
 
-    // Since we have already listed all the triplets than contain this edge.
-    // We can now remove the edge from the adjacency graph to reduce the
-    // node array size for the next iterations.
-    adjacency_list[edge_it.first].erase(edge_it.second);
-    adjacency_list[edge_it.second].erase(edge_it.first);
+  triplets.reserve(bucket_keys.size());
+  for (std::size_t node = 0; node < node_count; ++node)
+  {
+    for (std::size_t key = bucket_offsets[node]; key < bucket_offsets[node + 1]; ++key)
+    {
+      triplets.emplace_back(
+        graph.NodeId(node),
+        graph.NodeId(static_cast<NodeIndex>(bucket_keys[key] >> 32)),
+        graph.NodeId(static_cast<NodeIndex>(bucket_keys[key] & 0xFFFFFFFF)));
+    }
   }
   return ( !triplets.empty() );
 }
 
+/**
+* @brief Return triplets contained in the graph build from IterablePairs
+* @param[in] pairs A list of pairs (i.e. Pair_Set) or a container indexed by
+*   pairs (i.e. PairWiseMatches)
+* @param[out] triplets List of triplet found in graph
+* @return boolean return true if some triplet are found
+**/
+template <typename IterablePairs, class TTripletContainer>
+bool ListTriplets
+(
+  const IterablePairs & pairs,
+  TTripletContainer & triplets
+)
+{
+  return ListTriplets( CsrGraph( pairs ), triplets );
+}
+
 /**
 * @brief Return triplets contained in the graph build from IterablePairs
 * @param pairs Graph pairs
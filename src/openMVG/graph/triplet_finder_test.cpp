@@ -12,6 +12,8 @@
 #include "testing/testing.h"
 
 #include <iostream>
+#include <random>
+#include <set>
 #include <vector>
 
 using namespace openMVG::graph;
@@ -187,6 +189,44 @@ TEST(TripletFinder, test_for_triplet) {
   }
 }
 
+TEST(TripletFinder, random_graph) {
+
+  // Compare the triplet listing to a brute force enumeration
+  std::mt19937 random_generator(std::mt19937::default_seed);
+  const int node_count = 60;
+  std::bernoulli_distribution edge_distribution(0.2);
+  std::set<std::pair<int,int>> edges;
+  Pairs pairs;
+  for (int i = 0; i < node_count; ++i)
+    for (int j = i + 1; j < node_count; ++j)
+      if (edge_distribution(random_generator))
+      {
+        edges.insert({i, j});
+        // Use both edge directions
+        pairs.emplace_back((i + j) % 2 ? std::make_pair(i, j) : std::make_pair(j, i));
+      }
+
+  std::vector<Triplet> expected_triplets;
+  for (int i = 0; i < node_count; ++i)
+    for (int j = i + 1; j < node_count; ++j)
+      for (int k = j + 1; k < node_count; ++k)
+        if (edges.count({i, j}) && edges.count({i, k}) && edges.count({j, k}))
+          expected_triplets.emplace_back(i, j, k);
+
+  std::vector<Triplet> vec_triplets;
+  EXPECT_TRUE(ListTriplets(pairs, vec_triplets));
+  EXPECT_EQ(expected_triplets.size(), vec_triplets.size());
+  // The triplets are sorted
+  bool same_triplets = expected_triplets.size() == vec_triplets.size();
+  for (size_t i = 0; same_triplets && i < vec_triplets.size(); ++i)
+  {
+    same_triplets = vec_triplets[i].i == expected_triplets[i].i
+      && vec_triplets[i].j == expected_triplets[i].j
+      && vec_triplets[i].k == expected_triplets[i].k;
+  }
+  EXPECT_TRUE(same_triplets);
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
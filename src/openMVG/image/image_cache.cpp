@@ -0,0 +1,234 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/image/image_cache.hpp"
+#include "openMVG/image/image_io.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace openMVG
+{
+namespace image
+{
+
+ImageCache::ImageCache( std::size_t byte_budget )
+  : budget_( byte_budget )
+{
+}
+
+ImageCache::Native ImageCache::Acquire( const std::string & path )
+{
+  std::unique_lock<std::mutex> lock( mutex_ );
+  auto it = entries_.find( path );
+  if ( it != entries_.end() )
+  {
+    // Cached or in-flight image: wait for its decoding (if required)
+    Entry & entry = it->second;
+    lru_.splice( lru_.begin(), lru_, entry.lru_it );
+    const std::shared_future<Native> native = entry.native;
+    lock.unlock();
+    return native.get();
+  }
+
+  // Register the in-flight decoding, so concurrent requests wait for it
+  std::promise<Native> promise;
+  Entry & entry = entries_[path];
+  entry.native = promise.get_future().share();
+  lru_.push_front( path );
+  entry.lru_it = lru_.begin();
+  ++decode_count_;
+  lock.unlock();
+
+  std::size_t bytes = 0;
+  const Native native = Decode( path, &bytes );
+  promise.set_value( native );
+
+  // The in-flight entries are never erased, so the entry is still valid
+  lock.lock();
+  if ( native.depth == 0 )
+  {
+    // Failed read: not cached, the next requests read the file again
+    lru_.erase( entry.lru_it );
+    entries_.erase( path );
+    return native;
+  }
+  entry.ready = true;
+  entry.bytes = bytes;
+  bytes_ += bytes;
+  Evict();
+  return native;
+}
+
+std::shared_ptr<const void> ImageCache::FindConverted
+(
+  const std::string & path,
+  const std::type_index & type
+) const
+{
+  std::lock_guard<std::mutex> lock( mutex_ );
+  const auto it = entries_.find( path );
+  if ( it == entries_.end() )
+  {
+    return nullptr;
+  }
+  const auto converted_it = it->second.converted.find( type );
+  return converted_it != it->second.converted.end() ? converted_it->second : nullptr;
+}
+
+std::shared_ptr<const void> ImageCache::StoreConverted
+(
+  const std::string & path,
+  const std::type_index & type,
+  const std::shared_ptr<const void> & image,
+  std::size_t bytes
+)
+{
+  std::lock_guard<std::mutex> lock( mutex_ );
+  const auto it = entries_.find( path );
+  if ( it == entries_.end() || !it->second.ready )
+  {
+    // The image has been released meanwhile: do not cache its conversion
+    return image;
+  }
+  Entry & entry = it->second;
+  const auto converted_it = entry.converted.find( type );
+  if ( converted_it != entry.converted.end() )
+  {
+    return converted_it->second;
+  }
+  entry.converted[type] = image;
+  entry.bytes += bytes;
+  bytes_ += bytes;
+  Evict();
+  return image;
+}
+
+template <typename T>
+static std::shared_ptr<const void> RawToSharedImage
+(
+  std::vector<unsigned char> & ptr,
+  int w,
+  int h,
+  int depth,
+  std::size_t * bytes
+)
+{
+  std::shared_ptr<Image<T>> im = std::make_shared<Image<T>>();
+  if ( !RawToImage( ptr, w, h, depth, im.get() ) )
+  {
+    return nullptr;
+  }
+  *bytes = static_cast<std::size_t>( w ) * h * sizeof( T );
+  return im;
+}
+
+ImageCache::Native ImageCache::Decode
+(
+  const std::string & path,
+  std::size_t * bytes
+)
+{
+  Native native;
+  std::vector<unsigned char> ptr;
+  int w, h, depth;
+  if ( !ReadImage( path.c_str(), &ptr, &w, &h, &depth ) )
+  {
+    return native;
+  }
+  switch ( depth )
+  {
+    case 1:
+      native.image = RawToSharedImage<unsigned char>( ptr, w, h, depth, bytes );
+      break;
+    case 3:
+      native.image = RawToSharedImage<RGBColor>( ptr, w, h, depth, bytes );
+      break;
+    case 4:
+      native.image = RawToSharedImage<RGBAColor>( ptr, w, h, depth, bytes );
+      break;
+  }
+  if ( native.image )
+  {
+    native.depth = depth;
+  }
+  return native;
+}
+
+void ImageCache::Evict()
+{
+  auto it = lru_.end();
+  while ( bytes_ > budget_ && it != lru_.begin() )
+  {
+    --it;
+    const auto entry_it = entries_.find( *it );
+    const Entry & entry = entry_it->second;
+    // Keep the in-flight images and the images referenced by a handle
+    if ( !entry.ready ||
+         entry.native.get().image.use_count() > 1 ||
+         std::any_of( entry.converted.cbegin(), entry.converted.cend(),
+           []( const std::pair<const std::type_index, std::shared_ptr<const void>> & converted )
+           { return converted.second.use_count() > 1; } ) )
+    {
+      continue;
+    }
+    bytes_ -= entry.bytes;
+    entries_.erase( entry_it );
+    it = lru_.erase( it );
+  }
+}
+
+void ImageCache::Erase( const std::string & path )
+{
+  std::lock_guard<std::mutex> lock( mutex_ );
+  const auto it = entries_.find( path );
+  if ( it != entries_.end() && it->second.ready )
+  {
+    bytes_ -= it->second.bytes;
+    lru_.erase( it->second.lru_it );
+    entries_.erase( it );
+  }
+}
+
+void ImageCache::Clear()
+{
+  std::lock_guard<std::mutex> lock( mutex_ );
+  for ( auto it = entries_.begin(); it != entries_.end(); )
+  {
+    if ( it->second.ready )
+    {
+      bytes_ -= it->second.bytes;
+      lru_.erase( it->second.lru_it );
+      it = entries_.erase( it );
+    }
+    else
+    {
+      ++it;
+    }
+  }
+}
+
+std::size_t ImageCache::Budget() const
+{
+  return budget_;
+}
+
+std::size_t ImageCache::MemoryUsage() const
+{
+  std::lock_guard<std::mutex> lock( mutex_ );
+  return bytes_;
+}
+
+std::size_t ImageCache::DecodeCount() const
+{
+  std::lock_guard<std::mutex> lock( mutex_ );
+  return decode_count_;
+}
+
+} // namespace image
+} // namespace openMVG
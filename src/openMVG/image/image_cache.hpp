@@ -0,0 +1,231 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_IMAGE_IMAGE_CACHE_HPP
+#define OPENMVG_IMAGE_IMAGE_CACHE_HPP
+
+#include "openMVG/image/image_container.hpp"
+#include "openMVG/image/image_converter.hpp"
+#include "openMVG/image/pixel_types.hpp"
+
+#include <cstddef>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeindex>
+#include <typeinfo>
+
+namespace openMVG
+{
+namespace image
+{
+
+namespace internal
+{
+
+/**
+* @brief Conversion of a cached image to the requested pixel type
+* (same rules as ReadImage: no conversion from a lower channel count)
+*/
+template <typename From, typename To>
+struct CachedImageConversion
+{
+  static std::shared_ptr<const Image<To>> run( const std::shared_ptr<const Image<From>> & )
+  {
+    return nullptr;
+  }
+};
+
+template <typename T>
+struct CachedImageConversion<T, T>
+{
+  static std::shared_ptr<const Image<T>> run( const std::shared_ptr<const Image<T>> & im )
+  {
+    return im;
+  }
+};
+
+template <>
+struct CachedImageConversion<unsigned char, unsigned char>
+{
+  static std::shared_ptr<const Image<unsigned char>> run( const std::shared_ptr<const Image<unsigned char>> & im )
+  {
+    return im;
+  }
+};
+
+template <typename From>
+struct CachedImageConversion<From, unsigned char>
+{
+  static std::shared_ptr<const Image<unsigned char>> run( const std::shared_ptr<const Image<From>> & im )
+  {
+    std::shared_ptr<Image<unsigned char>> out = std::make_shared<Image<unsigned char>>();
+    ConvertPixelType( *im, out.get() );
+    return out;
+  }
+};
+
+template <>
+struct CachedImageConversion<RGBAColor, RGBColor>
+{
+  static std::shared_ptr<const Image<RGBColor>> run( const std::shared_ptr<const Image<RGBAColor>> & im )
+  {
+    std::shared_ptr<Image<RGBColor>> out = std::make_shared<Image<RGBColor>>();
+    ConvertPixelType( *im, out.get() );
+    return out;
+  }
+};
+
+} // namespace internal
+
+/**
+* @brief Process wide store of decoded images
+*
+* - An image file is decoded once, in its native pixel type (gray, RGB or RGBA),
+*   and the other pixel types are converted from the decoded image. The
+*   converted images are cached along the decoded one (converted once).
+* - The images are shared through reference counted handles (std::shared_ptr).
+* - Concurrent requests of the same file wait for the in-flight decoding
+*   instead of decoding it again. The failed reads are not cached.
+* - When the decoded images exceed the byte budget, the least recently used
+*   images that are not referenced by a handle anymore are released.
+*/
+class ImageCache
+{
+  public:
+
+    /**
+    * @brief Constructor
+    * @param byte_budget Memory budget (in bytes) of the decoded images
+    */
+    explicit ImageCache( std::size_t byte_budget = std::size_t( 1 ) << 30 );
+
+    /**
+    * @brief Get the image of a file (decode it if it is not cached)
+    * @param path Image file path
+    * @return The image, or nullptr if the file cannot be read in the requested
+    *  pixel type (same rules as ReadImage)
+    */
+    template <typename T>
+    std::shared_ptr<const Image<T>> Get( const std::string & path )
+    {
+      const Native native = Acquire( path );
+      const std::type_index type( typeid( T ) );
+      const std::shared_ptr<const void> converted = FindConverted( path, type );
+      if ( converted )
+      {
+        return std::static_pointer_cast<const Image<T>>( converted );
+      }
+
+      std::shared_ptr<const Image<T>> image;
+      switch ( native.depth )
+      {
+        case 1:
+          image = internal::CachedImageConversion<unsigned char, T>::run(
+            std::static_pointer_cast<const Image<unsigned char>>( native.image ) );
+          break;
+        case 3:
+          image = internal::CachedImageConversion<RGBColor, T>::run(
+            std::static_pointer_cast<const Image<RGBColor>>( native.image ) );
+          break;
+        case 4:
+          image = internal::CachedImageConversion<RGBAColor, T>::run(
+            std::static_pointer_cast<const Image<RGBAColor>>( native.image ) );
+          break;
+      }
+      if ( image && static_cast<const void *>( image.get() ) != native.image.get() )
+      {
+        // Keep the converted image (or the one stored concurrently)
+        image = std::static_pointer_cast<const Image<T>>( StoreConverted(
+          path, type, image,
+          static_cast<std::size_t>( image->Width() ) * image->Height() * sizeof( T ) ) );
+      }
+      return image;
+    }
+
+    /**
+    * @brief Release the image of a file (the existing handles stay valid)
+    */
+    void Erase( const std::string & path );
+
+    /**
+    * @brief Release all the images (the existing handles stay valid)
+    */
+    void Clear();
+
+    /// Memory budget (in bytes) of the decoded images
+    std::size_t Budget() const;
+
+    /// Memory (in bytes) used by the cached images
+    std::size_t MemoryUsage() const;
+
+    /// Number of image files decoded so far
+    std::size_t DecodeCount() const;
+
+  private:
+
+    /// A decoded image in its native pixel type (depth == 0 if the read failed)
+    struct Native
+    {
+      int depth = 0;
+      std::shared_ptr<const void> image;
+    };
+
+    struct Entry
+    {
+      std::shared_future<Native> native;
+      /// Images converted from the native one, by pixel type
+      std::map<std::type_index, std::shared_ptr<const void>> converted;
+      bool ready = false;
+      /// Memory used by the native and the converted images
+      std::size_t bytes = 0;
+      std::list<std::string>::iterator lru_it;
+    };
+
+    /// Return the cached image of a file, or decode it
+    Native Acquire( const std::string & path );
+
+    /// Return the cached conversion of an image to a pixel type (if any)
+    std::shared_ptr<const void> FindConverted
+    (
+      const std::string & path,
+      const std::type_index & type
+    ) const;
+
+    /// Cache the conversion of an image to a pixel type, return the cached
+    ///  conversion (the existing one if it was stored concurrently)
+    std::shared_ptr<const void> StoreConverted
+    (
+      const std::string & path,
+      const std::type_index & type,
+      const std::shared_ptr<const void> & image,
+      std::size_t bytes
+    );
+
+    /// Decode an image file in its native pixel type
+    static Native Decode( const std::string & path, std::size_t * bytes );
+
+    /// Release the least recently used images until the budget is met
+    void Evict();
+
+    const std::size_t budget_;
+    mutable std::mutex mutex_;
+    std::map<std::string, Entry> entries_;
+    /// Image file paths, the most recently used first
+    std::list<std::string> lru_;
+    std::size_t bytes_ = 0;
+    std::size_t decode_count_ = 0;
+};
+
+} // namespace image
+} // namespace openMVG
+
+#endif // OPENMVG_IMAGE_IMAGE_CACHE_HPP
@@ -0,0 +1,121 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/image/image_cache.hpp"
+#include "openMVG/image/image_io.hpp"
+
+#include "testing/testing.h"
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+using namespace openMVG;
+using namespace openMVG::image;
+using std::string;
+
+TEST(ImageCache, Decode_Once) {
+  const std::string filename = "test_image_cache.png";
+  const Image<RGBColor> image(10, 8, true, RGBColor(10, 120, 240));
+  EXPECT_TRUE(WriteImage(filename.c_str(), image));
+
+  ImageCache cache;
+  const std::shared_ptr<const Image<RGBColor>> rgb = cache.Get<RGBColor>(filename);
+  EXPECT_TRUE(rgb != nullptr);
+  EXPECT_EQ(10, rgb->Width());
+  EXPECT_EQ(8, rgb->Height());
+  EXPECT_EQ(RGBColor(10, 120, 240), (*rgb)(3, 4));
+  EXPECT_EQ(10 * 8 * 3, cache.MemoryUsage());
+
+  // Same handle for the same pixel type
+  EXPECT_TRUE(rgb == cache.Get<RGBColor>(filename));
+  // Gray level is converted from the decoded image
+  const std::shared_ptr<const Image<unsigned char>> gray = cache.Get<unsigned char>(filename);
+  EXPECT_TRUE(gray != nullptr);
+  EXPECT_EQ(10, gray->Width());
+  EXPECT_EQ(8, gray->Height());
+  // The converted image is cached too
+  EXPECT_TRUE(gray == cache.Get<unsigned char>(filename));
+  EXPECT_EQ(10 * 8 * 3 + 10 * 8, cache.MemoryUsage());
+  // RGBA cannot be obtained from a RGB image (as ReadImage)
+  EXPECT_TRUE(cache.Get<RGBAColor>(filename) == nullptr);
+  EXPECT_EQ(1, cache.DecodeCount());
+
+  // Erased images are decoded again, and the existing handles stay valid
+  cache.Erase(filename);
+  EXPECT_EQ(0, cache.MemoryUsage());
+  EXPECT_EQ(RGBColor(10, 120, 240), (*rgb)(3, 4));
+  EXPECT_TRUE(cache.Get<RGBColor>(filename) != nullptr);
+  EXPECT_EQ(2, cache.DecodeCount());
+  remove(filename.c_str());
+}
+
+TEST(ImageCache, Failed_Read) {
+  const std::string filename = "test_image_cache_failed.png";
+  remove(filename.c_str());
+
+  // The failed reads are not cached
+  ImageCache cache;
+  EXPECT_TRUE(cache.Get<RGBColor>(filename) == nullptr);
+  EXPECT_TRUE(cache.Get<unsigned char>(filename) == nullptr);
+  EXPECT_EQ(2, cache.DecodeCount());
+  EXPECT_EQ(0, cache.MemoryUsage());
+
+  // The file is read once it exists
+  const Image<unsigned char> image(10, 8, true, 127);
+  EXPECT_TRUE(WriteImage(filename.c_str(), image));
+  const std::shared_ptr<const Image<unsigned char>> gray = cache.Get<unsigned char>(filename);
+  EXPECT_TRUE(gray != nullptr);
+  EXPECT_EQ(127, (*gray)(3, 4));
+  EXPECT_TRUE(gray == cache.Get<unsigned char>(filename));
+  EXPECT_EQ(3, cache.DecodeCount());
+  remove(filename.c_str());
+}
+
+TEST(ImageCache, Budget) {
+  const std::string filename_a = "test_image_cache_a.png";
+  const std::string filename_b = "test_image_cache_b.png";
+  const std::string filename_c = "test_image_cache_c.png";
+  const Image<unsigned char> image(10, 10, true, 127);
+  EXPECT_TRUE(WriteImage(filename_a.c_str(), image));
+  EXPECT_TRUE(WriteImage(filename_b.c_str(), image));
+  EXPECT_TRUE(WriteImage(filename_c.c_str(), image));
+
+  // Room for two images
+  ImageCache cache(250);
+  const std::shared_ptr<const Image<unsigned char>> a = cache.Get<unsigned char>(filename_a);
+  cache.Get<unsigned char>(filename_b);
+  EXPECT_EQ(200, cache.MemoryUsage());
+
+  // b is released (a is referenced by a handle)
+  cache.Get<unsigned char>(filename_c);
+  EXPECT_EQ(200, cache.MemoryUsage());
+  EXPECT_EQ(3, cache.DecodeCount());
+  EXPECT_TRUE(a == cache.Get<unsigned char>(filename_a));
+  cache.Get<unsigned char>(filename_c);
+  EXPECT_EQ(3, cache.DecodeCount());
+  cache.Get<unsigned char>(filename_b);
+  EXPECT_EQ(4, cache.DecodeCount());
+
+  // Referenced images are kept even if the budget is exceeded
+  ImageCache tiny_cache(50);
+  const std::shared_ptr<const Image<unsigned char>> a_tiny = tiny_cache.Get<unsigned char>(filename_a);
+  EXPECT_EQ(100, tiny_cache.MemoryUsage());
+  tiny_cache.Get<unsigned char>(filename_b);
+  tiny_cache.Get<unsigned char>(filename_c);
+  EXPECT_TRUE(a_tiny == tiny_cache.Get<unsigned char>(filename_a));
+  EXPECT_EQ(3, tiny_cache.DecodeCount());
+
+  remove(filename_a.c_str());
+  remove(filename_b.c_str());
+  remove(filename_c.c_str());
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
@@ -8,9 +8,11 @@
 
 #include "openMVG/image/image_io.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 #include <iostream>
+#include <limits>
 
 extern "C" {
   #include "png.h"
@@ -77,6 +79,153 @@ int ReadImage(const char *filename,
   };
 }
 
+/// Check the validity of the read options
+static bool CheckReadOptions(const ImageReadOptions & options)
+{
+  if (options.downscale != 1 && options.downscale != 2 &&
+      options.downscale != 4 && options.downscale != 8)
+  {
+    std::cerr << "Error: Invalid image read downscale factor: " << options.downscale << std::endl;
+    return false;
+  }
+  return true;
+}
+
+/// Compute the region [x0,x1[ x [y0,y1[ of the downscaled image (of size
+///  scaled_w x scaled_h) that covers the read options region of interest
+static void ScaledRegionOfInterest
+(
+  const ImageReadOptions & options,
+  int scaled_w,
+  int scaled_h,
+  int * x0, int * y0,
+  int * x1, int * y1
+)
+{
+  if (options.roi_width <= 0 || options.roi_height <= 0)
+  {
+    *x0 = *y0 = 0;
+    *x1 = scaled_w;
+    *y1 = scaled_h;
+    return;
+  }
+  const int s = options.downscale;
+  const auto clamp = [](int v, int lo, int hi) { return std::min(std::max(v, lo), hi); };
+  *x0 = clamp(std::max(options.roi_x, 0) / s, 0, scaled_w);
+  *y0 = clamp(std::max(options.roi_y, 0) / s, 0, scaled_h);
+  *x1 = clamp((options.roi_x + options.roi_width + s - 1) / s, *x0, scaled_w);
+  *y1 = clamp((options.roi_y + options.roi_height + s - 1) / s, *y0, scaled_h);
+}
+
+/// Crop & downscale (box filter) a full resolution image according the read options.
+/// The input array contains the rows [first_row, first_row + array rows[
+///  of a w x h image.
+/// Return false if the resulting image is empty.
+static bool CropAndDownscale
+(
+  const ImageReadOptions & options,
+  int first_row,
+  std::vector<unsigned char> * ptr,
+  int * w,
+  int * h,
+  int depth
+)
+{
+  const int s = options.downscale;
+  int x0, y0, x1, y1;
+  ScaledRegionOfInterest(options, (*w + s - 1) / s, (*h + s - 1) / s, &x0, &y0, &x1, &y1);
+  if (s == 1 && first_row == 0 && x0 == 0 && y0 == 0 && x1 == *w && y1 == *h)
+    return true;
+
+  const int out_w = x1 - x0, out_h = y1 - y0;
+  std::vector<unsigned char> out(out_w * out_h * depth);
+  std::vector<unsigned int> sum(depth);
+  for (int y = 0; y < out_h; ++y)
+  {
+    const int row_begin = (y0 + y) * s, row_end = std::min(row_begin + s, *h);
+    for (int x = 0; x < out_w; ++x)
+    {
+      const int col_begin = (x0 + x) * s, col_end = std::min(col_begin + s, *w);
+      std::fill(sum.begin(), sum.end(), 0);
+      for (int row = row_begin; row < row_end; ++row)
+      {
+        const unsigned char * src = &(*ptr)[((row - first_row) * (*w) + col_begin) * depth];
+        for (int col = col_begin; col < col_end; ++col)
+          for (int c = 0; c < depth; ++c)
+            sum[c] += *src++;
+      }
+      const unsigned int count = (row_end - row_begin) * (col_end - col_begin);
+      unsigned char * dst = &out[(y * out_w + x) * depth];
+      for (int c = 0; c < depth; ++c)
+        dst[c] = static_cast<unsigned char>((sum[c] + count / 2) / count);
+    }
+  }
+  ptr->swap(out);
+  *w = out_w;
+  *h = out_h;
+  return out_w > 0 && out_h > 0;
+}
+
+static int ReadTiffRows(const char * filename,
+  std::vector<unsigned char> * ptr,
+  int * w,
+  int * h,
+  int * depth,
+  int row_begin,
+  int row_end,
+  int * first_row);
+
+int ReadImage(const char *filename,
+              std::vector<unsigned char> * ptr,
+              int * w,
+              int * h,
+              int * depth,
+              const ImageReadOptions & options){
+  if (!CheckReadOptions(options))
+    return 0;
+
+  const Format f = GetFormat(filename);
+  int res = 0, first_row = 0;
+  switch (f) {
+    case Pnm:
+      res = ReadPnm(filename, ptr, w, h, depth);
+    break;
+    case Png:
+      res = ReadPng(filename, ptr, w, h, depth);
+    break;
+    case Jpg:
+    {
+      // Downscale & region of interest are handled by the decoder
+      FILE *file = fopen(filename, "rb");
+      if (!file) {
+        std::cerr << "Error: Couldn't open " << filename << " fopen returned 0";
+        return 0;
+      }
+      res = ReadJpgStream(file, ptr, w, h, depth, options);
+      fclose(file);
+      return res;
+    }
+    case Tiff:
+    {
+      // Decode only the strips that contain the region of interest rows
+      int row_begin = 0, row_end = std::numeric_limits<int>::max();
+      if (options.roi_width > 0 && options.roi_height > 0)
+      {
+        const int s = options.downscale;
+        row_begin = std::max(options.roi_y, 0) / s * s;
+        row_end = (options.roi_y + options.roi_height + s - 1) / s * s;
+      }
+      res = ReadTiffRows(filename, ptr, w, h, depth, row_begin, row_end, &first_row);
+    }
+    break;
+    default:
+      return 0;
+  };
+  if (res == 1 && !CropAndDownscale(options, first_row, ptr, w, h, *depth))
+    return 0;
+  return res;
+}
+
 int WriteImage(const char * filename,
               const std::vector<unsigned char> & ptr,
               int w,
@@ -132,6 +281,19 @@ int ReadJpgStream(FILE * file,
                   int * w,
                   int * h,
                   int * depth) {
+  return ReadJpgStream(file, ptr, w, h, depth, ImageReadOptions());
+}
+
+int ReadJpgStream(FILE * file,
+                  std::vector<unsigned char> * ptr,
+                  int * w,
+                  int * h,
+                  int * depth,
+                  const ImageReadOptions & options) {
+  if (!CheckReadOptions(options))
+    return 0;
+
+  std::vector<unsigned char> scanline_buffer;
   jpeg_decompress_struct cinfo;
   struct my_error_mgr jerr;
   cinfo.err = jpeg_std_error(&jerr.pub);
@@ -146,29 +308,62 @@ int ReadJpgStream(FILE * file,
   jpeg_create_decompress(&cinfo);
   jpeg_stdio_src(&cinfo, file);
   jpeg_read_header(&cinfo, TRUE);
+  // Let the decoder downscale the image (DCT scaling)
+  cinfo.scale_num = 1;
+  cinfo.scale_denom = options.downscale;
   jpeg_start_decompress(&cinfo);
 
-  int row_stride = cinfo.output_width * cinfo.output_components;
+  // Region of the decoded image to keep
+  int x0, y0, x1, y1;
+  ScaledRegionOfInterest(options, cinfo.output_width, cinfo.output_height,
+    &x0, &y0, &x1, &y1);
+
+  // Offset of the first decoded column
+  int x_offset = 0;
+#if defined(LIBJPEG_TURBO_VERSION_NUMBER)
+  if (x0 > 0 || x1 < static_cast<int>(cinfo.output_width))
+  {
+    // Decode only the columns of the region of interest (iMCU aligned)
+    JDIMENSION crop_x = x0, crop_width = x1 - x0;
+    jpeg_crop_scanline(&cinfo, &crop_x, &crop_width);
+    x_offset = crop_x;
+  }
+  if (y0 > 0)
+    jpeg_skip_scanlines(&cinfo, y0);
+#endif
 
-  *h = cinfo.output_height;
-  *w = cinfo.output_width;
+  *h = y1 - y0;
+  *w = x1 - x0;
   *depth = cinfo.output_components;
   ptr->resize((*h)*(*w)*(*depth));
 
-  unsigned char *ptrCpy = &(*ptr)[0];
-
-  while (cinfo.output_scanline < cinfo.output_height) {
-    JSAMPROW scanline[1] = { ptrCpy };
+  // Decode the rows directly in the output array, or in a buffer if the
+  //  columns must be cropped (or the row is before the region of interest)
+  const bool bCrop = (*w != static_cast<int>(cinfo.output_width));
+  scanline_buffer.resize(cinfo.output_width * cinfo.output_components);
+  const int row_stride = (*w) * (*depth);
+  unsigned char *ptrCpy = ptr->data();
+
+  while (static_cast<int>(cinfo.output_scanline) < y1) {
+    const bool bKeep = static_cast<int>(cinfo.output_scanline) >= y0;
+    const bool bDirect = bKeep && !bCrop;
+    JSAMPROW scanline[1] = { bDirect ? ptrCpy : &scanline_buffer[0] };
     jpeg_read_scanlines(&cinfo, scanline, 1);
-    ptrCpy += row_stride;
+    if (bKeep) {
+      if (!bDirect)
+        std::memcpy(ptrCpy, &scanline_buffer[(x0 - x_offset) * (*depth)], row_stride);
+      ptrCpy += row_stride;
+    }
   }
 
-  jpeg_finish_decompress(&cinfo);
+  if (cinfo.output_scanline < cinfo.output_height)
+    jpeg_abort_decompress(&cinfo); // The remaining rows are not needed
+  else
+    jpeg_finish_decompress(&cinfo);
   jpeg_destroy_decompress(&cinfo);
-  return 1;
+  return (*w > 0 && *h > 0) ? 1 : 0;
 }
 
-
 int WriteJpg(const char * filename,
              const std::vector<unsigned char> & array,
              int w,
@@ -564,6 +759,23 @@ int ReadTiff(const char * filename,
   int * w,
   int * h,
   int * depth)
+{
+  int first_row = 0;
+  return ReadTiffRows(filename, ptr, w, h, depth,
+    0, std::numeric_limits<int>::max(), &first_row);
+}
+
+/// Read the rows [row_begin, row_end[ of a TIFF image
+/// The output array contains the rows [first_row, first_row + array rows[
+///  (since whole strips are decoded, more rows than asked can be returned).
+static int ReadTiffRows(const char * filename,
+  std::vector<unsigned char> * ptr,
+  int * w,
+  int * h,
+  int * depth,
+  int row_begin,
+  int row_end,
+  int * first_row)
 {
   TIFF* tiff = TIFFOpen(filename, "r");
   if (!tiff) {
@@ -577,10 +789,10 @@ int ReadTiff(const char * filename,
   TIFFGetField(tiff, TIFFTAG_BITSPERSAMPLE, &bps);
   TIFFGetField(tiff, TIFFTAG_SAMPLESPERPIXEL, &spp);
   *depth = bps * spp / 8;
-
-  ptr->resize((*h)*(*w)*(*depth));
+  *first_row = 0;
 
   if (*depth==4) {
+    ptr->resize((*h)*(*w)*(*depth));
     if (ptr != nullptr) {
       if (!TIFFReadRGBAImageOriented(tiff, *w, *h, (uint32*)&((*ptr)[0]), ORIENTATION_TOPLEFT, 0)) {
         TIFFClose(tiff);
@@ -588,8 +800,21 @@ int ReadTiff(const char * filename,
       }
     }
   } else {
-    for (size_t i=0; i<TIFFNumberOfStrips(tiff); ++i) {
-      if (TIFFReadEncodedStrip(tiff, i, ((uint8*)&((*ptr)[0]))+i*TIFFStripSize(tiff),(tsize_t)-1) ==
+    // Select the strips that contain the requested rows
+    uint32 rows_per_strip = *h;
+    TIFFGetFieldDefaulted(tiff, TIFFTAG_ROWSPERSTRIP, &rows_per_strip);
+    rows_per_strip = std::max<uint32>(1, std::min<uint32>(rows_per_strip, *h));
+    row_begin = std::max(0, std::min(row_begin, *h));
+    row_end = std::max(row_begin, std::min(row_end, *h));
+    const tstrip_t first_strip = row_begin / rows_per_strip;
+    const tstrip_t end_strip = std::min<tstrip_t>(
+      (row_end + rows_per_strip - 1) / rows_per_strip, TIFFNumberOfStrips(tiff));
+    *first_row = first_strip * rows_per_strip;
+    const int row_count = std::min<int>(end_strip * rows_per_strip, *h) - *first_row;
+    ptr->resize(std::max(row_count, 0)*(*w)*(*depth));
+
+    for (tstrip_t i = first_strip; i < end_strip; ++i) {
+      if (TIFFReadEncodedStrip(tiff, i, ((uint8*)&((*ptr)[0]))+(i-first_strip)*TIFFStripSize(tiff),(tsize_t)-1) ==
         std::numeric_limits<tsize_t>::max()) {
         TIFFClose(tiff);
         return 0;
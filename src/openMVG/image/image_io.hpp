@@ -50,6 +50,30 @@ enum Format
 */
 Format GetFormat( const char *c );
 
+/**
+* @brief Optional parameters of an image read operation
+* - downscale: the image is read at a reduced resolution (ceil(size / downscale)).
+*   JPEG images are directly decoded at the reduced resolution (DCT scaling),
+*   the other formats are decoded and then downsampled (box filter).
+* - region of interest: only the part of the (downscaled) image that covers the
+*   region is returned, i.e. the pixels
+*   [floor(roi_x / downscale), ceil((roi_x + roi_width) / downscale)[
+*   (clamped to the image domain), the same applies to the rows.
+*   JPEG and TIFF (strip based) images stop decoding after the last row of the region.
+*/
+struct ImageReadOptions
+{
+  /// Downscale factor (1, 2, 4 or 8)
+  int downscale = 1;
+
+  /// Region of interest (in full resolution pixel coordinates).
+  /// An empty region (roi_width or roi_height <= 0) means the whole image.
+  int roi_x = 0;
+  int roi_y = 0;
+  int roi_width = 0;
+  int roi_height = 0;
+};
+
 
 
 /**
@@ -62,6 +86,18 @@ Format GetFormat( const char *c );
 template<typename T>
 int ReadImage( const char * path , Image<T> * image );
 
+/**
+* @brief Load an image<T> from the provided input filename at a reduced
+*  resolution and/or for a region of interest
+* @param path Input path of the image to load
+* @param[out] Output image
+* @param options Downscale factor and region of interest
+* @retval 1 If loading is correct
+* @retval 0 If there was an error during load operation
+*/
+template<typename T>
+int ReadImage( const char * path , Image<T> * image, const ImageReadOptions & options );
+
 /**
 * @brief Save an image<T> from the provided input filename
 * @param path Output path of the image to save
@@ -84,6 +120,20 @@ int WriteImage( const char * path , const Image<T>& image );
 */
 int ReadImage( const char * path, std::vector<unsigned char> * image , int * w, int * h, int * depth );
 
+/**
+* @brief Unsigned char specialization for a reduced resolution and/or a region of interest
+* @param path Input path of the image to load
+* @param[out] image Output image
+* @param[out] w Width of the loaded image
+* @param[out] h Height of the loaded image
+* @param[out] depth Depth of the image
+* @param options Downscale factor and region of interest
+* @retval 1 If loading is correct
+* @retval 0 If there was an error during load operation
+*/
+int ReadImage( const char * path, std::vector<unsigned char> * image , int * w, int * h, int * depth,
+               const ImageReadOptions & options );
+
 /**
 * @brief Unsigned char specialization
 * @param path Output path of the image to save
@@ -175,6 +225,21 @@ int ReadJpg( const char * path , std::vector<unsigned char> * array, int * w, in
 */
 int ReadJpgStream( FILE * stream , std::vector<unsigned char> * array, int * w, int * h, int * depth );
 
+/**
+* @brief Read JPEG image from stream at a reduced resolution (DCT scaling)
+*  and/or for a region of interest
+* @param[in] stream Input data stream
+* @param[out] array Output image data
+* @param[out] w Image width
+* @param[out] h Image height
+* @param[out] depth Depth of image
+* @param options Downscale factor and region of interest
+* @retval 0 if there is an error during read operation
+* @return non nul value if read operation is valid
+*/
+int ReadJpgStream( FILE * stream , std::vector<unsigned char> * array, int * w, int * h, int * depth,
+                   const ImageReadOptions & options );
+
 /**
 * @brief Write JPEG file
 * @param path Output image path
@@ -357,24 +422,27 @@ bool Read_TIFF_ImageHeader( const char * path , ImageHeader * hdr );
 
 
 /**
-* @brief Generic Image read from file
-* @param[in] path Input image path
-* @param[out] im Ouput image
-* @retval 0 if there was an errir during read operation
-* @retval 1 if read is correct
+* @brief Convert a raw image array to an Image<T>
+* @param ptr Input image data
+* @param w Width of the image
+* @param h Height of the image
+* @param depth Depth of the image
+* @param[out] im Output image
+* @retval true If the conversion is supported
+* @retval false If the image depth cannot be converted to T
 */
+template<typename T>
+bool RawToImage( std::vector<unsigned char> & ptr, int w, int h, int depth, Image<T> * im );
+
 template<>
-inline int ReadImage( const char * path, Image<unsigned char> * im )
+inline bool RawToImage( std::vector<unsigned char> & ptr, int w, int h, int depth, Image<unsigned char> * im )
 {
-  std::vector<unsigned char> ptr;
-  int w, h, depth;
-  const int res = ReadImage( path, &ptr, &w, &h, &depth );
-  if ( res == 1 && depth == 1 )
+  if ( depth == 1 )
   {
     //convert raw array to Image
     ( *im ) = Eigen::Map<Image<unsigned char>::Base>( &ptr[0], h, w );
   }
-  else if ( res == 1 && depth == 3 )
+  else if ( depth == 3 )
   {
     //-- Must convert RGB to gray
     RGBColor * ptrCol = reinterpret_cast<RGBColor*>( &ptr[0] );
@@ -383,7 +451,7 @@ inline int ReadImage( const char * path, Image<unsigned char> * im )
     //convert RGB to gray
     ConvertPixelType( rgbColIm, im );
   }
-  else if ( res == 1 && depth == 4 )
+  else if ( depth == 4 )
   {
     //-- Must convert RGBA to gray
     RGBAColor * ptrCol = reinterpret_cast<RGBAColor*>( &ptr[0] );
@@ -392,34 +460,23 @@ inline int ReadImage( const char * path, Image<unsigned char> * im )
     //convert RGBA to gray
     ConvertPixelType( rgbaColIm, im );
   }
-  else if ( depth != 1 )
+  else
   {
-    return 0;
+    return false;
   }
-  return res;
+  return true;
 }
 
-
-/**
-* @brief Generic Image read from file (overload for RGBColor)
-* @param[in] path Input image path
-* @param[out] im Ouput image
-* @retval 0 if there was an errir during read operation
-* @retval 1 if read is correct
-*/
 template<>
-inline int ReadImage( const char * path, Image<RGBColor> * im )
+inline bool RawToImage( std::vector<unsigned char> & ptr, int w, int h, int depth, Image<RGBColor> * im )
 {
-  std::vector<unsigned char> ptr;
-  int w, h, depth;
-  const int res = ReadImage( path, &ptr, &w, &h, &depth );
-  if ( res == 1 && depth == 3 )
+  if ( depth == 3 )
   {
     RGBColor * ptrCol = reinterpret_cast<RGBColor*>( &ptr[0] );
     //convert raw array to Image
     ( *im ) = Eigen::Map<Image<RGBColor>::Base>( ptrCol, h, w );
   }
-  else if ( res == 1 && depth == 4 )
+  else if ( depth == 4 )
   {
     //-- Must convert RGBA to RGB
     RGBAColor * ptrCol = reinterpret_cast<RGBAColor*>( &ptr[0] );
@@ -430,35 +487,55 @@ inline int ReadImage( const char * path, Image<RGBColor> * im )
   }
   else
   {
-    return 0;
+    return false;
+  }
+  return true;
+}
+
+template<>
+inline bool RawToImage( std::vector<unsigned char> & ptr, int w, int h, int depth, Image<RGBAColor> * im )
+{
+  if ( depth != 4 )
+  {
+    return false;
   }
-  return res;
+  RGBAColor * ptrCol = reinterpret_cast<RGBAColor*>( &ptr[0] );
+  //convert raw array to Image
+  ( *im ) = Eigen::Map<Image<RGBAColor>::Base>( ptrCol, h, w );
+  return true;
 }
 
 /**
-* @brief Generic Image read from file (overload for RGBAColor)
+* @brief Generic Image read from file
 * @param[in] path Input image path
 * @param[out] im Ouput image
 * @retval 0 if there was an errir during read operation
 * @retval 1 if read is correct
 */
-template<>
-inline int ReadImage( const char * path, Image<RGBAColor> * im )
+template<typename T>
+int ReadImage( const char * path, Image<T> * im )
 {
   std::vector<unsigned char> ptr;
   int w, h, depth;
   const int res = ReadImage( path, &ptr, &w, &h, &depth );
-  if ( depth != 4 )
-  {
-    return 0;
-  }
-  if ( res == 1 )
-  {
-    RGBAColor * ptrCol = reinterpret_cast<RGBAColor*>( &ptr[0] );
-    //convert raw array to Image
-    ( *im ) = Eigen::Map<Image<RGBAColor>::Base>( ptrCol, h, w );
-  }
-  return res;
+  return ( res == 1 && RawToImage( ptr, w, h, depth, im ) ) ? 1 : 0;
+}
+
+/**
+* @brief Generic Image read from file at a reduced resolution and/or for a region of interest
+* @param[in] path Input image path
+* @param[out] im Ouput image
+* @param options Downscale factor and region of interest
+* @retval 0 if there was an errir during read operation
+* @retval 1 if read is correct
+*/
+template<typename T>
+int ReadImage( const char * path, Image<T> * im, const ImageReadOptions & options )
+{
+  std::vector<unsigned char> ptr;
+  int w, h, depth;
+  const int res = ReadImage( path, &ptr, &w, &h, &depth, options );
+  return ( res == 1 && RawToImage( ptr, w, h, depth, im ) ) ? 1 : 0;
 }
 
 //--------
@@ -11,6 +11,8 @@
 
 #include "testing/testing.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdio>
 #include <iostream>
 #include <string>
@@ -260,6 +262,128 @@ TEST(ImageHeader, AllFormats) {
   }
 }
 
+// Box filter downscale of an image region (reference for the ImageReadOptions tests)
+Image<unsigned char> BoxDownscale
+(
+  const Image<unsigned char> & image,
+  int downscale,
+  int x0, int y0, int x1, int y1 // region in the downscaled image
+)
+{
+  Image<unsigned char> out(x1 - x0, y1 - y0);
+  for (int y = y0; y < y1; ++y)
+    for (int x = x0; x < x1; ++x)
+    {
+      int sum = 0, count = 0;
+      for (int j = y * downscale; j < std::min((y + 1) * downscale, image.Height()); ++j)
+        for (int i = x * downscale; i < std::min((x + 1) * downscale, image.Width()); ++i)
+        {
+          sum += image(j, i);
+          ++count;
+        }
+      out(y - y0, x - x0) = (sum + count / 2) / count;
+    }
+  return out;
+}
+
+TEST(ImageReadOptions, Downscale_ROI) {
+  // Lossless formats (downscale & crop are computed after the decoding)
+  const std::vector<std::string> ext_Type = {"png", "pgm", "tif"};
+  for (const std::string & ext : ext_Type)
+  {
+    Image<unsigned char> image(37, 45);
+    for (int y = 0; y < image.Height(); ++y)
+      for (int x = 0; x < image.Width(); ++x)
+        image(y, x) = (x * 7 + y * 13) % 256;
+    const std::string filename = "test_read_options." + ext;
+    EXPECT_TRUE(WriteImage(filename.c_str(), image));
+
+    // Downscale
+    ImageReadOptions options;
+    options.downscale = 4;
+    Image<unsigned char> read_image;
+    EXPECT_TRUE(ReadImage(filename.c_str(), &read_image, options));
+    EXPECT_EQ(10, read_image.Width());
+    EXPECT_EQ(12, read_image.Height());
+    EXPECT_TRUE(read_image == BoxDownscale(image, 4, 0, 0, 10, 12));
+
+    // Region of interest
+    options.downscale = 1;
+    options.roi_x = 5; options.roi_y = 20;
+    options.roi_width = 10; options.roi_height = 17;
+    EXPECT_TRUE(ReadImage(filename.c_str(), &read_image, options));
+    EXPECT_EQ(10, read_image.Width());
+    EXPECT_EQ(17, read_image.Height());
+    EXPECT_TRUE(read_image == BoxDownscale(image, 1, 5, 20, 15, 37));
+
+    // Region of interest & downscale
+    options.downscale = 2;
+    EXPECT_TRUE(ReadImage(filename.c_str(), &read_image, options));
+    EXPECT_EQ(6, read_image.Width());
+    EXPECT_EQ(9, read_image.Height());
+    EXPECT_TRUE(read_image == BoxDownscale(image, 2, 2, 10, 8, 19));
+
+    // Region of interest outside of the image & invalid downscale
+    options.roi_x = 100;
+    EXPECT_FALSE(ReadImage(filename.c_str(), &read_image, options));
+    options.roi_x = 0;
+    options.downscale = 3;
+    EXPECT_FALSE(ReadImage(filename.c_str(), &read_image, options));
+    remove(filename.c_str());
+  }
+}
+
+TEST(ImageReadOptions, Jpg_Downscale_ROI) {
+  Image<unsigned char> image(64, 48);
+  for (int y = 0; y < image.Height(); ++y)
+    for (int x = 0; x < image.Width(); ++x)
+      image(y, x) = 2 * x + y;
+  const std::string filename = ("test_read_options.jpg");
+  EXPECT_TRUE(WriteJpg(filename.c_str(), image, 100));
+
+  Image<unsigned char> full_image;
+  EXPECT_TRUE(ReadImage(filename.c_str(), &full_image));
+
+  // Region of interest: same pixels as the full resolution decoding
+  ImageReadOptions options;
+  options.roi_x = 17; options.roi_y = 9;
+  options.roi_width = 30; options.roi_height = 20;
+  Image<unsigned char> read_image;
+  EXPECT_TRUE(ReadImage(filename.c_str(), &read_image, options));
+  EXPECT_EQ(30, read_image.Width());
+  EXPECT_EQ(20, read_image.Height());
+  EXPECT_TRUE(read_image == BoxDownscale(full_image, 1, 17, 9, 47, 29));
+
+  // Downscale (DCT scaling): close to the box filtered full resolution image
+  for (const int downscale : {2, 4, 8})
+  {
+    options = ImageReadOptions();
+    options.downscale = downscale;
+    EXPECT_TRUE(ReadImage(filename.c_str(), &read_image, options));
+    EXPECT_EQ(64 / downscale, read_image.Width());
+    EXPECT_EQ(48 / downscale, read_image.Height());
+    const Image<unsigned char> reference =
+      BoxDownscale(full_image, downscale, 0, 0, 64 / downscale, 48 / downscale);
+    const int max_error =
+      (read_image.GetMat().cast<int>() - reference.GetMat().cast<int>()).cwiseAbs().maxCoeff();
+    EXPECT_TRUE(max_error <= 2);
+  }
+
+  // RGB image
+  {
+    Image<RGBColor> rgb_image(64, 48, true, RGBColor(10, 120, 240));
+    EXPECT_TRUE(WriteJpg(filename.c_str(), rgb_image, 100));
+    options.downscale = 2;
+    options.roi_x = 17; options.roi_y = 9;
+    options.roi_width = 30; options.roi_height = 20;
+    EXPECT_TRUE(ReadImage(filename.c_str(), &rgb_image, options));
+    EXPECT_EQ(16, rgb_image.Width());
+    EXPECT_EQ(11, rgb_image.Height());
+    EXPECT_TRUE(std::abs(rgb_image(5, 5).g() - 120) <= 2);
+  }
+  remove(filename.c_str());
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
@@ -12,7 +12,9 @@
 
 #include <cassert>
 #include <cmath>
+#include <cstdint>
 #include <fstream>
+#include <map>
 
 using namespace openMVG;
 using namespace openMVG::image;
@@ -32,20 +34,19 @@ ImageScale::ImageScale( const Image<float>& I, double r )
   GradAndNorm( I, angles[ 0 ], magnitudes[ 0 ] );
   ratios[ 0 ] = 1;
 
-#ifdef OPENMVG_USE_OPENMP
-#pragma omp parallel for
-#endif
+  // the scales are computed one after the other, each one being processed by rows in parallel
+  Image<float> I2;
   for (int k = 1; k < number; k++ )
   {
-    Image<float> I2;
     double ratio = 1 * pow( step, k );
-    I2.resize( int( I.Width() / ratio ), int( I.Height() / ratio ) );
-    angles[ k ].resize( int( I.Width() / ratio ), int( I.Height() / ratio ) );
-    magnitudes[ k ].resize( int( I.Width() / ratio ), int( I.Height() / ratio ) );
+    I2.resize( int( I.Width() / ratio ), int( I.Height() / ratio ), false );
 
-    for (int i = 0; i < I2.Width(); i++ )
+#ifdef OPENMVG_USE_OPENMP
+#pragma omp parallel for
+#endif
+    for (int j = 0; j < I2.Height(); j++ )
     {
-      for (int j = 0; j < I2.Height(); j++ )
+      for (int i = 0; i < I2.Width(); i++ )
       {
         I2( j, i ) = inter( double( i + 0.5 ) * ratio, double( j + 0.5 ) * ratio, ratio );
       }
@@ -57,10 +58,8 @@ ImageScale::ImageScale( const Image<float>& I, double r )
 
 void ImageScale::GradAndNorm( const Image<float>& I, Image<float>& angle, Image<float>& m )
 {
-  angle = Image<float>( I.Width(), I.Height() );
-  m = Image<float>( I.Width(), I.Height() );
-  angle.fill( 0 );
-  m.fill( 0 );
+  angle = Image<float>( I.Width(), I.Height(), true, 0 );
+  m = Image<float>( I.Width(), I.Height(), true, 0 );
 #ifdef OPENMVG_USE_OPENMP
 #pragma omp parallel for
 #endif
@@ -96,6 +95,14 @@ int ImageScale::getIndex( const double r )const
   }
 }
 
+size_t ImageScale::MemoryUsage()const
+{
+  size_t bytes = 0;
+  for (size_t i = 0; i < angles.size(); ++i )
+    bytes += ( angles[ i ].size() + magnitudes[ i ].size() ) * sizeof( float );
+  return bytes;
+}
+
 template<typename T>
 VLD::VLD( const ImageScale& series, T const& P1, T const& P2 ) : contrast( 0.0 )
 {
@@ -194,56 +201,207 @@ VLD::VLD( const ImageScale& series, T const& P1, T const& P2 ) : contrast( 0.0 )
   normalize_weight( weight );
 }
 
-float KVLD( const Image<float>& I1,
-            const Image<float>& I2,
-            const std::vector<features::SIOPointFeature> & F1,
-            const std::vector<features::SIOPointFeature> & F2,
-            const std::vector<Pair>& matches,
-            std::vector<Pair>& matchesFiltered,
-            std::vector<double>& score,
-            openMVG::Mat& E,
-            std::vector<bool>& valide,
-            KvldParameters& kvldParameters )
+namespace {
+
+//====== Spatial grid of the match positions in an image, used to find the neighbor matches ======//
+class MatchGrid
 {
-  matchesFiltered.clear();
-  score.clear();
-  ImageScale Chaine1( I1 );
-  ImageScale Chaine2( I2 );
+public:
+  MatchGrid( const std::vector<Vec2f>& positions, const float cell_size )
+  {
+    min_ = max_ = positions.empty() ? Vec2f::Zero() : positions[ 0 ];
+    for (const Vec2f & pos : positions )
+    {
+      min_ = min_.cwiseMin( pos );
+      max_ = max_.cwiseMax( pos );
+    }
+    // bound the cell count (the cells are at least as large as the search radius)
+    cell_size_ = std::max( { cell_size, ( max_ - min_ ).maxCoeff() / 1024.f, 1.f } );
+    cols_ = int( ( max_.x() - min_.x() ) / cell_size_ ) + 1;
+    rows_ = int( ( max_.y() - min_.y() ) / cell_size_ ) + 1;
+
+    cell_start_.assign( cols_ * rows_ + 1, 0 );
+    for (const Vec2f & pos : positions )
+      ++cell_start_[ cell( pos ) + 1 ];
+    for (size_t i = 1; i < cell_start_.size(); ++i )
+      cell_start_[ i ] += cell_start_[ i - 1 ];
+    items_.resize( positions.size() );
+    std::vector<size_t> fill( cell_start_.begin(), cell_start_.end() - 1 );
+    for (size_t i = 0; i < positions.size(); ++i )
+      items_[ fill[ cell( positions[ i ] ) ]++ ] = static_cast<uint32_t>( i );
+  }
 
-  std::cout << "Image scale-space complete..." << std::endl;
+  // append the items whose cell intersects the square of half size radius around pos
+  void query( const Vec2f& pos, const float radius, std::vector<uint32_t>& out )const
+  {
+    const int x0 = std::max( 0, int( std::floor( ( pos.x() - radius - min_.x() ) / cell_size_ ) ) );
+    const int y0 = std::max( 0, int( std::floor( ( pos.y() - radius - min_.y() ) / cell_size_ ) ) );
+    const int x1 = std::min( cols_ - 1, int( std::floor( ( pos.x() + radius - min_.x() ) / cell_size_ ) ) );
+    const int y1 = std::min( rows_ - 1, int( std::floor( ( pos.y() + radius - min_.y() ) / cell_size_ ) ) );
+    for (int y = y0; y <= y1; ++y )
+      out.insert( out.end(),
+        items_.begin() + cell_start_[ y * cols_ + x0 ],
+        items_.begin() + cell_start_[ y * cols_ + x1 + 1 ] );
+  }
 
-  const float range1 = getRange( I1, std::min( F1.size(), matches.size() ), kvldParameters.inlierRate );
-  const float range2 = getRange( I2, std::min( F2.size(), matches.size() ), kvldParameters.inlierRate );
+private:
+  int cell( const Vec2f& pos )const
+  {
+    const int x = std::min( cols_ - 1, int( ( pos.x() - min_.x() ) / cell_size_ ) );
+    const int y = std::min( rows_ - 1, int( ( pos.y() - min_.y() ) / cell_size_ ) );
+    return y * cols_ + x;
+  }
 
-  const size_t size = matches.size();
+  Vec2f min_, max_;
+  float cell_size_;
+  int cols_, rows_;
+  std::vector<size_t> cell_start_;
+  std::vector<uint32_t> items_;
+};
+
+//====== Sparse structures of a KVLD process ======//
+// neighbors: for each match the sorted list of its neighbor matches (the ones used for the vld-consistency),
+//            the E values are stored along the lists (only used for the neighbors with a bigger index)
+// conflicts: for each match the list of the matches (with a bigger index) sharing one of its points
+struct KvldGraph
+{
+  std::vector<size_t> neighbor_start, forward_start;
+  std::vector<uint32_t> neighbors;
+  std::vector<float> E;
+  std::vector<size_t> conflict_start;
+  std::vector<uint32_t> conflicts;
+};
 
-  //================distance map construction, foruse of selecting neighbors===============//
-  std::cout << "computing distance maps" << std::endl;
+template<typename T>
+inline bool areNeighbors( const T& a1, const T& a2, const T& b1, const T& b2, const float range1, const float range2 )
+{
+  return ( point_distance( a1, a2 ) > min_dist && point_distance( b1, b2 ) > min_dist &&
+         ( point_distance( a1, a2 ) < range1   || point_distance( b1, b2 ) < range2 ) );
+}
 
-  const bool bPrecomputedDist = false;
+// Concatenate per match lists (start offsets + values)
+void flatten( std::vector<std::vector<uint32_t>>& lists, std::vector<size_t>& start, std::vector<uint32_t>& values )
+{
+  start.assign( lists.size() + 1, 0 );
+  for (size_t i = 0; i < lists.size(); ++i )
+    start[ i + 1 ] = start[ i ] + lists[ i ].size();
+  values.resize( start.back() );
+  for (size_t i = 0; i < lists.size(); ++i )
+  {
+    std::copy( lists[ i ].begin(), lists[ i ].end(), values.begin() + start[ i ] );
+    std::vector<uint32_t>().swap( lists[ i ] );
+  }
+}
 
-  openMVG::Matf dist1, dist2;
-  if (bPrecomputedDist )
+void buildKvldGraph(
+  const std::vector<features::SIOPointFeature> & F1,
+  const std::vector<features::SIOPointFeature> & F2,
+  const std::vector<Pair>& matches,
+  const float range1,
+  const float range2,
+  KvldGraph & graph )
+{
+  const int size = static_cast<int>( matches.size() );
+  std::vector<Vec2f> positions1( size ), positions2( size );
+  for (int it = 0; it < size; ++it )
   {
-    dist1 = openMVG::Matf::Zero( F1.size(), F1.size() );
-    dist2 = openMVG::Matf::Zero( F2.size(), F2.size() );
+    positions1[ it ] = F1[ matches[ it ].first ].coords();
+    positions2[ it ] = F2[ matches[ it ].second ].coords();
+  }
 
-    for (size_t a1 = 0; a1 < F1.size(); ++a1 )
-      for (size_t a2 = a1; a2 < F1.size(); ++a2 )
-        dist1( a1, a2 ) = dist1( a2, a1 ) = point_distance( F1[ a1 ], F1[ a2 ] );
+  //========neighbors: the matches close enough in one of the images============//
+  {
+    const MatchGrid grid1( positions1, range1 ), grid2( positions2, range2 );
+    std::vector<std::vector<uint32_t>> neighbors( size );
+#ifdef OPENMVG_USE_OPENMP
+#pragma omp parallel
+#endif
+    {
+      std::vector<uint32_t> candidates;
+#ifdef OPENMVG_USE_OPENMP
+#pragma omp for schedule(dynamic, 64)
+#endif
+      for (int it1 = 0; it1 < size; ++it1 )
+      {
+        candidates.clear();
+        grid1.query( positions1[ it1 ], range1, candidates );
+        grid2.query( positions2[ it1 ], range2, candidates );
+        std::sort( candidates.begin(), candidates.end() );
+        candidates.erase( std::unique( candidates.begin(), candidates.end() ), candidates.end() );
+
+        const size_t a1 = matches[ it1 ].first, b1 = matches[ it1 ].second;
+        for (const uint32_t it2 : candidates )
+        {
+          const size_t a2 = matches[ it2 ].first, b2 = matches[ it2 ].second;
+          if (int( it2 ) != it1 && areNeighbors( F1[ a1 ], F1[ a2 ], F2[ b1 ], F2[ b2 ], range1, range2 ) )
+            neighbors[ it1 ].push_back( it2 );
+        }
+      }
+    }
+    flatten( neighbors, graph.neighbor_start, graph.neighbors );
+    graph.forward_start.resize( size );
+    for (int it = 0; it < size; ++it )
+      graph.forward_start[ it ] = std::upper_bound(
+        graph.neighbors.begin() + graph.neighbor_start[ it ],
+        graph.neighbors.begin() + graph.neighbor_start[ it + 1 ], uint32_t( it ) ) - graph.neighbors.begin();
+    graph.E.assign( graph.neighbors.size(), -1.f );
+  }
 
-    for (size_t b1 = 0; b1 < F2.size(); ++b1 )
-      for (size_t b2 = b1; b2 < F2.size(); ++b2 )
-        dist2( b1, b2 ) = dist2( b2, b1 ) = point_distance( F2[ b1 ], F2[ b2 ] );
+  //========conflicts: the matches sharing a point position============//
+  {
+    std::map<std::pair<float, float>, std::vector<uint32_t>> same1, same2;
+    for (int it = 0; it < size; ++it )
+    {
+      same1[ { positions1[ it ].x(), positions1[ it ].y() } ].push_back( it );
+      same2[ { positions2[ it ].x(), positions2[ it ].y() } ].push_back( it );
+    }
+    std::vector<std::vector<uint32_t>> conflicts( size );
+    for (int it1 = 0; it1 < size; ++it1 )
+    {
+      const std::vector<uint32_t> & group1 = same1[ { positions1[ it1 ].x(), positions1[ it1 ].y() } ];
+      const std::vector<uint32_t> & group2 = same2[ { positions2[ it1 ].x(), positions2[ it1 ].y() } ];
+      if (group1.size() == 1 && group2.size() == 1 )
+        continue;
+      std::vector<uint32_t> & candidates = conflicts[ it1 ];
+      std::set_union( std::upper_bound( group1.begin(), group1.end(), uint32_t( it1 ) ), group1.end(),
+                      std::upper_bound( group2.begin(), group2.end(), uint32_t( it1 ) ), group2.end(),
+                      std::back_inserter( candidates ) );
+
+      const size_t a1 = matches[ it1 ].first, b1 = matches[ it1 ].second;
+      candidates.erase( std::remove_if( candidates.begin(), candidates.end(), [&]( const uint32_t it2 )
+      {
+        const size_t a2 = matches[ it2 ].first, b2 = matches[ it2 ].second;
+        return !( a1 == a2 || b1 == b2
+                  || ( F1[ a1 ].x() == F1[ a2 ].x() && F1[ a1 ].y() == F1[ a2 ].y() &&
+                     ( F2[ b1 ].x() != F2[ b2 ].x() || F2[ b1 ].y() != F2[ b2 ].y() ) )
+                  || ( ( F1[ a1 ].x() != F1[ a2 ].x() || F1[ a1 ].y() != F1[ a2 ].y() ) &&
+                         F2[ b1 ].x() == F2[ b2 ].x() && F2[ b1 ].y() == F2[ b2 ].y() ) );
+      } ), candidates.end() );
+    }
+    flatten( conflicts, graph.conflict_start, graph.conflicts );
   }
+}
+
+float KVLD(
+  const ImageScale& Chaine1,
+  const ImageScale& Chaine2,
+  const std::vector<features::SIOPointFeature> & F1,
+  const std::vector<features::SIOPointFeature> & F2,
+  const std::vector<Pair>& matches,
+  std::vector<Pair>& matchesFiltered,
+  std::vector<double>& score,
+  KvldGraph & graph,
+  std::vector<bool>& valide,
+  KvldParameters& kvldParameters )
+{
+  const int size = static_cast<int>( matches.size() );
 
   std::fill( valide.begin(), valide.end(), true );
   std::vector<double> scoretable( size, 0.0 );
   std::vector<size_t> result( size, 0 );
-
+  std::vector<unsigned char> switching( size );
 
 //============main iteration formatch verification==========//
-//    cout<<"main iteration";
   bool change = true;
 
   while (change)
@@ -253,62 +411,70 @@ float KVLD( const Image<float>& I1,
     std::fill( scoretable.begin(), scoretable.end(), 0.0 );
     std::fill( result.begin(), result.end(), 0 );
     //========substep 1: search foreach match its neighbors and verify if they are gvld-consistent ============//
-    for (size_t it1 = 0; it1 < size - 1; it1++ )
+    // The matches are processed by blocks:
+    // 1.a the unknown consistencies of the block are computed in parallel: for each match, along its neighbor list
+    //     until the match has max_connection consistent connections (counting the ones of the previous blocks).
+    //     It covers the pairs visited by the sequential scan 1.b.
+    // 1.b sequential count of the gvld-consistent neighbors
+    const int block_size = 64;
+    for (int block = 0; block < size; block += block_size )
     {
-      if (valide[ it1 ] )
+      const int block_end = std::min( size, block + block_size );
+#ifdef OPENMVG_USE_OPENMP
+#pragma omp parallel for schedule(dynamic, 4)
+#endif
+      for (int it1 = block; it1 < block_end; it1++ )
       {
-        size_t a1 = matches[ it1 ].first, b1 = matches[ it1 ].second;
-
-        for (size_t it2 = it1 + 1; it2 < size; it2++ )
-          if (valide[ it2 ])
-          {
+        if (!valide[ it1 ] )
+          continue;
+        const size_t a1 = matches[ it1 ].first, b1 = matches[ it1 ].second;
+        size_t count = result[ it1 ];
+        for (size_t e = graph.forward_start[ it1 ]; e < graph.neighbor_start[ it1 + 1 ]; ++e )
+        {
+          const uint32_t it2 = graph.neighbors[ e ];
+          if (!valide[ it2 ] )
+            continue;
+          if (graph.E[ e ] == -1 )
+          { //update E ifunknow
+            graph.E[ e ] = -2;
             const size_t a2 = matches[ it2 ].first, b2 = matches[ it2 ].second;
-
-            bool bOk = false;
-            if (bPrecomputedDist )
-              bOk = ( dist1( a1, a2 ) > min_dist && dist2( b1, b2 ) > min_dist
-                 && ( dist1( a1, a2 ) < range1   || dist2( b1, b2 ) < range2 ) );
-            else
-              bOk = ( point_distance( F1[ a1 ], F1[ a2 ] ) > min_dist && point_distance( F2[ b1 ], F2[ b2 ] ) > min_dist &&
-                    ( point_distance( F1[ a1 ], F1[ a2 ] ) < range1   || point_distance( F2[ b1 ], F2[ b2 ] ) < range2 ) );
-            if (bOk )
+            if (!kvldParameters.geometry || consistent( F1[ a1 ], F1[ a2 ], F2[ b1 ], F2[ b2 ] ) < distance_thres )
             {
-              if (E( it1, it2 ) == -1 )
-              { //update E ifunknow
-                E( it1, it2 ) = -2;
-                E( it2, it1 ) = -2;
+              const VLD vld1( Chaine1, F1[ a1 ], F1[ a2 ] );
+              const VLD vld2( Chaine2, F2[ b1 ], F2[ b2 ] );
+              const double error = vld1.difference( vld2 );
+              if (error < juge )
+                graph.E[ e ] = ( float ) error;
+            }
+          }
+          if (graph.E[ e ] >= 0 && ++count >= max_connection )
+            break;
+        }
+      }
 
-                if (!kvldParameters.geometry || consistent( F1[ a1 ], F1[ a2 ], F2[ b1 ], F2[ b2 ] ) < distance_thres )
-                {
-                  VLD vld1( Chaine1, F1[ a1 ], F1[ a2 ] );
-                  VLD vld2( Chaine2, F2[ b1 ], F2[ b2 ] );
-                  //vld1.test();
-                  double error = vld1.difference( vld2 );
-                  //cout<<endl<<it1<<" "<<it2<<" "<<dist1(a1,a2)<<" "<< dist2(b1,b2)<<" "<<error<<endl;
-                  if (error < juge )
-                  {
-                    E( it1, it2 ) = ( float ) error;
-                    E( it2, it1 ) = ( float ) error;
-                    //cout<<E(it2,it1)<<endl;
-                  }
-                }
-              }
-              if (E( it1, it2 ) >= 0 )
-              {
-                result[ it1 ] += 1;
-                result[ it2 ] += 1;
-                scoretable[ it1 ] += double( E( it1, it2 ) );
-                scoretable[ it2 ] += double( E( it1, it2 ) );
-                if (result[ it1 ] >= max_connection )
-                  break;
-              }
+      for (int it1 = block; it1 < block_end; it1++ )
+      {
+        if (valide[ it1 ] )
+        {
+          for (size_t e = graph.forward_start[ it1 ]; e < graph.neighbor_start[ it1 + 1 ]; ++e )
+          {
+            const uint32_t it2 = graph.neighbors[ e ];
+            if (valide[ it2 ] && graph.E[ e ] >= 0 )
+            {
+              result[ it1 ] += 1;
+              result[ it2 ] += 1;
+              scoretable[ it1 ] += double( graph.E[ e ] );
+              scoretable[ it2 ] += double( graph.E[ e ] );
+              if (result[ it1 ] >= max_connection )
+                break;
             }
           }
+        }
       }
     }
 
     //========substep 2: remove false matches by K gvld-consistency criteria ============//
-    for (size_t it = 0; it < size; it++ )
+    for (int it = 0; it < size; it++ )
     {
       if (valide[ it ] && result[ it ] < kvldParameters.K )
       {
@@ -318,107 +484,86 @@ float KVLD( const Image<float>& I1,
     }
     //========substep 3: remove multiple matches to a same point by keeping the one with the best average gvld-consistency score ============//
     if (uniqueMatch )
-      for (size_t it1 = 0; it1 < size - 1; it1++ )
+      for (int it1 = 0; it1 < size; it1++ )
         if (valide[ it1 ]) {
-          size_t a1 = matches[ it1 ].first;
-          size_t b1 = matches[ it1 ].second;
-
-          for (size_t it2 = it1 + 1; it2 < size; it2++ )
+          for (size_t c = graph.conflict_start[ it1 ]; c < graph.conflict_start[ it1 + 1 ]; ++c )
+          {
+            const uint32_t it2 = graph.conflicts[ c ];
             if (valide[ it2 ] )
             {
-              size_t a2 = matches[ it2 ].first;
-              size_t b2 = matches[ it2 ].second;
-
-              if (a1 == a2 || b1 == b2
-                  || ( F1[ a1 ].x() == F1[ a2 ].x() && F1[ a1 ].y() == F1[ a2 ].y() &&
-                     ( F2[ b1 ].x() != F2[ b2 ].x() || F2[ b1 ].y() != F2[ b2 ].y() ) )
-                  || ( ( F1[ a1 ].x() != F1[ a2 ].x() || F1[ a1 ].y() != F1[ a2 ].y() ) &&
-                         F2[ b1 ].x() == F2[ b2 ].x() && F2[ b1 ].y() == F2[ b2 ].y() ) )
+              //cardinal comparison
+              if (result[ it1 ] > result[ it2 ] )
               {
-                //cardinal comparison
-                if (result[ it1 ] > result[ it2 ] )
-                {
-                  valide[ it2 ] = false;
-                  change = true;
-                }
-                else if (result[ it1 ] < result[ it2 ] )
+                valide[ it2 ] = false;
+                change = true;
+              }
+              else if (result[ it1 ] < result[ it2 ] )
+              {
+                valide[ it1 ] = false;
+                change = true;
+              }
+              else if (result[ it1 ] == result[ it2 ] )
+              {
+                //score comparison
+                if (scoretable[ it1 ] > scoretable[ it2 ] )
                 {
                   valide[ it1 ] = false;
                   change = true;
                 }
-                else if (result[ it1 ] == result[ it2 ] )
+                else if (scoretable[ it1 ] < scoretable[ it2 ] )
                 {
-                  //score comparison
-                  if (scoretable[ it1 ] > scoretable[ it2 ] )
-                  {
-                    valide[ it1 ] = false;
-                    change = true;
-                  }
-                  else if (scoretable[ it1 ] < scoretable[ it2 ] )
-                  {
-                    valide[ it2 ] = false;
-                    change = true;
-                  }
+                  valide[ it2 ] = false;
+                  change = true;
                 }
               }
             }
+          }
         }
     //========substep 4: ifgeometric verification is set, re-score matches by geometric-consistency, and remove poorly scored ones ============================//
     if (uniqueMatch && kvldParameters.geometry )
     {
-      for (size_t i = 0; i < size; i++ )
-        scoretable[ i ]=0;
-
-      std::vector<bool> switching;
-      for (size_t i = 0; i < size; i++ )
-        switching.push_back( false );
-
-      for (size_t it1 = 0; it1 < size; it1++ )
+      std::fill( switching.begin(), switching.end(), 0 );
+#ifdef OPENMVG_USE_OPENMP
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+      for (int it1 = 0; it1 < size; it1++ )
       {
+        scoretable[ it1 ] = 0;
         if (valide[ it1 ] )
         {
-          size_t a1 = matches[ it1 ].first, b1 = matches[ it1 ].second;
+          const size_t a1 = matches[ it1 ].first, b1 = matches[ it1 ].second;
           float index = 0.0f;
           int good_index = 0;
-          for (size_t it2 = 0; it2 < size; it2++ )
+          for (size_t e = graph.neighbor_start[ it1 ]; e < graph.neighbor_start[ it1 + 1 ]; ++e )
           {
-            if (it1 != it2 && valide[ it2 ] )
+            const uint32_t it2 = graph.neighbors[ e ];
+            if (valide[ it2 ] )
             {
-              size_t a2 = matches[ it2 ].first;
-              size_t b2 = matches[ it2 ].second;
-
-              bool bOk = false;
-              if (bPrecomputedDist )
-                bOk = ( dist1( a1, a2 ) > min_dist && dist2( b1, b2 ) > min_dist &&
-                      ( dist1( a1, a2 ) < range1   || dist2( b1, b2 ) < range2 ) );
-              else
-                bOk = ( point_distance( F1[ a1 ], F1[ a2 ] ) > min_dist && point_distance( F2[ b1 ], F2[ b2 ] ) > min_dist &&
-                      ( point_distance( F1[ a1 ], F1[ a2 ] ) < range1   || point_distance( F2[ b1 ], F2[ b2 ] ) < range2 ) );
-              if (bOk )
-              {
-                float d = consistent( F1[ a1 ], F1[ a2 ], F2[ b1 ], F2[ b2 ] );
-                scoretable[ it1 ] += d;
-                index += 1;
-                if (d < distance_thres )
-                  good_index++;
-              }
+              const size_t a2 = matches[ it2 ].first, b2 = matches[ it2 ].second;
+              float d = consistent( F1[ a1 ], F1[ a2 ], F2[ b1 ], F2[ b2 ] );
+              scoretable[ it1 ] += d;
+              index += 1;
+              if (d < distance_thres )
+                good_index++;
             }
           }
           scoretable[ it1 ] /= index;
           if (good_index < 0.3f * float( index ) && scoretable[ it1 ] > 1.2 )
-          {
-            switching[ it1 ] = true;
-            change = true;
-          }
+            switching[ it1 ] = 1;
         }
       }
-      for (size_t it1 = 0; it1 < size; it1++ )
+      for (int it1 = 0; it1 < size; it1++ )
         if (switching[ it1 ] )
+        {
           valide[ it1 ] = false;
+          change = true;
+        }
     }
   }
   //=============== generating output list ===================//
-  for (size_t it = 0; it < size; it++ )
+  matchesFiltered.clear();
+  score.clear();
+  for (int it = 0; it < size; it++ )
     if (valide[ it ] )
     {
       matchesFiltered.push_back( matches[ it ] );
@@ -426,3 +571,73 @@ float KVLD( const Image<float>& I1,
     }
   return float( matchesFiltered.size() ) / matches.size();
 }
+
+} // namespace
+
+float KVLD( const ImageScale& Chaine1,
+            const ImageScale& Chaine2,
+            const std::vector<features::SIOPointFeature> & F1,
+            const std::vector<features::SIOPointFeature> & F2,
+            const std::vector<Pair>& matches,
+            std::vector<Pair>& matchesFiltered,
+            std::vector<double>& score,
+            std::vector<bool>& valide,
+            KvldParameters& kvldParameters )
+{
+  const float range1 = getRange( Chaine1.angles[ 0 ], std::min( F1.size(), matches.size() ), kvldParameters.inlierRate );
+  const float range2 = getRange( Chaine2.angles[ 0 ], std::min( F2.size(), matches.size() ), kvldParameters.inlierRate );
+
+  KvldGraph graph;
+  buildKvldGraph( F1, F2, matches, range1, range2, graph );
+
+  return KVLD( Chaine1, Chaine2, F1, F2, matches, matchesFiltered, score, graph, valide, kvldParameters );
+}
+
+float KVLD( const ImageScale& Chaine1,
+            const ImageScale& Chaine2,
+            const std::vector<features::SIOPointFeature> & F1,
+            const std::vector<features::SIOPointFeature> & F2,
+            const std::vector<Pair>& matches,
+            std::vector<Pair>& matchesFiltered,
+            std::vector<double>& score,
+            openMVG::Mat& E,
+            std::vector<bool>& valide,
+            KvldParameters& kvldParameters )
+{
+  const float range1 = getRange( Chaine1.angles[ 0 ], std::min( F1.size(), matches.size() ), kvldParameters.inlierRate );
+  const float range2 = getRange( Chaine2.angles[ 0 ], std::min( F2.size(), matches.size() ), kvldParameters.inlierRate );
+
+  KvldGraph graph;
+  buildKvldGraph( F1, F2, matches, range1, range2, graph );
+
+  // reuse the known consistencies, and export the computed ones
+  for (size_t it1 = 0; it1 < matches.size(); ++it1 )
+    for (size_t e = graph.forward_start[ it1 ]; e < graph.neighbor_start[ it1 + 1 ]; ++e )
+      graph.E[ e ] = static_cast<float>( E( it1, graph.neighbors[ e ] ) );
+
+  const float rate = KVLD( Chaine1, Chaine2, F1, F2, matches, matchesFiltered, score, graph, valide, kvldParameters );
+
+  for (size_t it1 = 0; it1 < matches.size(); ++it1 )
+    for (size_t e = graph.forward_start[ it1 ]; e < graph.neighbor_start[ it1 + 1 ]; ++e )
+      E( it1, graph.neighbors[ e ] ) = E( graph.neighbors[ e ], it1 ) = graph.E[ e ];
+  return rate;
+}
+
+float KVLD( const Image<float>& I1,
+            const Image<float>& I2,
+            const std::vector<features::SIOPointFeature> & F1,
+            const std::vector<features::SIOPointFeature> & F2,
+            const std::vector<Pair>& matches,
+            std::vector<Pair>& matchesFiltered,
+            std::vector<double>& score,
+            openMVG::Mat& E,
+            std::vector<bool>& valide,
+            KvldParameters& kvldParameters )
+{
+  const ImageScale Chaine1( I1 );
+  const ImageScale Chaine2( I2 );
+
+  std::cout << "Image scale-space complete..." << std::endl;
+
+  return KVLD( Chaine1, Chaine2, F1, F2, matches, matchesFiltered, score, E, valide, kvldParameters );
+}
@@ -50,6 +50,9 @@ struct KvldParameters
 //
 // angles: store orientations of pixels of each scale image into a vector of images, which varies from 0 to 2*PI for each pixel
 // magnitudes: store gradient norms of pixels of each scale image into a vector of images
+//
+// An ImageScale only depends on its image: it can be computed once per image and shared by
+// all the KVLD processes of the pairs using this image.
 struct ImageScale
 {
   std::vector<openMVG::image::Image<float>> angles;
@@ -60,6 +63,8 @@ struct ImageScale
 
   ImageScale(const openMVG::image::Image<float>& I, double r = 5.0);
   int getIndex( const double r )const;
+  // memory used by the scale images (in bytes)
+  size_t MemoryUsage()const;
 
 private:
   void GradAndNorm(
@@ -100,22 +105,15 @@ public:
   inline double difference( const  VLD& vld2 )const
   {
     double diff[ 2 ];
-    diff[ 0 ] = 0;
-    diff[ 1 ] = 0;
 
     if (contrast > 300 || vld2.contrast > 300  || contrast <= 0 || vld2.contrast <=0 )
       return 128;
 
-    for (int i = 0; i < dimension; i++ )
-    {
-      for (int j = 0; j < subdirection; j++ )
-      {// term of descriptor
-        diff[ 0 ] += std::abs( descriptor[ i * subdirection + j ] - vld2.descriptor[ i * subdirection + j ] );
-      }
-      //term of main SIFT like orientation
-      diff[ 1 ] += std::min( std::abs( principleAngle[ i ] - vld2.principleAngle[ i ] ),
-        binNum - std::abs( principleAngle[ i ] - vld2.principleAngle[ i ] ) ) * ( weight[ i ] + vld2.weight[ i ] );// orientation term
-    }
+    // term of descriptor
+    diff[ 0 ] = ( descriptor - vld2.descriptor ).cwiseAbs().sum();
+    //term of main SIFT like orientation
+    const Eigen::Array< int, dimension, 1 > angle_diff = ( principleAngle - vld2.principleAngle ).array().abs();
+    diff[ 1 ] = ( angle_diff.min( binNum - angle_diff ).cast<double>() * ( weight + vld2.weight ).array() ).sum();// orientation term
 
     diff[ 0 ] *= 0.36;
     diff[ 1 ] *= 0.64 / ( binNum );
@@ -169,6 +167,9 @@ public:
 //    matches.size vector with all equal to true.  e.g.  std::vector<bool> valide(size, true);
 //
 //kvldParameters: container of minimum inlier rate, the value of K (=3 initially) and geometric verification flag (true initially)
+//
+//The neighbor matches are found with a spatial grid, and the vld-consistencies of the neighbors of all the
+//matches are computed in parallel (OpenMP), the result being the same as the sequential processing.
 
 float KVLD(const openMVG::image::Image<float>& I1,
   const openMVG::image::Image<float>& I2,
@@ -181,4 +182,28 @@ float KVLD(const openMVG::image::Image<float>& I1,
   std::vector<bool>& valide,
   KvldParameters& kvldParameters );
 
+//Same as above with the ImageScale of the images (allowing to reuse them for several pairs).
+float KVLD(const ImageScale& Chaine1,
+  const ImageScale& Chaine2,
+  const std::vector<openMVG::features::SIOPointFeature> & F1,
+  const std::vector<openMVG::features::SIOPointFeature> & F2,
+  const std::vector<openMVG::Pair>& matches,
+  std::vector<openMVG::Pair>& matchesFiltered,
+  std::vector<double>& score,
+  openMVG::Mat& E,
+  std::vector<bool>& valide,
+  KvldParameters& kvldParameters );
+
+//Same as above without the gvld-consistency matrix (its memory is quadratic in the match count):
+//it can be used for large match sets, the consistency of the neighbor matches is not kept from one call to another.
+float KVLD(const ImageScale& Chaine1,
+  const ImageScale& Chaine2,
+  const std::vector<openMVG::features::SIOPointFeature> & F1,
+  const std::vector<openMVG::features::SIOPointFeature> & F2,
+  const std::vector<openMVG::Pair>& matches,
+  std::vector<openMVG::Pair>& matchesFiltered,
+  std::vector<double>& score,
+  std::vector<bool>& valide,
+  KvldParameters& kvldParameters );
+
 #endif // OPENMVG_MATCHING_KVLD_H
@@ -0,0 +1,683 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/matching/matcher_brute_force_batched.hpp"
+#include "openMVG/system/cpu_instruction_set.hpp"
+
+#include <algorithm>
+#include <limits>
+
+// The SIMD kernels are compiled for their own instruction set (function target
+// attributes) and are only called if the CPU supports it (runtime dispatch),
+// so the library does not have to be built with -mavx2 or -mavx512f.
+#if (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)) \
+  && (defined(__GNUC__) || defined(__clang__) || (defined(_MSC_VER) && _MSC_VER >= 1910))
+  #define OPENMVG_BATCHED_L2_SIMD
+  #include <immintrin.h>
+  #if defined(_MSC_VER) && !defined(__clang__)
+    #define OPENMVG_TARGET_AVX2
+    #define OPENMVG_TARGET_AVX512
+  #else
+    #define OPENMVG_TARGET_AVX2 __attribute__((target("avx2,fma")))
+    #define OPENMVG_TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+  #endif
+#endif
+
+namespace openMVG {
+namespace matching {
+namespace internal {
+
+/// Number of queries processed together on a database chunk
+static const int kQueryGroup = 64;
+/// Size of the database chunks (they are kept in cache while a query group is processed)
+static const int kChunkBytes = 128 * 1024;
+
+/// Two nearest candidates of a query per lane (state of the kernels)
+template <typename DistanceT>
+struct LaneTopTwo
+{
+  DistanceT best[2][kPanelWidth];
+  int32_t index[2][kPanelWidth];
+
+  LaneTopTwo()
+  {
+    std::fill(&best[0][0], &best[0][0] + 2 * kPanelWidth, std::numeric_limits<DistanceT>::max());
+    std::fill(&index[0][0], &index[0][0] + 2 * kPanelWidth, -1);
+  }
+};
+
+/// Process the panels [panel_begin, panel_end[ for a block of packed queries
+template <typename Scalar>
+using KernelFunction = void (*)
+(
+  const L2Panels<Scalar> & panels,
+  int panel_begin,
+  int panel_end,
+  const typename L2Panels<Scalar>::ElementT * queries,
+  LaneTopTwo<typename L2Panels<Scalar>::DistanceT> * states
+);
+
+//--
+//-- Descriptor packing
+//--
+
+static int Depth(const unsigned char *, int dimension) { return (dimension + 1) / 2; }
+static int Depth(const float *, int dimension) { return dimension; }
+
+// Dimension pairs packed as two int16 in an int32 (zero padded for odd dimensions)
+static int Pack(const unsigned char * descriptor, int dimension, int32_t * elements, int stride)
+{
+  int norm = 0;
+  for (int k = 0; k < dimension; k += 2)
+  {
+    const int32_t low = descriptor[k];
+    const int32_t high = (k + 1 < dimension) ? descriptor[k + 1] : 0;
+    elements[(k / 2) * stride] = low | (high << 16);
+    norm += low * low + high * high;
+  }
+  return norm;
+}
+
+static float Pack(const float * descriptor, int dimension, float * elements, int stride)
+{
+  float norm = 0.f;
+  for (int k = 0; k < dimension; ++k)
+  {
+    elements[k * stride] = descriptor[k];
+    norm += descriptor[k] * descriptor[k];
+  }
+  return norm;
+}
+
+// Norm of the padding lanes: larger than any descriptor distance, but the
+// distance computation must not overflow
+static int PaddingNorm(int) { return 1 << 30; }
+static float PaddingNorm(float) { return 1e30f; }
+
+template <typename Scalar>
+static void BuildPanelsT
+(
+  const Scalar * dataset,
+  int rows,
+  int dimension,
+  L2Panels<Scalar> & panels
+)
+{
+  using DistanceT = typename L2Panels<Scalar>::DistanceT;
+  panels.rows = rows;
+  panels.dimension = dimension;
+  panels.depth = Depth(dataset, dimension);
+  panels.panel_count = (rows + kPanelWidth - 1) / kPanelWidth;
+  panels.elements.assign(
+    static_cast<size_t>(panels.panel_count) * panels.depth * kPanelWidth, 0);
+  panels.norms.assign(panels.panel_count * kPanelWidth, PaddingNorm(DistanceT()));
+
+  for (int i = 0; i < rows; ++i)
+  {
+    const int panel = i / kPanelWidth;
+    const int lane = i % kPanelWidth;
+    panels.norms[i] = Pack(dataset + static_cast<size_t>(i) * dimension, dimension,
+      panels.elements.data() + static_cast<size_t>(panel) * panels.depth * kPanelWidth + lane,
+      kPanelWidth);
+  }
+}
+
+//--
+//-- Generic kernel: tiles of Q queries x 16 database descriptors
+//--
+
+// Sum of the products of the packed int16 pairs (the values fit in 16 bits,
+// so the compiler can use the 16 bit SIMD multiplications)
+static inline int MulAdd(int acc, int32_t query, int32_t database)
+{
+  return acc + static_cast<int16_t>(query) * static_cast<int16_t>(database)
+    + static_cast<int16_t>(query >> 16) * static_cast<int16_t>(database >> 16);
+}
+
+static inline float MulAdd(float acc, float query, float database)
+{
+  return acc + query * database;
+}
+
+template <typename Scalar, int Q>
+static void TopTwoGeneric
+(
+  const L2Panels<Scalar> & panels,
+  int panel_begin,
+  int panel_end,
+  const typename L2Panels<Scalar>::ElementT * queries,
+  LaneTopTwo<typename L2Panels<Scalar>::DistanceT> * states
+)
+{
+  using ElementT = typename L2Panels<Scalar>::ElementT;
+  using DistanceT = typename L2Panels<Scalar>::DistanceT;
+  const int depth = panels.depth;
+  for (int p = panel_begin; p < panel_end; ++p)
+  {
+    DistanceT dot[Q][kPanelWidth] = {};
+    const ElementT * panel = panels.elements.data() + static_cast<size_t>(p) * depth * kPanelWidth;
+    for (int k = 0; k < depth; ++k, panel += kPanelWidth)
+    {
+      for (int q = 0; q < Q; ++q)
+      {
+        const ElementT query = queries[q * depth + k];
+        for (int lane = 0; lane < kPanelWidth; ++lane)
+          dot[q][lane] = MulAdd(dot[q][lane], query, panel[lane]);
+      }
+    }
+    for (int q = 0; q < Q; ++q)
+    {
+      LaneTopTwo<DistanceT> & state = states[q];
+      for (int lane = 0; lane < kPanelWidth; ++lane)
+      {
+        const DistanceT dist = panels.norms[p * kPanelWidth + lane] - 2 * dot[q][lane];
+        const int index = p * kPanelWidth + lane;
+        if (dist < state.best[0][lane])
+        {
+          state.best[1][lane] = state.best[0][lane];
+          state.index[1][lane] = state.index[0][lane];
+          state.best[0][lane] = dist;
+          state.index[0][lane] = index;
+        }
+        else if (dist < state.best[1][lane])
+        {
+          state.best[1][lane] = dist;
+          state.index[1][lane] = index;
+        }
+      }
+    }
+  }
+}
+
+#ifdef OPENMVG_BATCHED_L2_SIMD
+
+//--
+//-- AVX2 kernel: tiles of Q queries x 16 database descriptors (2 registers)
+//--
+
+struct AVX2_L2_UChar
+{
+  using ScalarT = unsigned char;
+  using RegT = __m256i;
+  using ValueT = int32_t;
+
+  OPENMVG_TARGET_AVX2 static inline RegT Zero() { return _mm256_setzero_si256(); }
+  OPENMVG_TARGET_AVX2 static inline RegT Load(const ValueT * p)
+  {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+  }
+  OPENMVG_TARGET_AVX2 static inline void Store(ValueT * p, RegT a)
+  {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), a);
+  }
+  OPENMVG_TARGET_AVX2 static inline RegT Broadcast(ValueT a) { return _mm256_set1_epi32(a); }
+  // acc + (query pairs . database pairs)
+  OPENMVG_TARGET_AVX2 static inline RegT MulAdd(RegT acc, RegT query, RegT database)
+  {
+    return _mm256_add_epi32(acc, _mm256_madd_epi16(query, database));
+  }
+  // norm - 2 dot
+  OPENMVG_TARGET_AVX2 static inline RegT Distance(RegT norm, RegT dot)
+  {
+    return _mm256_sub_epi32(norm, _mm256_add_epi32(dot, dot));
+  }
+  OPENMVG_TARGET_AVX2 static inline RegT Min(RegT a, RegT b) { return _mm256_min_epi32(a, b); }
+  OPENMVG_TARGET_AVX2 static inline RegT Max(RegT a, RegT b) { return _mm256_max_epi32(a, b); }
+  OPENMVG_TARGET_AVX2 static inline __m256i Greater(RegT a, RegT b) { return _mm256_cmpgt_epi32(a, b); }
+};
+
+struct AVX2_L2_Float
+{
+  using ScalarT = float;
+  using RegT = __m256;
+  using ValueT = float;
+
+  OPENMVG_TARGET_AVX2 static inline RegT Zero() { return _mm256_setzero_ps(); }
+  OPENMVG_TARGET_AVX2 static inline RegT Load(const ValueT * p) { return _mm256_loadu_ps(p); }
+  OPENMVG_TARGET_AVX2 static inline void Store(ValueT * p, RegT a) { _mm256_storeu_ps(p, a); }
+  OPENMVG_TARGET_AVX2 static inline RegT Broadcast(ValueT a) { return _mm256_set1_ps(a); }
+  OPENMVG_TARGET_AVX2 static inline RegT MulAdd(RegT acc, RegT query, RegT database)
+  {
+    return _mm256_fmadd_ps(query, database, acc);
+  }
+  OPENMVG_TARGET_AVX2 static inline RegT Distance(RegT norm, RegT dot)
+  {
+    return _mm256_fnmadd_ps(_mm256_set1_ps(2.f), dot, norm);
+  }
+  OPENMVG_TARGET_AVX2 static inline RegT Min(RegT a, RegT b) { return _mm256_min_ps(a, b); }
+  OPENMVG_TARGET_AVX2 static inline RegT Max(RegT a, RegT b) { return _mm256_max_ps(a, b); }
+  OPENMVG_TARGET_AVX2 static inline __m256i Greater(RegT a, RegT b)
+  {
+    return _mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_GT_OQ));
+  }
+};
+
+template <typename Ops, int Q>
+OPENMVG_TARGET_AVX2 static void TopTwoAVX2
+(
+  const L2Panels<typename Ops::ScalarT> & panels,
+  int panel_begin,
+  int panel_end,
+  const typename Ops::ValueT * queries,
+  LaneTopTwo<typename Ops::ValueT> * states
+)
+{
+  using RegT = typename Ops::RegT;
+  using ValueT = typename Ops::ValueT;
+  const int depth = panels.depth;
+
+  RegT best1[Q][2], best2[Q][2];
+  __m256i index1[Q][2], index2[Q][2];
+  for (int q = 0; q < Q; ++q)
+  {
+    for (int h = 0; h < 2; ++h)
+    {
+      best1[q][h] = Ops::Load(states[q].best[0] + 8 * h);
+      best2[q][h] = Ops::Load(states[q].best[1] + 8 * h);
+      index1[q][h] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(states[q].index[0] + 8 * h));
+      index2[q][h] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(states[q].index[1] + 8 * h));
+    }
+  }
+  const __m256i lane_index[2] = {
+    _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+    _mm256_setr_epi32(8, 9, 10, 11, 12, 13, 14, 15)};
+
+  for (int p = panel_begin; p < panel_end; ++p)
+  {
+    const ValueT * panel = panels.elements.data() + static_cast<size_t>(p) * depth * kPanelWidth;
+    RegT dot[Q][2];
+    for (int q = 0; q < Q; ++q)
+      dot[q][0] = dot[q][1] = Ops::Zero();
+
+    for (int k = 0; k < depth; ++k, panel += kPanelWidth)
+    {
+      const RegT database0 = Ops::Load(panel);
+      const RegT database1 = Ops::Load(panel + 8);
+      for (int q = 0; q < Q; ++q)
+      {
+        const RegT query = Ops::Broadcast(queries[q * depth + k]);
+        dot[q][0] = Ops::MulAdd(dot[q][0], query, database0);
+        dot[q][1] = Ops::MulAdd(dot[q][1], query, database1);
+      }
+    }
+
+    // Update the two nearest candidates of each lane
+    const __m256i panel_index = _mm256_set1_epi32(p * kPanelWidth);
+    for (int h = 0; h < 2; ++h)
+    {
+      const RegT norm = Ops::Load(panels.norms.data() + p * kPanelWidth + 8 * h);
+      const __m256i index = _mm256_add_epi32(panel_index, lane_index[h]);
+      for (int q = 0; q < Q; ++q)
+      {
+        const RegT dist = Ops::Distance(norm, dot[q][h]);
+        const __m256i closer1 = Ops::Greater(best1[q][h], dist);
+        const __m256i closer2 = Ops::Greater(best2[q][h], dist);
+        index2[q][h] = _mm256_blendv_epi8(
+          _mm256_blendv_epi8(index2[q][h], index, closer2), index1[q][h], closer1);
+        index1[q][h] = _mm256_blendv_epi8(index1[q][h], index, closer1);
+        best2[q][h] = Ops::Min(best2[q][h], Ops::Max(best1[q][h], dist));
+        best1[q][h] = Ops::Min(best1[q][h], dist);
+      }
+    }
+  }
+
+  for (int q = 0; q < Q; ++q)
+  {
+    for (int h = 0; h < 2; ++h)
+    {
+      Ops::Store(states[q].best[0] + 8 * h, best1[q][h]);
+      Ops::Store(states[q].best[1] + 8 * h, best2[q][h]);
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(states[q].index[0] + 8 * h), index1[q][h]);
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(states[q].index[1] + 8 * h), index2[q][h]);
+    }
+  }
+}
+
+//--
+//-- AVX-512 kernel: tiles of Q queries x 16 database descriptors (1 register)
+//--
+
+struct AVX512_L2_UChar
+{
+  using ScalarT = unsigned char;
+  using RegT = __m512i;
+  using ValueT = int32_t;
+
+  OPENMVG_TARGET_AVX512 static inline RegT Zero() { return _mm512_setzero_si512(); }
+  OPENMVG_TARGET_AVX512 static inline RegT Load(const ValueT * p) { return _mm512_loadu_si512(p); }
+  OPENMVG_TARGET_AVX512 static inline void Store(ValueT * p, RegT a) { _mm512_storeu_si512(p, a); }
+  OPENMVG_TARGET_AVX512 static inline RegT Broadcast(ValueT a) { return _mm512_set1_epi32(a); }
+  OPENMVG_TARGET_AVX512 static inline RegT MulAdd(RegT acc, RegT query, RegT database)
+  {
+    return _mm512_add_epi32(acc, _mm512_madd_epi16(query, database));
+  }
+  OPENMVG_TARGET_AVX512 static inline RegT Distance(RegT norm, RegT dot)
+  {
+    return _mm512_sub_epi32(norm, _mm512_add_epi32(dot, dot));
+  }
+  OPENMVG_TARGET_AVX512 static inline RegT Min(RegT a, RegT b) { return _mm512_min_epi32(a, b); }
+  OPENMVG_TARGET_AVX512 static inline RegT Max(RegT a, RegT b) { return _mm512_max_epi32(a, b); }
+  OPENMVG_TARGET_AVX512 static inline __mmask16 Greater(RegT a, RegT b)
+  {
+    return _mm512_cmpgt_epi32_mask(a, b);
+  }
+};
+
+struct AVX512_L2_Float
+{
+  using ScalarT = float;
+  using RegT = __m512;
+  using ValueT = float;
+
+  OPENMVG_TARGET_AVX512 static inline RegT Zero() { return _mm512_setzero_ps(); }
+  OPENMVG_TARGET_AVX512 static inline RegT Load(const ValueT * p) { return _mm512_loadu_ps(p); }
+  OPENMVG_TARGET_AVX512 static inline void Store(ValueT * p, RegT a) { _mm512_storeu_ps(p, a); }
+  OPENMVG_TARGET_AVX512 static inline RegT Broadcast(ValueT a) { return _mm512_set1_ps(a); }
+  OPENMVG_TARGET_AVX512 static inline RegT MulAdd(RegT acc, RegT query, RegT database)
+  {
+    return _mm512_fmadd_ps(query, database, acc);
+  }
+  OPENMVG_TARGET_AVX512 static inline RegT Distance(RegT norm, RegT dot)
+  {
+    return _mm512_fnmadd_ps(_mm512_set1_ps(2.f), dot, norm);
+  }
+  OPENMVG_TARGET_AVX512 static inline RegT Min(RegT a, RegT b) { return _mm512_min_ps(a, b); }
+  OPENMVG_TARGET_AVX512 static inline RegT Max(RegT a, RegT b) { return _mm512_max_ps(a, b); }
+  OPENMVG_TARGET_AVX512 static inline __mmask16 Greater(RegT a, RegT b)
+  {
+    return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ);
+  }
+};
+
+template <typename Ops, int Q>
+OPENMVG_TARGET_AVX512 static void TopTwoAVX512
+(
+  const L2Panels<typename Ops::ScalarT> & panels,
+  int panel_begin,
+  int panel_end,
+  const typename Ops::ValueT * queries,
+  LaneTopTwo<typename Ops::ValueT> * states
+)
+{
+  using RegT = typename Ops::RegT;
+  using ValueT = typename Ops::ValueT;
+  const int depth = panels.depth;
+
+  RegT best1[Q], best2[Q];
+  __m512i index1[Q], index2[Q];
+  for (int q = 0; q < Q; ++q)
+  {
+    best1[q] = Ops::Load(states[q].best[0]);
+    best2[q] = Ops::Load(states[q].best[1]);
+    index1[q] = _mm512_loadu_si512(states[q].index[0]);
+    index2[q] = _mm512_loadu_si512(states[q].index[1]);
+  }
+  const __m512i lane_index = _mm512_setr_epi32(
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+  for (int p = panel_begin; p < panel_end; ++p)
+  {
+    const ValueT * panel = panels.elements.data() + static_cast<size_t>(p) * depth * kPanelWidth;
+    RegT dot[Q];
+    for (int q = 0; q < Q; ++q)
+      dot[q] = Ops::Zero();
+
+    for (int k = 0; k < depth; ++k, panel += kPanelWidth)
+    {
+      const RegT database = Ops::Load(panel);
+      for (int q = 0; q < Q; ++q)
+        dot[q] = Ops::MulAdd(dot[q], Ops::Broadcast(queries[q * depth + k]), database);
+    }
+
+    // Update the two nearest candidates of each lane
+    const RegT norm = Ops::Load(panels.norms.data() + p * kPanelWidth);
+    const __m512i index = _mm512_add_epi32(_mm512_set1_epi32(p * kPanelWidth), lane_index);
+    for (int q = 0; q < Q; ++q)
+    {
+      const RegT dist = Ops::Distance(norm, dot[q]);
+      const __mmask16 closer1 = Ops::Greater(best1[q], dist);
+      const __mmask16 closer2 = Ops::Greater(best2[q], dist);
+      index2[q] = _mm512_mask_blend_epi32(closer1,
+        _mm512_mask_blend_epi32(closer2, index2[q], index), index1[q]);
+      index1[q] = _mm512_mask_blend_epi32(closer1, index1[q], index);
+      best2[q] = Ops::Min(best2[q], Ops::Max(best1[q], dist));
+      best1[q] = Ops::Min(best1[q], dist);
+    }
+  }
+
+  for (int q = 0; q < Q; ++q)
+  {
+    Ops::Store(states[q].best[0], best1[q]);
+    Ops::Store(states[q].best[1], best2[q]);
+    _mm512_storeu_si512(states[q].index[0], index1[q]);
+    _mm512_storeu_si512(states[q].index[1], index2[q]);
+  }
+}
+
+#endif // OPENMVG_BATCHED_L2_SIMD
+
+//--
+//-- Kernel selection
+//--
+
+bool IsSupported(EBruteForceKernel kernel)
+{
+  switch (kernel)
+  {
+    case EBruteForceKernel::AUTO:
+    case EBruteForceKernel::GENERIC:
+      return true;
+#ifdef OPENMVG_BATCHED_L2_SIMD
+    case EBruteForceKernel::AVX2:
+    {
+      const system::CpuInstructionSet cpu;
+      return cpu.supportAVX2() && cpu.supportFMA();
+    }
+    case EBruteForceKernel::AVX512:
+    {
+      const system::CpuInstructionSet cpu;
+      return cpu.supportAVX512F() && cpu.supportAVX512BW();
+    }
+#endif
+    default:
+      return false;
+  }
+}
+
+EBruteForceKernel SelectKernel(EBruteForceKernel kernel)
+{
+  if (kernel != EBruteForceKernel::AUTO && IsSupported(kernel))
+    return kernel;
+  if (IsSupported(EBruteForceKernel::AVX512))
+    return EBruteForceKernel::AVX512;
+  if (IsSupported(EBruteForceKernel::AVX2))
+    return EBruteForceKernel::AVX2;
+  return EBruteForceKernel::GENERIC;
+}
+
+/// Return the kernel function and its number of queries per call
+#ifdef OPENMVG_BATCHED_L2_SIMD
+template <typename Scalar, typename AVX2_Ops, typename AVX512_Ops>
+static KernelFunction<Scalar> GetKernel(EBruteForceKernel kernel, int & block)
+{
+  switch (kernel)
+  {
+    case EBruteForceKernel::AVX512:
+      block = 8;
+      return &TopTwoAVX512<AVX512_Ops, 8>;
+    case EBruteForceKernel::AVX2:
+      block = 4;
+      return &TopTwoAVX2<AVX2_Ops, 4>;
+    default:
+      break;
+  }
+  block = 2;
+  return &TopTwoGeneric<Scalar, 2>;
+}
+#else
+template <typename Scalar, typename AVX2_Ops, typename AVX512_Ops>
+static KernelFunction<Scalar> GetKernel(EBruteForceKernel, int & block)
+{
+  block = 2;
+  return &TopTwoGeneric<Scalar, 2>;
+}
+#endif
+
+//--
+//-- Search
+//--
+
+static inline int QueryDistance(int norm, int partial) { return norm + partial; }
+static inline float QueryDistance(float norm, float partial)
+{
+  // Avoid the negative distances due to the rounding errors
+  return std::max(0.f, norm + partial);
+}
+
+template <typename Scalar>
+static void SearchTopTwoT
+(
+  const L2Panels<Scalar> & panels,
+  const Scalar * queries,
+  int query_count,
+  KernelFunction<Scalar> kernel,
+  int block,
+  TopTwo<typename L2Panels<Scalar>::DistanceT> * results
+)
+{
+  using ElementT = typename L2Panels<Scalar>::ElementT;
+  using DistanceT = typename L2Panels<Scalar>::DistanceT;
+  const int depth = panels.depth;
+  const int chunk = std::max<int>(1,
+    kChunkBytes / (depth * kPanelWidth * static_cast<int>(sizeof(ElementT))));
+  const int group_count = (query_count + kQueryGroup - 1) / kQueryGroup;
+
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for schedule(dynamic) if (group_count > 1)
+#endif
+  for (int group = 0; group < group_count; ++group)
+  {
+    const int first = group * kQueryGroup;
+    const int count = std::min(kQueryGroup, query_count - first);
+    // The last block is completed by zero queries
+    const int padded_count = ((count + block - 1) / block) * block;
+
+    std::vector<ElementT> packed(static_cast<size_t>(padded_count) * depth, 0);
+    std::vector<DistanceT> norms(count);
+    for (int i = 0; i < count; ++i)
+    {
+      norms[i] = Pack(queries + static_cast<size_t>(first + i) * panels.dimension,
+        panels.dimension, packed.data() + static_cast<size_t>(i) * depth, 1);
+    }
+
+    // Each database chunk is processed by all the queries of the group
+    std::vector<LaneTopTwo<DistanceT>> states(padded_count);
+    for (int panel = 0; panel < panels.panel_count; panel += chunk)
+    {
+      const int panel_end = std::min(panel + chunk, panels.panel_count);
+      for (int i = 0; i < padded_count; i += block)
+        kernel(panels, panel, panel_end, packed.data() + static_cast<size_t>(i) * depth, &states[i]);
+    }
+
+    // Merge the candidates of the lanes
+    for (int i = 0; i < count; ++i)
+    {
+      TopTwo<DistanceT> & result = results[first + i];
+      result.distance[0] = result.distance[1] = std::numeric_limits<DistanceT>::max();
+      result.index[0] = result.index[1] = -1;
+      for (int rank = 0; rank < 2; ++rank)
+      {
+        for (int lane = 0; lane < kPanelWidth; ++lane)
+        {
+          const int index = states[i].index[rank][lane];
+          if (index < 0 || index >= panels.rows)
+            continue;
+          const DistanceT dist = QueryDistance(norms[i], states[i].best[rank][lane]);
+          if (dist < result.distance[0] || (dist == result.distance[0] && index < result.index[0]))
+          {
+            result.distance[1] = result.distance[0];
+            result.index[1] = result.index[0];
+            result.distance[0] = dist;
+            result.index[0] = index;
+          }
+          else if (dist < result.distance[1] || (dist == result.distance[1] && index < result.index[1]))
+          {
+            result.distance[1] = dist;
+            result.index[1] = index;
+          }
+        }
+      }
+    }
+  }
+}
+
+void BuildPanels
+(
+  const unsigned char * dataset,
+  int rows,
+  int dimension,
+  L2Panels<unsigned char> & panels
+)
+{
+  BuildPanelsT(dataset, rows, dimension, panels);
+}
+
+void BuildPanels
+(
+  const float * dataset,
+  int rows,
+  int dimension,
+  L2Panels<float> & panels
+)
+{
+  BuildPanelsT(dataset, rows, dimension, panels);
+}
+
+void SearchTopTwo
+(
+  const L2Panels<unsigned char> & panels,
+  const unsigned char * queries,
+  int query_count,
+  EBruteForceKernel kernel,
+  TopTwo<int> * results
+)
+{
+  int block = 1;
+#ifdef OPENMVG_BATCHED_L2_SIMD
+  const KernelFunction<unsigned char> kernel_function =
+    GetKernel<unsigned char, AVX2_L2_UChar, AVX512_L2_UChar>(kernel, block);
+#else
+  const KernelFunction<unsigned char> kernel_function =
+    GetKernel<unsigned char, void, void>(kernel, block);
+#endif
+  SearchTopTwoT(panels, queries, query_count, kernel_function, block, results);
+}
+
+void SearchTopTwo
+(
+  const L2Panels<float> & panels,
+  const float * queries,
+  int query_count,
+  EBruteForceKernel kernel,
+  TopTwo<float> * results
+)
+{
+  int block = 1;
+#ifdef OPENMVG_BATCHED_L2_SIMD
+  const KernelFunction<float> kernel_function =
+    GetKernel<float, AVX2_L2_Float, AVX512_L2_Float>(kernel, block);
+#else
+  const KernelFunction<float> kernel_function =
+    GetKernel<float, void, void>(kernel, block);
+#endif
+  SearchTopTwoT(panels, queries, query_count, kernel_function, block, results);
+}
+
+} // namespace internal
+} // namespace matching
+} // namespace openMVG
@@ -0,0 +1,255 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_MATCHING_MATCHER_BRUTE_FORCE_BATCHED_HPP
+#define OPENMVG_MATCHING_MATCHER_BRUTE_FORCE_BATCHED_HPP
+
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "openMVG/matching/matching_interface.hpp"
+#include "openMVG/matching/metric.hpp"
+
+namespace openMVG {
+namespace matching {
+
+/// Instruction set used by the batched brute force L2 kernels
+enum class EBruteForceKernel
+{
+  AUTO,    // The best kernel supported by the CPU (runtime detection)
+  GENERIC, // Portable C++ kernel
+  AVX2,    // AVX2 + FMA kernel (4 queries x 16 database descriptors tiles)
+  AVX512   // AVX-512 F + BW kernel (8 queries x 16 database descriptors tiles)
+};
+
+namespace internal {
+
+/// Number of database descriptors processed together by the kernels
+static const int kPanelWidth = 16;
+
+template <typename Scalar> struct L2PanelTraits;
+
+/// unsigned char: the dimensions are paired, each pair is packed as two int16
+///  in an int32 (pairwise multiply-add of the AVX2 & AVX-512 BW instruction sets)
+template <> struct L2PanelTraits<unsigned char>
+{
+  using ElementT = int32_t;
+  using DistanceT = int;
+};
+
+template <> struct L2PanelTraits<float>
+{
+  using ElementT = float;
+  using DistanceT = float;
+};
+
+/**
+ * Database descriptors stored by panels of kPanelWidth descriptors interleaved
+ * by dimension: elements[panel][depth][lane] (the last panel is zero padded).
+ * The squared L2 distance is computed as |q|^2 + |d|^2 - 2 q.d, the squared
+ * norms of the database descriptors are computed once at build time.
+ */
+template <typename Scalar>
+struct L2Panels
+{
+  using ElementT = typename L2PanelTraits<Scalar>::ElementT;
+  using DistanceT = typename L2PanelTraits<Scalar>::DistanceT;
+
+  int rows = 0;        // Number of database descriptors
+  int dimension = 0;   // Descriptor dimension
+  int depth = 0;       // Number of elements per descriptor
+  int panel_count = 0;
+  std::vector<ElementT> elements;
+  /// Squared norms [panel * kPanelWidth + lane] (a huge value for the padding lanes)
+  std::vector<DistanceT> norms;
+};
+
+/// Two nearest database descriptors of a query (squared L2 distances)
+template <typename DistanceT>
+struct TopTwo
+{
+  DistanceT distance[2];
+  int index[2];
+};
+
+/// Return true if the kernel can be run on this CPU and OS (and was compiled in)
+bool IsSupported(EBruteForceKernel kernel);
+
+/// Resolve AUTO (or an unsupported kernel) to the best supported kernel
+EBruteForceKernel SelectKernel(EBruteForceKernel kernel);
+
+void BuildPanels
+(
+  const unsigned char * dataset,
+  int rows,
+  int dimension,
+  L2Panels<unsigned char> & panels
+);
+
+void BuildPanels
+(
+  const float * dataset,
+  int rows,
+  int dimension,
+  L2Panels<float> & panels
+);
+
+/// Search the two nearest database descriptors of each query
+void SearchTopTwo
+(
+  const L2Panels<unsigned char> & panels,
+  const unsigned char * queries,
+  int query_count,
+  EBruteForceKernel kernel,
+  TopTwo<int> * results
+);
+
+void SearchTopTwo
+(
+  const L2Panels<float> & panels,
+  const float * queries,
+  int query_count,
+  EBruteForceKernel kernel,
+  TopTwo<float> * results
+);
+
+} // namespace internal
+
+/**
+ * Brute force squared L2 matcher computing tiles of query x database distances
+ * at once (register blocked kernels), for unsigned char and float descriptors.
+ * The two nearest neighbors of each query are tracked in registers (one
+ * candidate pair per SIMD lane), so only NN <= 2 searches are supported (i.e
+ * nearest neighbor and distance ratio matching).
+ * The kernel (AVX-512, AVX2 or generic) is chosen at runtime by default.
+ */
+template <typename Scalar = float>
+class ArrayMatcherBruteForceBatched : public ArrayMatcher<Scalar, L2<Scalar>>
+{
+  static_assert(std::is_same<Scalar, unsigned char>::value || std::is_same<Scalar, float>::value,
+    "ArrayMatcherBruteForceBatched supports only unsigned char and float descriptors");
+
+  public:
+  using DistanceType = typename L2<Scalar>::ResultType;
+
+  explicit ArrayMatcherBruteForceBatched
+  (
+    EBruteForceKernel kernel = EBruteForceKernel::AUTO
+  ): kernel_(internal::SelectKernel(kernel))
+  {}
+
+  virtual ~ArrayMatcherBruteForceBatched() = default;
+
+  /// The kernel used by the matcher
+  EBruteForceKernel Kernel() const { return kernel_; }
+
+  /**
+   * Build the matching structure (copy the dataset in the panel layout)
+   *
+   * \param[in] dataset   Input data.
+   * \param[in] nbRows    The number of component.
+   * \param[in] dimension Length of the data contained in the dataset.
+   *
+   * \return True if success.
+   */
+  bool Build
+  (
+    const Scalar * dataset,
+    int nbRows,
+    int dimension
+  ) override
+  {
+    if (nbRows < 1 || dimension < 1)
+    {
+      panels_ = internal::L2Panels<Scalar>();
+      return false;
+    }
+    internal::BuildPanels(dataset, nbRows, dimension, panels_);
+    return true;
+  }
+
+  /**
+   * Search the nearest Neighbor of the scalar array query.
+   *
+   * \param[in]   query     The query array.
+   * \param[out]  indice    The indice of array in the dataset that.
+   *  have been computed as the nearest array.
+   * \param[out]  distance  The distance between the two arrays.
+   *
+   * \return True if success.
+   */
+  bool SearchNeighbour
+  (
+    const Scalar * query,
+    int * indice,
+    DistanceType * distance
+  ) override
+  {
+    if (panels_.rows < 1)
+      return false;
+
+    internal::TopTwo<DistanceType> result;
+    internal::SearchTopTwo(panels_, query, 1, kernel_, &result);
+    *indice = result.index[0];
+    *distance = result.distance[0];
+    return true;
+  }
+
+  /**
+   * Search the N (<= 2) nearest Neighbor of the scalar array query.
+   *
+   * \param[in]   query     The query array.
+   * \param[in]   nbQuery   The number of query rows.
+   * \param[out]  indices   The corresponding (query, neighbor) indices.
+   * \param[out]  distances The distances between the matched arrays.
+   * \param[in]  NN        The number of maximal neighbor that will be searched.
+   *
+   * \return True if success.
+   */
+  bool SearchNeighbours
+  (
+    const Scalar * query, int nbQuery,
+    IndMatches * pvec_indices,
+    std::vector<DistanceType> * pvec_distances,
+    size_t NN
+  ) override
+  {
+    if (panels_.rows < 1 ||
+        NN < 1 || NN > 2 ||
+        NN > static_cast<size_t>(panels_.rows) ||
+        nbQuery < 1)
+    {
+      return false;
+    }
+
+    std::vector<internal::TopTwo<DistanceType>> results(nbQuery);
+    internal::SearchTopTwo(panels_, query, nbQuery, kernel_, results.data());
+
+    pvec_distances->resize(nbQuery * NN);
+    pvec_indices->resize(nbQuery * NN);
+    for (int i = 0; i < nbQuery; ++i)
+    {
+      for (size_t j = 0; j < NN; ++j)
+      {
+        (*pvec_distances)[i * NN + j] = results[i].distance[j];
+        (*pvec_indices)[i * NN + j] = IndMatch(i, results[i].index[j]);
+      }
+    }
+    return true;
+  }
+
+private:
+  EBruteForceKernel kernel_;
+  internal::L2Panels<Scalar> panels_;
+};
+
+}  // namespace matching
+}  // namespace openMVG
+
+#endif // OPENMVG_MATCHING_MATCHER_BRUTE_FORCE_BATCHED_HPP
@@ -36,7 +36,8 @@ class ArrayMatcher_Kdtree_Flann : public ArrayMatcher<Scalar, Metric>
   public:
   using DistanceType = typename Metric::ResultType;
 
-  ArrayMatcher_Kdtree_Flann() = default;
+  /// \param[in] checks Number of leaves checked by a search (accuracy vs. speed)
+  explicit ArrayMatcher_Kdtree_Flann(int checks = 128): checks_(checks) {}
 
   virtual ~ArrayMatcher_Kdtree_Flann() = default;
 
@@ -99,8 +100,7 @@ class ArrayMatcher_Kdtree_Flann : public ArrayMatcher<Scalar, Metric>
 
       flann::Matrix<int> indices(indicePTR, 1, 1);
       flann::Matrix<DistanceType> dists(distancePTR, 1, 1);
-      // do a knn search, using 128 checks
-      return (index_->knnSearch(queries, indices, dists, 1, flann::SearchParams(128)) > 0);
+      return (index_->knnSearch(queries, indices, dists, 1, flann::SearchParams(checks_)) > 0);
     }
     else
     {
@@ -138,8 +138,7 @@ class ArrayMatcher_Kdtree_Flann : public ArrayMatcher<Scalar, Metric>
       flann::Matrix<int> indices(&(vec_indices[0]), nbQuery, NN);
 
       flann::Matrix<Scalar> queries((Scalar*)query, nbQuery, dimension_);
-      // do a knn search, using 128 checks
-      flann::SearchParams params(128);
+      flann::SearchParams params(checks_);
 #ifdef OPENMVG_USE_OPENMP
       params.cores = omp_get_max_threads();
 #endif
@@ -174,6 +173,7 @@ class ArrayMatcher_Kdtree_Flann : public ArrayMatcher<Scalar, Metric>
   std::unique_ptr<flann::Matrix<Scalar>> datasetM_;
   std::unique_ptr<flann::Index<Metric>> index_;
   std::size_t dimension_;
+  int checks_;
 };
 
 } // namespace matching
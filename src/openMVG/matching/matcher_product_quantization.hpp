@@ -0,0 +1,219 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_MATCHING_MATCHER_PRODUCT_QUANTIZATION_HPP
+#define OPENMVG_MATCHING_MATCHER_PRODUCT_QUANTIZATION_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <typeinfo>
+#include <vector>
+
+#include "openMVG/features/pq_regions.hpp"
+#include "openMVG/matching/product_quantizer.hpp"
+#include "openMVG/matching/regions_matcher.hpp"
+
+namespace openMVG {
+namespace matching {
+
+/**
+ * Brute force matching of product quantized regions (features::PQ_Regions).
+ * The squared L2 distances are computed on the database codes directly:
+ *  - the query regions are product quantized by the same quantizer:
+ *     symmetric distances (centroid to centroid distance table),
+ *  - the query regions are raw unsigned char or float scalar regions:
+ *     asymmetric distances (a distance table is computed per query).
+ */
+class RegionsMatcherProductQuantization : public RegionsMatcher
+{
+private:
+  const features::PQ_Regions_Base * regions_;
+
+public:
+
+  /**
+   * @brief Init the matcher with some reference (product quantized) regions.
+   */
+  explicit RegionsMatcherProductQuantization
+  (
+    const features::Regions & regions
+  ):
+    regions_(dynamic_cast<const features::PQ_Regions_Base *>(&regions))
+  {
+  }
+
+  bool Match
+  (
+    const features::Regions & query_regions,
+    matching::IndMatches & matches
+  ) override
+  {
+    return Search(query_regions, std::numeric_limits<float>::infinity(), matches);
+  }
+
+  bool MatchDistanceRatio
+  (
+    const float distance_ratio,
+    const features::Regions & query_regions,
+    matching::IndMatches & matches
+  ) override
+  {
+    return Search(query_regions, Square(distance_ratio), matches);
+  }
+
+private:
+
+  /// Search the nearest database code of each query.
+  /// The match is kept if (first_distance < second_distance * squared_ratio).
+  bool Search
+  (
+    const features::Regions & query_regions,
+    const float squared_ratio,
+    matching::IndMatches & matches
+  ) const
+  {
+    matches.clear();
+    if (!regions_ || !regions_->Quantizer() || regions_->RegionCount() == 0)
+      return false;
+    const ProductQuantizer & quantizer = *regions_->Quantizer();
+    const int code_size = quantizer.CodeSize();
+
+    const features::PQ_Regions_Base * query_pq =
+      dynamic_cast<const features::PQ_Regions_Base *>(&query_regions);
+    if (query_pq)
+    {
+      if (query_pq->Quantizer() != regions_->Quantizer())
+      {
+        std::cerr << "The regions are not encoded by the same product quantizer" << std::endl;
+        return false;
+      }
+      // Symmetric distances
+      const uint8_t * query_codes = query_pq->Codes().data();
+      return Search(query_regions.RegionCount(), squared_ratio,
+        [&](size_t, std::vector<float> &) {},
+        [&](size_t query, const std::vector<float> &, const uint8_t * code)
+        {
+          return quantizer.SymmetricDistance(query_codes + query * code_size, code);
+        },
+        matches);
+    }
+
+    if (!query_regions.IsScalar()
+        || query_regions.DescriptorLength() != static_cast<size_t>(quantizer.Dimension()))
+    {
+      std::cerr << "Invalid query regions for the product quantized regions" << std::endl;
+      return false;
+    }
+    // Asymmetric distances
+    if (query_regions.Type_id() == typeid(unsigned char).name())
+      return SearchAsymmetric(
+        reinterpret_cast<const unsigned char *>(query_regions.DescriptorRawData()),
+        query_regions.RegionCount(), squared_ratio, matches);
+    if (query_regions.Type_id() == typeid(float).name())
+      return SearchAsymmetric(
+        reinterpret_cast<const float *>(query_regions.DescriptorRawData()),
+        query_regions.RegionCount(), squared_ratio, matches);
+
+    std::cerr << "Unsupported query regions type: " << query_regions.Type_id() << std::endl;
+    return false;
+  }
+
+  template <typename T>
+  bool SearchAsymmetric
+  (
+    const T * queries,
+    const size_t query_count,
+    const float squared_ratio,
+    matching::IndMatches & matches
+  ) const
+  {
+    const ProductQuantizer & quantizer = *regions_->Quantizer();
+    const int dimension = quantizer.Dimension();
+    return Search(query_count, squared_ratio,
+      [&](size_t query, std::vector<float> & table)
+      {
+        table.resize(quantizer.CodeSize() * ProductQuantizer::kCentroidCount);
+        quantizer.ComputeDistanceTable(queries + query * dimension, table.data());
+      },
+      [&](size_t, const std::vector<float> & table, const uint8_t * code)
+      {
+        return quantizer.AsymmetricDistance(table.data(), code);
+      },
+      matches);
+  }
+
+  /**
+   * @brief Brute force search of the 2 nearest database codes of each query.
+   * @param prepare_functor void(query, table) prepare the distance table of a query
+   * @param distance_functor float(query, table, code) squared distance to a code
+   */
+  template <typename PrepareFunctorT, typename DistanceFunctorT>
+  bool Search
+  (
+    const size_t query_count,
+    const float squared_ratio,
+    PrepareFunctorT prepare_functor,
+    DistanceFunctorT distance_functor,
+    matching::IndMatches & matches
+  ) const
+  {
+    const size_t code_size = regions_->DescriptorLength();
+    const size_t database_count = regions_->RegionCount();
+    const uint8_t * codes = regions_->Codes().data();
+
+    // Nearest database index of each query (-1 if the query is rejected)
+    std::vector<int> nearest(query_count, -1);
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp parallel
+#endif
+    {
+      std::vector<float> table;
+#ifdef OPENMVG_USE_OPENMP
+      #pragma omp for schedule(dynamic, 64)
+#endif
+      for (int query = 0; query < static_cast<int>(query_count); ++query)
+      {
+        prepare_functor(query, table);
+        float best = std::numeric_limits<float>::max();
+        float second = std::numeric_limits<float>::max();
+        int best_index = -1;
+        const uint8_t * code = codes;
+        for (size_t i = 0; i < database_count; ++i, code += code_size)
+        {
+          const float dist = distance_functor(query, table, code);
+          if (dist < best)
+          {
+            second = best;
+            best = dist;
+            best_index = static_cast<int>(i);
+          }
+          else if (dist < second)
+          {
+            second = dist;
+          }
+        }
+        if (std::isinf(squared_ratio) || best < squared_ratio * second)
+          nearest[query] = best_index;
+      }
+    }
+
+    for (size_t query = 0; query < query_count; ++query)
+    {
+      if (nearest[query] >= 0)
+        matches.emplace_back(nearest[query], query);
+    }
+    return (!matches.empty());
+  }
+};
+
+}  // namespace matching
+}  // namespace openMVG
+
+#endif // OPENMVG_MATCHING_MATCHER_PRODUCT_QUANTIZATION_HPP
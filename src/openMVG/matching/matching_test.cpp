@@ -9,6 +9,7 @@
 
 
 #include "openMVG/matching/matcher_brute_force.hpp"
+#include "openMVG/matching/matcher_brute_force_batched.hpp"
 #include "openMVG/matching/matcher_cascade_hashing.hpp"
 #include "openMVG/matching/matcher_kdtree_flann.hpp"
 
@@ -17,7 +18,9 @@
 
 #include "testing/testing.h"
 
+#include <cmath>
 #include <iostream>
+#include <random>
 using namespace std;
 
 using namespace openMVG;
@@ -118,6 +121,92 @@ TEST(Matching, ArrayMatcher_Kdtree_Flann_Simple__NN)
   EXPECT_EQ(IndMatch(0,4), vec_nIndice[4]);
 }
 
+TEST(Matching, ArrayMatcherBruteForceBatched_Simple_NN)
+{
+  const float array[] = {0, 1, 2, 5, 6};
+  for (const EBruteForceKernel kernel :
+    {EBruteForceKernel::GENERIC, EBruteForceKernel::AVX2, EBruteForceKernel::AVX512})
+  {
+    if (!internal::IsSupported(kernel))
+      continue;
+    ArrayMatcherBruteForceBatched<float> matcher(kernel);
+    EXPECT_TRUE( matcher.Build(array, 5, 1) );
+
+    const float query[] = {2};
+    int nIndice = -1;
+    float fDistance = -1.0f;
+    EXPECT_TRUE( matcher.SearchNeighbour( query, &nIndice, &fDistance) );
+    EXPECT_EQ( 2, nIndice);
+    EXPECT_NEAR( 0.0f, fDistance, 1e-6);
+
+    IndMatches vec_nIndice;
+    vector<float> vec_fDistance;
+    EXPECT_FALSE( matcher.SearchNeighbours(query, 1, &vec_nIndice, &vec_fDistance, 3) );
+    EXPECT_TRUE( matcher.SearchNeighbours(query, 1, &vec_nIndice, &vec_fDistance, 2) );
+    EXPECT_EQ( 2, vec_nIndice.size());
+    EXPECT_EQ(IndMatch(0,2), vec_nIndice[0]);
+    EXPECT_EQ(IndMatch(0,1), vec_nIndice[1]);
+    EXPECT_NEAR( vec_fDistance[1], Square(1.0f-2.0f), 1e-6);
+  }
+}
+
+// Random descriptors: the batched kernels must find the same two nearest
+// neighbors as the reference brute force matcher.
+// Return the number of mismatches (for all the kernels supported by the CPU).
+template <typename Scalar>
+static int BatchedVsBruteForceMismatches(const int dimension, std::mt19937 & rng)
+{
+  // Not multiple of the kernel panel and query block sizes
+  const int nb_database = 1003, nb_query = 157;
+  std::uniform_int_distribution<int> distrib(0, 255);
+  std::vector<Scalar> database(nb_database * dimension), queries(nb_query * dimension);
+  for (auto & value : database)
+    value = static_cast<Scalar>(distrib(rng));
+  for (auto & value : queries)
+    value = static_cast<Scalar>(distrib(rng));
+
+  using DistanceType = typename L2<Scalar>::ResultType;
+  ArrayMatcherBruteForce<Scalar> reference_matcher;
+  IndMatches reference_indices;
+  std::vector<DistanceType> reference_distances;
+  if (!reference_matcher.Build(database.data(), nb_database, dimension) ||
+      !reference_matcher.SearchNeighbours(queries.data(), nb_query,
+        &reference_indices, &reference_distances, 2))
+    return -1;
+
+  int mismatch_count = 0;
+  for (const EBruteForceKernel kernel :
+    {EBruteForceKernel::GENERIC, EBruteForceKernel::AVX2, EBruteForceKernel::AVX512})
+  {
+    if (!internal::IsSupported(kernel))
+      continue;
+    ArrayMatcherBruteForceBatched<Scalar> matcher(kernel);
+    IndMatches indices;
+    std::vector<DistanceType> distances;
+    if (matcher.Kernel() != kernel ||
+        !matcher.Build(database.data(), nb_database, dimension) ||
+        !matcher.SearchNeighbours(queries.data(), nb_query, &indices, &distances, 2) ||
+        indices.size() != reference_indices.size())
+      return -1;
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+      if (indices[i] != reference_indices[i] ||
+          std::abs(distances[i] - reference_distances[i]) > 1e-5 * reference_distances[i])
+        ++mismatch_count;
+    }
+  }
+  return mismatch_count;
+}
+
+TEST(Matching, ArrayMatcherBruteForceBatched_vs_ArrayMatcherBruteForce)
+{
+  std::mt19937 rng(std::mt19937::default_seed);
+  EXPECT_EQ(0, BatchedVsBruteForceMismatches<unsigned char>(128, rng));
+  EXPECT_EQ(0, BatchedVsBruteForceMismatches<unsigned char>(61, rng));
+  EXPECT_EQ(0, BatchedVsBruteForceMismatches<float>(64, rng));
+  EXPECT_EQ(0, BatchedVsBruteForceMismatches<float>(61, rng));
+}
+
 //-- Test LIMIT case (empty arrays)
 
 TEST(Matching, ArrayMatcherBruteForce_Simple_EmptyArrays)
@@ -140,6 +229,16 @@ TEST(Matching, ArrayMatcher_Kdtree_Flann_Simple_EmptyArrays)
   EXPECT_FALSE( matcher.SearchNeighbour(nullptr, &nIndice, &fDistance) );
 }
 
+TEST(Matching, ArrayMatcherBruteForceBatched_Simple_EmptyArrays)
+{
+  ArrayMatcherBruteForceBatched<float> matcher;
+  EXPECT_FALSE( matcher.Build(nullptr, 0, 4) );
+
+  int nIndice = -1;
+  float fDistance = -1.0f;
+  EXPECT_FALSE( matcher.SearchNeighbour(nullptr, &nIndice, &fDistance) );
+}
+
 TEST(Matching, Cascade_Hashing_Simple_EmptyArrays)
 {
   ArrayMatcherCascadeHashing<float> matcher;
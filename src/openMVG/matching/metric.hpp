@@ -12,6 +12,7 @@
 #include "openMVG/matching/metric_avx2.hpp"
 #include "openMVG/matching/metric_hamming.hpp"
 #include "openMVG/numeric/accumulator_trait.hpp"
+#include <Eigen/Core>
 #include <cstdint>
 
 namespace openMVG {
@@ -133,6 +134,25 @@ struct L2<float>
   }
 };
 
+// Template specialization for the half float type (computed in float)
+template<>
+struct L2<Eigen::half>
+{
+  using ElementType = Eigen::half;
+  using ResultType = float;
+
+  template <typename Iterator1, typename Iterator2>
+  inline ResultType operator()(Iterator1 a, Iterator2 b, size_t size) const
+  {
+    ResultType result = ResultType();
+    for (Iterator1 last = a + size; a < last; ++a, ++b) {
+      const ResultType diff = static_cast<float>(*a) - static_cast<float>(*b);
+      result += diff * diff;
+    }
+    return result;
+  }
+};
+
 }  // namespace matching
 }  // namespace openMVG
 
@@ -0,0 +1,233 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_MATCHING_PRODUCT_QUANTIZER_HPP
+#define OPENMVG_MATCHING_PRODUCT_QUANTIZER_HPP
+
+//------------------
+//-- Bibliography --
+//------------------
+//- [1] "Product quantization for nearest neighbor search"
+//- Authors: Herve Jegou, Matthijs Douze, Cordelia Schmid.
+//- Date: 2011.
+//- Journal: IEEE Transactions on Pattern Analysis and Machine Intelligence.
+
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "openMVG/clustering/kmeans.hpp"
+#include "openMVG/matching/metric.hpp"
+
+namespace openMVG {
+namespace matching {
+
+/**
+ * @brief Product quantizer [1]
+ * A descriptor is split in M sub-vectors, each sub-vector is quantized by its
+ * own codebook of 256 centroids: a descriptor is encoded in M bytes.
+ * The squared L2 distances are computed on the codes by table lookups:
+ *  - asymmetric distance (raw query vs. code): the query to centroids
+ *     distances are computed once per query (M x 256 table),
+ *  - symmetric distance (code vs. code): the centroid to centroid distances
+ *     are computed once per quantizer (M x 256 x 256 table).
+ */
+class ProductQuantizer
+{
+public:
+  /// Number of centroids per sub-quantizer (the codes are bytes)
+  static const int kCentroidCount = 256;
+
+  ProductQuantizer(): dimension_(0), sub_quantizer_count_(0), sub_dimension_(0) {}
+
+  /// Descriptor dimension
+  int Dimension() const { return dimension_; }
+  /// Code size in bytes (number of sub-quantizers)
+  int CodeSize() const { return sub_quantizer_count_; }
+  /// Return true if the quantizer is trained (or loaded)
+  bool IsValid() const { return sub_quantizer_count_ > 0; }
+
+  /**
+   * @brief Train the codebooks (kmeans of each sub-space)
+   * @param[in] data Training descriptors (one per row)
+   * @param[in] code_size Number of sub-quantizers, must divide the descriptor dimension
+   * @param[in] params KMeans parameters
+   * @return false if the code size is invalid or if there is less than
+   *  kCentroidCount training descriptors.
+   */
+  template <typename T>
+  bool Train
+  (
+    const clustering::KMeansMatrix<T> & data,
+    const int code_size,
+    const clustering::KMeansMatrixParams & params = clustering::KMeansMatrixParams()
+  )
+  {
+    if (code_size <= 0 || data.cols() % code_size != 0
+        || data.rows() < kCentroidCount)
+      return false;
+
+    dimension_ = data.cols();
+    sub_quantizer_count_ = code_size;
+    sub_dimension_ = dimension_ / sub_quantizer_count_;
+    centroids_.resize(sub_quantizer_count_ * kCentroidCount * sub_dimension_);
+
+    for (int m = 0; m < sub_quantizer_count_; ++m)
+    {
+      const clustering::KMeansMatrix<float> sub_data =
+        data.middleCols(m * sub_dimension_, sub_dimension_).template cast<float>();
+      std::vector<uint32_t> assignment;
+      clustering::KMeansMatrix<float> centers;
+      clustering::KMeans(sub_data, assignment, centers, kCentroidCount, params);
+      std::copy(centers.data(), centers.data() + centers.size(),
+        centroids_.begin() + m * kCentroidCount * sub_dimension_);
+    }
+    ComputeSymmetricTable();
+    return true;
+  }
+
+  /// Encode a descriptor (CodeSize() bytes)
+  template <typename T>
+  void Encode(const T * descriptor, uint8_t * code) const
+  {
+    std::vector<float> sub_vector(sub_dimension_);
+    for (int m = 0; m < sub_quantizer_count_; ++m)
+    {
+      for (int d = 0; d < sub_dimension_; ++d)
+        sub_vector[d] = static_cast<float>(descriptor[m * sub_dimension_ + d]);
+      float best = std::numeric_limits<float>::max();
+      for (int k = 0; k < kCentroidCount; ++k)
+      {
+        const float dist = L2<float>()(sub_vector.data(), Centroid(m, k), sub_dimension_);
+        if (dist < best)
+        {
+          best = dist;
+          code[m] = static_cast<uint8_t>(k);
+        }
+      }
+    }
+  }
+
+  /// Decode a code to its approximated descriptor
+  void Decode(const uint8_t * code, float * descriptor) const
+  {
+    for (int m = 0; m < sub_quantizer_count_; ++m)
+    {
+      std::copy(Centroid(m, code[m]), Centroid(m, code[m]) + sub_dimension_,
+        descriptor + m * sub_dimension_);
+    }
+  }
+
+  /// Compute the asymmetric distance table of a query (CodeSize() x kCentroidCount)
+  template <typename T>
+  void ComputeDistanceTable(const T * query, float * table) const
+  {
+    std::vector<float> sub_vector(sub_dimension_);
+    for (int m = 0; m < sub_quantizer_count_; ++m)
+    {
+      for (int d = 0; d < sub_dimension_; ++d)
+        sub_vector[d] = static_cast<float>(query[m * sub_dimension_ + d]);
+      for (int k = 0; k < kCentroidCount; ++k)
+      {
+        table[m * kCentroidCount + k] =
+          L2<float>()(sub_vector.data(), Centroid(m, k), sub_dimension_);
+      }
+    }
+  }
+
+  /// Squared L2 distance between a query (given by its distance table) and a code
+  float AsymmetricDistance(const float * table, const uint8_t * code) const
+  {
+    float dist = 0.f;
+    for (int m = 0; m < sub_quantizer_count_; ++m, table += kCentroidCount)
+      dist += table[code[m]];
+    return dist;
+  }
+
+  /// Squared L2 distance between two codes
+  float SymmetricDistance(const uint8_t * code_a, const uint8_t * code_b) const
+  {
+    float dist = 0.f;
+    const float * table = symmetric_table_.data();
+    for (int m = 0; m < sub_quantizer_count_; ++m, table += kCentroidCount * kCentroidCount)
+      dist += table[code_a[m] * kCentroidCount + code_b[m]];
+    return dist;
+  }
+
+  /// Save the codebooks to a binary file
+  bool Save(const std::string & filename) const
+  {
+    std::ofstream stream(filename.c_str(), std::ios::out | std::ios::binary);
+    if (!stream.is_open())
+      return false;
+    const int32_t header[2] = {dimension_, sub_quantizer_count_};
+    stream.write(reinterpret_cast<const char*>(header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(centroids_.data()),
+      centroids_.size() * sizeof(float));
+    return stream.good();
+  }
+
+  /// Load the codebooks from a binary file
+  bool Load(const std::string & filename)
+  {
+    std::ifstream stream(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!stream.is_open())
+      return false;
+    int32_t header[2];
+    if (!stream.read(reinterpret_cast<char*>(header), sizeof(header))
+        || header[0] <= 0 || header[1] <= 0 || header[0] % header[1] != 0)
+      return false;
+    dimension_ = header[0];
+    sub_quantizer_count_ = header[1];
+    sub_dimension_ = dimension_ / sub_quantizer_count_;
+    centroids_.resize(sub_quantizer_count_ * kCentroidCount * sub_dimension_);
+    if (!stream.read(reinterpret_cast<char*>(centroids_.data()),
+          centroids_.size() * sizeof(float)))
+    {
+      sub_quantizer_count_ = 0;
+      return false;
+    }
+    ComputeSymmetricTable();
+    return true;
+  }
+
+private:
+
+  const float * Centroid(const int m, const int k) const
+  {
+    return &centroids_[(m * kCentroidCount + k) * sub_dimension_];
+  }
+
+  void ComputeSymmetricTable()
+  {
+    symmetric_table_.resize(sub_quantizer_count_ * kCentroidCount * kCentroidCount);
+    for (int m = 0; m < sub_quantizer_count_; ++m)
+    {
+      float * table = &symmetric_table_[m * kCentroidCount * kCentroidCount];
+      for (int i = 0; i < kCentroidCount; ++i)
+      {
+        for (int j = 0; j < kCentroidCount; ++j)
+          table[i * kCentroidCount + j] =
+            L2<float>()(Centroid(m, i), Centroid(m, j), sub_dimension_);
+      }
+    }
+  }
+
+  int dimension_, sub_quantizer_count_, sub_dimension_;
+  /// Centroids of the sub-quantizers [sub-quantizer][centroid][sub-dimension]
+  std::vector<float> centroids_;
+  /// Centroid to centroid squared distances [sub-quantizer][centroid][centroid]
+  std::vector<float> symmetric_table_;
+};
+
+}  // namespace matching
+}  // namespace openMVG
+
+#endif // OPENMVG_MATCHING_PRODUCT_QUANTIZER_HPP
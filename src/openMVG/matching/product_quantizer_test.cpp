@@ -0,0 +1,234 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/features/regions_factory.hpp"
+#include "openMVG/matching/matcher_brute_force.hpp"
+#include "openMVG/matching/product_quantizer.hpp"
+#include "openMVG/matching/regions_matcher.hpp"
+
+#include "testing/testing.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+
+using namespace openMVG;
+using namespace openMVG::features;
+using namespace openMVG::matching;
+
+static const int kDatabaseCount = 2000;
+static const int kQueryCount = 200;
+
+// Clustered descriptors (database), the queries are noisy copies of the first
+// database descriptors.
+template <typename T>
+static void SyntheticDescriptors
+(
+  const int dimension,
+  const float center_range,
+  const float database_noise,
+  const float query_noise,
+  clustering::KMeansMatrix<T> & database,
+  clustering::KMeansMatrix<T> & queries
+)
+{
+  std::mt19937 rng(std::mt19937::default_seed);
+  std::uniform_real_distribution<float> distrib_center(0.f, center_range);
+  std::normal_distribution<float> distrib_database(0.f, database_noise);
+  std::normal_distribution<float> distrib_query(0.f, query_noise);
+
+  clustering::KMeansMatrix<float> centers(32, dimension);
+  for (int i = 0; i < centers.size(); ++i)
+    centers.data()[i] = distrib_center(rng);
+
+  const auto clamp = [&](const float value) -> T {
+    return static_cast<T>(std::min(std::max(value, 0.f), center_range)); };
+
+  database.resize(kDatabaseCount, dimension);
+  for (int i = 0; i < kDatabaseCount; ++i)
+  {
+    for (int j = 0; j < dimension; ++j)
+      database(i, j) = clamp(centers(i % centers.rows(), j) + distrib_database(rng));
+  }
+  queries.resize(kQueryCount, dimension);
+  for (int i = 0; i < kQueryCount; ++i)
+  {
+    for (int j = 0; j < dimension; ++j)
+      queries(i, j) = clamp(static_cast<float>(database(i, j)) + distrib_query(rng));
+  }
+}
+
+// Nearest neighbor recall: fraction of the queries matched to the same database
+// index as the exact matching
+static double Recall
+(
+  const IndMatches & exact_matches,
+  const IndMatches & matches
+)
+{
+  int count = 0;
+  for (const auto & match : matches)
+  {
+    count += std::count(exact_matches.cbegin(), exact_matches.cend(), match);
+  }
+  return count / static_cast<double>(exact_matches.size());
+}
+
+template <typename RegionsT, typename T>
+static void FillRegions(const clustering::KMeansMatrix<T> & descriptors, RegionsT & regions)
+{
+  for (int i = 0; i < descriptors.rows(); ++i)
+  {
+    regions.Features().emplace_back(i, i, 1.0f, 0.0f);
+    typename RegionsT::DescriptorT desc;
+    for (int j = 0; j < descriptors.cols(); ++j)
+      desc[j] = descriptors(i, j);
+    regions.Descriptors().push_back(desc);
+  }
+}
+
+TEST(ProductQuantizer, Encode_Decode_Save_Load)
+{
+  clustering::KMeansMatrix<unsigned char> database, queries;
+  SyntheticDescriptors(128, 255.f, 20.f, 15.f, database, queries);
+
+  ProductQuantizer quantizer;
+  EXPECT_FALSE(quantizer.Train(database, 15)); // 128 is not divisible by 15
+  EXPECT_FALSE(quantizer.Train(clustering::KMeansMatrix<unsigned char>(database.topRows(100)), 16));
+  EXPECT_TRUE(quantizer.Train(database, 16));
+  EXPECT_EQ(128, quantizer.Dimension());
+  EXPECT_EQ(16, quantizer.CodeSize());
+
+  // The distance tables are consistent with the decoded descriptors
+  std::vector<uint8_t> code_a(16), code_b(16);
+  quantizer.Encode(database.row(0).data(), code_a.data());
+  quantizer.Encode(database.row(1).data(), code_b.data());
+  std::vector<float> decoded_a(128), decoded_b(128), table(16 * ProductQuantizer::kCentroidCount);
+  quantizer.Decode(code_a.data(), decoded_a.data());
+  quantizer.Decode(code_b.data(), decoded_b.data());
+  EXPECT_NEAR(L2<float>()(decoded_a.data(), decoded_b.data(), 128),
+    quantizer.SymmetricDistance(code_a.data(), code_b.data()), 1e-1);
+  quantizer.ComputeDistanceTable(decoded_a.data(), table.data());
+  EXPECT_NEAR(L2<float>()(decoded_a.data(), decoded_b.data(), 128),
+    quantizer.AsymmetricDistance(table.data(), code_b.data()), 1e-1);
+
+  // Save, load and check that the codes are the same
+  EXPECT_TRUE(quantizer.Save("pq_codebooks.bin"));
+  ProductQuantizer loaded_quantizer;
+  EXPECT_TRUE(loaded_quantizer.Load("pq_codebooks.bin"));
+  std::remove("pq_codebooks.bin");
+  EXPECT_EQ(16, loaded_quantizer.CodeSize());
+  std::vector<uint8_t> loaded_code(16);
+  for (int i = 0; i < 100; ++i)
+  {
+    quantizer.Encode(database.row(i).data(), code_a.data());
+    loaded_quantizer.Encode(database.row(i).data(), loaded_code.data());
+    EXPECT_TRUE(code_a == loaded_code);
+  }
+}
+
+// Match the PQ encoded regions (loaded from the SIFT_Regions files) and report
+// the recall loss (vs. the uncompressed brute force matching).
+TEST(ProductQuantizer, PQ_Regions_Matching_Recall)
+{
+  clustering::KMeansMatrix<unsigned char> database, queries;
+  SyntheticDescriptors(128, 255.f, 20.f, 15.f, database, queries);
+
+  SIFT_Regions database_regions, query_regions;
+  FillRegions(database, database_regions);
+  FillRegions(queries, query_regions);
+  EXPECT_TRUE(database_regions.Save("pq_database.feat", "pq_database.desc"));
+  EXPECT_TRUE(query_regions.Save("pq_query.feat", "pq_query.desc"));
+
+  IndMatches exact_matches;
+  Match(BRUTE_FORCE_L2, database_regions, query_regions, exact_matches);
+  EXPECT_EQ(kQueryCount, exact_matches.size());
+
+  for (const int code_size : {8, 16})
+  {
+    auto quantizer = std::make_shared<ProductQuantizer>();
+    EXPECT_TRUE(quantizer->Train(database, code_size));
+
+    // The descriptors are encoded while they are read
+    std::unique_ptr<Regions> region_type(new SIFT_PQ_Regions(quantizer));
+    std::unique_ptr<Regions> database_pq(region_type->EmptyClone());
+    std::unique_ptr<Regions> query_pq(region_type->EmptyClone());
+    EXPECT_TRUE(database_pq->Load("pq_database.feat", "pq_database.desc"));
+    EXPECT_TRUE(query_pq->Load("pq_query.feat", "pq_query.desc"));
+    EXPECT_EQ(kDatabaseCount, database_pq->RegionCount());
+    EXPECT_EQ(code_size, database_pq->DescriptorLength());
+
+    // Symmetric (PQ queries) and asymmetric (raw queries) distances
+    IndMatches sdc_matches, adc_matches;
+    Match(BRUTE_FORCE_L2, *database_pq, *query_pq, sdc_matches);
+    Match(BRUTE_FORCE_L2, *database_pq, query_regions, adc_matches);
+    const double sdc_recall = Recall(exact_matches, sdc_matches);
+    const double adc_recall = Recall(exact_matches, adc_matches);
+    std::cout
+      << "PQ " << code_size << " bytes (" << 128 / code_size << "x less memory): "
+      << "recall SDC " << sdc_recall << ", ADC " << adc_recall << std::endl;
+    EXPECT_TRUE(sdc_recall > 0.9);
+    EXPECT_TRUE(adc_recall > 0.95);
+  }
+  std::remove("pq_database.feat");
+  std::remove("pq_database.desc");
+  std::remove("pq_query.feat");
+  std::remove("pq_query.desc");
+}
+
+// Load float descriptors as unsigned char and half float, and report the
+// recall loss (vs. the float brute force matching).
+TEST(QuantizedScalarRegions, AKAZE_Float_Matching_Recall)
+{
+  clustering::KMeansMatrix<float> database, queries;
+  SyntheticDescriptors(64, 1.f, 0.08f, 0.06f, database, queries);
+  // Normalized descriptors (as the AKAZE MSURF ones)
+  database.rowwise().normalize();
+  queries.rowwise().normalize();
+
+  AKAZE_Float_Regions database_regions, query_regions;
+  FillRegions(database, database_regions);
+  FillRegions(queries, query_regions);
+  EXPECT_TRUE(database_regions.Save("akaze_database.feat", "akaze_database.desc"));
+  EXPECT_TRUE(query_regions.Save("akaze_query.feat", "akaze_query.desc"));
+
+  IndMatches exact_matches;
+  Match(BRUTE_FORCE_L2, database_regions, query_regions, exact_matches);
+  EXPECT_EQ(kQueryCount, exact_matches.size());
+
+  const std::pair<std::string, std::shared_ptr<Regions>> region_types[] = {
+    {"unsigned char (4x less memory)", std::make_shared<AKAZE_Float_Uchar_Regions>()},
+    {"half float (2x less memory)", std::make_shared<AKAZE_Float_Half_Regions>()}};
+  for (const auto & region_type_it : region_types)
+  {
+    const std::shared_ptr<Regions> & region_type = region_type_it.second;
+    std::unique_ptr<Regions> database_compact(region_type->EmptyClone());
+    std::unique_ptr<Regions> query_compact(region_type->EmptyClone());
+    EXPECT_TRUE(database_compact->Load("akaze_database.feat", "akaze_database.desc"));
+    EXPECT_TRUE(query_compact->Load("akaze_query.feat", "akaze_query.desc"));
+
+    IndMatches matches;
+    Match(BRUTE_FORCE_L2, *database_compact, *query_compact, matches);
+    const double recall = Recall(exact_matches, matches);
+    std::cout << "AKAZE float descriptors as " << region_type_it.first
+      << ": recall " << recall << std::endl;
+    EXPECT_TRUE(recall > 0.95);
+  }
+  std::remove("akaze_database.feat");
+  std::remove("akaze_database.desc");
+  std::remove("akaze_query.feat");
+  std::remove("akaze_query.desc");
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
@@ -8,8 +8,10 @@
 
 #include "openMVG/matching/regions_matcher.hpp"
 #include "openMVG/matching/matcher_brute_force.hpp"
+#include "openMVG/matching/matcher_brute_force_batched.hpp"
 #include "openMVG/matching/matcher_cascade_hashing.hpp"
 #include "openMVG/matching/matcher_kdtree_flann.hpp"
+#include "openMVG/matching/matcher_product_quantization.hpp"
 #include "openMVG/matching/metric.hpp"
 #include "openMVG/matching/metric_hamming.hpp"
 
@@ -62,6 +64,13 @@ std::unique_ptr<RegionsMatcher> RegionMatcherFactory
     return {};
 
   std::unique_ptr<RegionsMatcher> region_matcher;
+  // Product quantized regions: the distances are computed on the codes
+  //  (by brute force, whatever the L2 matcher type)
+  if (dynamic_cast<const features::PQ_Regions_Base *>(&regions))
+  {
+    region_matcher.reset(new matching::RegionsMatcherProductQuantization(regions));
+    return region_matcher;
+  }
   // Switch regions type ID, matcher & Metric: initialize the Matcher interface
   if (regions.IsScalar())
   {
@@ -72,8 +81,7 @@ std::unique_ptr<RegionsMatcher> RegionMatcherFactory
       {
         case BRUTE_FORCE_L2:
         {
-          using MetricT = L2<unsigned char>;
-          using MatcherT = ArrayMatcherBruteForce<unsigned char, MetricT>;
+          using MatcherT = ArrayMatcherBruteForceBatched<unsigned char>;
           region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, true));
         }
         break;
@@ -102,8 +110,7 @@ std::unique_ptr<RegionsMatcher> RegionMatcherFactory
       {
         case BRUTE_FORCE_L2:
         {
-          using MetricT = L2<float>;
-          using MatcherT = ArrayMatcherBruteForce<float, MetricT>;
+          using MatcherT = ArrayMatcherBruteForceBatched<float>;
           region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, true));
         }
         break;
@@ -153,6 +160,28 @@ std::unique_ptr<RegionsMatcher> RegionMatcherFactory
           std::cerr << "Using unknown matcher type" << std::endl;
       }
     }
+    else if (regions.Type_id() == typeid(Eigen::half).name())
+    {
+      // Build on the fly half float based Matcher
+      switch (eMatcherType)
+      {
+        case BRUTE_FORCE_L2:
+        {
+          using MetricT = L2<Eigen::half>;
+          using MatcherT = ArrayMatcherBruteForce<Eigen::half, MetricT>;
+          region_matcher.reset(new matching::RegionsMatcherT<MatcherT>(regions, true));
+        }
+        break;
+        case ANN_L2:
+        case CASCADE_HASHING_L2:
+        {
+          std::cerr << "Not implemented" << std::endl;
+        }
+        break;
+        default:
+          std::cerr << "Using unknown matcher type" << std::endl;
+      }
+    }
   }
   else if (regions.IsBinary() && regions.Type_id() == typeid(unsigned char).name())
   {
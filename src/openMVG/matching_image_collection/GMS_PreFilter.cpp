@@ -0,0 +1,128 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/matching_image_collection/GMS_PreFilter.hpp"
+
+#include "openMVG/features/feature.hpp"
+#include "openMVG/features/regions.hpp"
+#include "openMVG/sfm/pipelines/sfm_regions_provider.hpp"
+#include "openMVG/sfm/sfm_data.hpp"
+
+#include <set>
+#include <vector>
+
+namespace openMVG {
+namespace matching_image_collection {
+
+GMS_PreFilter::GMS_PreFilter
+(
+  const int threshold_factor,
+  const bool scale_invariance,
+  const bool rotation_invariance,
+  const std::size_t min_putative_count
+):
+  threshold_factor_(threshold_factor),
+  scale_invariance_(scale_invariance),
+  rotation_invariance_(rotation_invariance),
+  min_putative_count_(min_putative_count)
+{
+}
+
+void GMS_PreFilter::Init
+(
+  const sfm::SfM_Data & sfm_data,
+  const sfm::Regions_Provider & regions_provider,
+  const matching::PairWiseMatches & putative_matches
+)
+{
+  // List the views that are not initialized yet
+  std::set<IndexT> view_id_set;
+  for (const auto & pair_it : putative_matches)
+  {
+    for (const IndexT view_id : {pair_it.first.first, pair_it.first.second})
+    {
+      if (grids_.count(view_id) == 0)
+        view_id_set.insert(view_id);
+    }
+  }
+  const std::vector<IndexT> view_ids(view_id_set.cbegin(), view_id_set.cend());
+
+  // Allocate the entries beforehand, so they can be filled concurrently
+  std::vector<robust::GMSGridAssignment *> view_grids(view_ids.size());
+  for (size_t i = 0; i < view_ids.size(); ++i)
+    view_grids[i] = &grids_[view_ids[i]];
+
+#ifdef OPENMVG_USE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int i = 0; i < static_cast<int>(view_ids.size()); ++i)
+  {
+    const auto view_it = sfm_data.GetViews().find(view_ids[i]);
+    if (view_it == sfm_data.GetViews().end() ||
+        view_it->second->ui_width == 0 || view_it->second->ui_height == 0)
+      continue;
+
+    const std::shared_ptr<features::Regions> regions = regions_provider.get(view_ids[i]);
+    if (!regions)
+      continue;
+
+    std::vector<Eigen::Vector2f> point_positions;
+    {
+      const features::PointFeatures features = regions->GetRegionsPositions();
+      point_positions.reserve(features.size());
+      for (const features::PointFeature & feature : features)
+        point_positions.push_back(feature.coords());
+    }
+    *view_grids[i] = robust::GMSGridAssignment(
+      point_positions,
+      {static_cast<int>(view_it->second->ui_width),
+       static_cast<int>(view_it->second->ui_height)},
+      scale_invariance_);
+  }
+}
+
+matching::IndMatches GMS_PreFilter::Filter
+(
+  const Pair & pair,
+  const matching::IndMatches & putative_matches
+) const
+{
+  if (putative_matches.size() < min_putative_count_)
+    return putative_matches;
+
+  const auto grid_it_I = grids_.find(pair.first);
+  const auto grid_it_J = grids_.find(pair.second);
+  // Unknown image size or regions: keep the putative matches
+  if (grid_it_I == grids_.cend() || grid_it_J == grids_.cend() ||
+      grid_it_I->second.left_cells[0].empty() ||
+      grid_it_J->second.right_cells[0].empty())
+  {
+    return putative_matches;
+  }
+
+  robust::GMSFilter gms(
+    grid_it_I->second,
+    grid_it_J->second,
+    putative_matches,
+    threshold_factor_);
+  std::vector<bool> inlier_flags;
+  const int inlier_count =
+    gms.GetInlierMask(inlier_flags, scale_invariance_, rotation_invariance_);
+
+  matching::IndMatches inliers;
+  inliers.reserve(inlier_count);
+  for (size_t i = 0; i < inlier_flags.size(); ++i)
+  {
+    if (inlier_flags[i])
+      inliers.push_back(putative_matches[i]);
+  }
+  return inliers;
+}
+
+} // namespace matching_image_collection
+} // namespace openMVG
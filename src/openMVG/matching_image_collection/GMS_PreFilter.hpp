@@ -0,0 +1,84 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_MATCHING_IMAGE_COLLECTION_GMS_PREFILTER_HPP
+#define OPENMVG_MATCHING_IMAGE_COLLECTION_GMS_PREFILTER_HPP
+
+#include <cstddef>
+#include <map>
+#include <memory>
+
+#include "openMVG/matching/indMatch.hpp"
+#include "openMVG/robust_estimation/gms_filter.hpp"
+#include "openMVG/types.hpp"
+
+namespace openMVG {
+
+namespace sfm {
+  struct Regions_Provider;
+  struct SfM_Data;
+} // namespace sfm
+
+namespace matching_image_collection {
+
+/**
+* @brief GMS (Grid-based Motion Statistics) filtering of the pairwise putative
+*  matches of an image collection.
+*
+* It is a cheap way to discard most of the outlier putative matches before the
+*  robust model estimation.
+* The grid cells of the features of a view are computed once and shared by all
+*  the pairs the view belongs to.
+*/
+class GMS_PreFilter
+{
+  public:
+    /// @param [in] threshold_factor      GMS threshold
+    /// @param [in] scale_invariance      Test the 5 GMS grid scales
+    /// @param [in] rotation_invariance   Test the 8 GMS grid rotations
+    /// @param [in] min_putative_count    Pairs with less putative matches are
+    ///  not filtered (GMS requires dense motion statistics)
+    explicit GMS_PreFilter
+    (
+      const int threshold_factor = 6,
+      const bool scale_invariance = true,
+      const bool rotation_invariance = false,
+      const std::size_t min_putative_count = 100
+    );
+
+    /// Compute (in parallel) the grid cells of the views used by the pairs
+    /// that are not known yet.
+    /// The views without a valid image size are not filtered.
+    void Init
+    (
+      const sfm::SfM_Data & sfm_data,
+      const sfm::Regions_Provider & regions_provider,
+      const matching::PairWiseMatches & putative_matches
+    );
+
+    /// Filter the putative matches of a pair.
+    /// Thread safe once the pair views have been initialized.
+    matching::IndMatches Filter
+    (
+      const Pair & pair,
+      const matching::IndMatches & putative_matches
+    ) const;
+
+  private:
+    const int threshold_factor_;
+    const bool scale_invariance_;
+    const bool rotation_invariance_;
+    const std::size_t min_putative_count_;
+    /// Feature grid cells of the initialized views
+    std::map<IndexT, robust::GMSGridAssignment> grids_;
+};
+
+} // namespace matching_image_collection
+} // namespace openMVG
+
+#endif // OPENMVG_MATCHING_IMAGE_COLLECTION_GMS_PREFILTER_HPP
@@ -0,0 +1,128 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/features/regions_factory.hpp"
+#include "openMVG/matching_image_collection/GMS_PreFilter.hpp"
+#include "openMVG/robust_estimation/gms_filter.hpp"
+#include "openMVG/sfm/pipelines/sfm_regions_provider.hpp"
+#include "openMVG/sfm/sfm_data.hpp"
+
+#include "testing/testing.h"
+
+#include <random>
+#include <vector>
+
+using namespace openMVG;
+using namespace openMVG::features;
+using namespace openMVG::matching;
+using namespace openMVG::matching_image_collection;
+using namespace openMVG::sfm;
+
+// Regions provider filled with in memory regions
+struct Regions_Provider_Memory : public Regions_Provider
+{
+  void Set(const IndexT view_id, const std::shared_ptr<Regions> & regions)
+  {
+    cache_[view_id] = regions;
+  }
+};
+
+// Filtering of the putative matches with the GMS filter built from the
+// point positions of the pair.
+static IndMatches GMS_Reference
+(
+  const std::vector<Eigen::Vector2f> & points_I,
+  const std::vector<Eigen::Vector2f> & points_J,
+  const std::pair<int, int> & image_size,
+  const IndMatches & putative_matches,
+  const int threshold_factor,
+  const bool scale_invariance,
+  const bool rotation_invariance
+)
+{
+  robust::GMSFilter gms(
+    points_I, image_size, points_J, image_size, putative_matches, threshold_factor);
+  std::vector<bool> inlier_flags;
+  gms.GetInlierMask(inlier_flags, scale_invariance, rotation_invariance);
+  IndMatches inliers;
+  for (size_t i = 0; i < inlier_flags.size(); ++i)
+  {
+    if (inlier_flags[i])
+      inliers.push_back(putative_matches[i]);
+  }
+  return inliers;
+}
+
+// 3 views of 4000 points: the views 1 & 2 are the view 0 translated,
+// 10% of the putative matches are outliers.
+TEST(GMS_PreFilter, SameInliersAsGMSFilter) {
+
+  const int kImageSize = 200;
+  const int kNbPoints = 4000;
+  std::mt19937 random_generator(std::mt19937::default_seed);
+  std::uniform_int_distribution<int> dist_position(20, kImageSize - 20);
+  std::uniform_int_distribution<int> dist_index(0, kNbPoints - 1);
+
+  SfM_Data sfm_data;
+  auto regions_provider = std::make_shared<Regions_Provider_Memory>();
+  std::vector<std::vector<Eigen::Vector2f>> points(3);
+  for (IndexT view_id = 0; view_id < 3; ++view_id)
+  {
+    sfm_data.views[view_id] = std::make_shared<View>("", view_id, 0, view_id, kImageSize, kImageSize);
+    std::shared_ptr<SIFT_Regions> regions = std::make_shared<SIFT_Regions>();
+    for (int i = 0; i < kNbPoints; ++i)
+    {
+      if (view_id == 0)
+        points[view_id].emplace_back(dist_position(random_generator), dist_position(random_generator));
+      else
+        points[view_id].push_back(points[0][i] + Eigen::Vector2f(5.f * view_id, 3.f));
+      regions->Features().emplace_back(points[view_id][i].x(), points[view_id][i].y());
+    }
+    regions_provider->Set(view_id, regions);
+  }
+
+  PairWiseMatches putative_matches;
+  for (const Pair pair : {Pair(0, 1), Pair(0, 2), Pair(1, 2)})
+  {
+    IndMatches & matches = putative_matches[pair];
+    for (int i = 0; i < kNbPoints; ++i)
+    {
+      matches.emplace_back(i, (i % 10 == 0) ? dist_index(random_generator) : i);
+    }
+  }
+
+  for (const bool scale_invariance : {false, true})
+  {
+    for (const bool rotation_invariance : {false, true})
+    {
+      const int threshold_factor = 6;
+      GMS_PreFilter gms_prefilter(threshold_factor, scale_invariance, rotation_invariance);
+      gms_prefilter.Init(sfm_data, *regions_provider, putative_matches);
+      for (const auto & pair_it : putative_matches)
+      {
+        const IndMatches inliers = gms_prefilter.Filter(pair_it.first, pair_it.second);
+        const IndMatches reference_inliers = GMS_Reference(
+          points[pair_it.first.first], points[pair_it.first.second],
+          {kImageSize, kImageSize}, pair_it.second,
+          threshold_factor, scale_invariance, rotation_invariance);
+        CHECK(inliers.size() < pair_it.second.size());
+        CHECK(inliers.size() > kNbPoints / 2);
+        CHECK(inliers == reference_inliers);
+      }
+    }
+  }
+
+  // Not enough putative matches: the matches are kept
+  GMS_PreFilter gms_prefilter(6, true, false, kNbPoints + 1);
+  gms_prefilter.Init(sfm_data, *regions_provider, putative_matches);
+  CHECK(gms_prefilter.Filter({0, 1}, putative_matches.at({0, 1})) == putative_matches.at({0, 1}));
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
@@ -11,10 +11,12 @@
 
 #include <algorithm>
 #include <map>
+#include <memory>
 #include <vector>
 
 #include "openMVG/features/feature.hpp"
 #include "openMVG/matching/indMatch.hpp"
+#include "openMVG/matching_image_collection/GMS_PreFilter.hpp"
 
 #include "third_party/progress/progress_display.hpp"
 
@@ -57,10 +59,18 @@ struct ImageCollectionGeometricFilter
     return _map_GeometricMatches;
   }
 
+  /// Enable a GMS filtering of the putative matches before the robust model
+  /// estimation (nullptr to disable it)
+  void Set_GMS_prefilter(const std::shared_ptr<GMS_PreFilter> & gms_prefilter)
+  {
+    gms_prefilter_ = gms_prefilter;
+  }
+
   // Data
   const sfm::SfM_Data * sfm_data_;
   const std::shared_ptr<sfm::Regions_Provider> & regions_provider_;
   PairWiseMatches _map_GeometricMatches;
+  std::shared_ptr<GMS_PreFilter> gms_prefilter_;
 };
 
 template<typename GeometryFunctor>
@@ -75,6 +85,10 @@ void ImageCollectionGeometricFilter::Robust_model_estimation
 {
   if (!my_progress_bar)
     my_progress_bar = &C_Progress::dummy();
+  // Compute the feature grid cells used by the GMS filter once per view
+  if (gms_prefilter_ && sfm_data_ && regions_provider_)
+    gms_prefilter_->Init(*sfm_data_, *regions_provider_, putative_matches);
+
   my_progress_bar->restart( putative_matches.size(), "\n- Geometric filtering -\n" );
 
 #ifdef OPENMVG_USE_OPENMP
@@ -88,7 +102,11 @@ void ImageCollectionGeometricFilter::Robust_model_estimation
     advance(iter,i);
 
     Pair current_pair = iter->first;
-    const std::vector<IndMatch> & vec_PutativeMatches = iter->second;
+    // Discard most of the outliers before the robust model estimation
+    const IndMatches gms_putative_matches = gms_prefilter_ ?
+      gms_prefilter_->Filter(current_pair, iter->second) : IndMatches();
+    const std::vector<IndMatch> & vec_PutativeMatches =
+      gms_prefilter_ ? gms_putative_matches : iter->second;
 
     //-- Apply the geometric filter (robust model estimation)
     {
@@ -0,0 +1,183 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/matching_image_collection/KVLD_Filter.hpp"
+
+#include "openMVG/features/feature.hpp"
+#include "openMVG/features/regions_factory.hpp"
+#include "openMVG/image/image_io.hpp"
+#include "openMVG/matching/kvld/kvld.h"
+#include "openMVG/sfm/pipelines/sfm_regions_provider.hpp"
+#include "openMVG/sfm/sfm_data.hpp"
+
+#include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
+
+#include <vector>
+
+namespace openMVG {
+namespace matching_image_collection {
+
+KVLD_ImageScaleCache::KVLD_ImageScaleCache( std::size_t byte_budget )
+  : budget_( byte_budget )
+{
+}
+
+std::shared_ptr<const ImageScale> KVLD_ImageScaleCache::Get
+(
+  const sfm::SfM_Data & sfm_data,
+  const IndexT view_id
+)
+{
+  std::unique_lock<std::mutex> lock( mutex_ );
+  auto it = entries_.find( view_id );
+  if ( it != entries_.end() )
+  {
+    // Cached or in-flight scale-space: wait for its computation (if required)
+    Entry & entry = it->second;
+    lru_.splice( lru_.begin(), lru_, entry.lru_it );
+    const std::shared_future<std::shared_ptr<const ImageScale>> scale = entry.scale;
+    lock.unlock();
+    return scale.get();
+  }
+
+  // Register the in-flight computation, so concurrent requests wait for it
+  std::promise<std::shared_ptr<const ImageScale>> promise;
+  Entry & entry = entries_[view_id];
+  entry.scale = promise.get_future().share();
+  lru_.push_front( view_id );
+  entry.lru_it = lru_.begin();
+  lock.unlock();
+
+  std::shared_ptr<const ImageScale> scale;
+  const auto view_it = sfm_data.GetViews().find( view_id );
+  image::Image<unsigned char> image;
+  if ( view_it != sfm_data.GetViews().end() &&
+       image::ReadImage(
+         stlplus::create_filespec( sfm_data.s_root_path, view_it->second->s_Img_path ).c_str(),
+         &image ) )
+  {
+    scale = std::make_shared<const ImageScale>( image::Image<float>( image.GetMat().cast<float>() ) );
+  }
+  promise.set_value( scale );
+
+  // The in-flight entries are never erased, so the entry is still valid
+  lock.lock();
+  entry.ready = true;
+  entry.bytes = scale ? scale->MemoryUsage() : 0;
+  bytes_ += entry.bytes;
+  Evict();
+  return scale;
+}
+
+void KVLD_ImageScaleCache::Evict()
+{
+  auto it = lru_.end();
+  while ( bytes_ > budget_ && it != lru_.begin() )
+  {
+    --it;
+    const auto entry_it = entries_.find( *it );
+    const Entry & entry = entry_it->second;
+    // Keep the in-flight scale-spaces and the ones referenced by a handle
+    if ( !entry.ready || entry.bytes == 0 ||
+         entry.scale.get().use_count() > 1 )
+    {
+      continue;
+    }
+    bytes_ -= entry.bytes;
+    entries_.erase( entry_it );
+    it = lru_.erase( it );
+  }
+}
+
+/// Get the features of regions with a scale and an orientation
+static bool GetSIOFeatures
+(
+  const features::Regions & regions,
+  std::vector<features::SIOPointFeature> & feats
+)
+{
+  if ( const auto * sift = dynamic_cast<const features::SIFT_Regions *>( &regions ) )
+    feats = sift->Features();
+  else if ( const auto * akaze = dynamic_cast<const features::AKAZE_Float_Regions *>( &regions ) )
+    feats = akaze->Features();
+  else if ( const auto * liop = dynamic_cast<const features::AKAZE_Liop_Regions *>( &regions ) )
+    feats = liop->Features();
+  else if ( const auto * mldb = dynamic_cast<const features::AKAZE_Binary_Regions *>( &regions ) )
+    feats = mldb->Features();
+  else
+  {
+    // Only the positions are known
+    const features::PointFeatures points = regions.GetRegionsPositions();
+    feats.clear();
+    feats.reserve( points.size() );
+    for ( const features::PointFeature & point : points )
+      feats.emplace_back( point.x(), point.y() );
+    return false;
+  }
+  return true;
+}
+
+bool GeometricFilter_KVLD::Robust_estimation
+(
+  const sfm::SfM_Data * sfm_data,
+  const std::shared_ptr<sfm::Regions_Provider> & regions_provider,
+  const Pair pairIndex,
+  const matching::IndMatches & vec_PutativeMatches,
+  matching::IndMatches & geometric_inliers
+)
+{
+  geometric_inliers.clear();
+  inliers_.clear();
+
+  const std::shared_ptr<features::Regions>
+    regionsI = regions_provider->get( pairIndex.first ),
+    regionsJ = regions_provider->get( pairIndex.second );
+  if ( !regionsI || !regionsJ || vec_PutativeMatches.size() < min_inliers_ )
+    return false;
+
+  const std::shared_ptr<const ImageScale>
+    scaleI = scale_cache_->Get( *sfm_data, pairIndex.first ),
+    scaleJ = scale_cache_->Get( *sfm_data, pairIndex.second );
+  if ( !scaleI || !scaleJ )
+    return false;
+
+  std::vector<features::SIOPointFeature> featsI, featsJ;
+  const bool bSIO_I = GetSIOFeatures( *regionsI, featsI );
+  const bool bSIO_J = GetSIOFeatures( *regionsJ, featsJ );
+  KvldParameters kvldparameters; // initial parameters of KVLD
+  kvldparameters.geometry = bSIO_I && bSIO_J;
+
+  std::vector<Pair> matchesPair, matchesFiltered;
+  matchesPair.reserve( vec_PutativeMatches.size() );
+  for ( const auto & match_it : vec_PutativeMatches )
+    matchesPair.emplace_back( match_it.i_, match_it.j_ );
+
+  std::vector<double> vec_score;
+  std::vector<bool> valid( matchesPair.size(), true );
+  size_t it_num = 0;
+  while ( it_num < 5 &&
+          kvldparameters.inlierRate > KVLD( *scaleI, *scaleJ, featsI, featsJ,
+            matchesPair, matchesFiltered, vec_score, valid, kvldparameters ) )
+  {
+    kvldparameters.inlierRate /= 2;
+    kvldparameters.K = 2;
+    ++it_num;
+  }
+
+  if ( matchesFiltered.size() < min_inliers_ )
+    return false;
+
+  geometric_inliers.reserve( matchesFiltered.size() );
+  for ( const Pair & match : matchesFiltered )
+    geometric_inliers.emplace_back( match.first, match.second );
+  inliers_ = geometric_inliers;
+  return true;
+}
+
+} // namespace matching_image_collection
+} // namespace openMVG
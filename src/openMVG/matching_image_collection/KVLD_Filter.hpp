@@ -0,0 +1,124 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_MATCHING_IMAGE_COLLECTION_KVLD_FILTER_HPP
+#define OPENMVG_MATCHING_IMAGE_COLLECTION_KVLD_FILTER_HPP
+
+#include <cstddef>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "openMVG/matching/indMatch.hpp"
+#include "openMVG/types.hpp"
+
+struct ImageScale;
+
+namespace openMVG {
+
+namespace sfm {
+  struct Regions_Provider;
+  struct SfM_Data;
+} // namespace sfm
+
+namespace matching_image_collection {
+
+/**
+* @brief Store of the K-VLD scale-spaces of the views shared by the pairs
+*
+* - The scale-space of a view is computed once while it stays in the store,
+*   concurrent requests wait for the in-flight computation.
+* - When the scale-spaces exceed the byte budget, the least recently used
+*   ones that are not referenced by a handle anymore are released.
+*/
+class KVLD_ImageScaleCache
+{
+  public:
+    explicit KVLD_ImageScaleCache( std::size_t byte_budget = std::size_t( 1 ) << 30 );
+
+    /// Get the scale-space of a view (nullptr if its image cannot be read)
+    std::shared_ptr<const ImageScale> Get
+    (
+      const sfm::SfM_Data & sfm_data,
+      const IndexT view_id
+    );
+
+  private:
+    struct Entry
+    {
+      std::shared_future<std::shared_ptr<const ImageScale>> scale;
+      bool ready = false;
+      std::size_t bytes = 0;
+      std::list<IndexT>::iterator lru_it;
+    };
+
+    /// Release the least recently used scale-spaces until the budget is met
+    void Evict();
+
+    const std::size_t budget_;
+    std::mutex mutex_;
+    std::map<IndexT, Entry> entries_;
+    /// View ids, the most recently used first
+    std::list<IndexT> lru_;
+    std::size_t bytes_ = 0;
+};
+
+//-- K-VLD functor used for filter pair of putative correspondences:
+//  the matches that are photometrically (and geometrically) consistent with
+//  their neighbor matches are kept.
+//  The geometric consistency is checked if the regions have a scale and an
+//  orientation (SIFT, AKAZE regions), else only the photometric one is used.
+struct GeometricFilter_KVLD
+{
+  explicit GeometricFilter_KVLD
+  (
+    const std::shared_ptr<KVLD_ImageScaleCache> & scale_cache =
+      std::make_shared<KVLD_ImageScaleCache>(),
+    const std::size_t min_inliers = 16
+  ):
+    scale_cache_(scale_cache),
+    min_inliers_(min_inliers)
+  {
+  }
+
+  /// Filter the putative matches of a pair
+  bool Robust_estimation
+  (
+    const sfm::SfM_Data * sfm_data,
+    const std::shared_ptr<sfm::Regions_Provider> & regions_provider,
+    const Pair pairIndex,
+    const matching::IndMatches & vec_PutativeMatches,
+    matching::IndMatches & geometric_inliers
+  );
+
+  /// No model is estimated, the K-VLD inliers are returned
+  bool Geometry_guided_matching
+  (
+    const sfm::SfM_Data *,
+    const std::shared_ptr<sfm::Regions_Provider> &,
+    const Pair,
+    const double,
+    matching::IndMatches & matches
+  )
+  {
+    matches = inliers_;
+    return true;
+  }
+
+  // shared between the functor copies
+  std::shared_ptr<KVLD_ImageScaleCache> scale_cache_;
+  std::size_t min_inliers_;
+  matching::IndMatches inliers_;
+};
+
+} //namespace matching_image_collection
+}  // namespace openMVG
+
+#endif // OPENMVG_MATCHING_IMAGE_COLLECTION_KVLD_FILTER_HPP
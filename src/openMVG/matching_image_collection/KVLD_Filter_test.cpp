@@ -0,0 +1,123 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/features/sift/SIFT_Anatomy_Image_Describer.hpp"
+#include "openMVG/image/image_io.hpp"
+#include "openMVG/matching/kvld/kvld.h"
+#include "openMVG/matching/regions_matcher.hpp"
+#include "openMVG/matching_image_collection/KVLD_Filter.hpp"
+#include "openMVG/sfm/pipelines/sfm_regions_provider.hpp"
+#include "openMVG/sfm/sfm_data.hpp"
+
+#include "testing/testing.h"
+
+#include <string>
+#include <vector>
+
+using namespace openMVG;
+using namespace openMVG::features;
+using namespace openMVG::image;
+using namespace openMVG::matching;
+using namespace openMVG::matching_image_collection;
+using namespace openMVG::sfm;
+
+// Regions provider filled with in memory regions
+struct Regions_Provider_Memory : public Regions_Provider
+{
+  void Set(const IndexT view_id, const std::shared_ptr<Regions> & regions)
+  {
+    cache_[view_id] = regions;
+  }
+};
+
+// K-VLD filtering of the putative matches of a pair of images, computed from
+// the images (no scale-space cache).
+static IndMatches KVLD_Reference
+(
+  const Image<unsigned char> & imageI,
+  const Image<unsigned char> & imageJ,
+  const SIFT_Regions & regionsI,
+  const SIFT_Regions & regionsJ,
+  const IndMatches & putative_matches
+)
+{
+  std::vector<Pair> matchesPair, matchesFiltered;
+  for (const auto & match_it : putative_matches)
+    matchesPair.emplace_back(match_it.i_, match_it.j_);
+  std::vector<double> vec_score;
+  Mat E = Mat::Ones(matchesPair.size(), matchesPair.size()) * (-1);
+  std::vector<bool> valid(matchesPair.size(), true);
+
+  const Image<float> imgI(imageI.GetMat().cast<float>()), imgJ(imageJ.GetMat().cast<float>());
+  size_t it_num = 0;
+  KvldParameters kvldparameters;
+  while (it_num < 5 &&
+          kvldparameters.inlierRate > KVLD(imgI, imgJ, regionsI.Features(), regionsJ.Features(),
+            matchesPair, matchesFiltered, vec_score, E, valid, kvldparameters))
+  {
+    kvldparameters.inlierRate /= 2;
+    kvldparameters.K = 2;
+    ++it_num;
+  }
+
+  IndMatches inliers;
+  for (const Pair & match : matchesFiltered)
+    inliers.emplace_back(match.first, match.second);
+  return inliers;
+}
+
+TEST(GeometricFilter_KVLD, SameInliersWithAndWithoutCache) {
+
+  const std::string root_path = std::string(THIS_SOURCE_DIR)
+    + "/../../openMVG_Samples/imageData/StanfordMobileVisualSearch/";
+  const std::string filenames[2] = {"Ace_0.png", "Ace_1.png"};
+
+  SfM_Data sfm_data;
+  sfm_data.s_root_path = root_path;
+  auto regions_provider = std::make_shared<Regions_Provider_Memory>();
+  Image<unsigned char> images[2];
+  std::shared_ptr<Regions> regions[2];
+  SIFT_Anatomy_Image_describer image_describer;
+  for (IndexT i = 0; i < 2; ++i)
+  {
+    EXPECT_TRUE(ReadImage((root_path + filenames[i]).c_str(), &images[i]));
+    sfm_data.views[i] = std::make_shared<View>(filenames[i], i, 0, i,
+      images[i].Width(), images[i].Height());
+    regions[i] = image_describer.Describe(images[i]);
+    regions_provider->Set(i, regions[i]);
+  }
+
+  IndMatches putative_matches;
+  DistanceRatioMatch(0.8f, BRUTE_FORCE_L2, *regions[0], *regions[1], putative_matches);
+
+  const IndMatches reference_inliers = KVLD_Reference(images[0], images[1],
+    dynamic_cast<const SIFT_Regions &>(*regions[0]),
+    dynamic_cast<const SIFT_Regions &>(*regions[1]),
+    putative_matches);
+  EXPECT_TRUE(reference_inliers.size() >= 16);
+
+  // The scale-spaces are computed (empty budget) or reused from the cache
+  for (const std::size_t budget : {std::size_t(0), std::size_t(1) << 30})
+  {
+    GeometricFilter_KVLD filter(std::make_shared<KVLD_ImageScaleCache>(budget));
+    for (int repeat = 0; repeat < 2; ++repeat)
+    {
+      IndMatches inliers, guided_inliers;
+      EXPECT_TRUE(filter.Robust_estimation(&sfm_data, regions_provider, {0, 1},
+        putative_matches, inliers));
+      EXPECT_TRUE(inliers == reference_inliers);
+      EXPECT_TRUE(filter.Geometry_guided_matching(&sfm_data, regions_provider, {0, 1},
+        0.6, guided_inliers));
+      EXPECT_TRUE(guided_inliers == reference_inliers);
+    }
+  }
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
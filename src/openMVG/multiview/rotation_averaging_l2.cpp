@@ -7,6 +7,7 @@
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
 #include "openMVG/multiview/rotation_averaging_l2.hpp"
+#include "openMVG/multiview/rotation_averaging_l1.hpp"
 
 #ifdef OPENMVG_USE_OPENMP
 #include <omp.h>
@@ -15,6 +16,11 @@
 #include <ceres/ceres.h>
 #include <ceres/rotation.h>
 
+#include <Eigen/IterativeLinearSolvers>
+
+#include <iostream>
+#include <random>
+
 #ifdef _MSC_VER
 #pragma warning( once : 4267 ) //warning C4267: 'argument' : conversion from 'size_t' to 'const int', possible loss of data
 #endif
@@ -27,6 +33,12 @@
 //- [1] "Robust Multiview Reconstruction."
 //- Author : Daniel Martinec.
 //- Date : July 2, 2008.
+//
+//- The sparse formulation uses the LOBPCG eigen-solver from:
+//- [2] "Toward the Optimal Preconditioned Eigensolver: Locally Optimal Block
+//-      Preconditioned Conjugate Gradient Method."
+//- Author : Andrew V. Knyazev.
+//- Date : 2001.
 //--
 namespace openMVG   {
 namespace rotation_averaging  {
@@ -59,6 +71,327 @@ bool compare_first_abs(std::pair<double, Vec> const &x, std::pair<double, Vec> c
  return std::abs(x.first) < std::abs(y.first);
 }
 
+// Preconditioner of the sparse AtA matrix:
+//  If the global rotations Ri were consistent with the relative rotations,
+//  AtA would be equal to B * (L (x) Id3) * transpose(B) with B = diag(Ri) and
+//  L the Laplacian of the (squared) weighted relative rotation graph.
+//  The inverse of this approximation is used as preconditioner.
+//  L is a nCamera x nCamera matrix that is factorized once, the Ri rotations
+//  are updated from the current eigenvectors estimate.
+//  The factorization of L is an incomplete Cholesky one: an exact one fills in
+//  (long range edges) and its cost grows much faster than the camera count.
+namespace {
+class RotationGraphPreconditioner
+{
+public:
+  RotationGraphPreconditioner
+  (
+    size_t nCamera,
+    const RelativeRotations& vec_relativeRot
+  ): rotations_(nCamera, Mat3::Identity())
+  {
+    std::vector<Eigen::Triplet<double>> tripletList;
+    tripletList.reserve(vec_relativeRot.size() * 4);
+    for (const auto & iter : vec_relativeRot)
+    {
+      const double w2 = static_cast<double>(iter.weight) * iter.weight;
+      tripletList.emplace_back(iter.i, iter.i, w2);
+      tripletList.emplace_back(iter.j, iter.j, w2);
+      tripletList.emplace_back(iter.i, iter.j, -w2);
+      tripletList.emplace_back(iter.j, iter.i, -w2);
+    }
+    sMat L(nCamera, nCamera);
+    L.setFromTriplets(tripletList.begin(), tripletList.end());
+    // L is singular (constant vector), use a small shift
+    const double shift = 1e-6 * std::max(L.diagonal().maxCoeff(), 1.0);
+    L.diagonal().array() += shift;
+    incomplete_cholesky_.compute(L);
+  }
+
+  bool ok() const { return incomplete_cholesky_.info() == Eigen::Success; }
+
+  // Setup the rotations from the three first columns of the eigenvectors estimate
+  void Update(const Mat & X)
+  {
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp parallel for
+#endif
+    for (int i = 0; i < static_cast<int>(rotations_.size()); ++i)
+    {
+      rotations_[i] = ClosestSVDRotationMatrix(X.block<3, 3>(3 * i, 0));
+    }
+  }
+
+  // Apply the preconditioner to the columns of R
+  Mat Apply(const Mat & R) const
+  {
+    const Mat::Index nCamera = rotations_.size();
+    const Mat::Index k = R.cols();
+    // Go to the rotation frames: one row per camera, 3 values per column of R
+    Mat Y(nCamera, 3 * k);
+    for (Mat::Index i = 0; i < nCamera; ++i)
+      for (Mat::Index c = 0; c < k; ++c)
+        Y.block<1, 3>(i, 3 * c) =
+          (rotations_[i].transpose() * R.block<3, 1>(3 * i, c)).transpose();
+    Mat Z(nCamera, 3 * k);
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp parallel for
+#endif
+    for (int c = 0; c < static_cast<int>(Y.cols()); ++c)
+    {
+      Z.col(c) = incomplete_cholesky_.solve(Y.col(c));
+    }
+    Mat W(3 * nCamera, k);
+    for (Mat::Index i = 0; i < nCamera; ++i)
+      for (Mat::Index c = 0; c < k; ++c)
+        W.block<3, 1>(3 * i, c) = rotations_[i] * Z.block<1, 3>(i, 3 * c).transpose();
+    return W;
+  }
+
+private:
+  Eigen::IncompleteCholesky<double> incomplete_cholesky_;
+  std::vector<Mat3> rotations_;
+};
+} // namespace
+
+// Orthonormalize the columns of Z against the orthonormal columns of X,
+//  the columns that are (almost) linearly dependent are discarded.
+static Mat OrthonormalizeAgainst
+(
+  const Mat & X,
+  Mat Z
+)
+{
+  // Twice is enough [Giraud et al. 2005]
+  for (int pass = 0; pass < 2; ++pass)
+  {
+    Z -= X * (X.transpose() * Z);
+  }
+  // SVQB: Z * V * S^-1/2 with Z^t * Z = V * S * V^t
+  const Mat G = Z.transpose() * Z;
+  const Eigen::SelfAdjointEigenSolver<Mat> es(G);
+  const Vec & s = es.eigenvalues();
+  const double kMinEigenvalue = 1e-12 * std::max(s.maxCoeff(), 0.0);
+  Mat::Index rank = 0;
+  while (rank < s.size() && s(s.size() - 1 - rank) > kMinEigenvalue)
+    ++rank;
+  if (rank == 0)
+    return Mat(Z.rows(), 0);
+  const Mat V = es.eigenvectors().rightCols(rank);
+  Mat Q = Z * V * s.tail(rank).cwiseSqrt().cwiseInverse().asDiagonal();
+  // One more pass for the loss of orthogonality to X
+  Q -= X * (X.transpose() * Q);
+  return Q;
+}
+
+// Compute the eigenvectors of the sparse symmetric positive semi-definite
+//  matrix M associated to its smallest eigenvalues thanks to LOBPCG [2].
+//- M:          The sparse matrix
+//- preconditioner: The M^-1 approximation
+//- X:          The initial guess (the block size is the number of columns),
+//               the Ritz vectors sorted by ascending Ritz values at return
+//- nev:        The number of eigenvectors that must converge
+//- tolerance:  The residual norm under which an eigenvector has converged
+//- max_iteration: The maximal number of iterations
+// Return true if the nev first Ritz vectors have converged.
+static bool SmallestEigenvectorsLOBPCG
+(
+  const sMat & M,
+  RotationGraphPreconditioner & preconditioner,
+  Mat & X,
+  const Mat::Index nev,
+  const double tolerance,
+  const int max_iteration
+)
+{
+  const Mat::Index block_size = X.cols();
+
+  // Initial Rayleigh-Ritz procedure
+  X = OrthonormalizeAgainst(Mat(X.rows(), 0), X);
+  if (X.cols() != block_size)
+    return false;
+  Mat MX = M * X;
+  Vec ritz_values;
+  {
+    const Mat G = X.transpose() * MX;
+    const Eigen::SelfAdjointEigenSolver<Mat> es((G + G.transpose()) / 2.0);
+    X = X * es.eigenvectors();
+    MX = MX * es.eigenvectors();
+    ritz_values = es.eigenvalues();
+  }
+
+  Mat P; // Search directions
+  for (int iteration = 0; iteration < max_iteration; ++iteration)
+  {
+    const Mat R = MX - X * ritz_values.asDiagonal();
+    if (R.leftCols(nev).colwise().norm().maxCoeff() < tolerance)
+    {
+      return true;
+    }
+
+    // Rayleigh-Ritz procedure on the subspace [X, T(R), P]
+    preconditioner.Update(X);
+    Mat WP = preconditioner.Apply(R);
+    if (P.cols() > 0) // No search direction at the first iteration
+    {
+      WP.conservativeResize(Eigen::NoChange, block_size + P.cols());
+      WP.rightCols(P.cols()) = P;
+    }
+    const Mat Z = OrthonormalizeAgainst(X, WP);
+    if (Z.cols() == 0)
+    {
+      return true;
+    }
+    const Mat MZ = M * Z;
+    Mat Q(X.rows(), block_size + Z.cols());
+    Q << X, Z;
+    Mat MQ(X.rows(), block_size + Z.cols());
+    MQ << MX, MZ;
+    const Mat G = Q.transpose() * MQ;
+    const Eigen::SelfAdjointEigenSolver<Mat> es((G + G.transpose()) / 2.0);
+    if (es.info() != Eigen::Success)
+    {
+      return false;
+    }
+    const Mat C = es.eigenvectors().leftCols(block_size);
+
+    // The new search directions are the components along [T(R), P]
+    P = Z * C.bottomRows(Z.cols());
+    X = Q * C;
+    MX = MQ * C;
+    ritz_values = es.eigenvalues().head(block_size);
+  }
+  return false;
+}
+
+// Build the global rotations from a basis of the AtA nullspace (3n x 3)
+static void RotationsFromNullspace
+(
+  const Mat & nullspace,
+  std::vector<Mat3> & global_rotations
+)
+{
+  const size_t nCamera = nullspace.rows() / 3;
+  //--
+  // Search the closest matrix :
+  //  - From solution of SVD get back column and reconstruct Rotation matrix
+  //  - Enforce the orthogonality constraint
+  //     (approximate rotation in the Frobenius norm using SVD).
+  //--
+  global_rotations.clear();
+  global_rotations.reserve(nCamera);
+  for (size_t i=0; i < nCamera; ++i)
+  {
+    const Mat3 Rotation = nullspace.block<3, 3>(3 * i, 0);
+
+    //-- Compute the closest SVD rotation matrix
+    global_rotations.emplace_back(ClosestSVDRotationMatrix(Rotation));
+  }
+  // Force R0 to be Identity
+  const Mat3 R0T = global_rotations[0].transpose();
+  for (size_t i = 0; i < nCamera; ++i) {
+    global_rotations[i] *= R0T;
+  }
+}
+
+bool L2RotationAveraging_Sparse
+(
+  size_t nCamera,
+  const RelativeRotations& vec_relativeRot,
+  // Output
+  std::vector<Mat3> & global_rotations,
+  const std::vector<Mat3> * initial_rotations
+)
+{
+  if (nCamera == 0)
+  {
+    return false;
+  }
+
+  //--
+  // Setup directly the sparse AtA matrix:
+  //  each weight * ( rj - Rij * ri ) = 0 constraint adds
+  //  - weight^2 * Id on the (i,i) and (j,j) diagonal blocks,
+  //  - -weight^2 * transpose(Rij) on the (i,j) block,
+  //  - -weight^2 * Rij on the (j,i) block.
+  //--
+  std::vector<Eigen::Triplet<double>> tripletList;
+  tripletList.reserve(vec_relativeRot.size() * 24); // 2*3*3 + 2*3
+  for (const auto & iter : vec_relativeRot)
+  {
+    const sMat::Index i = iter.i;
+    const sMat::Index j = iter.j;
+    const double w2 = static_cast<double>(iter.weight) * iter.weight;
+    for (const int k : {0, 1, 2})
+    {
+      tripletList.emplace_back(3 * i + k, 3 * i + k, w2);
+      tripletList.emplace_back(3 * j + k, 3 * j + k, w2);
+      for (const int l : {0, 1, 2})
+      {
+        tripletList.emplace_back(3 * i + k, 3 * j + l, - w2 * iter.Rij(l, k));
+        tripletList.emplace_back(3 * j + k, 3 * i + l, - w2 * iter.Rij(k, l));
+      }
+    }
+  }
+  sMat AtA(3 * nCamera, 3 * nCamera);
+  AtA.setFromTriplets(tripletList.begin(), tripletList.end());
+  tripletList.clear();
+  tripletList.shrink_to_fit();
+
+  RotationGraphPreconditioner preconditioner(nCamera, vec_relativeRot);
+  if (!preconditioner.ok())
+  {
+    return false;
+  }
+
+  //--
+  // Initial guess: the nullspace is spanned by the columns of the stacked
+  //  global rotations, they are approximated by chaining the relative
+  //  rotations along a maximum spanning tree.
+  // Three additional (guard) vectors speed up the convergence.
+  //--
+  std::vector<Mat3> spanning_tree_rotations;
+  if (!initial_rotations || initial_rotations->size() != nCamera)
+  {
+    spanning_tree_rotations.assign(nCamera, Mat3::Identity());
+    rotation_averaging::l1::InitRotationsMST(vec_relativeRot, spanning_tree_rotations, 0);
+    initial_rotations = &spanning_tree_rotations;
+  }
+  const Mat::Index kBlockSize = 6;
+  Mat X(3 * nCamera, kBlockSize);
+  {
+    std::mt19937 random_generator(std::mt19937::default_seed);
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+    for (size_t i = 0; i < nCamera; ++i)
+    {
+      X.block<3, 3>(3 * i, 0) = (*initial_rotations)[i];
+      for (Mat::Index k = 3; k < kBlockSize; ++k)
+        for (const int l : {0, 1, 2})
+          X(3 * i + l, k) = distribution(random_generator);
+    }
+  }
+
+  // Solve Ax=0 => eigen vectors
+  // If the smallest eigenvalues are clustered (weakly connected graphs, such as
+  //  long camera chains) the solver may not converge: its Ritz vectors are then
+  //  mixtures of eigenvectors that do not give rotations.
+  const double kTolerance = 1e-6 * AtA.diagonal().maxCoeff();
+  const int kMaxIteration = 100;
+  if (!SmallestEigenvectorsLOBPCG(AtA, preconditioner, X, 3, kTolerance, kMaxIteration))
+  {
+    std::cerr
+      << "L2 rotation averaging: the sparse eigen-solver did not converge."
+      << std::endl;
+    return false;
+  }
+
+  RotationsFromNullspace(X.leftCols(3), global_rotations);
+  return true;
+}
+
+// Over this number of camera the sparse formulation is used
+static const size_t kMaxDenseSolverCameraCount = 300;
+
 //-- Solve the Global Rotation matrix registration for each camera given a list
 //    of relative orientation using matrix parametrization
 //    [1] formula 6.62 page 100. Dense formulation.
@@ -96,6 +429,12 @@ bool L2RotationAveraging
   std::vector<Mat3> & global_rotations
 )
 {
+  // The dense formulation is O(n^3) in time and O(n^2) in memory
+  if (nCamera > kMaxDenseSolverCameraCount)
+  {
+    return L2RotationAveraging_Sparse(nCamera, vec_relativeRot, global_rotations);
+  }
+
   const size_t nRotationEstimation = vec_relativeRot.size();
   //--
   // Setup the Action Matrix
@@ -157,33 +496,9 @@ bool L2RotationAveraging
     }
     std::stable_sort(eigs.begin(), eigs.end(), &compare_first_abs);
 
-    const Vec & NullspaceVector0 = eigs[0].second;
-    const Vec & NullspaceVector1 = eigs[1].second;
-    const Vec & NullspaceVector2 = eigs[2].second;
-
-    //--
-    // Search the closest matrix :
-    //  - From solution of SVD get back column and reconstruct Rotation matrix
-    //  - Enforce the orthogonality constraint
-    //     (approximate rotation in the Frobenius norm using SVD).
-    //--
-    global_rotations.clear();
-    global_rotations.reserve(nCamera);
-    for (size_t i=0; i < nCamera; ++i)
-    {
-      Mat3 Rotation;
-      Rotation << NullspaceVector0.segment(3 * i, 3),
-                  NullspaceVector1.segment(3 * i, 3),
-                  NullspaceVector2.segment(3 * i, 3);
-
-      //-- Compute the closest SVD rotation matrix
-      global_rotations.emplace_back(ClosestSVDRotationMatrix(Rotation));
-    }
-    // Force R0 to be Identity
-    const Mat3 R0T = global_rotations[0].transpose();
-    for (size_t i = 0; i < nCamera; ++i) {
-      global_rotations[i] *= R0T;
-    }
+    Mat nullspace(AtA.cols(), 3);
+    nullspace << eigs[0].second, eigs[1].second, eigs[2].second;
+    RotationsFromNullspace(nullspace, global_rotations);
   }
   return true;
 }
@@ -63,6 +63,20 @@ bool L2RotationAveraging( size_t nCamera,
   // Output
   std::vector<Mat3> & vec_ApprRotMatrix);
 
+//-- Sparse formulation of L2RotationAveraging (used by it for large problems):
+//    only the three eigenvectors of AtA associated to the smallest eigenvalues
+//    are computed, thanks to an iterative eigen-solver (LOBPCG) working on the
+//    sparse AtA matrix.
+//- initial_rotations: (optional) An approximation of the global rotations used
+//    to warm start the solver. If not provided the relative rotations are
+//    chained along a maximum spanning tree.
+// Return false if the eigen-solver does not converge (weakly connected graphs).
+bool L2RotationAveraging_Sparse( size_t nCamera,
+  const RelativeRotations& vec_relativeRot,
+  // Output
+  std::vector<Mat3> & vec_ApprRotMatrix,
+  const std::vector<Mat3> * initial_rotations = nullptr);
+
 // None linear refinement of the rotation using an angle-axis representation
 bool L2RotationAveraging_Refine(
   const RelativeRotations & vec_relativeRot,
@@ -17,6 +17,7 @@
 #include <iostream>
 #include <iterator>
 #include <numeric>
+#include <random>
 #include <vector>
 
 using namespace openMVG;
@@ -160,6 +161,80 @@ TEST ( rotation_averaging, RefineRotationsL2_CompleteGraph)
   }
 }
 
+// Check that the sparse formulation gives the same solution as the dense one
+TEST ( rotation_averaging, RotationLeastSquare_Sparse_vs_Dense)
+{
+  //-- Setup a circular camera rig
+  const int iNviews = 60;
+  const NViewDataSet d = NRealisticCamerasRing(iNviews, 5,
+    nViewDatasetConfigurator(1,1,0,0,5,0)); // Suppose a camera with Unit matrix as K
+
+  //Link each camera to the three next ones with some noisy relative rotations
+  RelativeRotations vec_relativeRotEstimate;
+  for (size_t i = 0; i < iNviews; ++i)
+  {
+    for (const size_t offset : {1, 2, 3})
+    {
+      const size_t index0 = i;
+      const size_t index1 = (i + offset) % iNviews;
+      Mat3 Rrel;
+      Vec3 trel;
+      RelativeCameraMotion(d._R[index0], d._t[index0], d._R[index1], d._t[index1], &Rrel, &trel);
+      const Mat3 noise = RotationAroundX(D2R(0.1 * ((i + offset) % 5))) * RotationAroundY(D2R(0.1 * (i % 3)));
+      vec_relativeRotEstimate.push_back(RelativeRotation(index0, index1, noise * Rrel, 1));
+    }
+  }
+
+  //- Solve the global rotation estimation problem with the two formulations:
+  std::vector<Mat3> vec_globalR_dense, vec_globalR_sparse;
+  EXPECT_TRUE(L2RotationAveraging(iNviews, vec_relativeRotEstimate, vec_globalR_dense));
+  EXPECT_TRUE(L2RotationAveraging_Sparse(iNviews, vec_relativeRotEstimate, vec_globalR_sparse));
+
+  EXPECT_EQ(iNviews, vec_globalR_sparse.size());
+  for (size_t i = 0; i < iNviews; ++i)
+  {
+    EXPECT_NEAR(0.0, FrobeniusDistance(vec_globalR_dense[i], vec_globalR_sparse[i]), 1e-5);
+  }
+}
+
+// Check that the sparse formulation reports a failure (instead of returning
+//  wrong rotations) if it does not converge: on a long and noisy camera chain
+//  the smallest eigenvalues of AtA are clustered.
+TEST ( rotation_averaging, RotationLeastSquare_Sparse_NoConvergence)
+{
+  const size_t iNviews = 2000;
+  std::mt19937 random_generator(std::mt19937::default_seed);
+  std::uniform_real_distribution<double> angle_distribution(-M_PI, M_PI);
+  std::normal_distribution<double> noise_distribution(0.0, D2R(3.0));
+  std::vector<Mat3> vec_globalR_GT(iNviews);
+  for (auto & rotation : vec_globalR_GT)
+  {
+    rotation = RotationAroundX(angle_distribution(random_generator))
+      * RotationAroundY(angle_distribution(random_generator))
+      * RotationAroundZ(angle_distribution(random_generator));
+  }
+
+  //Link each camera to the three next ones with some noisy relative rotations
+  RelativeRotations vec_relativeRotEstimate;
+  for (size_t i = 0; i < iNviews; ++i)
+  {
+    for (const size_t offset : {1, 2, 3})
+    {
+      const size_t index1 = i + offset;
+      if (index1 >= iNviews)
+        continue;
+      const Mat3 noise = RotationAroundX(noise_distribution(random_generator))
+        * RotationAroundY(noise_distribution(random_generator))
+        * RotationAroundZ(noise_distribution(random_generator));
+      vec_relativeRotEstimate.push_back(RelativeRotation(i, index1,
+        noise * vec_globalR_GT[index1] * vec_globalR_GT[i].transpose(), 1));
+    }
+  }
+
+  std::vector<Mat3> vec_globalR;
+  EXPECT_FALSE(L2RotationAveraging_Sparse(iNviews, vec_relativeRotEstimate, vec_globalR));
+}
+
 TEST ( rotation_averaging, RefineRotationsAvgL1IRLS_SimpleTriplet)
 {
   using namespace std;
@@ -30,6 +30,8 @@ namespace openMVG {
 
 /// Implementation of [1] : "5. Solving the Translations Problem" equation (3)
 /// Compute camera center positions from relative camera translations (translation directions).
+/// If X_is_initial_guess is true, X content is used as initial solution
+///  instead of a random guess.
 bool
 solve_translations_problem_l2_chordal
 (
@@ -41,7 +43,8 @@ solve_translations_problem_l2_chordal
   double* X,
   double function_tolerance,
   double parameter_tolerance,
-  int max_iterations
+  int max_iterations,
+  bool X_is_initial_guess = false
 );
 
 /**
@@ -54,8 +57,11 @@ solve_translations_problem_l2_chordal
 *             Bearing: 2 view estimates => essential matrices)
 *             N-Uplets: N-view estimates => i.e. 3 view estimations means a triplet of relative motion
 
-* @param[out] translations found global camera translations
+* @param[in,out] translations found global camera translations
+*  (used as initial solution if translations_are_initial_guess is true)
 * @param[in] d_l1_loss_threshold optional threshold for SoftL1 loss (-1: no loss function)
+* @param[in] translations_are_initial_guess use the provided translations as
+*  initial solution. The first translation is considered as the gauge (0,0,0).
 * @return True if the registration can be solved
 */
 bool
@@ -63,7 +69,8 @@ solve_translations_problem_softl1
 (
   const std::vector<openMVG::RelativeInfo_Vec > & vec_initial_estimates,
   std::vector<Eigen::Vector3d> & translations,
-  const double d_l1_loss_threshold = 0.01
+  const double d_l1_loss_threshold = 0.01,
+  const bool translations_are_initial_guess = false
 );
 
 } // namespace openMVG
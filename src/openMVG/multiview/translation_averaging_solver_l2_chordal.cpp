@@ -60,7 +60,8 @@ bool solve_translations_problem_l2_chordal
   double* X,
   double function_tolerance,
   double parameter_tolerance,
-  int max_iterations
+  int max_iterations,
+  bool X_is_initial_guess
 )
 {
   // seed the random number generator
@@ -72,10 +73,24 @@ bool solve_translations_problem_l2_chordal
   reindex_problem(&reindexed_edges[0], num_edges, reindexed_lookup);
   const int num_nodes = reindexed_lookup.size();
 
-  // Init with a random guess solution
   std::vector<double> x(3*num_nodes);
-  for (int i=0; i<3*num_nodes; ++i)
-    x[i] = (double)rand() / RAND_MAX;
+  if (X_is_initial_guess)
+  {
+    // Init with the provided solution (shifted to have the first camera in {0,0,0})
+    const int first = reindexed_lookup[0];
+    for (int i=0; i<num_nodes; ++i) {
+      const int j = reindexed_lookup[i];
+      x[3*i+0] = X[3*j+0] - X[3*first+0];
+      x[3*i+1] = X[3*j+1] - X[3*first+1];
+      x[3*i+2] = X[3*j+2] - X[3*first+2];
+    }
+  }
+  else
+  {
+    // Init with a random guess solution
+    for (int i=0; i<3*num_nodes; ++i)
+      x[i] = (double)rand() / RAND_MAX;
+  }
 
   // add the parameter blocks (a 3-vector for each node)
   Problem problem;
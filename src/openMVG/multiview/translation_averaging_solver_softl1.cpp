@@ -18,6 +18,7 @@
 #include <ceres/ceres.h>
 #include <ceres/rotation.h>
 
+#include <algorithm>
 #include <vector>
 
 namespace openMVG {
@@ -90,7 +91,8 @@ bool solve_translations_problem_softl1
 (
   const std::vector<openMVG::RelativeInfo_Vec > & vec_relative_group_estimates,
   std::vector<Eigen::Vector3d> & translations,
-  const double d_l1_loss_threshold
+  const double d_l1_loss_threshold,
+  const bool translations_are_initial_guess
 )
 {
   //-- Count:
@@ -121,6 +123,54 @@ bool solve_translations_problem_softl1
   const unsigned nb_scales = vec_relative_group_estimates.size();
   std::vector<double> vec_scales(nb_scales, 1.0);
 
+  if (translations_are_initial_guess && translations.size() == nb_poses)
+  {
+    // Initial guess:
+    // - use the provided translations,
+    // - estimate the scale of each group of relative translations (least squares)
+    //   and rescale the scene to have a median group scale equal to 1.
+    //   Half of the scales are then lower than 1: the scale factors are only
+    //   softly pushed above 1 by the penalty residuals, not constrained.
+    for (unsigned int i = 0; i < nb_poses; ++i)
+    {
+      vec_translations[i*3]   = translations[i](0);
+      vec_translations[i*3+1] = translations[i](1);
+      vec_translations[i*3+2] = translations[i](2);
+    }
+    std::vector<double> vec_positive_scales;
+    for (unsigned int i = 0; i < nb_scales; ++i)
+    {
+      double num = 0.0, denom = 0.0;
+      for (const relativeInfo & info : vec_relative_group_estimates[i])
+      {
+        const Vec3 & t_i = translations[info.first.first];
+        const Vec3 & t_j = translations[info.first.second];
+        const Vec3 & t_ij = info.second.second;
+        num += t_ij.dot(t_j - info.second.first * t_i);
+        denom += t_ij.squaredNorm();
+      }
+      vec_scales[i] = (denom > 0.0) ? num / denom : 0.0;
+      if (vec_scales[i] > 0.0)
+        vec_positive_scales.push_back(vec_scales[i]);
+    }
+    if (!vec_positive_scales.empty())
+    {
+      std::nth_element(
+        vec_positive_scales.begin(),
+        vec_positive_scales.begin() + vec_positive_scales.size() / 2,
+        vec_positive_scales.end());
+      const double median_scale = vec_positive_scales[vec_positive_scales.size() / 2];
+      for (double & translation : vec_translations)
+        translation /= median_scale;
+      for (double & scale : vec_scales)
+        scale = (scale > 0.0) ? scale / median_scale : 1.0;
+    }
+    else
+    {
+      std::fill(vec_scales.begin(), vec_scales.end(), 1.0);
+    }
+  }
+
   // Setup the relative rotations array (angle axis parametrization)
   std::vector<double> vec_relative_rotations(relative_info_count*3, 0.0);
   unsigned int cpt = 0;
@@ -48,13 +48,30 @@ bool TriangulateNViewAlgebraic
   Mat4 AtA = Mat4::Zero();
   for (Mat3X::Index i = 0; i < points.cols(); ++i)
   {
-    const Vec3 point_norm = points.col(i).normalized();
-    const Mat34 cost =
-        poses[i] -
-        point_norm * point_norm.transpose() * poses[i];
-    AtA += cost.transpose() * cost;
+    AtA += TriangulateNViewAlgebraicTerm(points.col(i), poses[i]);
   }
+  return TriangulateNViewAlgebraic(AtA, X);
+}
+
+Mat4 TriangulateNViewAlgebraicTerm
+(
+  const Vec3 &point,
+  const Mat34 &pose
+)
+{
+  const Vec3 point_norm = point.normalized();
+  const Mat34 cost =
+      pose -
+      point_norm * point_norm.transpose() * pose;
+  return cost.transpose() * cost;
+}
 
+bool TriangulateNViewAlgebraic
+(
+  const Mat4 &AtA,
+  Vec4 *X
+)
+{
   Eigen::SelfAdjointEigenSolver<Mat4> eigen_solver(AtA);
   *X = eigen_solver.eigenvectors().col(0);
   return eigen_solver.info() == Eigen::Success;
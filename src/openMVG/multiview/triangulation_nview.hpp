@@ -36,6 +36,26 @@ namespace openMVG {
     Vec4 *X
   );
 
+  /// Contribution of one view to the normal equations (AtA) of the
+  /// algebraic N-view triangulation.
+  /// Summing the terms of all the views and solving them with
+  /// TriangulateNViewAlgebraic(AtA, X) gives the same result as
+  /// TriangulateNViewAlgebraic(x, Ps, X). It allows to precompute the terms
+  /// once when many subsets of the same views are triangulated (i.e. RANSAC).
+  Mat4 TriangulateNViewAlgebraicTerm
+  (
+    const Vec3 &x, // landmark bearing vector in the camera
+    const Mat34 &P // projective camera
+  );
+
+  /// Solve the normal equations of the algebraic N-view triangulation
+  /// (sum of TriangulateNViewAlgebraicTerm).
+  bool TriangulateNViewAlgebraic
+  (
+    const Mat4 &AtA,
+    Vec4 *X
+  );
+
 }  // namespace openMVG
 
 #endif  // OPENMVG_MULTIVIEW_TRIANGULATION_NVIEW_HPP
@@ -52,6 +52,107 @@ static const std::array<double, 5> kScaleRatios = {
   { 1.0, 1.0 / 2.0, 1.0 / sqrt(2.0), sqrt(2.0), 2.0 }
 };
 
+// Size of the left grid (and of the right grid at the unit scale)
+static const int kGridSize = 20;
+
+namespace {
+
+///  @brief Compute the grid index on the Left image for the given point and the chosen grid type
+///
+///  @param [in] pt     The normalized point position
+///  @param [in] type   The grid type (1:center, 2: East, 3:South, 4:West)
+///
+///  @return The left grid index
+int GetGridIndexLeft
+(
+  const Eigen::Vector2f & pt,
+  int type
+)
+{
+  // Moving the point according the asked direction
+  // (1:center, 2:East, 3:South, 4:SEst)
+  // C -> E
+  // | \
+  // S   SE
+  const double x_offset = (type == 2 || type == 4) ? 0.5 : 0;
+  const double y_offset = (type == 3 || type == 4) ? 0.5 : 0;
+
+  const int x = std::floor(pt.x() * kGridSize + x_offset);
+  const int y = std::floor(pt.y() * kGridSize + y_offset);
+
+  // Be sure that the point still belong to the grid bounds
+  if (x >= kGridSize ||
+      y >= kGridSize ||
+      x < 0 ||
+      y < 0)
+  {
+    return -1;
+  }
+
+  return x + y * kGridSize;
+}
+
+///  @brief Compute the grid index on the Right image for the given point and grid size
+///
+///  @param [in] pt         The normalized point position
+///  @param [in] grid_size  The right grid size
+///
+///  @return The right grid index
+int GetGridIndexRight
+(
+  const Eigen::Vector2f & pt,
+  const std::pair<int, int> & grid_size
+)
+{
+  const int x = std::floor(pt.x() * grid_size.first);
+  const int y = std::floor(pt.y() * grid_size.second);
+
+  // Be sure that the point is not out of bounds
+  if (x >= grid_size.first ||
+      y >= grid_size.second ||
+      x < 0 ||
+      y < 0)
+  {
+    return -1;
+  }
+
+  return x + y * grid_size.first;
+}
+
+} // namespace
+
+GMSGridAssignment::GMSGridAssignment
+(
+  const std::vector<Eigen::Vector2f> & point_positions,
+  const std::pair<int,int> & image_size,
+  const bool scale_invariance
+)
+{
+  for (auto & cells : left_cells)
+    cells.resize(point_positions.size());
+  const int scale_count = scale_invariance ? static_cast<int>(kScaleRatios.size()) : 1;
+  for (int scale = 0; scale < scale_count; ++scale)
+    right_cells[scale].resize(point_positions.size());
+
+  for (size_t i = 0; i < point_positions.size(); ++i)
+  {
+    // Normalize the point position to [{0,1};{0,1}]
+    const Eigen::Vector2f pt(
+      point_positions[i].x() / static_cast<float>(image_size.first),
+      point_positions[i].y() / static_cast<float>(image_size.second));
+
+    for (const int grid_type : {1, 2, 3, 4})
+      left_cells[grid_type - 1][i] = GetGridIndexLeft(pt, grid_type);
+
+    for (int scale = 0; scale < scale_count; ++scale)
+    {
+      const int grid_size_at_scale = kGridSize * kScaleRatios[scale];
+      const std::pair<int, int> grid_size(grid_size_at_scale, grid_size_at_scale);
+      right_cells[scale][i] = GetGridIndexRight(pt, grid_size);
+    }
+  }
+}
+
 GMSFilter::GMSFilter
 (
   const std::vector<Eigen::Vector2f> & point_positions1,
@@ -61,34 +162,48 @@ GMSFilter::GMSFilter
   const matching::IndMatches & matches,
   const int threshold_factor
 ):
-  point_positions1_(point_positions1),
-  point_positions2_(point_positions2),
+  // Compute the grid cells of the points
+  GMSFilter(
+    std::unique_ptr<const GMSGridAssignment>(
+      new GMSGridAssignment(point_positions1, image_size1)),
+    std::unique_ptr<const GMSGridAssignment>(
+      new GMSGridAssignment(point_positions2, image_size2)),
+    matches,
+    threshold_factor)
+{
+}
+
+GMSFilter::GMSFilter
+(
+  std::unique_ptr<const GMSGridAssignment> grid1,
+  std::unique_ptr<const GMSGridAssignment> grid2,
+  const matching::IndMatches & matches,
+  const int threshold_factor
+):
+  GMSFilter(*grid1, *grid2, matches, threshold_factor)
+{
+  owned_grid1_ = std::move(grid1);
+  owned_grid2_ = std::move(grid2);
+}
+
+GMSFilter::GMSFilter
+(
+  const GMSGridAssignment & grid1,
+  const GMSGridAssignment & grid2,
+  const matching::IndMatches & matches,
+  const int threshold_factor
+):
+  grid1_(&grid1),
+  grid2_(&grid2),
   matches_indexes_(matches),
+  threshold_factor_(threshold_factor),
   // Grid initialization
   left_grid_size_(kGridSize, kGridSize),
-  left_grid_count_(left_grid_size_.first * left_grid_size_.second),
-  threshold_factor_(threshold_factor)
+  left_grid_count_(left_grid_size_.first * left_grid_size_.second)
 {
-  // Normalize the points position to [{0,1};{0,1}]
-  NormalizePoints(image_size1, point_positions1_);
-  NormalizePoints(image_size2, point_positions2_);
-
   // Initialize the right grid neighbor indexes
   left_neighbor_grid_indexes_.resize(left_grid_count_);
   InitalizeGridNeighborhood(left_neighbor_grid_indexes_, left_grid_size_);
-};
-
-void GMSFilter::NormalizePoints
-(
-  const std::pair<int, int> & image_size,
-  std::vector<Eigen::Vector2f> & points
-) const
-{
-  for (auto & kp : points)
-  {
-    kp.x() /= static_cast<float>(image_size.first);
-    kp.y() /= static_cast<float>(image_size.second);
-  }
 }
 
 void GMSFilter::InitalizeGridNeighborhood
@@ -116,55 +231,6 @@ void GMSFilter::InitalizeRightGridNeighborhoodWithScale
   InitalizeGridNeighborhood(right_neighbor_grid_indexes_, right_grid_size_);
 }
 
-int GMSFilter::GetGridIndexLeft
-(
-  const Eigen::Vector2f & pt,
-  int type
-) const
-{
-  // Moving the point according the asked direction
-  // (1:center, 2:East, 3:South, 4:SEst)
-  // C -> E
-  // | \
-  // S   SE
-  const double x_offset = (type == 2 || type == 4) ? 0.5 : 0;
-  const double y_offset = (type == 3 || type == 4) ? 0.5 : 0;
-
-  const int x = std::floor(pt.x() * left_grid_size_.first  + x_offset);
-  const int y = std::floor(pt.y() * left_grid_size_.second + y_offset);
-
-  // Be sure that the point still belong to the grid bounds
-  if (x >= left_grid_size_.first ||
-      y >= left_grid_size_.second ||
-      x < 0 ||
-      y < 0)
-  {
-    return -1;
-  }
-
-  return x + y * left_grid_size_.first;
-}
-
-int GMSFilter::GetGridIndexRight
-(
-  const Eigen::Vector2f & pt
-) const
-{
-  const int x = std::floor(pt.x() * right_grid_size_.first);
-  const int y = std::floor(pt.y() * right_grid_size_.second);
-
-  // Be sure that the point is not out of bounds
-  if (x >= right_grid_size_.first ||
-      y >= right_grid_size_.second ||
-      x < 0 ||
-      y < 0)
-  {
-    return -1;
-  }
-
-  return x + y * right_grid_size_.first;
-}
-
 std::array<int, 9> GMSFilter::GetNB9
 (
   const int idx,
@@ -212,6 +278,9 @@ int GMSFilter::GetInlierMask
 
   for (const auto & scale_it : scales_idx)
   {
+    // Skip the scales for which the right grid cells are not known
+    if (grid2_->right_cells[scale_it].empty())
+      continue;
     InitalizeRightGridNeighborhoodWithScale(scale_it);
     for (const auto & rotation_it : rotations_idx)
     {
@@ -226,16 +295,15 @@ int GMSFilter::GetInlierMask
   return max_inlier;
 }
 
-void GMSFilter::AssignMatchPairs(int grid_type)
+void GMSFilter::AssignMatchPairs(int grid_type, int scale)
 {
+  const auto & left_cells = grid1_->left_cells[grid_type - 1];
+  const auto & right_cells = grid2_->right_cells[scale];
   for (size_t i = 0; i < matches_indexes_.size(); ++i)
   {
-    const auto & lp = point_positions1_[matches_indexes_[i].i_];
-    const auto & rp = point_positions2_[matches_indexes_[i].j_];
-
-    const int lgidx = match_cell_pairs_[i].first = GetGridIndexLeft(lp, grid_type);
+    const int lgidx = match_cell_pairs_[i].first = left_cells[matches_indexes_[i].i_];
     if (lgidx == -1) continue;
-    const int rgidx = match_cell_pairs_[i].second = GetGridIndexRight(rp);
+    const int rgidx = match_cell_pairs_[i].second = right_cells[matches_indexes_[i].j_];
     if (rgidx == -1) continue;
 
     ++motion_statistics_(lgidx,rgidx);
@@ -320,7 +388,7 @@ int GMSFilter::Run
     nb_points_per_left_cell_.assign(left_grid_count_, 0);
 
     // Compute and verify motion statistics
-    AssignMatchPairs(grid_type_it);
+    AssignMatchPairs(grid_type_it, scale);
     VerifyCellPairs(rotation_type);
 
     // Mark inliers
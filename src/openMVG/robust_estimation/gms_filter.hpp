@@ -13,8 +13,11 @@
 #include "openMVG/numeric/eigen_alias_definition.hpp"
 
 #include <array>
+#include <cstdint>
 #include <map>
+#include <memory>
 #include <utility>
+#include <vector>
 
 namespace openMVG {
 namespace robust {
@@ -24,6 +27,31 @@ namespace robust {
 //     JiaWang Bian, Wen-Yan Lin, Yasuyuki Matsushita, Sai-Kit Yeung, Tan Dat Nguyen, Ming-Ming Cheng
 //     CVPR, 2017
 
+/// Grid cells of the points of an image, as used by the GMS filter.
+/// They only depend on the image point positions, so they can be computed
+/// once per image and shared by all the pairs the image belongs to.
+struct GMSGridAssignment
+{
+  GMSGridAssignment() = default;
+
+  /// @brief Compute the grid cell of the image points
+  /// @param [in] point_positions     Image point positions
+  /// @param [in] image_size          Image size (w,h)
+  /// @param [in] scale_invariance    Compute the cells of the 5 right grid
+  ///  scales (else only the one of the unit scale)
+  GMSGridAssignment
+  (
+    const std::vector<Eigen::Vector2f> & point_positions,
+    const std::pair<int,int> & image_size,
+    const bool scale_invariance = true
+  );
+
+  /// Point cells in the left grid for the 4 grid types (-1 if out of the grid)
+  std::array<std::vector<int16_t>, 4> left_cells;
+  /// Point cells in the right grid for the 5 scales (empty if not computed)
+  std::array<std::vector<int16_t>, 5> right_cells;
+};
+
 class GMSFilter
 {
 public:
@@ -46,6 +74,27 @@ public:
     const int threshold_factor = 12
   );
 
+  /// @brief GMS constructor (setup the precomputed point grid cells)
+  /// @param [in] grid1               Image 1 point grid cells
+  /// @param [in] grid2               Image 2 point grid cells
+  /// @param [in] matches             Corresponding indexes for the point grid
+  /// cells that depict a match.
+  /// @param [in] threshold_factor    GMS threshold
+  ///
+  /// The grid assignments must outlive the filter.
+  GMSFilter
+  (
+    const GMSGridAssignment & grid1,
+    const GMSGridAssignment & grid2,
+    const matching::IndMatches & matches,
+    const int threshold_factor = 12
+  );
+
+  // The filter refers to the grid assignments
+  GMSFilter(const GMSFilter &) = delete;
+  GMSFilter & operator=(const GMSFilter &) = delete;
+  GMSFilter(GMSFilter &&) = default;
+
   ///  @brief Get the inliers indexes thanks to an inlier boolean mask
   ///
   ///  @param [out] inlier_mask         The inlier/outlier classification as a boolean mask
@@ -62,45 +111,21 @@ public:
 
 private:
 
-  ///  @brief Normalize point coordinates to the range (0 - 1)
-  ///
-  ///  @param [in] image_size   The image size (w, h)
-  ///  @param [in,out] points   The points that are normalized inplace
-  ///
-  void NormalizePoints
-  (
-    const std::pair<int, int> & image_size,
-    std::vector<Eigen::Vector2f> & points
-  ) const;
-
-  ///  @brief Compute the grid index on the Left image for the given point and the chosen grid type
-  ///
-  ///  @param [in] pt     The normalized point position
-  ///  @param [in] type   The grid type (1:center, 2: East, 3:South, 4:West)
-  ///
-  ///  @return The left grid index
-  int GetGridIndexLeft
-  (
-    const Eigen::Vector2f & pt,
-    int type
-  ) const;
-
-  ///  @brief Compute the grid index on the Right image for the given point and the chosen grid type
-  ///
-  ///  @param [in] pt     The normalized point position
-  ///  @param [in] type   The subgrid type (1:center, 2:East, 3:South, 4:SEst)
-  ///
-  ///  @return The right grid index
-  int GetGridIndexRight
+  /// Take the ownership of the grid assignments (built from the point positions)
+  GMSFilter
   (
-    const Eigen::Vector2f & pt
-  ) const;
+    std::unique_ptr<const GMSGridAssignment> grid1,
+    std::unique_ptr<const GMSGridAssignment> grid2,
+    const matching::IndMatches & matches,
+    const int threshold_factor
+  );
 
   ///  @brief Accumulate motion statistics for the match_pairs and given grid_type
   ///
   ///  @param [in] grid_type The grid type (1:center, 2:East, 3:South, 4:SEst)
+  ///  @param [in] scale     The right grid scale index [0,4]
   ///
-  void AssignMatchPairs(int grid_type);
+  void AssignMatchPairs(int grid_type, int scale);
 
   ///  @brief Verify Cell Pairs
   ///  Threshold the aggregate statistics for the neighborhood grids.
@@ -152,10 +177,10 @@ private:
   // Data
   // --
 
-  const uint8_t kGridSize = 20;
-
-  // Normalized Points
-  std::vector<Eigen::Vector2f> point_positions1_, point_positions2_;
+  // Point grid cells (owned if built from the point positions: they are heap
+  //  allocated, so the pointers stay valid when the filter is moved)
+  std::unique_ptr<const GMSGridAssignment> owned_grid1_, owned_grid2_;
+  const GMSGridAssignment * grid1_, * grid2_;
 
   // Matches
   const matching::IndMatches matches_indexes_;
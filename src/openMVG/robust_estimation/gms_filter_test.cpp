@@ -187,6 +187,82 @@ TEST(GMSFilter, OutlierDetection)
   EXPECT_EQ(6, std::count(inlier_flags.cbegin(), inlier_flags.cbegin() + 6, false));
 }
 
+// The grid assignment and the point position constructors give the same inliers
+TEST(GMSFilter, GridAssignment)
+{
+  const int kImageSize = 200;
+  const int kBorder = 20;
+  const int kNbPoints = (kImageSize * kImageSize) * 0.1;
+  std::vector<Eigen::Vector2f> vec_point_left(kNbPoints), vec_point_right(kNbPoints);
+  matching::IndMatches matches;
+  GenerateCorrespondingPoints(
+    kImageSize, kBorder, kNbPoints, vec_point_left, vec_point_right, matches);
+
+  // Two motion fields and some outliers
+  for (int i = 0; i < kNbPoints; ++i)
+  {
+    vec_point_right[i] += (i % 2) ? Vec2f(kBorder / 2, kBorder / 4) : Vec2f(kBorder / 4, kBorder / 2);
+  }
+  for (int i = 0; i < 50; ++i)
+  {
+    matches[i].j_ = matches[i + 100].j_;
+  }
+
+  const GMSGridAssignment
+    grid_left(vec_point_left, {kImageSize, kImageSize}),
+    grid_right(vec_point_right, {kImageSize, kImageSize});
+
+  for (const bool with_scale_invariance : {false, true})
+  {
+    for (const bool with_rotation_invariance : {false, true})
+    {
+      robust::GMSFilter gms_points(
+        vec_point_left,  {kImageSize, kImageSize},
+        vec_point_right, {kImageSize, kImageSize},
+        matches);
+      std::vector<bool> inlier_flags_points;
+      const int num_inliers_points = gms_points.GetInlierMask(inlier_flags_points,
+        with_scale_invariance, with_rotation_invariance);
+
+      robust::GMSFilter gms_grid(grid_left, grid_right, matches);
+      std::vector<bool> inlier_flags_grid;
+      const int num_inliers_grid = gms_grid.GetInlierMask(inlier_flags_grid,
+        with_scale_invariance, with_rotation_invariance);
+
+      CHECK(num_inliers_points > 0);
+      EXPECT_EQ(num_inliers_points, num_inliers_grid);
+      CHECK(inlier_flags_points == inlier_flags_grid);
+    }
+  }
+}
+
+// A filter built from the point positions can be moved (it owns its grids)
+TEST(GMSFilter, Move)
+{
+  const int kImageSize = 200;
+  const int kBorder = 20;
+  const int kNbPoints = (kImageSize * kImageSize) * 0.1;
+  std::vector<Eigen::Vector2f> vec_point_left(kNbPoints), vec_point_right(kNbPoints);
+  matching::IndMatches matches;
+  GenerateCorrespondingPoints(
+    kImageSize, kBorder, kNbPoints, vec_point_left, vec_point_right, matches);
+  for (const int i : {0,1,2,3,4,5})
+  {
+    matches[i].j_ = matches[i + 5].j_;
+  }
+
+  std::vector<robust::GMSFilter> filters;
+  {
+    robust::GMSFilter gms(
+      vec_point_left,  {kImageSize, kImageSize},
+      vec_point_right, {kImageSize, kImageSize},
+      matches);
+    filters.push_back(std::move(gms));
+  }
+  std::vector<bool> inlier_flags;
+  EXPECT_EQ(kNbPoints - 6, filters.front().GetInlierMask(inlier_flags));
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
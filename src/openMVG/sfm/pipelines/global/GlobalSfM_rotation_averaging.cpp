@@ -16,6 +16,9 @@
 
 #include "third_party/histogram/histogram.hpp"
 
+#include <algorithm>
+#include <deque>
+
 namespace openMVG{
 namespace sfm{
 
@@ -26,11 +29,56 @@ Pair_Set GlobalSfM_Rotation_AveragingSolver::GetUsedPairs() const
   return used_pairs;
 }
 
+/// Chain the relative rotations (breadth first traversal) from the poses
+///  that have a known rotation to initialize the rotation of the other poses.
+/// Return false if some poses are not connected to a pose with a known rotation.
+static bool ChainInitialRotations
+(
+  const RelativeRotations & relativeRotations,
+  std::vector<Mat3> & vec_globalR,
+  std::vector<bool> & vec_known
+)
+{
+  std::vector<std::vector<std::pair<IndexT, Mat3>>> adjacency(vec_globalR.size());
+  for (const RelativeRotation & rel : relativeRotations)
+  {
+    // Rj = Rij * Ri
+    adjacency[rel.i].emplace_back(rel.j, rel.Rij);
+    adjacency[rel.j].emplace_back(rel.i, rel.Rij.transpose());
+  }
+
+  std::deque<IndexT> queue;
+  for (IndexT i = 0; i < vec_known.size(); ++i)
+  {
+    if (vec_known[i])
+      queue.push_back(i);
+  }
+  if (queue.empty())
+    return false;
+
+  while (!queue.empty())
+  {
+    const IndexT i = queue.front();
+    queue.pop_front();
+    for (const auto & neighbor : adjacency[i])
+    {
+      if (!vec_known[neighbor.first])
+      {
+        vec_globalR[neighbor.first] = neighbor.second * vec_globalR[i];
+        vec_known[neighbor.first] = true;
+        queue.push_back(neighbor.first);
+      }
+    }
+  }
+  return std::find(vec_known.cbegin(), vec_known.cend(), false) == vec_known.cend();
+}
+
 bool GlobalSfM_Rotation_AveragingSolver::Run(
   ERotationAveragingMethod eRotationAveragingMethod,
   ERelativeRotationInferenceMethod eRelativeRotationInferenceMethod,
   const RelativeRotations & relativeRot_In,
-  Hash_Map<IndexT, Mat3> & map_globalR
+  Hash_Map<IndexT, Mat3> & map_globalR,
+  const Hash_Map<IndexT, Mat3> * initial_globalR
 ) const
 {
   RelativeRotations relativeRotations = relativeRot_In;
@@ -81,15 +129,40 @@ bool GlobalSfM_Rotation_AveragingSolver::Run(
   //- B. solve global rotation computation
   bool bSuccess = false;
   std::vector<Mat3> vec_globalR(reindexForward.size());
+
+  // Initial guess: setup the initial rotations from the provided ones
+  bool bInitialGuess = false;
+  if (initial_globalR && !initial_globalR->empty())
+  {
+    std::vector<bool> vec_known(vec_globalR.size(), false);
+    for (const auto & reindex_it : reindexForward)
+    {
+      const auto initial_it = initial_globalR->find(reindex_it.first);
+      if (initial_it != initial_globalR->end())
+      {
+        vec_globalR[reindex_it.second] = initial_it->second;
+        vec_known[reindex_it.second] = true;
+      }
+    }
+    const size_t initial_count = std::count(vec_known.cbegin(), vec_known.cend(), true);
+    bInitialGuess = ChainInitialRotations(relativeRotations, vec_globalR, vec_known);
+    std::cout
+      << "Rotation averaging initial guess: "
+      << initial_count << " known rotations over " << vec_globalR.size() << " poses"
+      << (bInitialGuess ? "" : " (not connected, use a full solve)") << std::endl;
+  }
+
   switch (eRotationAveragingMethod)
   {
     case ROTATION_AVERAGING_L2:
     {
       //- Solve the global rotation estimation problem:
-      bSuccess = rotation_averaging::l2::L2RotationAveraging(
-        reindexForward.size(),
-        relativeRotations,
-        vec_globalR);
+      // (skipped if an initial solution is available)
+      bSuccess = bInitialGuess ||
+        rotation_averaging::l2::L2RotationAveraging(
+          reindexForward.size(),
+          relativeRotations,
+          vec_globalR);
       //- Non linear refinement of the global rotations
       if (bSuccess)
         bSuccess = rotation_averaging::l2::L2RotationAveraging_Refine(
@@ -113,8 +186,27 @@ bool GlobalSfM_Rotation_AveragingSolver::Run(
       //- Solve the global rotation estimation problem:
       const size_t nMainViewID = 0; //arbitrary choice
       std::vector<bool> vec_inliers;
-      bSuccess = rotation_averaging::l1::GlobalRotationsRobust(
-        relativeRotations, vec_globalR, nMainViewID, 0.0f, &vec_inliers);
+      if (bInitialGuess)
+      {
+        // refine global rotations from the initial solution
+        // (expressed in the frame of the main view, then restored in the frame
+        //  of the initial rotations)
+        const Mat3 R0 = vec_globalR[nMainViewID];
+        for (Mat3 & R : vec_globalR)
+          R = R * R0.transpose();
+        vec_globalR[nMainViewID] = Mat3::Identity();
+        bSuccess = rotation_averaging::l1::RefineRotationsAvgL1IRLS(
+          relativeRotations, vec_globalR, nMainViewID);
+        rotation_averaging::l1::FilterRelativeRotations(
+          relativeRotations, vec_globalR, 0.0f, &vec_inliers);
+        for (Mat3 & R : vec_globalR)
+          R = R * R0;
+      }
+      else
+      {
+        bSuccess = rotation_averaging::l1::GlobalRotationsRobust(
+          relativeRotations, vec_globalR, nMainViewID, 0.0f, &vec_inliers);
+      }
 
       std::cout << "\ninliers: " << std::endl;
       std::copy(vec_inliers.begin(), vec_inliers.end(), std::ostream_iterator<bool>(std::cout, " "));
@@ -42,11 +42,17 @@ private:
   mutable Pair_Set used_pairs; // pair that are considered as valid by the rotation averaging solver
 
 public:
+  /// Compute the global rotations from the relative rotations.
+  /// If initial global rotations are provided (i.e. from a
+  ///  previous reconstruction of a subset of the scene), the rotations of the
+  ///  remaining poses are chained from them and the solver only performs the
+  ///  refinement step (the linear/MST initialization is skipped).
   bool Run(
     ERotationAveragingMethod eRotationAveragingMethod,
     ERelativeRotationInferenceMethod eRelativeRotationInferenceMethod,
     const rotation_averaging::RelativeRotations & relativeRot_In,
-    Hash_Map<IndexT, Mat3> & map_globalR
+    Hash_Map<IndexT, Mat3> & map_globalR,
+    const Hash_Map<IndexT, Mat3> * initial_globalR = nullptr
   ) const;
 
   /// Reject edges of the view graph that do not produce triplets with tiny
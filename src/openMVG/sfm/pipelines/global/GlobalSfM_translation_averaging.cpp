@@ -8,10 +8,6 @@
 
 #include "openMVG/sfm/pipelines/global/GlobalSfM_translation_averaging.hpp"
 
-#ifdef OPENMVG_USE_OPENMP
-#include <omp.h>
-#endif
-
 #include "openMVG/graph/graph.hpp"
 #include "openMVG/types.hpp"
 #include "openMVG/cameras/Camera_Intrinsics.hpp"
@@ -21,8 +17,8 @@
 #include "openMVG/multiview/translation_averaging_common.hpp"
 #include "openMVG/multiview/translation_averaging_solver.hpp"
 #include "openMVG/robust_estimation/robust_estimator_ACRansac.hpp"
-#include "openMVG/sfm/pipelines/global/mutexSet.hpp"
 #include "openMVG/sfm/pipelines/global/sfm_global_reindex.hpp"
+#include "openMVG/sfm/pipelines/global/triplet_edge_coverage_scheduler.hpp"
 #include "openMVG/sfm/pipelines/global/triplet_t_ACRansac_kernelAdaptator.hpp"
 #include "openMVG/sfm/pipelines/sfm_features_provider.hpp"
 #include "openMVG/sfm/pipelines/sfm_matches_provider.hpp"
@@ -31,6 +27,10 @@
 #include "openMVG/stl/stl.hpp"
 #include "openMVG/system/timer.hpp"
 
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <utility>
 #include <vector>
 
 namespace openMVG{
@@ -40,6 +40,85 @@ using namespace openMVG::cameras;
 using namespace openMVG::geometry;
 using namespace openMVG::matching;
 
+/// Build the initial guess of the camera centers (contiguous indexing):
+/// - the known centers are copied,
+/// - the other ones are chained along the relative translation directions
+///   (using the median known baseline as length).
+/// Return false if no center is known or some poses cannot be reached.
+static bool InitialCameraCenters
+(
+  const std::vector<RelativeInfo_Vec> & vec_relative_motion,
+  const Hash_Map<IndexT, IndexT> & reindex_backward,
+  const Hash_Map<IndexT, Mat3> & map_globalR,
+  const Hash_Map<IndexT, Vec3> & initial_centers,
+  std::vector<Vec3> & centers
+)
+{
+  const size_t node_count = reindex_backward.size();
+  centers.assign(node_count, Vec3::Zero());
+  std::vector<bool> vec_known(node_count, false);
+  for (size_t i = 0; i < node_count; ++i)
+  {
+    const auto center_it = initial_centers.find(reindex_backward.at(i));
+    if (center_it != initial_centers.end())
+    {
+      centers[i] = center_it->second;
+      vec_known[i] = true;
+    }
+  }
+
+  // Adjacency list: (neighbor, unit direction from the node to its neighbor)
+  std::vector<std::vector<std::pair<IndexT, Vec3>>> adjacency(node_count);
+  std::vector<double> vec_baselines;
+  for (const RelativeInfo_Vec & iter : vec_relative_motion)
+  {
+    for (const relativeInfo & rel : iter)
+    {
+      const IndexT i = rel.first.first, j = rel.first.second;
+      const Mat3 & Rj = map_globalR.at(reindex_backward.at(j));
+      const Vec3 direction = -(Rj.transpose() * rel.second.second.normalized());
+      adjacency[i].emplace_back(j, direction);
+      adjacency[j].emplace_back(i, -direction);
+      if (vec_known[i] && vec_known[j])
+        vec_baselines.push_back((centers[j] - centers[i]).norm());
+    }
+  }
+  double baseline = 1.0;
+  if (!vec_baselines.empty())
+  {
+    std::nth_element(
+      vec_baselines.begin(),
+      vec_baselines.begin() + vec_baselines.size() / 2,
+      vec_baselines.end());
+    baseline = vec_baselines[vec_baselines.size() / 2];
+  }
+
+  std::deque<IndexT> queue;
+  for (IndexT i = 0; i < node_count; ++i)
+  {
+    if (vec_known[i])
+      queue.push_back(i);
+  }
+  if (queue.empty())
+    return false;
+
+  while (!queue.empty())
+  {
+    const IndexT i = queue.front();
+    queue.pop_front();
+    for (const auto & neighbor : adjacency[i])
+    {
+      if (!vec_known[neighbor.first])
+      {
+        centers[neighbor.first] = centers[i] + baseline * neighbor.second;
+        vec_known[neighbor.first] = true;
+        queue.push_back(neighbor.first);
+      }
+    }
+  }
+  return std::find(vec_known.cbegin(), vec_known.cend(), false) == vec_known.cend();
+}
+
 /// Use features in normalized camera frames
 bool GlobalSfM_Translation_AveragingSolver::Run
 (
@@ -48,7 +127,8 @@ bool GlobalSfM_Translation_AveragingSolver::Run
   const openMVG::sfm::Features_Provider * features_provider,
   const openMVG::sfm::Matches_Provider * matches_provider,
   const Hash_Map<IndexT, Mat3> & map_globalR,
-  matching::PairWiseMatches & tripletWise_matches
+  matching::PairWiseMatches & tripletWise_matches,
+  const Hash_Map<IndexT, Vec3> * initial_centers
 )
 {
   // Compute the relative translations and save them to vec_initialRijTijEstimates:
@@ -62,7 +142,8 @@ bool GlobalSfM_Translation_AveragingSolver::Run
   const bool b_translation = Translation_averaging(
     eTranslationAveragingMethod,
     sfm_data,
-    map_globalR);
+    map_globalR,
+    initial_centers);
 
   // Filter matches to keep only them link to view that have valid poses
   // (necessary since multiple components exists before translation averaging)
@@ -80,7 +161,8 @@ bool GlobalSfM_Translation_AveragingSolver::Run
 bool GlobalSfM_Translation_AveragingSolver::Translation_averaging(
   ETranslationAveragingMethod eTranslationAveragingMethod,
   sfm::SfM_Data & sfm_data,
-  const Hash_Map<IndexT, Mat3> & map_globalR)
+  const Hash_Map<IndexT, Mat3> & map_globalR,
+  const Hash_Map<IndexT, Vec3> * initial_centers)
 {
   //-------------------
   //-- GLOBAL TRANSLATIONS ESTIMATION from initial triplets t_ij guess
@@ -126,6 +208,19 @@ bool GlobalSfM_Translation_AveragingSolver::Translation_averaging(
       }
     }
 
+    // Initial guess of the camera centers (contiguous indexing)
+    std::vector<Vec3> vec_initial_centers;
+    const bool b_initial_guess =
+      initial_centers && !initial_centers->empty()
+      && eTranslationAveragingMethod != TRANSLATION_AVERAGING_L1
+      && InitialCameraCenters(vec_relative_motion_cpy, reindex_backward,
+           map_globalR, *initial_centers, vec_initial_centers);
+    if (initial_centers && !initial_centers->empty())
+    {
+      std::cout << "Translation averaging initial guess: "
+        << (b_initial_guess ? "enabled" : "disabled (use a full solve)") << std::endl;
+    }
+
     openMVG::system::Timer timerLP_translation;
 
     switch (eTranslationAveragingMethod)
@@ -202,8 +297,19 @@ bool GlobalSfM_Translation_AveragingSolver::Translation_averaging(
       case TRANSLATION_AVERAGING_SOFTL1:
       {
         std::vector<Vec3> vec_translations;
+        if (b_initial_guess)
+        {
+          // Convert the camera centers to translations
+          //  (the first camera is set in {0,0,0} to fix the gauge)
+          vec_translations.resize(iNview);
+          for (size_t i = 0; i < iNview; ++i)
+          {
+            const Mat3 & Ri = map_globalR.at(reindex_backward[i]);
+            vec_translations[i] = -Ri * (vec_initial_centers[i] - vec_initial_centers[0]);
+          }
+        }
         if (!solve_translations_problem_softl1(
-          vec_relative_motion_cpy, vec_translations))
+          vec_relative_motion_cpy, vec_translations, 0.01, b_initial_guess))
         {
           std::cerr << "Compute global translations: failed" << std::endl;
           return false;
@@ -257,6 +363,15 @@ bool GlobalSfM_Translation_AveragingSolver::Translation_averaging(
         const double loss_width = 0.0; // No loss in order to compare with TRANSLATION_AVERAGING_L1
 
         std::vector<double> X(iNview*3, 0.0);
+        if (b_initial_guess)
+        {
+          for (size_t i = 0; i < iNview; ++i)
+          {
+            X[i*3]   = vec_initial_centers[i](0);
+            X[i*3+1] = vec_initial_centers[i](1);
+            X[i*3+2] = vec_initial_centers[i](2);
+          }
+        }
         if (!solve_translations_problem_l2_chordal(
           &vec_edges[0],
           &vec_poses[0],
@@ -266,7 +381,8 @@ bool GlobalSfM_Translation_AveragingSolver::Translation_averaging(
           &X[0],
           function_tolerance,
           parameter_tolerance,
-          max_iterations))  {
+          max_iterations,
+          b_initial_guess))  {
             std::cerr << "Compute global translations: failed" << std::endl;
             return false;
         }
@@ -365,8 +481,8 @@ void GlobalSfM_Translation_AveragingSolver::ComputePutativeTranslation_EdgesCove
     // Avoid to cover each edge of the graph by using an edge coverage algorithm
     // An estimated triplets of translation mark three edges as estimated.
 
-    //-- Alias (list triplet ids used per edges)
-    using myEdge = Pair; // An edge between two pose id
+    //-- Precompute the visibility count per triplets (sum of their 2 view matches)
+    using myEdge = Pair; // An edge between two pose id (sorted)
     Hash_Map<myEdge, std::vector<uint32_t>> map_tripletIds_perEdge;
     for (size_t i = 0; i < vec_triplets.size(); ++i)
     {
@@ -375,9 +491,7 @@ void GlobalSfM_Translation_AveragingSolver::ComputePutativeTranslation_EdgesCove
       map_tripletIds_perEdge[{triplet.i, triplet.k}].push_back(i);
       map_tripletIds_perEdge[{triplet.j, triplet.k}].push_back(i);
     }
-
-    //-- precompute the visibility count per triplets (sum of their 2 view matches)
-    Hash_Map<IndexT, IndexT> map_tracksPerTriplets;
+    std::vector<uint32_t> vec_tracksPerTriplets(vec_triplets.size(), 0);
     for (const auto & match_iterator : matches_provider->pairWise_matches_)
     {
       const Pair pair = match_iterator.first;
@@ -386,194 +500,159 @@ void GlobalSfM_Translation_AveragingSolver::ComputePutativeTranslation_EdgesCove
       if (v1->id_pose != v2->id_pose)
       {
         // Consider the pair iff it is supported by 2 different pose id
-        const myEdge edge(v1->id_pose,v2->id_pose);
-        if (map_tripletIds_perEdge.count(edge) != 0)
+        const myEdge edge(std::min(v1->id_pose, v2->id_pose),
+                          std::max(v1->id_pose, v2->id_pose));
+        const auto edge_it = map_tripletIds_perEdge.find(edge);
+        if (edge_it != map_tripletIds_perEdge.end())
         {
-          const auto & edge_tripletIds = map_tripletIds_perEdge.at(edge);
-          for (const auto & triplet_id : edge_tripletIds)
+          for (const auto & triplet_id : edge_it->second)
           {
-            if (map_tracksPerTriplets.count(triplet_id) == 0)
-              map_tracksPerTriplets[triplet_id] = match_iterator.second.size();
-            else
-              map_tracksPerTriplets[triplet_id] += match_iterator.second.size();
+            vec_tracksPerTriplets[triplet_id] += match_iterator.second.size();
           }
         }
       }
     }
-    // Collect edges that are covered by the triplets
-    std::vector<myEdge> vec_edges;
-    std::transform(map_tripletIds_perEdge.cbegin(),
-                   map_tripletIds_perEdge.cend(),
-                   std::back_inserter(vec_edges),
-                   stl::RetrieveKey());
+    map_tripletIds_perEdge.clear();
 
-    openMVG::sfm::MutexSet<myEdge> m_mutexSet;
+    // Schedule the triplets estimation by rounds of edge-disjoint triplets:
+    //  an uncovered edge tries its triplets by descending track count until
+    //  one of them is estimated. The estimated triplets do not depend on the
+    //  thread count.
+    TripletEdgeCoverageScheduler scheduler(vec_triplets, vec_tracksPerTriplets);
 
     C_Progress_display my_progress_bar(
-      vec_edges.size(),
+      scheduler.EdgeCount(),
       std::cout,
       "\nRelative translations computation (edge coverage algorithm)\n");
 
-#  ifdef OPENMVG_USE_OPENMP
-    std::vector<std::vector<RelativeInfo_Vec>> initial_estimates(omp_get_max_threads());
-#  else
-    std::vector<std::vector<RelativeInfo_Vec>> initial_estimates(1);
-#  endif
+    // The inlier tracks of an estimated triplet, as pairwise matches
+    struct TripletEstimate
+    {
+      RelativeInfo_Vec relative_motions;
+      std::vector<std::pair<Pair, matching::IndMatch>> inlier_matches;
+    };
 
-    #ifdef OPENMVG_USE_OPENMP
-    #pragma omp parallel for schedule(dynamic)
-    #endif
-    for (int k = 0; k < static_cast<int>(vec_edges.size()); ++k)
+    size_t pending_edge_count = scheduler.EdgeCount();
+    while (!scheduler.NextRound().empty())
     {
-      const myEdge & edge = vec_edges[k];
-      ++my_progress_bar;
+      my_progress_bar += pending_edge_count - scheduler.PendingEdgeCount();
+      pending_edge_count = scheduler.PendingEdgeCount();
+
+      const std::vector<uint32_t> & round = scheduler.Round();
+      std::vector<std::unique_ptr<TripletEstimate>> round_estimates(round.size());
 
-      if (m_mutexSet.count(edge) == 0 && m_mutexSet.size() != vec_edges.size())
+      #ifdef OPENMVG_USE_OPENMP
+      #pragma omp parallel for schedule(dynamic)
+      #endif
+      for (int round_index = 0; round_index < static_cast<int>(round.size()); ++round_index)
       {
-        // Find the triplets that are supporting the given edge
-        const auto & vec_possibleTripletIndexes = map_tripletIds_perEdge.at(edge);
+        const uint32_t triplet_index = round[round_index];
+        const graph::Triplet & triplet = vec_triplets[triplet_index];
 
-        //-- Sort the triplets according their number of track
-        std::vector<uint32_t> vec_commonTracksPerTriplets;
-        for (const uint32_t triplet_index : vec_possibleTripletIndexes)
-        {
-          vec_commonTracksPerTriplets.push_back(map_tracksPerTriplets[triplet_index]);
-        }
+        //--
+        // Try to estimate this triplet of translations
+        //--
+        double dPrecision = 4.0; // upper bound of the residual pixel reprojection error
 
-        using namespace stl::indexed_sort;
-        std::vector<sort_index_packet_descend<uint32_t,uint32_t>> packet_vec(vec_commonTracksPerTriplets.size());
-        sort_index_helper(packet_vec, &vec_commonTracksPerTriplets[0]);
+        std::vector<Vec3> vec_tis(3);
+        std::vector<uint32_t> vec_inliers;
+        openMVG::tracks::STLMAPTracks pose_triplet_tracks;
 
-        std::vector<uint32_t> vec_triplet_ordered(vec_commonTracksPerTriplets.size(), 0);
-        for (size_t i = 0; i < vec_commonTracksPerTriplets.size(); ++i) {
-          vec_triplet_ordered[i] = vec_possibleTripletIndexes[packet_vec[i].index];
-        }
+        const std::string sOutDirectory = "./";
+
+        const bool bTriplet_estimation = Estimate_T_triplet(
+            sfm_data,
+            map_globalR,
+            features_provider,
+            matches_provider,
+            triplet,
+            vec_tis,
+            dPrecision,
+            vec_inliers,
+            pose_triplet_tracks,
+            sOutDirectory);
 
-        // Try to solve a triplet of translations for the given edge
-        for (const uint32_t triplet_index : vec_triplet_ordered)
+        if (!bTriplet_estimation)
+          continue;
+
+        // Since new translation edges have been computed, mark their corresponding edges as estimated
+        scheduler.MarkEstimated(triplet_index);
+
+        std::unique_ptr<TripletEstimate> estimate(new TripletEstimate);
+
+        // Compute the triplet relative motions (IJ, JK, IK)
         {
-          const graph::Triplet & triplet = vec_triplets[triplet_index];
+          const Mat3
+            RI = map_globalR.at(triplet.i),
+            RJ = map_globalR.at(triplet.j),
+            RK = map_globalR.at(triplet.k);
+          const Vec3
+            ti = vec_tis[0],
+            tj = vec_tis[1],
+            tk = vec_tis[2];
+
+          Mat3 Rij;
+          Vec3 tij;
+          RelativeCameraMotion(RI, ti, RJ, tj, &Rij, &tij);
+
+          Mat3 Rjk;
+          Vec3 tjk;
+          RelativeCameraMotion(RJ, tj, RK, tk, &Rjk, &tjk);
+
+          Mat3 Rik;
+          Vec3 tik;
+          RelativeCameraMotion(RI, ti, RK, tk, &Rik, &tik);
+
+          estimate->relative_motions.push_back(
+            {{triplet.i, triplet.j}, {Rij, tij}});
+          estimate->relative_motions.push_back(
+            {{triplet.j, triplet.k}, {Rjk, tjk}});
+          estimate->relative_motions.push_back(
+            {{triplet.i, triplet.k}, {Rik, tik}});
+        }
 
-          // If the triplet is already estimated by another thread; try the next one
-          if (m_mutexSet.count(Pair(triplet.i, triplet.j)) &&
-              m_mutexSet.count(Pair(triplet.i, triplet.k)) &&
-              m_mutexSet.count(Pair(triplet.j, triplet.k)))
-          {
-            continue;
+        // Add inliers as valid pairwise matches
+        std::sort(vec_inliers.begin(), vec_inliers.end());
+        tracks::STLMAPTracks::const_iterator it_tracks = pose_triplet_tracks.begin();
+        uint32_t track_index = 0;
+        for (const uint32_t & inlier_it : vec_inliers)
+        {
+          std::advance(it_tracks, inlier_it - track_index);
+          track_index = inlier_it;
+          const tracks::submapTrack & track = it_tracks->second;
+
+          // create pairwise matches from the inlier track
+          tracks::submapTrack::const_iterator iter_I = track.begin();
+          tracks::submapTrack::const_iterator iter_J = track.begin();
+          std::advance(iter_J, 1);
+          while (iter_J != track.end())
+          { // matches(pair(view_id(I), view_id(J))) <= IndMatch(feat_id(I), feat_id(J))
+            estimate->inlier_matches.emplace_back(
+              Pair(iter_I->first, iter_J->first),
+              matching::IndMatch(iter_I->second, iter_J->second));
+            ++iter_I;
+            ++iter_J;
           }
+        }
+        round_estimates[round_index] = std::move(estimate);
+      }
 
-          //--
-          // Try to estimate this triplet of translations
-          //--
-          double dPrecision = 4.0; // upper bound of the residual pixel reprojection error
-
-          std::vector<Vec3> vec_tis(3);
-          std::vector<uint32_t> vec_inliers;
-          openMVG::tracks::STLMAPTracks pose_triplet_tracks;
-
-          const std::string sOutDirectory = "./";
-
-          const bool bTriplet_estimation = Estimate_T_triplet(
-              sfm_data,
-              map_globalR,
-              features_provider,
-              matches_provider,
-              triplet,
-              vec_tis,
-              dPrecision,
-              vec_inliers,
-              pose_triplet_tracks,
-              sOutDirectory);
-
-          if (bTriplet_estimation)
-          {
-            // Since new translation edges have been computed, mark their corresponding edges as estimated
-            #ifdef OPENMVG_USE_OPENMP
-              #pragma omp critical
-            #endif
-            {
-              m_mutexSet.insert({triplet.i, triplet.j});
-              m_mutexSet.insert({triplet.j, triplet.k});
-              m_mutexSet.insert({triplet.i, triplet.k});
-            }
-
-            // Compute the triplet relative motions (IJ, JK, IK)
-            {
-              const Mat3
-                RI = map_globalR.at(triplet.i),
-                RJ = map_globalR.at(triplet.j),
-                RK = map_globalR.at(triplet.k);
-              const Vec3
-                ti = vec_tis[0],
-                tj = vec_tis[1],
-                tk = vec_tis[2];
-
-              Mat3 Rij;
-              Vec3 tij;
-              RelativeCameraMotion(RI, ti, RJ, tj, &Rij, &tij);
-
-              Mat3 Rjk;
-              Vec3 tjk;
-              RelativeCameraMotion(RJ, tj, RK, tk, &Rjk, &tjk);
-
-              Mat3 Rik;
-              Vec3 tik;
-              RelativeCameraMotion(RI, ti, RK, tk, &Rik, &tik);
-
-              #ifdef OPENMVG_USE_OPENMP
-                const int thread_id = omp_get_thread_num();
-              #else
-                const int thread_id = 0;
-              #endif
-
-              RelativeInfo_Vec triplet_relative_motion;
-              triplet_relative_motion.push_back(
-                {{triplet.i, triplet.j}, {Rij, tij}});
-              triplet_relative_motion.push_back(
-                {{triplet.j, triplet.k}, {Rjk, tjk}});
-              triplet_relative_motion.push_back(
-                {{triplet.i, triplet.k}, {Rik, tik}});
-
-              initial_estimates[thread_id].emplace_back(triplet_relative_motion);
-
-              #ifdef OPENMVG_USE_OPENMP
-                #pragma omp critical
-              #endif
-              {
-                // Add inliers as valid pairwise matches
-                for (const uint32_t & inlier_it : vec_inliers)
-                {
-                  tracks::STLMAPTracks::const_iterator it_tracks = pose_triplet_tracks.begin();
-                  std::advance(it_tracks, inlier_it);
-                  const tracks::submapTrack & track = it_tracks->second;
-
-                  // create pairwise matches from the inlier track
-                  tracks::submapTrack::const_iterator iter_I = track.begin();
-                  tracks::submapTrack::const_iterator iter_J = track.begin();
-                  std::advance(iter_J, 1);
-                  while (iter_J != track.end())
-                  { // matches(pair(view_id(I), view_id(J))) <= IndMatch(feat_id(I), feat_id(J))
-                    newpairMatches[{iter_I->first, iter_J->first}]
-                     .emplace_back(iter_I->second, iter_J->second);
-                    ++iter_I;
-                    ++iter_J;
-                  }
-                }
-              }
-            }
-            // Since a relative translation have been found for the edge: vec_edges[k],
-            //  we break and start to estimate the translations for some other edges.
-            break;
-          }
+      // Collect the round estimates (in the round order)
+      for (auto & estimate : round_estimates)
+      {
+        if (!estimate)
+          continue;
+        vec_triplet_relative_motion.emplace_back(std::move(estimate->relative_motions));
+        for (const auto & inlier_match : estimate->inlier_matches)
+        {
+          newpairMatches[inlier_match.first].push_back(inlier_match.second);
         }
       }
     }
-    // Merge thread(s) estimates
-    for (auto & vec : initial_estimates)
-    {
-      vec_triplet_relative_motion.insert( vec_triplet_relative_motion.end(),
-        std::make_move_iterator(vec.begin()), std::make_move_iterator(vec.end()));
-    }
+    my_progress_bar += pending_edge_count;
+    std::cout
+      << "-- #Covered edges: " << scheduler.CoveredEdgeCount()
+      << " / " << scheduler.EdgeCount() << std::endl;
   }
 
   const double timeLP_triplet = timerLP_triplet.elapsed();
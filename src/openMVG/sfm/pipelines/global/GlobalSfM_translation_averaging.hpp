@@ -41,20 +41,26 @@ class GlobalSfM_Translation_AveragingSolver
 
 public:
 
+  /// Compute the global translations of the poses.
+  /// Optional initial camera centers (i.e. from a previous
+  ///  reconstruction of a subset of the scene) are used to initialize the
+  ///  L2_DISTANCE_CHORDAL and SOFTL1 solvers (L1 is always solved from scratch).
   bool Run(
     ETranslationAveragingMethod eTranslationAveragingMethod,
     openMVG::sfm::SfM_Data & sfm_data,
     const openMVG::sfm::Features_Provider * features_provider,
     const openMVG::sfm::Matches_Provider * matches_provider,
     const Hash_Map<IndexT, Mat3> & map_globalR,
-    matching::PairWiseMatches & tripletWise_matches
+    matching::PairWiseMatches & tripletWise_matches,
+    const Hash_Map<IndexT, Vec3> * initial_centers = nullptr
   );
 
 private:
   bool Translation_averaging(
     ETranslationAveragingMethod eTranslationAveragingMethod,
     sfm::SfM_Data & sfm_data,
-    const Hash_Map<IndexT, Mat3> & map_globalR);
+    const Hash_Map<IndexT, Mat3> & map_globalR,
+    const Hash_Map<IndexT, Vec3> * initial_centers);
 
   void Compute_translations(
     const sfm::SfM_Data & sfm_data,
@@ -18,14 +18,22 @@
 //   - the desired number of poses are found.
 //-----------------
 
+#include "openMVG/graph/triplet_finder.hpp"
+#include "openMVG/sfm/pipelines/global/triplet_edge_coverage_scheduler.hpp"
 #include "openMVG/sfm/pipelines/pipelines_test.hpp"
 #include "openMVG/sfm/sfm.hpp"
 
 #include "testing/testing.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <set>
+#include <string>
 
 using namespace openMVG;
 using namespace openMVG::cameras;
@@ -242,6 +250,301 @@ TEST(GLOBAL_SFM, RotationAveragingL2_TranslationAveragingSoftL1) {
   EXPECT_TRUE( IsTracksOneCC(sfmEngine.Get_SfM_Data()));
 }
 
+// Largest angle (degree) between the relative rotations of two sets of
+// global rotations (invariant to the gauge freedom)
+double MaxRelativeRotationError
+(
+  const Hash_Map<IndexT, Mat3> & map_R0,
+  const Hash_Map<IndexT, Mat3> & map_R1
+)
+{
+  double max_error = 0.0;
+  for (const auto & it_i : map_R0)
+  {
+    for (const auto & it_j : map_R0)
+    {
+      if (map_R1.count(it_i.first) == 0 || map_R1.count(it_j.first) == 0)
+        return std::numeric_limits<double>::max();
+      const Mat3 R0_ij = it_j.second * it_i.second.transpose();
+      const Mat3 R1_ij = map_R1.at(it_j.first) * map_R1.at(it_i.first).transpose();
+      max_error = std::max(max_error, R2D(getRotationMagnitude(R0_ij * R1_ij.transpose())));
+    }
+  }
+  return max_error;
+}
+
+// Noisy relative rotations of all the pose pairs of a synthetic scene
+rotation_averaging::RelativeRotations NoisyRelativeRotations
+(
+  const NViewDataSet & d
+)
+{
+  std::mt19937 random_generator(std::mt19937::default_seed);
+  std::normal_distribution<double> distribution(0.0, D2R(0.5));
+  rotation_averaging::RelativeRotations relative_rotations;
+  for (IndexT i = 0; i < d._R.size(); ++i)
+  {
+    for (IndexT j = i + 1; j < d._R.size(); ++j)
+    {
+      const Vec3 noise(
+        distribution(random_generator),
+        distribution(random_generator),
+        distribution(random_generator));
+      const Mat3 R_noise = Eigen::AngleAxisd(noise.norm(), noise.normalized()).toRotationMatrix();
+      relative_rotations.emplace_back(i, j, R_noise * d._R[j] * d._R[i].transpose());
+    }
+  }
+  return relative_rotations;
+}
+
+TEST(GLOBAL_SFM, RotationAveraging_InitialGuess) {
+
+  const int nviews = 6;
+  const int npoints = 8;
+  const nViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+  const rotation_averaging::RelativeRotations relative_rotations =
+    NoisyRelativeRotations(d);
+
+  for (const ERotationAveragingMethod method : {ROTATION_AVERAGING_L1, ROTATION_AVERAGING_L2})
+  {
+    GlobalSfM_Rotation_AveragingSolver rotation_averaging_solver;
+
+    // Full solve
+    Hash_Map<IndexT, Mat3> global_rotations;
+    EXPECT_TRUE(rotation_averaging_solver.Run(
+      method, TRIPLET_ROTATION_INFERENCE_NONE,
+      relative_rotations, global_rotations));
+    EXPECT_EQ(nviews, global_rotations.size());
+
+    // Initial guess from the poses of a previous reconstruction of a subset of
+    // the scene: the other rotations are chained, the same solution is found
+    {
+      Hash_Map<IndexT, Mat3> initial_rotations;
+      for (IndexT i = 0; i < 4; ++i)
+        initial_rotations[i] = d._R[i];
+      Hash_Map<IndexT, Mat3> global_rotations_initial_guess;
+      EXPECT_TRUE(rotation_averaging_solver.Run(
+        method, TRIPLET_ROTATION_INFERENCE_NONE,
+        relative_rotations, global_rotations_initial_guess, &initial_rotations));
+      EXPECT_EQ(nviews, global_rotations_initial_guess.size());
+      EXPECT_TRUE(MaxRelativeRotationError(global_rotations, global_rotations_initial_guess) < 0.1);
+      // The rotations are kept in the frame of the initial ones
+      for (IndexT i = 0; i < 4; ++i)
+      {
+        EXPECT_TRUE(R2D(getRotationMagnitude(
+          global_rotations_initial_guess.at(i) * d._R[i].transpose())) < 1.0);
+      }
+    }
+
+    // No initial pose can be reached (unknown pose ids): full solve fallback
+    {
+      Hash_Map<IndexT, Mat3> initial_rotations;
+      initial_rotations[nviews] = Mat3::Identity();
+      initial_rotations[nviews + 1] = Mat3::Identity();
+      Hash_Map<IndexT, Mat3> global_rotations_fallback;
+      EXPECT_TRUE(rotation_averaging_solver.Run(
+        method, TRIPLET_ROTATION_INFERENCE_NONE,
+        relative_rotations, global_rotations_fallback, &initial_rotations));
+      EXPECT_EQ(nviews, global_rotations_fallback.size());
+      EXPECT_TRUE(MaxRelativeRotationError(global_rotations, global_rotations_fallback) < 1e-4);
+    }
+  }
+}
+
+// Run the global SfM engine on a synthetic scene
+// (with optional initial poses, i.e. from a previous reconstruction)
+SfM_Data GlobalSfM
+(
+  const NViewDataSet & d,
+  const SfM_Data & sfm_data,
+  ETranslationAveragingMethod translation_method,
+  const SfM_Data * previous_sfm_data,
+  size_t & initial_pose_count
+)
+{
+  // Remove poses and structure
+  SfM_Data sfm_data_2 = sfm_data;
+  sfm_data_2.poses.clear();
+  sfm_data_2.structure.clear();
+
+  GlobalSfMReconstructionEngine_RelativeMotions sfmEngine(
+    sfm_data_2,
+    "./",
+    stlplus::create_filespec("./", "Reconstruction_Report.html"));
+
+  std::shared_ptr<Features_Provider> feats_provider =
+    std::make_shared<Synthetic_Features_Provider>();
+  std::normal_distribution<double> distribution(0.0,0.5);
+  dynamic_cast<Synthetic_Features_Provider*>(feats_provider.get())->load(d,distribution);
+
+  std::shared_ptr<Matches_Provider> matches_provider =
+    std::make_shared<Synthetic_Matches_Provider>();
+  dynamic_cast<Synthetic_Matches_Provider*>(matches_provider.get())->load(d);
+
+  sfmEngine.SetFeaturesProvider(feats_provider.get());
+  sfmEngine.SetMatchesProvider(matches_provider.get());
+  sfmEngine.Set_Intrinsics_Refinement_Type(cameras::Intrinsic_Parameter_Type::NONE);
+  sfmEngine.SetRotationAveragingMethod(ROTATION_AVERAGING_L2);
+  sfmEngine.SetTranslationAveragingMethod(translation_method);
+
+  initial_pose_count = previous_sfm_data ?
+    sfmEngine.SetInitialPoses(*previous_sfm_data) : 0;
+
+  if (!sfmEngine.Process())
+    return SfM_Data();
+  return sfmEngine.Get_SfM_Data();
+}
+
+// Largest difference between the pairwise camera center distances of two
+// scenes (normalized by the first distance: invariant to the gauge freedom)
+double MaxCenterDistanceError
+(
+  const SfM_Data & sfm_data0,
+  const SfM_Data & sfm_data1
+)
+{
+  const Poses & poses0 = sfm_data0.GetPoses(), & poses1 = sfm_data1.GetPoses();
+  if (poses0.size() < 2 || poses0.size() != poses1.size())
+    return std::numeric_limits<double>::max();
+  const IndexT first = poses0.begin()->first, second = std::next(poses0.begin())->first;
+  const double
+    scale0 = (poses0.at(first).center() - poses0.at(second).center()).norm(),
+    scale1 = (poses1.at(first).center() - poses1.at(second).center()).norm();
+  double max_error = 0.0;
+  for (const auto & it_i : poses0)
+  {
+    for (const auto & it_j : poses0)
+    {
+      const double
+        d0 = (it_i.second.center() - it_j.second.center()).norm() / scale0,
+        d1 = (poses1.at(it_i.first).center() - poses1.at(it_j.first).center()).norm() / scale1;
+      max_error = std::max(max_error, std::abs(d0 - d1));
+    }
+  }
+  return max_error;
+}
+
+TEST(GLOBAL_SFM, InitialPoses) {
+
+  const int nviews = 6;
+  const int npoints = 64;
+  const nViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  // Translate the input dataset to a SfM_Data scene
+  // (views are associated by image path to the previous reconstruction)
+  SfM_Data sfm_data = getInputScene(d, config, PINHOLE_CAMERA);
+  for (auto & view_it : sfm_data.views)
+    view_it.second->s_Img_path = std::to_string(view_it.first) + ".jpg";
+
+  for (const ETranslationAveragingMethod method :
+    {TRANSLATION_AVERAGING_SOFTL1, TRANSLATION_AVERAGING_L2_DISTANCE_CHORDAL})
+  {
+    size_t initial_pose_count = 0;
+    const SfM_Data sfm_data_cold =
+      GlobalSfM(d, sfm_data, method, nullptr, initial_pose_count);
+    EXPECT_EQ(nviews, sfm_data_cold.GetPoses().size());
+
+    // Previous reconstruction of a subset of the views (2 views were added since)
+    // (the views are deep copied, since they are shared by the SfM_Data copies)
+    SfM_Data previous_sfm_data = sfm_data_cold;
+    for (auto & view_it : previous_sfm_data.views)
+      view_it.second = std::make_shared<View>(*view_it.second);
+    for (IndexT i = 4; i < nviews; ++i)
+    {
+      previous_sfm_data.views.erase(i);
+      previous_sfm_data.poses.erase(i);
+    }
+    const SfM_Data sfm_data_initial_guess =
+      GlobalSfM(d, sfm_data, method, &previous_sfm_data, initial_pose_count);
+    EXPECT_EQ(4, initial_pose_count);
+    EXPECT_EQ(nviews, sfm_data_initial_guess.GetPoses().size());
+    EXPECT_EQ(npoints, sfm_data_initial_guess.GetLandmarks().size());
+    EXPECT_TRUE(RMSE(sfm_data_initial_guess) < 0.5);
+
+    // Same solution as the full solve
+    Hash_Map<IndexT, Mat3> rotations_cold, rotations_initial_guess;
+    for (const auto & pose_it : sfm_data_cold.GetPoses())
+      rotations_cold[pose_it.first] = pose_it.second.rotation();
+    for (const auto & pose_it : sfm_data_initial_guess.GetPoses())
+      rotations_initial_guess[pose_it.first] = pose_it.second.rotation();
+    EXPECT_TRUE(MaxRelativeRotationError(rotations_cold, rotations_initial_guess) < 0.1);
+    EXPECT_TRUE(MaxCenterDistanceError(sfm_data_cold, sfm_data_initial_guess) < 0.01);
+
+    // The previous views are unknown (no image path match): full solve fallback
+    for (auto & view_it : previous_sfm_data.views)
+      view_it.second->s_Img_path = "unknown_" + view_it.second->s_Img_path;
+    const SfM_Data sfm_data_fallback =
+      GlobalSfM(d, sfm_data, method, &previous_sfm_data, initial_pose_count);
+    EXPECT_EQ(0, initial_pose_count);
+    EXPECT_EQ(nviews, sfm_data_fallback.GetPoses().size());
+    EXPECT_TRUE(RMSE(sfm_data_fallback) < 0.5);
+  }
+}
+
+TEST(GLOBAL_SFM, TripletEdgeCoverageScheduler) {
+
+  // Triplets of a complete graph
+  const IndexT nNodes = 12;
+  Pair_Set pairs;
+  for (IndexT i = 0; i < nNodes; ++i)
+    for (IndexT j = i + 1; j < nNodes; ++j)
+      pairs.insert({i, j});
+  const std::vector<graph::Triplet> triplets = graph::TripletListing(pairs);
+  std::vector<uint32_t> priorities(triplets.size());
+  for (size_t t = 0; t < triplets.size(); ++t)
+    priorities[t] = (triplets[t].i * 7 + triplets[t].j * 3 + triplets[t].k) % 5;
+
+  // Simulated estimations: some triplets fail, the ones with the node 0 always
+  const auto estimation_succeeds = [&](uint32_t t) {
+    return triplets[t].i != 0 && (triplets[t].i + triplets[t].j + triplets[t].k) % 4 != 0;
+  };
+
+  // Run the scheduler, the round triplets are estimated in a given order
+  bool edge_disjoint_rounds = true;
+  size_t covered_edge_count = 0;
+  const auto run = [&](bool reverse_order) -> std::set<uint32_t> {
+    TripletEdgeCoverageScheduler scheduler(triplets, priorities);
+    std::set<uint32_t> estimated;
+    while (!scheduler.NextRound().empty())
+    {
+      std::vector<uint32_t> round = scheduler.Round();
+      // The triplets of a round are edge-disjoint
+      Pair_Set round_edges;
+      for (const uint32_t t : round)
+      {
+        const graph::Triplet & triplet = triplets[t];
+        edge_disjoint_rounds &= round_edges.insert({triplet.i, triplet.j}).second;
+        edge_disjoint_rounds &= round_edges.insert({triplet.i, triplet.k}).second;
+        edge_disjoint_rounds &= round_edges.insert({triplet.j, triplet.k}).second;
+      }
+      if (reverse_order)
+        std::reverse(round.begin(), round.end());
+      for (const uint32_t t : round)
+      {
+        if (estimation_succeeds(t))
+        {
+          scheduler.MarkEstimated(t);
+          estimated.insert(t);
+        }
+      }
+    }
+    covered_edge_count = scheduler.CoveredEdgeCount();
+    return estimated;
+  };
+
+  const std::set<uint32_t> estimated = run(false);
+  EXPECT_TRUE(edge_disjoint_rounds);
+  // Only the edges of the node 0 cannot be covered
+  EXPECT_EQ(pairs.size() - (nNodes - 1), covered_edge_count);
+  // Edge coverage: less triplets than edges are required
+  EXPECT_TRUE(!estimated.empty());
+  EXPECT_TRUE(estimated.size() < pairs.size());
+  // The estimated triplets do not depend on the estimation order
+  EXPECT_TRUE(estimated == run(true));
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
@@ -107,6 +107,44 @@ void GlobalSfMReconstructionEngine_RelativeMotions::SetTranslationAveragingMetho
   eTranslation_averaging_method_ = eTranslationAveragingMethod;
 }
 
+size_t GlobalSfMReconstructionEngine_RelativeMotions::SetInitialPoses
+(
+  const SfM_Data & previous_sfm_data
+)
+{
+  initial_poses_.clear();
+
+  // Associate the views by image path
+  Hash_Map<std::string, const View*> current_views;
+  for (const auto & view_it : sfm_data_.GetViews())
+  {
+    current_views[view_it.second->s_Img_path] = view_it.second.get();
+  }
+
+  for (const auto & view_it : previous_sfm_data.GetViews())
+  {
+    const View * previous_view = view_it.second.get();
+    if (previous_view->id_pose == UndefinedIndexT
+        || previous_sfm_data.GetPoses().count(previous_view->id_pose) == 0)
+      continue;
+    const auto current_it = current_views.find(previous_view->s_Img_path);
+    if (current_it == current_views.end()
+        || current_it->second->id_pose == UndefinedIndexT)
+      continue;
+    initial_poses_[current_it->second->id_pose] =
+      previous_sfm_data.GetPoseOrDie(previous_view);
+  }
+  return initial_poses_.size();
+}
+
+void GlobalSfMReconstructionEngine_RelativeMotions::SetRelativePoseCacheFilename
+(
+  const std::string & filename
+)
+{
+  relative_pose_cache_filename_ = filename;
+}
+
 bool GlobalSfMReconstructionEngine_RelativeMotions::Process() {
 
   //-------------------
@@ -201,11 +239,18 @@ bool GlobalSfMReconstructionEngine_RelativeMotions::Compute_Global_Rotations
     TRIPLET_ROTATION_INFERENCE_COMPOSITION_ERROR;
     //TRIPLET_ROTATION_INFERENCE_NONE;
 
+  // Initial guess of the global rotations (if any)
+  Hash_Map<IndexT, Mat3> initial_rotations;
+  for (const auto & pose_it : initial_poses_)
+  {
+    initial_rotations[pose_it.first] = pose_it.second.rotation();
+  }
+
   system::Timer t;
   GlobalSfM_Rotation_AveragingSolver rotation_averaging_solver;
   const bool b_rotation_averaging = rotation_averaging_solver.Run(
     eRotation_averaging_method_, eRelativeRotationInferenceMethod,
-    relatives_R, global_rotations);
+    relatives_R, global_rotations, &initial_rotations);
 
   std::cout
     << "Found #global_rotations: " << global_rotations.size() << "\n"
@@ -263,7 +308,7 @@ bool GlobalSfMReconstructionEngine_RelativeMotions::Compute_Global_Rotations
           set_pose_ids.insert(pose_id);
         }
         const std::string sGraph_name = "global_relative_rotation_pose_graph_final";
-        graph::indexedGraph putativeGraph(set_pose_ids, rotation_averaging_solver.GetUsedPairs());
+        graph::CsrGraph putativeGraph(set_pose_ids, rotation_averaging_solver.GetUsedPairs());
         graph::exportToGraphvizData(
           stlplus::create_filespec(sOut_directory_, sGraph_name),
           putativeGraph);
@@ -290,6 +335,13 @@ bool GlobalSfMReconstructionEngine_RelativeMotions::Compute_Global_Translations
   matching::PairWiseMatches & tripletWise_matches
 )
 {
+  // Initial guess of the camera centers (if any)
+  Hash_Map<IndexT, Vec3> initial_centers;
+  for (const auto & pose_it : initial_poses_)
+  {
+    initial_centers[pose_it.first] = pose_it.second.center();
+  }
+
   // Translation averaging (compute translations & update them to a global common coordinates system)
   GlobalSfM_Translation_AveragingSolver translation_averaging_solver;
   const bool bTranslationAveraging = translation_averaging_solver.Run(
@@ -298,7 +350,8 @@ bool GlobalSfMReconstructionEngine_RelativeMotions::Compute_Global_Translations
     features_provider_,
     matches_provider_,
     global_rotations,
-    tripletWise_matches);
+    tripletWise_matches,
+    &initial_centers);
 
   if (!sLogging_file_.empty())
   {
@@ -536,6 +589,7 @@ void GlobalSfMReconstructionEngine_RelativeMotions::Compute_Relative_Rotations
   const Relative_Pose_Engine::Relative_Pair_Poses relative_poses = [&]
   {
     Relative_Pose_Engine relative_pose_engine;
+    relative_pose_engine.Set_Cache_Filename(relative_pose_cache_filename_);
     if (!relative_pose_engine.Process(sfm_data_,
         matches_provider_,
         features_provider_))
@@ -562,7 +616,7 @@ void GlobalSfMReconstructionEngine_RelativeMotions::Compute_Relative_Rotations
       std::set<IndexT> set_ViewIds;
       std::transform(sfm_data_.GetViews().cbegin(), sfm_data_.GetViews().cend(),
         std::inserter(set_ViewIds, set_ViewIds.begin()), stl::RetrieveKey());
-      graph::indexedGraph putativeGraph(set_ViewIds, getPairs(matches_provider_->pairWise_matches_));
+      graph::CsrGraph putativeGraph(set_ViewIds, matches_provider_->pairWise_matches_);
       graph::exportToGraphvizData(
         stlplus::create_filespec(sOut_directory_, "global_relative_rotation_view_graph"),
         putativeGraph);
@@ -580,7 +634,7 @@ void GlobalSfMReconstructionEngine_RelativeMotions::Compute_Relative_Rotations
         set_pose_ids.insert(relative_R.j);
       }
       const std::string sGraph_name = "global_relative_rotation_pose_graph";
-      graph::indexedGraph putativeGraph(set_pose_ids, relative_pose_pairs);
+      graph::CsrGraph putativeGraph(set_pose_ids, relative_pose_pairs);
       graph::exportToGraphvizData(
         stlplus::create_filespec(sOut_directory_, sGraph_name),
         putativeGraph);
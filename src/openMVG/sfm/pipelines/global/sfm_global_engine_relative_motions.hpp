@@ -12,6 +12,7 @@
 #include <memory>
 #include <string>
 
+#include "openMVG/geometry/pose3.hpp"
 #include "openMVG/sfm/pipelines/global/GlobalSfM_rotation_averaging.hpp"
 #include "openMVG/sfm/pipelines/global/GlobalSfM_translation_averaging.hpp"
 #include "openMVG/sfm/pipelines/sfm_engine.hpp"
@@ -44,6 +45,19 @@ public:
   void SetRotationAveragingMethod(ERotationAveragingMethod eRotationAveragingMethod);
   void SetTranslationAveragingMethod(ETranslationAveragingMethod eTranslation_averaging_method_);
 
+  /// Use the poses of a previous reconstruction (i.e. of a subset of the
+  ///  current views) as initial guess of the motion averaging steps.
+  /// Views are associated by image path.
+  /// Only the initialization of the solvers is changed: the relative motions
+  ///  are still estimated for every pair (use a relative pose cache to reuse
+  ///  the ones of the pairs that were already estimated).
+  /// Return the number of poses that can be used as initial guess.
+  size_t SetInitialPoses(const SfM_Data & previous_sfm_data);
+
+  /// Use a persistent relative pose cache file (see Relative_Pose_Cache)
+  ///  in order to reuse the relative poses computed by a previous run.
+  void SetRelativePoseCacheFilename(const std::string & filename);
+
   bool Process() override;
 
 protected:
@@ -89,6 +103,12 @@ private:
   ERotationAveragingMethod eRotation_averaging_method_;
   ETranslationAveragingMethod eTranslation_averaging_method_;
 
+  // Initial guess of the poses (indexed by the current pose ids)
+  Hash_Map<IndexT, geometry::Pose3> initial_poses_;
+
+  // Relative pose cache filename (optional)
+  std::string relative_pose_cache_filename_;
+
   //-- Data provider
   Features_Provider  * features_provider_;
   Matches_Provider  * matches_provider_;
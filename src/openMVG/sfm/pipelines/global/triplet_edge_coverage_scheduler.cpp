@@ -0,0 +1,159 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/sfm/pipelines/global/triplet_edge_coverage_scheduler.hpp"
+
+#include <algorithm>
+#include <bitset>
+#include <numeric>
+
+namespace openMVG {
+namespace sfm {
+
+TripletEdgeCoverageScheduler::TripletEdgeCoverageScheduler
+(
+  const std::vector<graph::Triplet> & triplets,
+  const std::vector<uint32_t> & priorities
+):
+  round_count_(0)
+{
+  const auto sorted_edge = [](IndexT a, IndexT b)
+  {
+    return a < b ? Pair(a, b) : Pair(b, a);
+  };
+
+  // List the edges and give them a dense id
+  edges_.reserve(triplets.size() * 3);
+  for (const graph::Triplet & triplet : triplets)
+  {
+    edges_.push_back(sorted_edge(triplet.i, triplet.j));
+    edges_.push_back(sorted_edge(triplet.i, triplet.k));
+    edges_.push_back(sorted_edge(triplet.j, triplet.k));
+  }
+  std::sort(edges_.begin(), edges_.end());
+  edges_.erase(std::unique(edges_.begin(), edges_.end()), edges_.end());
+  edges_.shrink_to_fit();
+
+  const auto edge_id = [&](IndexT a, IndexT b)
+  {
+    return static_cast<uint32_t>(
+      std::lower_bound(edges_.cbegin(), edges_.cend(), sorted_edge(a, b))
+      - edges_.cbegin());
+  };
+
+  // Count the triplets per edge
+  triplet_edges_.resize(triplets.size());
+  candidate_offsets_.assign(edges_.size() + 1, 0);
+  for (size_t t = 0; t < triplets.size(); ++t)
+  {
+    const graph::Triplet & triplet = triplets[t];
+    triplet_edges_[t] = {{
+      edge_id(triplet.i, triplet.j),
+      edge_id(triplet.i, triplet.k),
+      edge_id(triplet.j, triplet.k)}};
+    for (const uint32_t edge : triplet_edges_[t])
+      ++candidate_offsets_[edge + 1];
+  }
+  std::partial_sum(candidate_offsets_.begin(), candidate_offsets_.end(),
+                   candidate_offsets_.begin());
+
+  // Fill the candidates (ascending triplet index), then sort them by priority
+  candidates_.resize(candidate_offsets_.back());
+  candidate_cursors_.assign(candidate_offsets_.cbegin(), candidate_offsets_.cend() - 1);
+  for (size_t t = 0; t < triplets.size(); ++t)
+  {
+    for (const uint32_t edge : triplet_edges_[t])
+      candidates_[candidate_cursors_[edge]++] = t;
+  }
+  for (size_t e = 0; e < edges_.size(); ++e)
+  {
+    std::stable_sort(
+      candidates_.begin() + candidate_offsets_[e],
+      candidates_.begin() + candidate_offsets_[e + 1],
+      [&](uint32_t a, uint32_t b) { return priorities[a] > priorities[b]; });
+  }
+  candidate_cursors_.assign(candidate_offsets_.cbegin(), candidate_offsets_.cend() - 1);
+
+  tried_triplets_.assign(triplets.size(), false);
+  covered_edges_ = std::vector<std::atomic<uint64_t>>((edges_.size() + 63) / 64);
+  for (auto & word : covered_edges_)
+    word.store(0);
+  edge_rounds_.assign(edges_.size(), 0);
+  pending_edges_.resize(edges_.size());
+  std::iota(pending_edges_.begin(), pending_edges_.end(), 0);
+}
+
+bool TripletEdgeCoverageScheduler::IsCovered(uint32_t edge_id) const
+{
+  return (covered_edges_[edge_id / 64].load(std::memory_order_relaxed)
+          >> (edge_id % 64)) & 1;
+}
+
+const std::vector<uint32_t> & TripletEdgeCoverageScheduler::NextRound()
+{
+  round_.clear();
+  ++round_count_;
+
+  size_t pending_count = 0;
+  for (const uint32_t edge : pending_edges_)
+  {
+    if (IsCovered(edge))
+      continue;
+
+    // Skip the candidates that are tried or that cannot cover a new edge
+    uint32_t & cursor = candidate_cursors_[edge];
+    const uint32_t end = candidate_offsets_[edge + 1];
+    for (; cursor < end; ++cursor)
+    {
+      const uint32_t triplet_id = candidates_[cursor];
+      const std::array<uint32_t, 3> & edges = triplet_edges_[triplet_id];
+      if (!tried_triplets_[triplet_id] &&
+          !(IsCovered(edges[0]) && IsCovered(edges[1]) && IsCovered(edges[2])))
+        break;
+    }
+    if (cursor == end)
+      continue; // This edge cannot be covered
+
+    pending_edges_[pending_count++] = edge;
+
+    // Schedule the candidate iff it is edge-disjoint from the round triplets
+    const uint32_t triplet_id = candidates_[cursor];
+    const std::array<uint32_t, 3> & edges = triplet_edges_[triplet_id];
+    if (edge_rounds_[edges[0]] != round_count_ &&
+        edge_rounds_[edges[1]] != round_count_ &&
+        edge_rounds_[edges[2]] != round_count_)
+    {
+      for (const uint32_t triplet_edge : edges)
+        edge_rounds_[triplet_edge] = round_count_;
+      tried_triplets_[triplet_id] = true;
+      round_.push_back(triplet_id);
+    }
+  }
+  pending_edges_.resize(pending_count);
+  return round_;
+}
+
+void TripletEdgeCoverageScheduler::MarkEstimated(uint32_t triplet_id)
+{
+  for (const uint32_t edge : triplet_edges_[triplet_id])
+  {
+    covered_edges_[edge / 64].fetch_or(uint64_t(1) << (edge % 64),
+                                       std::memory_order_relaxed);
+  }
+}
+
+std::size_t TripletEdgeCoverageScheduler::CoveredEdgeCount() const
+{
+  std::size_t count = 0;
+  for (const auto & word : covered_edges_)
+    count += std::bitset<64>(word.load(std::memory_order_relaxed)).count();
+  return count;
+}
+
+} // namespace sfm
+} // namespace openMVG
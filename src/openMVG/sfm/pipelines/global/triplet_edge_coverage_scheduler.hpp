@@ -0,0 +1,105 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_SFM_PIPELINES_GLOBAL_TRIPLET_EDGE_COVERAGE_SCHEDULER_HPP
+#define OPENMVG_SFM_PIPELINES_GLOBAL_TRIPLET_EDGE_COVERAGE_SCHEDULER_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "openMVG/graph/triplet_finder.hpp"
+#include "openMVG/types.hpp"
+
+namespace openMVG {
+namespace sfm {
+
+/**
+* @brief Deterministic scheduling of the triplet estimations used to cover the
+*  edges of a graph (an estimated triplet covers its three edges).
+*
+* The triplets are estimated by rounds:
+*  - every edge that is not covered yet proposes its best triplet candidate
+*    (highest priority first) that is not tried yet,
+*  - the proposals are greedily accepted in edge order if they share no edge
+*    with an already accepted triplet of the round (edge-disjoint coloring).
+* The triplets of a round can then be estimated concurrently: the covered edges
+*  are marked in an atomic bitmap and a round only depends on the outcome of
+*  the previous ones. The set of estimated triplets is thus independent of the
+*  thread count and of the thread timings.
+*
+* Usage:
+*  while (!scheduler.NextRound().empty())
+*    for each triplet_id of scheduler.Round() (in parallel)
+*      if (estimation succeeds) scheduler.MarkEstimated(triplet_id);
+*/
+class TripletEdgeCoverageScheduler
+{
+public:
+  /// @param[in] triplets   The triplets (their node ids must be distinct)
+  /// @param[in] priorities The priority of the triplets (i.e. their
+  ///   supporting track count), triplets with the highest priorities are
+  ///   tried first. Ties are broken by triplet index.
+  TripletEdgeCoverageScheduler
+  (
+    const std::vector<graph::Triplet> & triplets,
+    const std::vector<uint32_t> & priorities
+  );
+
+  /// Compute the next round of triplets to estimate.
+  /// Return an empty list once every edge is covered or has no more
+  ///  candidate triplets.
+  const std::vector<uint32_t> & NextRound();
+
+  /// The triplet indexes of the current round
+  const std::vector<uint32_t> & Round() const { return round_; }
+
+  /// Mark the edges of a triplet of the current round as covered.
+  /// Thread safe.
+  void MarkEstimated(uint32_t triplet_id);
+
+  /// Number of (distinct) edges used by the triplets
+  std::size_t EdgeCount() const { return edges_.size(); }
+
+  /// Number of edges that are neither covered nor without candidate triplet
+  std::size_t PendingEdgeCount() const { return pending_edges_.size(); }
+
+  /// Number of edges that are covered by an estimated triplet
+  std::size_t CoveredEdgeCount() const;
+
+private:
+  bool IsCovered(uint32_t edge_id) const;
+
+  /// The edges sorted as (min, max) node ids, their index is their dense id
+  std::vector<Pair> edges_;
+  /// The dense edge ids of the triplets edges: (i,j), (i,k), (j,k)
+  std::vector<std::array<uint32_t, 3>> triplet_edges_;
+  /// The candidate triplets of each edge (sorted by descending priority),
+  ///  stored contiguously: the edge e ones are in
+  ///  [candidate_offsets_[e], candidate_offsets_[e+1])
+  std::vector<uint32_t> candidate_offsets_;
+  std::vector<uint32_t> candidates_;
+  /// Position of the next candidate to propose for every edge
+  std::vector<uint32_t> candidate_cursors_;
+  /// Already scheduled triplets (estimated or not)
+  std::vector<bool> tried_triplets_;
+  /// Covered edges bitmap
+  std::vector<std::atomic<uint64_t>> covered_edges_;
+  /// Last round that used an edge (edge-disjoint rounds)
+  std::vector<uint32_t> edge_rounds_;
+  /// Edges that still need to be covered, in ascending order
+  std::vector<uint32_t> pending_edges_;
+  std::vector<uint32_t> round_;
+  uint32_t round_count_;
+};
+
+} // namespace sfm
+} // namespace openMVG
+
+#endif // OPENMVG_SFM_PIPELINES_GLOBAL_TRIPLET_EDGE_COVERAGE_SCHEDULER_HPP
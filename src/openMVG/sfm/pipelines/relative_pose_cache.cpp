@@ -0,0 +1,159 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+// The <cereal/archives> headers are special and must be included first.
+#include <cereal/archives/portable_binary.hpp>
+
+#include "openMVG/sfm/pipelines/relative_pose_cache.hpp"
+
+#include "openMVG/cameras/Camera_Intrinsics.hpp"
+#include "openMVG/features/feature.hpp"
+#include "openMVG/geometry/pose3_io.hpp"
+#include "openMVG/stl/hash.hpp"
+
+#include <fstream>
+#include <iostream>
+
+#include <cereal/types/map.hpp>
+#include <cereal/types/string.hpp>
+#include <cereal/types/unordered_map.hpp>
+#include <cereal/types/utility.hpp>
+#include <cereal/types/vector.hpp>
+
+namespace openMVG {
+namespace sfm {
+
+// Identify the file content and its layout
+static const std::string kRelativePoseCacheHeader = "openMVG_relative_pose_cache";
+static const int kRelativePoseCacheVersion = 2;
+
+template <class Archive>
+void Relative_Pose_Cache::Entry::serialize( Archive & ar )
+{
+  ar(hash, relative_pose, inliers, quality);
+}
+
+bool Relative_Pose_Cache::Load(const std::string & filename)
+{
+  std::ifstream stream(filename.c_str(), std::ios::in | std::ios::binary);
+  if (!stream.is_open())
+    return false;
+
+  Hash_Map<Pair, Entry> entries;
+  try
+  {
+    cereal::PortableBinaryInputArchive archive(stream);
+    std::string header;
+    int version = 0;
+    archive(header, version);
+    if (header != kRelativePoseCacheHeader || version != kRelativePoseCacheVersion)
+    {
+      std::cerr << "Incompatible relative pose cache file: " << filename << std::endl;
+      return false;
+    }
+    archive(entries);
+  }
+  catch (const std::exception & e)
+  {
+    // cereal::Exception, or a bad allocation from a corrupted length
+    std::cerr << e.what() << std::endl;
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_ = std::move(entries);
+  modified_ = false;
+  return true;
+}
+
+bool Relative_Pose_Cache::Save(const std::string & filename) const
+{
+  std::ofstream stream(filename.c_str(), std::ios::out | std::ios::binary);
+  if (!stream.is_open())
+    return false;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  {
+    cereal::PortableBinaryOutputArchive archive(stream);
+    archive(kRelativePoseCacheHeader, kRelativePoseCacheVersion, entries_);
+  }
+  const bool bOk = stream.good();
+  stream.close();
+  return bOk;
+}
+
+bool Relative_Pose_Cache::Get
+(
+  const Pair & view_pair,
+  uint64_t hash,
+  Entry & entry
+) const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto it = entries_.find(view_pair);
+  if (it == entries_.end() || it->second.hash != hash)
+    return false;
+  entry = it->second;
+  return true;
+}
+
+void Relative_Pose_Cache::Set
+(
+  const Pair & view_pair,
+  const Entry & entry
+)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_[view_pair] = entry;
+  modified_ = true;
+}
+
+std::size_t Relative_Pose_Cache::Size() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+bool Relative_Pose_Cache::Modified() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return modified_;
+}
+
+uint64_t Relative_Pose_Cache::Hash
+(
+  const cameras::IntrinsicBase * cam_I,
+  const cameras::IntrinsicBase * cam_J,
+  const matching::IndMatches & putative_matches,
+  const features::PointFeatures & features_I,
+  const features::PointFeatures & features_J
+)
+{
+  std::size_t seed = 0;
+  stl::hash_combine(seed, cam_I->hashValue());
+  stl::hash_combine(seed, cam_J->hashValue());
+  stl::hash_combine(seed, putative_matches.size());
+  for (const auto & match : putative_matches)
+  {
+    stl::hash_combine(seed, match.i_);
+    stl::hash_combine(seed, match.j_);
+    if (match.i_ < features_I.size() && match.j_ < features_J.size())
+    {
+      const features::PointFeature & feature_I = features_I[match.i_];
+      const features::PointFeature & feature_J = features_J[match.j_];
+      stl::hash_combine(seed, feature_I.x());
+      stl::hash_combine(seed, feature_I.y());
+      stl::hash_combine(seed, feature_J.x());
+      stl::hash_combine(seed, feature_J.y());
+    }
+  }
+  return static_cast<uint64_t>(seed);
+}
+
+} // namespace sfm
+} // namespace openMVG
@@ -0,0 +1,91 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_SFM_RELATIVE_POSE_CACHE_HPP
+#define OPENMVG_SFM_RELATIVE_POSE_CACHE_HPP
+
+#include "openMVG/features/feature_container.hpp"
+#include "openMVG/geometry/pose3.hpp"
+#include "openMVG/matching/indMatch.hpp"
+#include "openMVG/types.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace openMVG { namespace cameras { struct IntrinsicBase; } }
+
+namespace openMVG {
+namespace sfm {
+
+/// A persistent (on disk) store of relative pose estimates.
+/// An entry is identified by its view pair and by a hash of the data used to
+///  compute it (the camera intrinsics, the putative matches and the matched
+///  feature positions), so an entry computed from a different calibration,
+///  feature detection or matching is never reused.
+/// Get & Set are thread safe.
+class Relative_Pose_Cache
+{
+public:
+  struct Entry
+  {
+    /// Hash of the data used to compute the relative pose
+    uint64_t hash = 0;
+    /// Relative pose of the second view in the first view coordinate frame
+    geometry::Pose3 relative_pose;
+    /// Indexes of the inlier putative matches
+    /// (empty if no relative pose can be estimated for this pair)
+    std::vector<uint32_t> inliers;
+    /// Quality of the estimate (AContrario residual upper bound, in pixels)
+    double quality = 0.0;
+
+    template <class Archive>
+    void serialize( Archive & ar );
+  };
+
+  /// Load the entries from a file (.bin), return false if the file cannot be read
+  bool Load(const std::string & filename);
+
+  /// Save the entries to a file (.bin)
+  bool Save(const std::string & filename) const;
+
+  /// Retrieve the entry of a view pair, if its hash is matching
+  bool Get(const Pair & view_pair, uint64_t hash, Entry & entry) const;
+
+  /// Add or replace the entry of a view pair
+  void Set(const Pair & view_pair, const Entry & entry);
+
+  /// Number of stored entries
+  std::size_t Size() const;
+
+  /// Return true if some entries have been set since the last Load
+  bool Modified() const;
+
+  /// Hash of the data used to compute the relative pose of a view pair
+  /// (the positions of the matched features are hashed, so a new feature
+  ///  detection with the same match indexes is detected)
+  static uint64_t Hash
+  (
+    const cameras::IntrinsicBase * cam_I,
+    const cameras::IntrinsicBase * cam_J,
+    const matching::IndMatches & putative_matches,
+    const features::PointFeatures & features_I,
+    const features::PointFeatures & features_J
+  );
+
+private:
+  mutable std::mutex mutex_;
+  Hash_Map<Pair, Entry> entries_;
+  bool modified_ = false;
+};
+
+} // namespace sfm
+} // namespace openMVG
+
+#endif // OPENMVG_SFM_RELATIVE_POSE_CACHE_HPP
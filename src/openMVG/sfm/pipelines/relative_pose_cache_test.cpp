@@ -0,0 +1,160 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/cameras/Camera_Pinhole.hpp"
+#include "openMVG/features/feature.hpp"
+#include "openMVG/sfm/pipelines/relative_pose_cache.hpp"
+
+#include "testing/testing.h"
+#include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
+
+#include <fstream>
+#include <string>
+
+using namespace openMVG;
+using namespace openMVG::cameras;
+using namespace openMVG::features;
+using namespace openMVG::geometry;
+using namespace openMVG::matching;
+using namespace openMVG::sfm;
+
+// Features on a regular grid
+PointFeatures GridFeatures(int count)
+{
+  PointFeatures features;
+  for (int i = 0; i < count; ++i)
+    features.emplace_back(10.f * (i % 8), 10.f * (i / 8));
+  return features;
+}
+
+TEST(RELATIVE_POSE_CACHE, Hash) {
+
+  const Pinhole_Intrinsic cam_I(640, 480, 500, 320, 240);
+  const Pinhole_Intrinsic cam_J(640, 480, 600, 320, 240);
+  const PointFeatures features_I = GridFeatures(32), features_J = GridFeatures(32);
+  const IndMatches matches = {{0, 1}, {2, 3}, {4, 5}, {6, 7}};
+
+  const uint64_t hash =
+    Relative_Pose_Cache::Hash(&cam_I, &cam_J, matches, features_I, features_J);
+
+  // Same data: same hash
+  EXPECT_EQ(hash,
+    Relative_Pose_Cache::Hash(&cam_I, &cam_J, matches, features_I, features_J));
+
+  // A different intrinsic changes the hash
+  EXPECT_TRUE(hash !=
+    Relative_Pose_Cache::Hash(&cam_I, &cam_I, matches, features_I, features_J));
+
+  // Different putative matches change the hash
+  {
+    IndMatches matches_changed = matches;
+    matches_changed.back().j_ = 8;
+    EXPECT_TRUE(hash !=
+      Relative_Pose_Cache::Hash(&cam_I, &cam_J, matches_changed, features_I, features_J));
+    matches_changed.pop_back();
+    EXPECT_TRUE(hash !=
+      Relative_Pose_Cache::Hash(&cam_I, &cam_J, matches_changed, features_I, features_J));
+  }
+
+  // Moving a matched feature (same match indexes) changes the hash
+  {
+    PointFeatures features_changed = features_J;
+    features_changed[5] = PointFeature(features_J[5].x() + 0.5f, features_J[5].y());
+    EXPECT_TRUE(hash !=
+      Relative_Pose_Cache::Hash(&cam_I, &cam_J, matches, features_I, features_changed));
+  }
+
+  // Moving an unmatched feature does not change the hash
+  {
+    PointFeatures features_changed = features_J;
+    features_changed[6] = PointFeature(features_J[6].x() + 0.5f, features_J[6].y());
+    EXPECT_EQ(hash,
+      Relative_Pose_Cache::Hash(&cam_I, &cam_J, matches, features_I, features_changed));
+  }
+}
+
+TEST(RELATIVE_POSE_CACHE, Get_Set) {
+
+  Relative_Pose_Cache cache;
+  EXPECT_EQ(0, cache.Size());
+  EXPECT_FALSE(cache.Modified());
+
+  Relative_Pose_Cache::Entry entry;
+  entry.hash = 42;
+  entry.relative_pose = Pose3(RotationAroundY(0.1), Vec3(1, 2, 3));
+  entry.inliers = {0, 2, 3};
+  entry.quality = 1.5;
+  cache.Set({0, 1}, entry);
+  EXPECT_EQ(1, cache.Size());
+  EXPECT_TRUE(cache.Modified());
+
+  // Hit
+  Relative_Pose_Cache::Entry cached_entry;
+  EXPECT_TRUE(cache.Get({0, 1}, 42, cached_entry));
+  EXPECT_EQ(entry.inliers.size(), cached_entry.inliers.size());
+  EXPECT_MATRIX_NEAR(entry.relative_pose.rotation(), cached_entry.relative_pose.rotation(), 1e-12);
+  EXPECT_MATRIX_NEAR(entry.relative_pose.center(), cached_entry.relative_pose.center(), 1e-12);
+
+  // Miss: different data hash or unknown view pair
+  EXPECT_FALSE(cache.Get({0, 1}, 43, cached_entry));
+  EXPECT_FALSE(cache.Get({0, 2}, 42, cached_entry));
+}
+
+TEST(RELATIVE_POSE_CACHE, Save_Load) {
+
+  const std::string filename =
+    stlplus::create_filespec(stlplus::folder_current(), "relative_pose_cache_test.bin");
+
+  Relative_Pose_Cache cache;
+  for (IndexT i = 0; i < 8; ++i)
+  {
+    Relative_Pose_Cache::Entry entry;
+    entry.hash = 100 + i;
+    // Odd pairs are recorded failures (no inliers)
+    if (i % 2 == 0)
+    {
+      entry.relative_pose = Pose3(RotationAroundZ(0.1 * i), Vec3(i, 1, 0));
+      entry.inliers = {i, i + 1, i + 2};
+      entry.quality = 0.5 * i;
+    }
+    cache.Set({i, i + 1}, entry);
+  }
+  EXPECT_TRUE(cache.Save(filename));
+
+  Relative_Pose_Cache cache_loaded;
+  EXPECT_TRUE(cache_loaded.Load(filename));
+  EXPECT_EQ(cache.Size(), cache_loaded.Size());
+  EXPECT_FALSE(cache_loaded.Modified());
+  for (IndexT i = 0; i < 8; ++i)
+  {
+    Relative_Pose_Cache::Entry entry, entry_loaded;
+    EXPECT_TRUE(cache.Get({i, i + 1}, 100 + i, entry));
+    EXPECT_TRUE(cache_loaded.Get({i, i + 1}, 100 + i, entry_loaded));
+    EXPECT_FALSE(cache_loaded.Get({i, i + 1}, 200 + i, entry_loaded));
+    EXPECT_TRUE(entry.inliers == entry_loaded.inliers);
+    EXPECT_NEAR(entry.quality, entry_loaded.quality, 1e-12);
+    EXPECT_MATRIX_NEAR(entry.relative_pose.rotation(), entry_loaded.relative_pose.rotation(), 1e-12);
+    EXPECT_MATRIX_NEAR(entry.relative_pose.center(), entry_loaded.relative_pose.center(), 1e-12);
+  }
+
+  // Invalid files
+  EXPECT_FALSE(cache_loaded.Load(filename + ".missing"));
+  {
+    std::ofstream stream(filename.c_str(), std::ios::out | std::ios::binary);
+    stream << "not a relative pose cache";
+  }
+  EXPECT_FALSE(cache_loaded.Load(filename));
+  // The previously loaded entries are kept
+  EXPECT_EQ(cache.Size(), cache_loaded.Size());
+
+  stlplus::file_delete(filename);
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
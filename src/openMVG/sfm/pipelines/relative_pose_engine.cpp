@@ -10,6 +10,7 @@
 
 #include "openMVG/multiview/essential.hpp"
 #include "openMVG/multiview/triangulation.hpp"
+#include "openMVG/sfm/pipelines/relative_pose_cache.hpp"
 #include "openMVG/sfm/pipelines/sfm_robust_model_estimation.hpp"
 #include "openMVG/sfm/pipelines/sfm_features_provider.hpp"
 #include "openMVG/sfm/pipelines/sfm_matches_provider.hpp"
@@ -19,8 +20,12 @@
 #include "openMVG/sfm/sfm_data_triangulation.hpp"
 #include "openMVG/system/timer.hpp"
 
+#include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
+
 #include "ceres/ceres.h"
 
+#include <atomic>
+
 namespace openMVG {
 namespace sfm {
 
@@ -77,6 +82,15 @@ bool Relative_Pose_Engine::Relative_Pose_Engine::Process(
 
   system::Timer t;
 
+  // Load the previously computed relative poses (if any)
+  Relative_Pose_Cache cache;
+  if (!cache_filename_.empty() && stlplus::file_exists(cache_filename_))
+  {
+    if (cache.Load(cache_filename_))
+      std::cout << "Relative pose cache: " << cache.Size() << " entries." << std::endl;
+  }
+  std::atomic<unsigned int> cache_hits(0);
+
   std::unique_ptr<C_Progress> progress_status
     (new C_Progress_display(posewise_matches.size(),
       std::cout, "\n- Relative pose computation -\n" ));
@@ -127,8 +141,31 @@ bool Relative_Pose_Engine::Relative_Pose_Engine::Process(
         * cam_I = sfm_data_.GetIntrinsics().at(view_I->id_intrinsic).get(),
         * cam_J = sfm_data_.GetIntrinsics().at(view_J->id_intrinsic).get();
 
-      // Compute for each feature the un-distorted camera coordinates
       const matching::IndMatches & matches = matches_provider_->pairWise_matches_.at(current_pair);
+
+      // Reuse the cached relative pose (if computed from the same data)
+      const uint64_t cache_hash =
+        cache_filename_.empty() ? 0 :
+        Relative_Pose_Cache::Hash(cam_I, cam_J, matches,
+          features_provider_->feats_per_view.at(I),
+          features_provider_->feats_per_view.at(J));
+      Relative_Pose_Cache::Entry cache_entry;
+      if (!cache_filename_.empty() && cache.Get(current_pair, cache_hash, cache_entry))
+      {
+        ++cache_hits;
+        if (!cache_entry.inliers.empty())
+        {
+#ifdef OPENMVG_USE_OPENMP
+          #pragma omp critical
+#endif
+          {
+            relative_poses_[relative_pose_pair] = cache_entry.relative_pose;
+          }
+        }
+        continue;
+      }
+
+      // Compute for each feature the un-distorted camera coordinates
       size_t number_matches = matches.size();
       Mat2X x1(2, number_matches), x2(2, number_matches);
       number_matches = 0;
@@ -148,6 +185,12 @@ bool Relative_Pose_Engine::Relative_Pose_Engine::Process(
                               {cam_J->w(), cam_J->h()},
                               256))
       {
+        // Record the failure to avoid a new estimation attempt
+        if (!cache_filename_.empty())
+        {
+          cache_entry.hash = cache_hash;
+          cache.Set(current_pair, cache_entry);
+        }
         continue;
       }
       const bool bRefine_using_BA = true;
@@ -206,6 +249,14 @@ bool Relative_Pose_Engine::Relative_Pose_Engine::Process(
           relativePose_info.relativePose = Pose3(Rrel, -Rrel.transpose() * trel);
         }
       }
+      if (!cache_filename_.empty())
+      {
+        cache_entry.hash = cache_hash;
+        cache_entry.relative_pose = relativePose_info.relativePose;
+        cache_entry.inliers = relativePose_info.vec_inliers;
+        cache_entry.quality = relativePose_info.found_residual_precision;
+        cache.Set(current_pair, cache_entry);
+      }
 #ifdef OPENMVG_USE_OPENMP
       #pragma omp critical
 #endif
@@ -216,6 +267,15 @@ bool Relative_Pose_Engine::Relative_Pose_Engine::Process(
     }
   }
   std::cout << "Relative motion computation took: " << t.elapsedMs() << "(ms)" << std::endl;
+
+  if (!cache_filename_.empty())
+  {
+    std::cout << "Relative pose cache: " << cache_hits << " relative poses reused." << std::endl;
+    if (cache.Modified() && !cache.Save(cache_filename_))
+    {
+      std::cerr << "Cannot save the relative pose cache: " << cache_filename_ << std::endl;
+    }
+  }
   return !relative_poses_.empty();
 }
 
@@ -226,5 +286,10 @@ Relative_Pose_Engine::Get_Relative_Poses() const
   return relative_poses_;
 }
 
+void Relative_Pose_Engine::Set_Cache_Filename(const std::string & filename)
+{
+  cache_filename_ = filename;
+}
+
 } // namespace sfm
 } // namespace openMVG
@@ -12,6 +12,8 @@
 #include "openMVG/types.hpp"
 #include "openMVG/geometry/pose3.hpp"
 
+#include <string>
+
 namespace openMVG {
 namespace sfm {
 
@@ -45,8 +47,14 @@ public:
   // Relative poses accessor
   Relative_Pair_Poses Get_Relative_Poses() const;
 
+  // Set a persistent relative pose cache file (see Relative_Pose_Cache):
+  // - the pairs that are already in the cache are not estimated again,
+  // - the new estimates are appended to the cache file.
+  void Set_Cache_Filename(const std::string & filename);
+
 private:
   Relative_Pair_Poses relative_poses_;
+  std::string cache_filename_;
 };
 
 } // namespace sfm
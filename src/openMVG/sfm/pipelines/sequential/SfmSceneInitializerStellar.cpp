@@ -24,8 +24,10 @@ namespace sfm {
 SfMSceneInitializerStellar::SfMSceneInitializerStellar(
   SfM_Data & sfm_data,
   const Features_Provider * features_provider,
-  const Matches_Provider * matches_provider)
-  :SfMSceneInitializer(sfm_data, features_provider, matches_provider)
+  const Matches_Provider * matches_provider,
+  const std::string & relative_pose_cache_filename)
+  :SfMSceneInitializer(sfm_data, features_provider, matches_provider),
+   relative_pose_cache_filename_(relative_pose_cache_filename)
 {
   sfm_data_.poses.clear();
 }
@@ -110,6 +112,7 @@ bool SfMSceneInitializerStellar::Process()
   const Relative_Pose_Engine::Relative_Pair_Poses relative_poses = [&]
   {
     Relative_Pose_Engine relative_pose_engine;
+    relative_pose_engine.Set_Cache_Filename(relative_pose_cache_filename_);
     if (!relative_pose_engine.Process(
           selected_putative_stellar_pod,
           sfm_data_,
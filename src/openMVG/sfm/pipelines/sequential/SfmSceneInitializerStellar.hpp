@@ -12,22 +12,30 @@
 
 #include "openMVG/sfm/pipelines/sequential/SfmSceneInitializer.hpp"
 
+#include <string>
+
 namespace openMVG {
 namespace sfm {
 
 // Initialize a sfm_data with a "largest" stellar reconstruction:
 // - a set of N cameras that share a common node.
+// An optional relative pose cache file can be used to reuse the relative poses
+//  computed by a previous run (see Relative_Pose_Cache).
 class SfMSceneInitializerStellar : public SfMSceneInitializer
 {
 public:
   SfMSceneInitializerStellar(
     SfM_Data & sfm_data,
     const Features_Provider * features_provider,
-    const Matches_Provider * matches_provider);
+    const Matches_Provider * matches_provider,
+    const std::string & relative_pose_cache_filename = "");
 
   ~SfMSceneInitializerStellar() override = default;
 
   bool Process() override;
+
+private:
+  std::string relative_pose_cache_filename_;
 };
 
 } // namespace sfm
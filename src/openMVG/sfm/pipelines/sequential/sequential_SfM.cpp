@@ -19,6 +19,7 @@
 #include "openMVG/sfm/sfm_data_BA_ceres.hpp"
 #include "openMVG/sfm/sfm_data_filters.hpp"
 #include "openMVG/sfm/sfm_data_io.hpp"
+#include "openMVG/sfm/sfm_data_io_ply.hpp"
 #include "openMVG/stl/stl.hpp"
 
 #include "third_party/histogram/histogram.hpp"
@@ -48,7 +49,8 @@ SequentialSfMReconstructionEngine::SequentialSfMReconstructionEngine(
   : ReconstructionEngine(sfm_data, soutDirectory),
     sLogging_file_(sloggingFile),
     initial_pair_(0,0),
-    cam_type_(EINTRINSIC(PINHOLE_CAMERA_RADIAL3))
+    cam_type_(EINTRINSIC(PINHOLE_CAMERA_RADIAL3)),
+    b_delta_debug_snapshots_(false)
 {
   if (!sLogging_file_.empty())
   {
@@ -90,6 +92,40 @@ void SequentialSfMReconstructionEngine::SetMatchesProvider(Matches_Provider * pr
   matches_provider_ = provider;
 }
 
+bool SequentialSfMReconstructionEngine::ExportDebugSnapshot(const std::string & filename)
+{
+  if (!b_delta_debug_snapshots_)
+    return Save(sfm_data_, filename, ESfM_Data(ALL));
+
+  // Export only the new poses (Green points) and landmarks (White points)
+  std::vector<Vec3> vec_new_points;
+  for (const auto & pose_it : sfm_data_.GetPoses())
+  {
+    if (set_logged_pose_id_.insert(pose_it.first).second)
+      vec_new_points.push_back(pose_it.second.center());
+  }
+  const size_t new_pose_count = vec_new_points.size();
+  for (const auto & landmark_it : sfm_data_.GetLandmarks())
+  {
+    if (landmark_it.first >= vec_logged_landmark_.size())
+      vec_logged_landmark_.resize(landmark_it.first + 1, false);
+    if (!vec_logged_landmark_[landmark_it.first])
+    {
+      vec_logged_landmark_[landmark_it.first] = true;
+      vec_new_points.push_back(landmark_it.second.X);
+    }
+  }
+
+  return Save_PLY_Vertices(
+    filename,
+    vec_new_points.size(),
+    [&](size_t i, Vec3 & X, Vec3uc & color)
+    {
+      X = vec_new_points[i];
+      color = (i < new_pose_count) ? Vec3uc(0, 255, 0) : Vec3uc(255, 255, 255);
+    });
+}
+
 bool SequentialSfMReconstructionEngine::Process() {
 
   //-------------------
@@ -136,7 +172,7 @@ bool SequentialSfMReconstructionEngine::Process() {
       // Scene logging as ply for visual debug
       std::ostringstream os;
       os << std::setw(8) << std::setfill('0') << resectionGroupIndex << "_Resection";
-      Save(sfm_data_, stlplus::create_filespec(sOut_directory_, os.str(), ".ply"), ESfM_Data(ALL));
+      ExportDebugSnapshot(stlplus::create_filespec(sOut_directory_, os.str(), ".ply"));
 
       // Perform BA until all point are under the given precision
       do
@@ -71,6 +71,16 @@ public:
     cam_type_ = camType;
   }
 
+  /**
+   * Write only the poses and the landmarks that were added since the previous
+   * resection group in the per resection group PLY debug files
+   * (instead of the whole scene).
+   */
+  void SetDeltaDebugSnapshots(bool bDelta)
+  {
+    b_delta_debug_snapshots_ = bDelta;
+  }
+
 protected:
 
 
@@ -91,6 +101,9 @@ private:
   /// Discard track with too large residual error
   bool badTrackRejector(double dPrecision, size_t count = 0);
 
+  /// Export the scene (or its delta) as a PLY debug file
+  bool ExportDebugSnapshot(const std::string & filename);
+
   //----
   //-- Data
   //----
@@ -102,6 +115,7 @@ private:
   // Parameter
   Pair initial_pair_;
   cameras::EINTRINSIC cam_type_; // The camera type for the unknown cameras
+  bool b_delta_debug_snapshots_;
 
   //-- Data provider
   Features_Provider  * features_provider_;
@@ -116,6 +130,10 @@ private:
   Hash_Map<IndexT, double> map_ACThreshold_; // Per camera confidence (A contrario estimated threshold error)
 
   std::set<uint32_t> set_remaining_view_id_;     // Remaining camera index that can be used for resection
+
+  // Poses and landmarks already exported by the delta debug snapshots
+  std::set<IndexT> set_logged_pose_id_;
+  std::vector<bool> vec_logged_landmark_;
 };
 
 } // namespace sfm
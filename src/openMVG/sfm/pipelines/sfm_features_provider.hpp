@@ -11,10 +11,12 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "openMVG/features/feature.hpp"
 #include "openMVG/features/feature_container.hpp"
 #include "openMVG/features/regions.hpp"
+#include "openMVG/sfm/pipelines/sfm_view_files_loader.hpp"
 #include "openMVG/sfm/sfm_data.hpp"
 #include "openMVG/types.hpp"
 
@@ -40,40 +42,40 @@ struct Features_Provider
   {
     C_Progress_display my_progress_bar( sfm_data.GetViews().size(),
       std::cout, "\n- Features Loading -\n" );
-    // Read for each view the corresponding features and store them as PointFeatures
-    bool bContinue = true;
-#ifdef OPENMVG_USE_OPENMP
-    #pragma omp parallel
-#endif
-    for (Views::const_iterator iter = sfm_data.GetViews().begin();
-      iter != sfm_data.GetViews().end() && bContinue; ++iter)
+    // List the features files of the views
+    std::vector<IndexT> view_ids;
+    std::vector<std::vector<std::string>> view_files;
+    view_ids.reserve(sfm_data.GetViews().size());
+    view_files.reserve(sfm_data.GetViews().size());
+    for (const auto & view_it : sfm_data.GetViews())
     {
-#ifdef OPENMVG_USE_OPENMP
-    #pragma omp single nowait
-#endif
-      {
-        const std::string sImageName = stlplus::create_filespec(sfm_data.s_root_path, iter->second->s_Img_path);
-        const std::string basename = stlplus::basename_part(sImageName);
-        const std::string featFile = stlplus::create_filespec(feat_directory, basename, ".feat");
+      const std::string sImageName = stlplus::create_filespec(sfm_data.s_root_path, view_it.second->s_Img_path);
+      const std::string basename = stlplus::basename_part(sImageName);
+      view_ids.push_back(view_it.second->id_view);
+      view_files.push_back({stlplus::create_filespec(feat_directory, basename, ".feat")});
+    }
 
+    // Read for each view the corresponding features (parsed in parallel while
+    //  the next files are read) and store them as PointFeatures by view position
+    std::vector<features::PointFeatures> feats(view_ids.size());
+    const bool bContinue = Load_View_Files(view_files,
+      [&](std::size_t i, std::vector<std::string> & contents) -> bool
+      {
+        Memory_Istream stream(contents[0].data(), contents[0].size());
         std::unique_ptr<features::Regions> regions(region_type->EmptyClone());
-        if (!stlplus::file_exists(featFile) || !regions->LoadFeatures(featFile))
+        if (!regions->LoadFeatures(stream))
         {
-          std::cerr << "Invalid feature files for the view: " << sImageName << std::endl;
-#ifdef OPENMVG_USE_OPENMP
-      #pragma omp critical
-#endif
-          bContinue = false;
+          std::cerr << "Invalid feature files for the view: " << view_files[i][0] << std::endl;
+          return false;
         }
-#ifdef OPENMVG_USE_OPENMP
-      #pragma omp critical
-#endif
-        {
-          // save loaded Features as PointFeature
-          feats_per_view[iter->second->id_view] = regions->GetRegionsPositions();
-        }
-        ++my_progress_bar;
-      }
+        feats[i] = regions->GetRegionsPositions();
+        return true;
+      },
+      &my_progress_bar);
+
+    for (std::size_t i = 0; i < view_ids.size(); ++i)
+    {
+      feats_per_view[view_ids[i]] = std::move(feats[i]);
     }
     return bContinue;
   }
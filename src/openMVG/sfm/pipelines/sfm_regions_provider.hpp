@@ -12,9 +12,11 @@
 #include <atomic>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "openMVG/features/image_describer.hpp"
 #include "openMVG/features/regions_factory.hpp"
+#include "openMVG/sfm/pipelines/sfm_view_files_loader.hpp"
 #include "openMVG/sfm/sfm_data.hpp"
 #include "openMVG/types.hpp"
 
@@ -97,43 +99,44 @@ public:
     region_type_.reset(region_type->EmptyClone());
 
     my_progress_bar->restart(sfm_data.GetViews().size(), "\n- Regions Loading -\n");
-    // Read for each view the corresponding regions and store them
-    std::atomic<bool> bContinue(true);
-#ifdef OPENMVG_USE_OPENMP
-    #pragma omp parallel
-#endif
-    for (Views::const_iterator iter = sfm_data.GetViews().begin();
-      iter != sfm_data.GetViews().end() && bContinue; ++iter)
+    // List the regions files of the views
+    std::vector<IndexT> view_ids;
+    std::vector<std::vector<std::string>> view_files;
+    view_ids.reserve(sfm_data.GetViews().size());
+    view_files.reserve(sfm_data.GetViews().size());
+    for (const auto & view_it : sfm_data.GetViews())
     {
-        if (my_progress_bar->hasBeenCanceled())
-        {
-          bContinue = false;
-          continue;
-        }
-#ifdef OPENMVG_USE_OPENMP
-    #pragma omp single nowait
-#endif
-      {
-        const std::string sImageName = stlplus::create_filespec(sfm_data.s_root_path, iter->second->s_Img_path);
-        const std::string basename = stlplus::basename_part(sImageName);
-        const std::string featFile = stlplus::create_filespec(feat_directory, basename, ".feat");
-        const std::string descFile = stlplus::create_filespec(feat_directory, basename, ".desc");
+      const std::string sImageName = stlplus::create_filespec(sfm_data.s_root_path, view_it.second->s_Img_path);
+      const std::string basename = stlplus::basename_part(sImageName);
+      view_ids.push_back(view_it.second->id_view);
+      view_files.push_back({
+        stlplus::create_filespec(feat_directory, basename, ".feat"),
+        stlplus::create_filespec(feat_directory, basename, ".desc")});
+    }
 
+    // Read for each view the corresponding regions (parsed in parallel while
+    //  the next files are read) and store them by view position
+    std::vector<std::unique_ptr<features::Regions>> regions(view_ids.size());
+    const bool bContinue = Load_View_Files(view_files,
+      [&](std::size_t i, std::vector<std::string> & contents) -> bool
+      {
+        Memory_Istream feats(contents[0].data(), contents[0].size());
+        Memory_Istream descs(contents[1].data(), contents[1].size());
         std::unique_ptr<features::Regions> regions_ptr(region_type->EmptyClone());
-        if (!regions_ptr->Load(featFile, descFile))
+        if (!regions_ptr->Load(feats, descs))
         {
-          std::cerr << "Invalid regions files for the view: " << sImageName << std::endl;
-          bContinue = false;
+          std::cerr << "Invalid regions files for the view: " << view_files[i][0] << std::endl;
+          return false;
         }
-        //else
-#ifdef OPENMVG_USE_OPENMP
-        #pragma omp critical
-#endif
-        {
-          cache_[iter->second->id_view] = std::move(regions_ptr);
-        }
-        ++(*my_progress_bar);
-      }
+        regions[i] = std::move(regions_ptr);
+        return true;
+      },
+      my_progress_bar);
+
+    for (std::size_t i = 0; i < view_ids.size(); ++i)
+    {
+      if (regions[i])
+        cache_[view_ids[i]] = std::move(regions[i]);
     }
     return bContinue;
   }
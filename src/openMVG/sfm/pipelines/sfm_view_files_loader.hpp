@@ -0,0 +1,209 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_SFM_SFM_VIEW_FILES_LOADER_HPP
+#define OPENMVG_SFM_SFM_VIEW_FILES_LOADER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "third_party/progress/progress.hpp"
+
+namespace openMVG {
+namespace sfm {
+
+/// Read only std::istream on a memory buffer (the buffer is not copied)
+class Memory_Istream : private std::streambuf, public std::istream
+{
+public:
+  Memory_Istream(const char * data, std::size_t size)
+    : std::istream(static_cast<std::streambuf*>(this))
+  {
+    char * begin = const_cast<char*>(data);
+    setg(begin, begin, begin + size);
+  }
+};
+
+/// Read a whole file in memory
+inline bool Read_File
+(
+  const std::string & filename,
+  std::string & content
+)
+{
+  std::ifstream stream(filename.c_str(), std::ios::in | std::ios::binary);
+  if (!stream.is_open())
+    return false;
+  stream.seekg(0, std::ios::end);
+  const std::streamoff size = stream.tellg();
+  if (size < 0)
+    return false;
+  stream.seekg(0, std::ios::beg);
+  content.resize(static_cast<std::size_t>(size));
+  if (size > 0)
+    stream.read(&content[0], size);
+  return !stream.fail();
+}
+
+/**
+* @brief Load the files of every view, overlapping the file reads and the parsing:
+*  - a bounded pool of I/O threads reads the files of the views in memory,
+*  - the parsing threads (the OpenMP threads) parse the views as soon as their
+*     files are read. The count of read views waiting to be parsed is bounded,
+*     so the memory used by the file contents stays bounded.
+* The parse functor is expected to store its result in the slot of a pre-sized
+*  array indexed by the view position (no lock is required).
+*
+* @param[in] view_files The files of each view
+* @param[in] parse_functor Thread safe functor
+*   bool(std::size_t view_position, std::vector<std::string> & file_contents)
+* @param[in] my_progress_bar Progress (incremented for each parsed view)
+* @param[in] io_thread_count Number of I/O threads
+* @return false if a file cannot be read or parsed, or if the loading has been canceled
+*/
+template <typename ParseFunctorT>
+bool Load_View_Files
+(
+  const std::vector<std::vector<std::string>> & view_files,
+  ParseFunctorT parse_functor,
+  C_Progress * my_progress_bar = nullptr,
+  unsigned int io_thread_count = 4
+)
+{
+  if (!my_progress_bar)
+    my_progress_bar = &C_Progress::dummy();
+  if (view_files.empty())
+    return true;
+
+  io_thread_count = std::max(1u,
+    std::min(io_thread_count, static_cast<unsigned int>(view_files.size())));
+  const std::size_t max_pending_views = 4 * io_thread_count;
+
+  // The read views waiting to be parsed
+  struct Read_View
+  {
+    std::size_t position;
+    std::vector<std::string> contents;
+  };
+  std::deque<Read_View> pending_views;
+  std::mutex mutex;
+  std::condition_variable cond_pending, cond_space;
+  unsigned int active_io_thread_count = io_thread_count;
+
+  std::atomic<bool> bContinue(true);
+  std::atomic<std::size_t> next_position(0);
+  std::atomic<std::uint64_t> read_bytes(0);
+
+  // Stop the loading and wake up the waiting threads
+  const auto stop = [&]()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    bContinue = false;
+    cond_pending.notify_all();
+    cond_space.notify_all();
+  };
+
+  const auto read_views = [&]()
+  {
+    for (std::size_t position = next_position++;
+      position < view_files.size() && bContinue;
+      position = next_position++)
+    {
+      if (my_progress_bar->hasBeenCanceled())
+      {
+        stop();
+        break;
+      }
+      Read_View view{position, std::vector<std::string>(view_files[position].size())};
+      for (std::size_t i = 0; i < view.contents.size() && bContinue; ++i)
+      {
+        if (!Read_File(view_files[position][i], view.contents[i]))
+        {
+          std::cerr << "Cannot read the file: " << view_files[position][i] << std::endl;
+          stop();
+        }
+        read_bytes += view.contents[i].size();
+      }
+      std::unique_lock<std::mutex> lock(mutex);
+      cond_space.wait(lock, [&]{
+        return pending_views.size() < max_pending_views || !bContinue; });
+      if (!bContinue)
+        break;
+      pending_views.push_back(std::move(view));
+      cond_pending.notify_one();
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    --active_io_thread_count;
+    cond_pending.notify_all();
+  };
+
+  const auto parse_views = [&]()
+  {
+    while (true)
+    {
+      Read_View view;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond_pending.wait(lock, [&]{
+          return !pending_views.empty() || active_io_thread_count == 0 || !bContinue; });
+        if (!bContinue || pending_views.empty())
+          return;
+        view = std::move(pending_views.front());
+        pending_views.pop_front();
+        cond_space.notify_one();
+      }
+      if (!parse_functor(view.position, view.contents))
+      {
+        stop();
+        return;
+      }
+      ++(*my_progress_bar);
+    }
+  };
+
+  const auto start_time = std::chrono::steady_clock::now();
+  std::vector<std::thread> io_threads;
+  for (unsigned int i = 0; i < io_thread_count; ++i)
+    io_threads.emplace_back(read_views);
+
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel
+#endif
+  parse_views();
+
+  for (auto & io_thread : io_threads)
+    io_thread.join();
+
+  if (bContinue)
+  {
+    const double elapsed = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start_time).count();
+    const double read_MB = read_bytes / (1024.0 * 1024.0);
+    std::cout
+      << "\n" << view_files.size() << " views loaded: " << read_MB << " MB in "
+      << elapsed << " s (" << (elapsed > 0. ? read_MB / elapsed : 0.) << " MB/s)"
+      << std::endl;
+  }
+  return bContinue;
+}
+
+} // namespace sfm
+} // namespace openMVG
+
+#endif // OPENMVG_SFM_SFM_VIEW_FILES_LOADER_HPP
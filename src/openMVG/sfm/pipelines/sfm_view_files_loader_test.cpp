@@ -0,0 +1,126 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/sfm/pipelines/sfm_view_files_loader.hpp"
+
+#include "testing/testing.h"
+#include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace openMVG::sfm;
+
+// <view_count> views of 2 files ("<view>.feat" and "<view>.desc"),
+// the content of a file is its name
+struct View_Files_Scene
+{
+  std::string root;
+  std::vector<std::vector<std::string>> view_files;
+
+  explicit View_Files_Scene(const std::size_t view_count)
+  {
+    root = stlplus::create_filespec(stlplus::folder_current(), "view_files_loader_test");
+    stlplus::folder_delete(root, true);
+    stlplus::folder_create(root);
+    for (std::size_t i = 0; i < view_count; ++i)
+    {
+      view_files.emplace_back();
+      for (const std::string extension : {"feat", "desc"})
+      {
+        view_files.back().push_back(
+          stlplus::create_filespec(root, std::to_string(i), extension));
+        std::ofstream stream(view_files.back().back().c_str(), std::ios::binary);
+        stream << view_files.back().back();
+      }
+    }
+  }
+
+  ~View_Files_Scene()
+  {
+    stlplus::folder_delete(root, true);
+  }
+};
+
+TEST(Load_View_Files, ManyViews) {
+  const View_Files_Scene scene(500);
+
+  for (const unsigned int io_thread_count : {1u, 2u, 4u, 1000u})
+  {
+    // The contents are stored in the slot of their view
+    std::vector<std::vector<std::string>> contents(scene.view_files.size());
+    std::vector<int> parse_counts(scene.view_files.size(), 0);
+    C_Progress progress(scene.view_files.size());
+    EXPECT_TRUE(Load_View_Files(scene.view_files,
+      [&](std::size_t position, std::vector<std::string> & file_contents)
+      {
+        ++parse_counts[position];
+        contents[position] = std::move(file_contents);
+        return true;
+      },
+      &progress, io_thread_count));
+
+    EXPECT_EQ(scene.view_files.size(), progress.count());
+    for (std::size_t i = 0; i < scene.view_files.size(); ++i)
+    {
+      EXPECT_EQ(1, parse_counts[i]);
+      EXPECT_TRUE(contents[i] == scene.view_files[i]);
+    }
+  }
+}
+
+TEST(Load_View_Files, NoView) {
+  EXPECT_TRUE(Load_View_Files({},
+    [](std::size_t, std::vector<std::string> &) { return false; }));
+}
+
+// A missing file (first, middle or last view) stops the loading
+TEST(Load_View_Files, MissingFile) {
+  for (const std::size_t failing_position : {0, 250, 499})
+  {
+    View_Files_Scene scene(500);
+    stlplus::file_delete(scene.view_files[failing_position][1]);
+
+    for (const unsigned int io_thread_count : {1u, 4u})
+    {
+      std::vector<int> parse_counts(scene.view_files.size(), 0);
+      EXPECT_FALSE(Load_View_Files(scene.view_files,
+        [&](std::size_t position, std::vector<std::string> &)
+        {
+          ++parse_counts[position];
+          return true;
+        },
+        nullptr, io_thread_count));
+      // The view of the missing file is not parsed
+      EXPECT_EQ(0, parse_counts[failing_position]);
+    }
+  }
+}
+
+// A file that cannot be parsed (first, middle or last view) stops the loading
+TEST(Load_View_Files, CorruptFile) {
+  const View_Files_Scene scene(500);
+
+  for (const std::size_t failing_position : {0, 250, 499})
+  {
+    for (const unsigned int io_thread_count : {1u, 4u})
+    {
+      EXPECT_FALSE(Load_View_Files(scene.view_files,
+        [&](std::size_t position, std::vector<std::string> &)
+        {
+          return position != failing_position;
+        },
+        nullptr, io_thread_count));
+    }
+  }
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
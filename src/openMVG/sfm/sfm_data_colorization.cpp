@@ -9,6 +9,7 @@
 
 #include "openMVG/sfm/sfm_data_colorization.hpp"
 
+#include "openMVG/image/image_cache.hpp"
 #include "openMVG/image/image_container.hpp"
 #include "openMVG/image/image_io.hpp"
 #include "openMVG/image/pixel_types.hpp"
@@ -18,126 +19,173 @@
 #include "third_party/progress/progress_display.hpp"
 #include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
 
+#include <map>
+#include <memory>
+#include <queue>
+#include <utility>
+#include <vector>
+
 namespace openMVG {
 namespace sfm {
 
-/// Find the color of the SfM_Data Landmarks/structure
-bool ColorizeTracks(
-  const SfM_Data & sfm_data,
-  std::vector<Vec3> & vec_3dPoints,
-  std::vector<Vec3> & vec_tracksColor)
+/// Assign each track to one of the views that observe it, in order to read the
+///  fewest images: greedily select the view that observes the most of the
+///  remaining tracks (the per view counts are updated lazily).
+/// Return the track indexes (in the landmark iteration order) to color per view.
+static std::vector<std::pair<IndexT, std::vector<IndexT>>> AssignTracksToViews
+(
+  const std::vector<const Landmark*> & landmarks
+)
 {
-  // Colorize each track
-  // Start with the most representative image
-  //   and iterate to provide a color to each 3D point
-
+  // List the tracks observed by each view
+  std::map<IndexT, std::vector<IndexT>> tracks_per_view;
+  for (IndexT i = 0; i < landmarks.size(); ++i)
   {
-    C_Progress_display my_progress_bar(sfm_data.GetLandmarks().size(),
-                                       std::cout,
-                                       "\nCompute scene structure color\n");
-
-    vec_tracksColor.resize(sfm_data.GetLandmarks().size());
-    vec_3dPoints.resize(sfm_data.GetLandmarks().size());
-
-    //Build a list of contiguous index for the trackIds
-    std::map<IndexT, IndexT> trackIds_to_contiguousIndexes;
-    IndexT cpt = 0;
-    for (Landmarks::const_iterator it = sfm_data.GetLandmarks().begin();
-      it != sfm_data.GetLandmarks().end(); ++it, ++cpt)
+    for (const auto & obs_it : landmarks[i]->obs)
     {
-      trackIds_to_contiguousIndexes[it->first] = cpt;
-      vec_3dPoints[cpt] = it->second.X;
+      tracks_per_view[obs_it.first].push_back(i);
     }
+  }
 
-    // The track list that will be colored (point removed during the process)
-    std::set<IndexT> remainingTrackToColor;
-    std::transform(sfm_data.GetLandmarks().begin(), sfm_data.GetLandmarks().end(),
-      std::inserter(remainingTrackToColor, remainingTrackToColor.begin()),
-      stl::RetrieveKey());
+  // Number of remaining tracks observed by each view
+  std::map<IndexT, IndexT> remaining_count;
+  // Sorted by the most remaining tracks first, then by the smallest view id
+  using Candidate = std::pair<IndexT, IndexT>; // (remaining count, view id)
+  const auto candidate_cmp = [](const Candidate & a, const Candidate & b)
+  {
+    return (a.first != b.first) ? a.first < b.first : a.second > b.second;
+  };
+  std::priority_queue<Candidate, std::vector<Candidate>, decltype(candidate_cmp)>
+    candidates(candidate_cmp);
+  for (const auto & view_tracks : tracks_per_view)
+  {
+    remaining_count[view_tracks.first] = view_tracks.second.size();
+    candidates.emplace(view_tracks.second.size(), view_tracks.first);
+  }
 
-    while ( !remainingTrackToColor.empty() )
+  std::vector<bool> assigned(landmarks.size(), false);
+  std::vector<std::pair<IndexT, std::vector<IndexT>>> tracks_to_color_per_view;
+  while (!candidates.empty())
+  {
+    const Candidate candidate = candidates.top();
+    candidates.pop();
+    const IndexT view_id = candidate.second;
+    const IndexT count = remaining_count[view_id];
+    if (count == 0)
+      continue;
+    if (count != candidate.first)
     {
-      // Find the most representative image (for the remaining 3D points)
-      //  a. Count the number of observation per view for each 3Dpoint Index
-      //  b. Sort to find the most representative view index
+      // Outdated count, reinsert the view with its current count
+      candidates.emplace(count, view_id);
+      continue;
+    }
 
-      std::map<IndexT, IndexT> map_IndexCardinal; // ViewId, Cardinal
-      for (const auto & track_to_color_it : remainingTrackToColor)
+    std::vector<IndexT> tracks_to_color;
+    tracks_to_color.reserve(count);
+    for (const IndexT track_index : tracks_per_view[view_id])
+    {
+      if (assigned[track_index])
+        continue;
+      assigned[track_index] = true;
+      tracks_to_color.push_back(track_index);
+      for (const auto & obs_it : landmarks[track_index]->obs)
       {
-        const auto trackId = track_to_color_it;
-        const Observations & obs = sfm_data.GetLandmarks().at(trackId).obs;
-        for (const auto & obs_it : obs)
-        {
-          const auto viewId = obs_it.first;
-          if (map_IndexCardinal.find(viewId) == map_IndexCardinal.end())
-            map_IndexCardinal[viewId] = 1;
-          else
-            ++map_IndexCardinal[viewId];
-        }
+        --remaining_count[obs_it.first];
       }
+    }
+    tracks_to_color_per_view.emplace_back(view_id, std::move(tracks_to_color));
+  }
+  return tracks_to_color_per_view;
+}
+
+/// Find the color of the SfM_Data Landmarks/structure
+bool ColorizeTracks(
+  const SfM_Data & sfm_data,
+  std::vector<Vec3> & vec_3dPoints,
+  std::vector<Vec3> & vec_tracksColor,
+  image::ImageCache * image_cache)
+{
+  // Colorize each track:
+  // - assign each track to a view (the most representative images first),
+  // - read the images in parallel and color their assigned tracks.
+  // Without a shared image cache, an image is released once its tracks are
+  //  colored, so about one image per thread is kept in memory.
+
+  C_Progress_display my_progress_bar(sfm_data.GetLandmarks().size(),
+                                     std::cout,
+                                     "\nCompute scene structure color\n");
+
+  vec_tracksColor.resize(sfm_data.GetLandmarks().size());
+  vec_3dPoints.resize(sfm_data.GetLandmarks().size());
+
+  // Use a contiguous index for the tracks
+  std::vector<const Landmark*> landmarks;
+  landmarks.reserve(sfm_data.GetLandmarks().size());
+  for (const auto & landmark_it : sfm_data.GetLandmarks())
+  {
+    vec_3dPoints[landmarks.size()] = landmark_it.second.X;
+    landmarks.push_back(&landmark_it.second);
+  }
+
+  const std::vector<std::pair<IndexT, std::vector<IndexT>>> tracks_to_color_per_view =
+    AssignTracksToViews(landmarks);
+
+  // Without a shared cache, keep only the images that are in use
+  image::ImageCache local_image_cache(0);
+  if (!image_cache)
+    image_cache = &local_image_cache;
 
-      // Find the View index that is the most represented
-      std::vector<IndexT> vec_cardinal;
-      std::transform(map_IndexCardinal.begin(),
-        map_IndexCardinal.end(),
-        std::back_inserter(vec_cardinal),
-        stl::RetrieveValue());
-      using namespace stl::indexed_sort;
-      std::vector<sort_index_packet_descend<IndexT, IndexT>> packet_vec(vec_cardinal.size());
-      sort_index_helper(packet_vec, &vec_cardinal[0], 1);
-
-      // First image index with the most of occurence
-      std::map<IndexT, IndexT>::const_iterator iterTT = map_IndexCardinal.begin();
-      std::advance(iterTT, packet_vec[0].index);
-      const size_t view_index = iterTT->first;
-      const View * view = sfm_data.GetViews().at(view_index).get();
-      const std::string sView_filename = stlplus::create_filespec(sfm_data.s_root_path,
-        view->s_Img_path);
-      image::Image<image::RGBColor> image_rgb;
-      image::Image<unsigned char> image_gray;
-      const bool b_rgb_image = ReadImage(sView_filename.c_str(), &image_rgb);
-      if (!b_rgb_image) //try Gray level
+  bool b_ok = true;
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for schedule(dynamic)
+#endif
+  for (int i = 0; i < static_cast<int>(tracks_to_color_per_view.size()); ++i)
+  {
+    const IndexT view_index = tracks_to_color_per_view[i].first;
+    const std::vector<IndexT> & tracks_to_color = tracks_to_color_per_view[i].second;
+
+    const View * view = sfm_data.GetViews().at(view_index).get();
+    const std::string sView_filename = stlplus::create_filespec(sfm_data.s_root_path,
+      view->s_Img_path);
+    const std::shared_ptr<const image::Image<image::RGBColor>> image_rgb =
+      image_cache->Get<image::RGBColor>(sView_filename);
+    const bool b_rgb_image = static_cast<bool>(image_rgb);
+    std::shared_ptr<const image::Image<unsigned char>> image_gray;
+    if (!b_rgb_image) //try Gray level
+    {
+      image_gray = image_cache->Get<unsigned char>(sView_filename);
+      if (!image_gray)
       {
-        const bool b_gray_image = ReadImage(sView_filename.c_str(), &image_gray);
-        if (!b_gray_image)
+#ifdef OPENMVG_USE_OPENMP
+        #pragma omp critical
+#endif
         {
           std::cerr << "Cannot open provided the image." << std::endl;
-          return false;
+          b_ok = false;
         }
+        continue;
       }
+    }
 
-      // Iterate through the remaining track to color
-      // - look if the current view is present to color the track
-      std::set<IndexT> set_toRemove;
-      for (const auto & track_to_color_it : remainingTrackToColor)
-      {
-        const auto trackId = track_to_color_it;
-        const Observations & obs = sfm_data.GetLandmarks().at(trackId).obs;
-        Observations::const_iterator it = obs.find(view_index);
+    // Color the tracks assigned to this view
+    for (const IndexT track_index : tracks_to_color)
+    {
+      const Vec2 & pt = landmarks[track_index]->obs.at(view_index).x;
+      const image::RGBColor color =
+        b_rgb_image
+        ? (*image_rgb)(pt.y(), pt.x())
+        : image::RGBColor((*image_gray)(pt.y(), pt.x()));
 
-        if (it != obs.end())
-        {
-          // Color the track
-          const Vec2 & pt = it->second.x;
-          const image::RGBColor color =
-            b_rgb_image
-            ? image_rgb(pt.y(), pt.x())
-            : image::RGBColor(image_gray(pt.y(), pt.x()));
-
-          vec_tracksColor[trackIds_to_contiguousIndexes.at(trackId)] =
-            Vec3(color.r(), color.g(), color.b());
-          set_toRemove.insert(trackId);
-          ++my_progress_bar;
-        }
-      }
-      // Remove colored track
-      for (const auto & to_remove_it : set_toRemove)
-      {
-        remainingTrackToColor.erase(to_remove_it);
-      }
+      vec_tracksColor[track_index] = Vec3(color.r(), color.g(), color.b());
+    }
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp critical
+#endif
+    {
+      my_progress_bar += tracks_to_color.size();
     }
   }
-  return true;
+  return b_ok;
 }
 
 } // namespace sfm
@@ -12,15 +12,21 @@
 
 #include "openMVG/numeric/eigen_alias_definition.hpp"
 
+namespace openMVG { namespace image { class ImageCache; } }
+
 namespace openMVG {
 namespace sfm {
 
 struct SfM_Data;
 
+/// Compute the color of each landmark from one of its observations.
+/// If an image cache is provided, the images are read through it (and so can
+///  be shared with the other processing steps of the scene).
 bool ColorizeTracks(
   const SfM_Data & sfm_data,
   std::vector<Vec3> & vec_3dPoints,
-  std::vector<Vec3> & vec_tracksColor);
+  std::vector<Vec3> & vec_tracksColor,
+  image::ImageCache * image_cache = nullptr);
 
 } // namespace sfm
 } // namespace openMVG
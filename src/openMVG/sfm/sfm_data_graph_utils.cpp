@@ -9,8 +9,7 @@
 #include "openMVG/sfm/sfm_data_graph_utils.hpp"
 
 #include "openMVG/graph/connectedComponent.hpp"
-#include "openMVG/graph/graph.hpp"
-#include "openMVG/graph/graph_builder.hpp"
+#include "openMVG/graph/csr_graph.hpp"
 #include "openMVG/types.hpp"
 
 
@@ -46,47 +45,21 @@ bool PairsToConnectedComponents
 {
   subgraphs_ids.clear();
 
-  using Graph = graph::indexedGraph::GraphT;
-  graph::indexedGraph putativeGraph(pairs);
+  graph::CsrGraph putativeGraph(pairs);
 
   // For global SFM, firstly remove the not bi-edge element
   if (is_biedge)
   {
-    using EdgeMapAlias = Graph::EdgeMap<bool>;
-    EdgeMapAlias cutMap(putativeGraph.g);
-    if (lemon::biEdgeConnectedCutEdges(putativeGraph.g, cutMap) > 0)
-    {
-      // Some edges must be removed because they don't follow the biEdge condition.
-      using EdgeIterator = Graph::EdgeIt;
-      EdgeIterator itEdge(putativeGraph.g);
-      for (EdgeMapAlias::MapIt it(cutMap); it != lemon::INVALID; ++it, ++itEdge)
-      {
-        if (*it)
-        {
-          putativeGraph.g.erase(itEdge);  // remove the not bi-edge element
-        }
-      }
-    }
+    putativeGraph = graph::RemoveBridges(putativeGraph);
   }
 
   // Compute all subgraphs in the putative graph
-  const int connectedComponentCount = lemon::countConnectedComponents(putativeGraph.g);
-  if (connectedComponentCount >= 1)
+  const auto map_subgraphs = graph::exportGraphToMapSubgraphs(putativeGraph);
+  for (const auto & iter_map_subgraphs : map_subgraphs)
   {
-    const auto map_subgraphs = graph::exportGraphToMapSubgraphs<Graph, IndexT>(putativeGraph.g);
-    for (const auto & iter_map_subgraphs : map_subgraphs)
+    if (iter_map_subgraphs.second.size() > min_nodes)
     {
-      if (iter_map_subgraphs.second.size() > min_nodes)
-      {
-        std::set<IndexT> subgraphNodes;
-        const std::set<lemon::ListGraph::Node> & ccSet = iter_map_subgraphs.second;
-        for (const auto & iter2 : ccSet)
-        {
-          const IndexT Id = (*putativeGraph.node_map_id)[iter2];
-          subgraphNodes.insert(Id);
-        }
-        subgraphs_ids.emplace(iter_map_subgraphs.first, subgraphNodes);
-      }
+      subgraphs_ids.emplace(iter_map_subgraphs.first, iter_map_subgraphs.second);
     }
   }
   return !subgraphs_ids.empty();
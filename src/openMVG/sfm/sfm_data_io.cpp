@@ -15,7 +15,9 @@
 #include "openMVG/sfm/sfm_data_io.hpp"
 #include "openMVG/sfm/sfm_data_io_baf.hpp"
 #include "openMVG/sfm/sfm_data_io_cereal.hpp"
+#include "openMVG/sfm/sfm_data_io_json.hpp"
 #include "openMVG/sfm/sfm_data_io_ply.hpp"
+#include "openMVG/sfm/sfm_data_io_sfmb.hpp"
 #include "openMVG/stl/stlMap.hpp"
 #include "openMVG/types.hpp"
 #include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
@@ -74,11 +76,13 @@ bool Load(SfM_Data & sfm_data, const std::string & filename, ESfM_Data flags_par
   bool bStatus = false;
   const std::string ext = stlplus::extension_part(filename);
   if (ext == "json")
-    bStatus = Load_Cereal<cereal::JSONInputArchive>(sfm_data, filename, flags_part);
+    bStatus = Load_JSON(sfm_data, filename, flags_part);
   else if (ext == "bin")
     bStatus = Load_Cereal<cereal::PortableBinaryInputArchive>(sfm_data, filename, flags_part);
   else if (ext == "xml")
     bStatus = Load_Cereal<cereal::XMLInputArchive>(sfm_data, filename, flags_part);
+  else if (ext == "sfmb") // Sectioned binary file
+    bStatus = Load_SFMB(sfm_data, filename, flags_part);
   else
   {
     std::cerr << "Unknown sfm_data input format: " << ext << std::endl;
@@ -100,11 +104,13 @@ bool Save(const SfM_Data & sfm_data, const std::string & filename, ESfM_Data fla
 {
   const std::string ext = stlplus::extension_part(filename);
   if (ext == "json")
-    return Save_Cereal<cereal::JSONOutputArchive>(sfm_data, filename, flags_part);
+    return Save_JSON(sfm_data, filename, flags_part);
   else if (ext == "bin")
     return Save_Cereal<cereal::PortableBinaryOutputArchive>(sfm_data, filename, flags_part);
   else if (ext == "xml")
     return Save_Cereal<cereal::XMLOutputArchive>(sfm_data, filename, flags_part);
+  else if (ext == "sfmb") // Sectioned binary file
+    return Save_SFMB(sfm_data, filename, flags_part);
   else if (ext == "ply")
     return Save_PLY(sfm_data, filename, flags_part);
   else if (ext == "baf") // Bundle Adjustment file
@@ -286,6 +286,89 @@ bool Save_Cereal(
   return true;
 }
 
+bool Save_Cereal_Part(
+  const SfM_Data & data,
+  std::ostream & stream,
+  ESfM_Data part)
+{
+  cereal::PortableBinaryOutputArchive archive(stream);
+  if (part == VIEWS)
+    archive(cereal::make_nvp("views", data.views));
+  else if (part == INTRINSICS)
+    archive(cereal::make_nvp("intrinsics", data.intrinsics));
+  else
+    return false;
+  return stream.good();
+}
+
+bool Load_Cereal_Part(
+  SfM_Data & data,
+  std::istream & stream,
+  ESfM_Data part)
+{
+  try
+  {
+    cereal::PortableBinaryInputArchive archive(stream);
+    if (part == VIEWS)
+      archive(cereal::make_nvp("views", data.views));
+    else if (part == INTRINSICS)
+      archive(cereal::make_nvp("intrinsics", data.intrinsics));
+    else
+      return false;
+  }
+  catch (const cereal::Exception & e)
+  {
+    std::cerr << e.what() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool Save_Cereal_JSON_Head(
+  const SfM_Data & data,
+  std::ostream & stream,
+  ESfM_Data flags_part)
+{
+  {
+    cereal::JSONOutputArchive archive(stream);
+    const std::string version = "0.3";
+    archive(cereal::make_nvp("sfm_data_version", version));
+    archive(cereal::make_nvp("root_path", data.s_root_path));
+
+    if ((flags_part & VIEWS) == VIEWS)
+      archive(cereal::make_nvp("views", data.views));
+    else
+      archive(cereal::make_nvp("views", Views()));
+
+    if ((flags_part & INTRINSICS) == INTRINSICS)
+      archive(cereal::make_nvp("intrinsics", data.intrinsics));
+    else
+      archive(cereal::make_nvp("intrinsics", Intrinsics()));
+  }
+  return stream.good();
+}
+
+bool Load_Cereal_JSON_Head(
+  SfM_Data & data,
+  std::istream & stream,
+  ESfM_Data flags_part)
+{
+  try
+  {
+    cereal::JSONInputArchive archive(stream);
+    if ((flags_part & VIEWS) == VIEWS)
+      archive(cereal::make_nvp("views", data.views));
+    if ((flags_part & INTRINSICS) == INTRINSICS)
+      archive(cereal::make_nvp("intrinsics", data.intrinsics));
+  }
+  catch (const cereal::Exception & e)
+  {
+    std::cerr << e.what() << std::endl;
+    return false;
+  }
+  return true;
+}
+
 //
 // Explicit template instantiation
 //
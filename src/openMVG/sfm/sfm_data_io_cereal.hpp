@@ -9,6 +9,7 @@
 #ifndef OPENMVG_SFM_SFM_DATA_IO_CEREAL_HPP
 #define OPENMVG_SFM_SFM_DATA_IO_CEREAL_HPP
 
+#include <iosfwd>
 #include <string>
 
 #include "openMVG/sfm/sfm_data_io.hpp"
@@ -38,6 +39,34 @@ bool Save_Cereal(
   const std::string & filename,
   ESfM_Data flags_part);
 
+/// Save the VIEWS or the INTRINSICS of a SfM_Data scene to a stream using a
+///  Cereal portable binary archive (used by the .sfmb container sections)
+bool Save_Cereal_Part(
+  const SfM_Data & data,
+  std::ostream & stream,
+  ESfM_Data part);
+
+/// Load the VIEWS or the INTRINSICS of a SfM_Data scene from a stream written
+///  by Save_Cereal_Part
+bool Load_Cereal_Part(
+  SfM_Data & data,
+  std::istream & stream,
+  ESfM_Data part);
+
+/// Save the version, the root path, the VIEWS and the INTRINSICS of a SfM_Data
+///  scene as a Cereal JSON object (the head of the streaming JSON writer)
+bool Save_Cereal_JSON_Head(
+  const SfM_Data & data,
+  std::ostream & stream,
+  ESfM_Data flags_part);
+
+/// Load the VIEWS and the INTRINSICS of a SfM_Data scene from a Cereal JSON
+///  object (used by the streaming JSON reader)
+bool Load_Cereal_JSON_Head(
+  SfM_Data & data,
+  std::istream & stream,
+  ESfM_Data flags_part);
+
 } // namespace sfm
 } // namespace openMVG
 
@@ -0,0 +1,645 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+// The <cereal/archives> headers are special and must be included first.
+#include <cereal/archives/json.hpp>
+
+#include "openMVG/sfm/sfm_data_io_json.hpp"
+
+#include "openMVG/sfm/sfm_data.hpp"
+#include "openMVG/sfm/sfm_data_io_cereal.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace openMVG {
+namespace sfm {
+
+namespace {
+
+//
+// Writer
+//
+
+void AppendNumber(double value, std::string & buffer)
+{
+  char text[32];
+  // Integral values are written without exponent nor decimals,
+  //  the other ones with enough digits to be read back exactly.
+  const int length = (value == std::floor(value) && std::abs(value) < 1e15) ?
+    std::snprintf(text, sizeof(text), "%.0f", value) :
+    std::snprintf(text, sizeof(text), "%.17g", value);
+  buffer.append(text, length);
+}
+
+void AppendIndex(IndexT value, std::string & buffer)
+{
+  buffer += std::to_string(value);
+}
+
+template <typename VecT>
+void AppendVector(const VecT & vec, std::string & buffer)
+{
+  buffer += '[';
+  for (int i = 0; i < vec.size(); ++i)
+  {
+    if (i > 0)
+      buffer += ", ";
+    AppendNumber(vec(i), buffer);
+  }
+  buffer += ']';
+}
+
+void AppendPose(const Poses::value_type & pose_it, std::string & buffer)
+{
+  buffer += "{\"key\": ";
+  AppendIndex(pose_it.first, buffer);
+  buffer += ", \"value\": {\"rotation\": [";
+  for (int row = 0; row < 3; ++row)
+  {
+    if (row > 0)
+      buffer += ", ";
+    AppendVector(pose_it.second.rotation().row(row), buffer);
+  }
+  buffer += "], \"center\": ";
+  AppendVector(pose_it.second.center(), buffer);
+  buffer += "}}";
+}
+
+void AppendLandmark(const Landmarks::value_type & landmark_it, std::string & buffer)
+{
+  buffer += "{\"key\": ";
+  AppendIndex(landmark_it.first, buffer);
+  buffer += ", \"value\": {\"X\": ";
+  AppendVector(landmark_it.second.X, buffer);
+  buffer += ", \"observations\": [";
+  bool b_first = true;
+  for (const auto & obs_it : landmark_it.second.obs)
+  {
+    buffer += b_first ? "{\"key\": " : ", {\"key\": ";
+    b_first = false;
+    AppendIndex(obs_it.first, buffer);
+    buffer += ", \"value\": {\"id_feat\": ";
+    AppendIndex(obs_it.second.id_feat, buffer);
+    buffer += ", \"x\": ";
+    AppendVector(obs_it.second.x, buffer);
+    buffer += "}}";
+  }
+  buffer += "]}}";
+}
+
+/**
+* @brief Write the items of a map as a JSON array.
+* The items are formatted by chunks in parallel, the chunks are written in
+*  order (by batches, to bound the memory usage).
+*/
+template <typename MapT, typename AppendItem>
+void WriteArray
+(
+  std::ostream & stream,
+  const MapT & map,
+  AppendItem append_item
+)
+{
+  if (map.empty())
+  {
+    stream << "[]";
+    return;
+  }
+
+  std::vector<const typename MapT::value_type *> items;
+  items.reserve(map.size());
+  for (const auto & item : map)
+    items.push_back(&item);
+
+  const int chunk_size = 1024;
+  const int batch_size = 64; // chunks
+  const int chunk_count = static_cast<int>((items.size() + chunk_size - 1) / chunk_size);
+  std::vector<std::string> buffers(batch_size);
+
+  stream << "[\n";
+  for (int batch_begin = 0; batch_begin < chunk_count; batch_begin += batch_size)
+  {
+    const int batch_end = std::min(batch_begin + batch_size, chunk_count);
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (int chunk = batch_begin; chunk < batch_end; ++chunk)
+    {
+      std::string & buffer = buffers[chunk - batch_begin];
+      buffer.clear();
+      const std::size_t end = std::min(items.size(), std::size_t(chunk + 1) * chunk_size);
+      for (std::size_t i = std::size_t(chunk) * chunk_size; i < end; ++i)
+      {
+        buffer += "        ";
+        append_item(*items[i], buffer);
+        buffer += (i + 1 < items.size()) ? ",\n" : "\n";
+      }
+    }
+    for (int chunk = batch_begin; chunk < batch_end; ++chunk)
+      stream << buffers[chunk - batch_begin];
+  }
+  stream << "    ]";
+}
+
+//
+// Reader
+//
+
+/// Buffered pull parser of a JSON stream
+class JsonStreamReader
+{
+public:
+  explicit JsonStreamReader(std::istream & stream):
+    stream_(stream), buffer_(1 << 20), begin_(0), end_(0)
+  {}
+
+  /// Return the next character (0 at the end of the stream)
+  char PeekRaw()
+  {
+    if (begin_ == end_ && !Fill())
+      return 0;
+    return buffer_[begin_];
+  }
+
+  char GetRaw()
+  {
+    const char c = PeekRaw();
+    if (c)
+      ++begin_;
+    return c;
+  }
+
+  /// Return the next non whitespace character
+  char Peek()
+  {
+    char c = PeekRaw();
+    while (c == ' ' || c == '\n' || c == '\r' || c == '\t')
+    {
+      ++begin_;
+      c = PeekRaw();
+    }
+    return c;
+  }
+
+  char Get()
+  {
+    const char c = Peek();
+    if (c)
+      ++begin_;
+    return c;
+  }
+
+  bool ReadString(std::string & value)
+  {
+    if (Get() != '"')
+      return false;
+    value.clear();
+    for (char c = GetRaw(); c != '"'; c = GetRaw())
+    {
+      if (c == 0)
+        return false;
+      if (c != '\\')
+      {
+        value += c;
+        continue;
+      }
+      switch (c = GetRaw())
+      {
+        case 'b': value += '\b'; break;
+        case 'f': value += '\f'; break;
+        case 'n': value += '\n'; break;
+        case 'r': value += '\r'; break;
+        case 't': value += '\t'; break;
+        case 'u':
+        {
+          unsigned int code_point;
+          if (!ReadHex(code_point))
+            return false;
+          if (code_point >= 0xD800 && code_point < 0xDC00) // surrogate pair
+          {
+            unsigned int low;
+            if (GetRaw() != '\\' || GetRaw() != 'u' || !ReadHex(low))
+              return false;
+            code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+          }
+          AppendUTF8(code_point, value);
+        }
+        break;
+        case 0: return false;
+        default: value += c; // '"', '\\', '/'
+      }
+    }
+    return true;
+  }
+
+  bool ReadNumber(double & value)
+  {
+    char text[64];
+    std::size_t length = 0;
+    Peek();
+    for (char c = PeekRaw();
+         (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+         c = PeekRaw())
+    {
+      if (length + 1 == sizeof(text))
+        return false;
+      text[length++] = GetRaw();
+    }
+    text[length] = 0;
+    char * end;
+    value = std::strtod(text, &end);
+    return length > 0 && end == text + length;
+  }
+
+  bool ReadIndex(IndexT & value)
+  {
+    double number;
+    if (!ReadNumber(number) || number < 0 || number > UndefinedIndexT)
+      return false;
+    value = static_cast<IndexT>(number);
+    return value == number;
+  }
+
+  /// Skip a value, its raw text is appended to capture if not null
+  bool SkipValue(std::string * capture = nullptr)
+  {
+    const char first = Peek();
+    if (first == 0)
+      return false;
+    if (first != '{' && first != '[' && first != '"')
+    {
+      // Scalar: read up to the next delimiter
+      for (char c = PeekRaw();
+           c && c != ',' && c != '}' && c != ']' && c != ' ' && c != '\n' && c != '\r' && c != '\t';
+           c = PeekRaw())
+      {
+        if (capture)
+          *capture += c;
+        ++begin_;
+      }
+      return true;
+    }
+    int depth = 0;
+    bool b_in_string = false, b_escaped = false;
+    do
+    {
+      const char c = GetRaw();
+      if (c == 0)
+        return false;
+      if (capture)
+        *capture += c;
+      if (b_in_string)
+      {
+        if (b_escaped)
+          b_escaped = false;
+        else if (c == '\\')
+          b_escaped = true;
+        else if (c == '"')
+          b_in_string = false;
+      }
+      else if (c == '"')
+        b_in_string = true;
+      else if (c == '{' || c == '[')
+        ++depth;
+      else if (c == '}' || c == ']')
+        --depth;
+    } while (b_in_string || depth > 0);
+    return true;
+  }
+
+  /// Read an array, read_element is called for each element
+  template <typename ReadElement>
+  bool ReadArray(ReadElement read_element)
+  {
+    if (Get() != '[')
+      return false;
+    if (Peek() == ']')
+    {
+      Get();
+      return true;
+    }
+    char c;
+    do
+    {
+      if (!read_element())
+        return false;
+      c = Get();
+    } while (c == ',');
+    return c == ']';
+  }
+
+  /// Read an object, read_member is called with the name of each member
+  template <typename ReadMember>
+  bool ReadObject(ReadMember read_member)
+  {
+    if (Get() != '{')
+      return false;
+    if (Peek() == '}')
+    {
+      Get();
+      return true;
+    }
+    std::string name;
+    char c;
+    do
+    {
+      if (!ReadString(name) || Get() != ':' || !read_member(name))
+        return false;
+      c = Get();
+    } while (c == ',');
+    return c == '}';
+  }
+
+private:
+  bool Fill()
+  {
+    if (!stream_)
+      return false;
+    stream_.read(buffer_.data(), buffer_.size());
+    begin_ = 0;
+    end_ = static_cast<std::size_t>(stream_.gcount());
+    return end_ > 0;
+  }
+
+  bool ReadHex(unsigned int & value)
+  {
+    value = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+      const char c = GetRaw();
+      value <<= 4;
+      if (c >= '0' && c <= '9') value += c - '0';
+      else if (c >= 'a' && c <= 'f') value += c - 'a' + 10;
+      else if (c >= 'A' && c <= 'F') value += c - 'A' + 10;
+      else return false;
+    }
+    return true;
+  }
+
+  static void AppendUTF8(unsigned int code_point, std::string & value)
+  {
+    if (code_point < 0x80)
+      value += static_cast<char>(code_point);
+    else if (code_point < 0x800)
+    {
+      value += static_cast<char>(0xC0 | (code_point >> 6));
+      value += static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+    else if (code_point < 0x10000)
+    {
+      value += static_cast<char>(0xE0 | (code_point >> 12));
+      value += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+      value += static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+    else
+    {
+      value += static_cast<char>(0xF0 | (code_point >> 18));
+      value += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+      value += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+      value += static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+  }
+
+  std::istream & stream_;
+  std::vector<char> buffer_;
+  std::size_t begin_, end_;
+};
+
+template <typename VecT>
+bool ReadVector(JsonStreamReader & reader, VecT & vec)
+{
+  int i = 0;
+  return reader.ReadArray([&]() -> bool
+  {
+    double value;
+    if (i >= vec.size() || !reader.ReadNumber(value))
+      return false;
+    vec(i++) = value;
+    return true;
+  }) && i == vec.size();
+}
+
+/// Read a Cereal map: an array of {"key": id, "value": value} objects
+template <typename MapT, typename ReadValue>
+bool ReadMap(JsonStreamReader & reader, MapT & map, ReadValue read_value)
+{
+  return reader.ReadArray([&]() -> bool
+  {
+    IndexT key;
+    bool b_key = false;
+    typename MapT::mapped_type value;
+    if (!reader.ReadObject([&](const std::string & name) -> bool
+        {
+          if (name == "key")
+            return (b_key = reader.ReadIndex(key));
+          if (name == "value")
+            return read_value(value);
+          return reader.SkipValue();
+        }) || !b_key)
+      return false;
+    map[key] = std::move(value);
+    return true;
+  });
+}
+
+bool ReadPose(JsonStreamReader & reader, geometry::Pose3 & pose)
+{
+  Mat3 rotation;
+  Vec3 center;
+  int row = 0;
+  const bool b_ok = reader.ReadObject([&](const std::string & name) -> bool
+  {
+    if (name == "rotation")
+    {
+      return reader.ReadArray([&]() -> bool
+      {
+        if (row >= 3)
+          return false;
+        Vec3 rotation_row;
+        if (!ReadVector(reader, rotation_row))
+          return false;
+        rotation.row(row++) = rotation_row;
+        return true;
+      });
+    }
+    if (name == "center")
+      return ReadVector(reader, center);
+    return reader.SkipValue();
+  });
+  if (!b_ok || row != 3)
+    return false;
+  pose = geometry::Pose3(rotation, center);
+  return true;
+}
+
+bool ReadObservation(JsonStreamReader & reader, Observation & observation)
+{
+  return reader.ReadObject([&](const std::string & name) -> bool
+  {
+    if (name == "id_feat")
+      return reader.ReadIndex(observation.id_feat);
+    if (name == "x")
+      return ReadVector(reader, observation.x);
+    return reader.SkipValue();
+  });
+}
+
+bool ReadLandmark(JsonStreamReader & reader, Landmark & landmark)
+{
+  return reader.ReadObject([&](const std::string & name) -> bool
+  {
+    if (name == "X")
+      return ReadVector(reader, landmark.X);
+    if (name == "observations")
+    {
+      return ReadMap(reader, landmark.obs, [&](Observation & observation)
+        { return ReadObservation(reader, observation); });
+    }
+    return reader.SkipValue();
+  });
+}
+
+} // namespace
+
+bool Save_JSON(
+  const SfM_Data & sfm_data,
+  const std::string & filename,
+  ESfM_Data flags_part)
+{
+  const bool b_extrinsics = (flags_part & EXTRINSICS) == EXTRINSICS;
+  const bool b_structure = (flags_part & STRUCTURE) == STRUCTURE;
+  const bool b_control_point = (flags_part & CONTROL_POINTS) == CONTROL_POINTS;
+
+  // Serialize the head object and remove its closing brace,
+  //  the remaining members are appended to it
+  std::ostringstream head_stream;
+  if (!Save_Cereal_JSON_Head(sfm_data, head_stream, flags_part))
+    return false;
+  std::string head = head_stream.str();
+  const std::size_t head_end = head.find_last_of('}');
+  if (head_end == std::string::npos)
+    return false;
+  head.resize(head_end);
+  while (!head.empty() && std::isspace(static_cast<unsigned char>(head.back())))
+    head.pop_back();
+
+  // Use a large stream buffer to limit the write calls
+  std::vector<char> stream_buffer(1 << 22);
+  std::ofstream stream;
+  stream.rdbuf()->pubsetbuf(stream_buffer.data(), stream_buffer.size());
+  stream.open(filename.c_str(), std::ios::binary | std::ios::out);
+  if (!stream.is_open())
+    return false;
+
+  stream << head;
+
+  stream << ",\n    \"extrinsics\": ";
+  if (b_extrinsics)
+    WriteArray(stream, sfm_data.poses, AppendPose);
+  else
+    stream << "[]";
+
+  stream << ",\n    \"structure\": ";
+  if (b_structure)
+    WriteArray(stream, sfm_data.structure, AppendLandmark);
+  else
+    stream << "[]";
+
+  stream << ",\n    \"control_points\": ";
+  if (b_control_point)
+    WriteArray(stream, sfm_data.control_points, AppendLandmark);
+  else
+    stream << "[]";
+
+  stream << "\n}\n";
+  stream.close();
+  return !stream.fail();
+}
+
+bool Load_JSON(
+  SfM_Data & sfm_data,
+  const std::string & filename,
+  ESfM_Data flags_part)
+{
+  const bool b_views = (flags_part & VIEWS) == VIEWS;
+  const bool b_intrinsics = (flags_part & INTRINSICS) == INTRINSICS;
+  const bool b_extrinsics = (flags_part & EXTRINSICS) == EXTRINSICS;
+  const bool b_structure = (flags_part & STRUCTURE) == STRUCTURE;
+  const bool b_control_point = (flags_part & CONTROL_POINTS) == CONTROL_POINTS;
+
+  std::ifstream stream(filename.c_str(), std::ios::binary | std::ios::in);
+  if (!stream.is_open())
+    return false;
+
+  // The views and the intrinsics are captured and deserialized by Cereal
+  std::string head;
+  bool b_legacy_version = false;
+
+  JsonStreamReader reader(stream);
+  const bool b_ok = reader.ReadObject([&](const std::string & name) -> bool
+  {
+    if (name == "sfm_data_version")
+    {
+      std::string version;
+      if (!reader.ReadString(version))
+        return false;
+      b_legacy_version = version < "0.3";
+      return !b_legacy_version;
+    }
+    if (name == "root_path")
+      return reader.ReadString(sfm_data.s_root_path);
+    if ((name == "views" && b_views) || (name == "intrinsics" && b_intrinsics))
+    {
+      head += head.empty() ? "{\"" : ",\"";
+      head += name + "\":";
+      return reader.SkipValue(&head);
+    }
+    if (name == "extrinsics" && b_extrinsics)
+    {
+      return ReadMap(reader, sfm_data.poses, [&](geometry::Pose3 & pose)
+        { return ReadPose(reader, pose); });
+    }
+    if ((name == "structure" && b_structure) || (name == "control_points" && b_control_point))
+    {
+      return ReadMap(reader,
+        name == "structure" ? sfm_data.structure : sfm_data.control_points,
+        [&](Landmark & landmark) { return ReadLandmark(reader, landmark); });
+    }
+    return reader.SkipValue();
+  });
+
+  if (b_legacy_version)
+  {
+    // The views of the previous versions are not polymorphic
+    stream.close();
+    return Load_Cereal<cereal::JSONInputArchive>(sfm_data, filename, flags_part);
+  }
+  if (!b_ok)
+  {
+    std::cerr << "Invalid sfm_data JSON file: " << filename << std::endl;
+    return false;
+  }
+  if (!head.empty())
+  {
+    head += '}';
+    std::istringstream head_stream(head);
+    return Load_Cereal_JSON_Head(sfm_data, head_stream, flags_part);
+  }
+  return true;
+}
+
+} // namespace sfm
+} // namespace openMVG
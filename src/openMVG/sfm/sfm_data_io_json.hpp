@@ -0,0 +1,48 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_SFM_SFM_DATA_IO_JSON_HPP
+#define OPENMVG_SFM_SFM_DATA_IO_JSON_HPP
+
+#include <string>
+
+#include "openMVG/sfm/sfm_data_io.hpp"
+
+namespace openMVG {
+namespace sfm {
+
+struct SfM_Data;
+
+/// Streaming JSON SfM_Data serialization
+//--
+// The files use the Cereal JSON layout (they are interchangeable with the
+//  files written and read by the Cereal JSON archives):
+// - the version, the root path, the views and the intrinsics (small and
+//    polymorphic) are serialized by Cereal,
+// - the poses and the landmarks are formatted by chunks in parallel and the
+//    chunks are written in order. They are parsed while the file is read,
+//    without building a document.
+//--
+
+/// Save a SfM_Data scene to a JSON file
+bool Save_JSON(
+  const SfM_Data & sfm_data,
+  const std::string & filename,
+  ESfM_Data flags_part);
+
+/// Load a SfM_Data scene from a JSON file
+/// (the files older than the 0.3 version are loaded by Cereal)
+bool Load_JSON(
+  SfM_Data & sfm_data,
+  const std::string & filename,
+  ESfM_Data flags_part);
+
+} // namespace sfm
+} // namespace openMVG
+
+#endif // OPENMVG_SFM_SFM_DATA_IO_JSON_HPP
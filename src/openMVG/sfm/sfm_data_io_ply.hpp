@@ -9,175 +9,388 @@
 #ifndef OPENMVG_SFM_SFM_DATA_IO_PLY_HPP
 #define OPENMVG_SFM_SFM_DATA_IO_PLY_HPP
 
+#include "openMVG/sfm/sfm_data.hpp"
 #include "openMVG/sfm/sfm_data_io.hpp"
+#include "openMVG/sfm/sfm_view_priors.hpp"
 
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
-#include <iomanip>
-#include <limits>
+#include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace openMVG {
 namespace sfm {
 
-/// Save the structure and camera positions of a SfM_Data container as 3D points in a PLY ASCII/BIN file.
-inline bool Save_PLY
+/// RGB color of a PLY vertex
+using Vec3uc = Eigen::Matrix<unsigned char, 3, 1>;
+
+/**
+* @brief Save colored 3D points in a PLY file (double x,y,z and uchar red,green,blue).
+* The vertices are packed (binary little endian) or formatted (ASCII) by chunks
+*  in parallel and the chunks are written in order with large writes.
+* @param[in] filename The PLY file
+* @param[in] vertex_count The number of vertices
+* @param[in] vertex Functor (std::size_t i, Vec3 & X, Vec3uc & color) that
+*   returns the i-th vertex, it is called concurrently
+* @param[in] b_write_in_ascii ASCII or binary little endian PLY file
+*/
+template <typename VertexFunctor>
+bool Save_PLY_Vertices
 (
-  const SfM_Data & sfm_data,
   const std::string & filename,
-  ESfM_Data flags_part,
+  std::size_t vertex_count,
+  VertexFunctor vertex,
   bool b_write_in_ascii = false
 )
 {
-  const bool b_structure = (flags_part & STRUCTURE) == STRUCTURE;
-  const bool b_control_points = (flags_part & CONTROL_POINTS) == CONTROL_POINTS;
-  const bool b_extrinsics = (flags_part & EXTRINSICS) == EXTRINSICS;
+  // Use a large stream buffer to limit the write calls
+  std::vector<char> stream_buffer(1 << 22);
+  std::ofstream stream;
+  stream.rdbuf()->pubsetbuf(stream_buffer.data(), stream_buffer.size());
+  stream.open(filename.c_str(), std::ios::out | std::ios::binary);
+  if (!stream.is_open())
+    return false;
 
-  if (!(b_structure || b_extrinsics || b_control_points))
-    return false; // No 3D points to display, so it would produce an empty PLY file
+  stream << "ply"
+    << '\n' << "format "
+            << (b_write_in_ascii ? "ascii 1.0" : "binary_little_endian 1.0")
+    << '\n' << "comment generated by OpenMVG"
+    << '\n' << "element vertex " << vertex_count
+    << '\n' << "property double x"
+    << '\n' << "property double y"
+    << '\n' << "property double z"
+    << '\n' << "property uchar red"
+    << '\n' << "property uchar green"
+    << '\n' << "property uchar blue"
+    << '\n' << "end_header" << '\n';
 
-  // Create the stream and check its status
-  std::ofstream stream(filename.c_str(), std::ios::out | std::ios::binary);
-  if (!stream.is_open())
+  // The binary vertices are stored in the host byte order
+  const uint16_t byte_order_test = 1;
+  if (!b_write_in_ascii && *reinterpret_cast<const unsigned char*>(&byte_order_test) != 1)
     return false;
 
-  bool bOk = false;
+  const int chunk_size = 16384; // vertices
+  const int batch_size = 64; // chunks
+  const int chunk_count = static_cast<int>((vertex_count + chunk_size - 1) / chunk_size);
+  const std::size_t binary_vertex_size = sizeof(Vec3) + sizeof(Vec3uc);
+  std::vector<std::string> buffers(std::min(batch_size, chunk_count));
+
+  for (int batch_begin = 0; batch_begin < chunk_count; batch_begin += batch_size)
   {
-    // Count how many views having valid poses:
-    IndexT view_with_pose_count = 0;
-    IndexT view_with_pose_prior_count = 0;
-    if (b_extrinsics)
+    const int batch_end = std::min(batch_begin + batch_size, chunk_count);
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (int chunk = batch_begin; chunk < batch_end; ++chunk)
     {
-      for (const auto & view : sfm_data.GetViews())
-      {
-        view_with_pose_count += sfm_data.IsPoseAndIntrinsicDefined(view.second.get());
-      }
+      const std::size_t begin = std::size_t(chunk) * chunk_size;
+      const std::size_t end = std::min(vertex_count, begin + chunk_size);
+      std::string & buffer = buffers[chunk - batch_begin];
+      buffer.clear();
+      if (!b_write_in_ascii)
+        buffer.resize((end - begin) * binary_vertex_size);
 
-      for (const auto & view : sfm_data.GetViews())
+      Vec3 X;
+      Vec3uc color;
+      // Longest line: 3 x "%.16f" (sign, 309 digits, point, 16 decimals),
+      //  3 x "%d" of an unsigned char, the separators and the new line
+      char text[3 * (1 + 309 + 1 + 16 + 1) + 3 * (3 + 1) + 1];
+      for (std::size_t i = begin; i < end; ++i)
       {
-        if (const sfm::ViewPriors *prior = dynamic_cast<sfm::ViewPriors*>(view.second.get()))
+        vertex(i, X, color);
+        if (b_write_in_ascii)
         {
-            view_with_pose_prior_count += prior->b_use_pose_center_;
+          const int length = std::snprintf(text, sizeof(text), "%.16f %.16f %.16f %d %d %d\n",
+            X(0), X(1), X(2), int(color(0)), int(color(1)), int(color(2)));
+          if (length > 0)
+            buffer.append(text, std::min(static_cast<std::size_t>(length), sizeof(text) - 1));
+        }
+        else
+        {
+          char * data = &buffer[(i - begin) * binary_vertex_size];
+          std::memcpy(data, X.data(), sizeof(Vec3));
+          std::memcpy(data + sizeof(Vec3), color.data(), sizeof(Vec3uc));
         }
       }
     }
+    for (int chunk = batch_begin; chunk < batch_end; ++chunk)
+      stream.write(buffers[chunk - batch_begin].data(), buffers[chunk - batch_begin].size());
+  }
+
+  stream.flush();
+  const bool bOk = stream.good();
+  stream.close();
+  return bOk;
+}
+
+/**
+* @brief Load the 3D points (and their colors) of a PLY file.
+* ASCII and binary little endian files are supported, the vertex element must
+*  be the first element of the file. The vertices are parsed in parallel.
+* @param[in] filename The PLY file
+* @param[out] points The vertex positions
+* @param[out] colors The vertex colors (white if the file has no red, green,
+*   blue properties), not loaded if nullptr
+*/
+inline bool Load_PLY_Vertices
+(
+  const std::string & filename,
+  std::vector<Vec3> & points,
+  std::vector<Vec3uc> * colors = nullptr
+)
+{
+  std::ifstream stream(filename.c_str(), std::ios::in | std::ios::binary);
+  if (!stream.is_open())
+    return false;
 
-    stream << std::fixed << std::setprecision (std::numeric_limits<double>::digits10 + 1);
-
-    using Vec3uc = Eigen::Matrix<unsigned char, 3, 1>;
-
-    stream << "ply"
-      << '\n' << "format "
-              << (b_write_in_ascii ? "ascii 1.0" : "binary_little_endian 1.0")
-      << '\n' << "comment generated by OpenMVG"
-      << '\n' << "element vertex "
-        // Vertex count: (#landmark + #GCP + #view_with_valid_pose)
-        << (  (b_structure ? sfm_data.GetLandmarks().size() : 0)
-            + (b_control_points ? sfm_data.GetControl_Points().size() : 0)
-            + view_with_pose_count
-            + view_with_pose_prior_count)
-      << '\n' << "property double x"
-      << '\n' << "property double y"
-      << '\n' << "property double z"
-      << '\n' << "property uchar red"
-      << '\n' << "property uchar green"
-      << '\n' << "property uchar blue"
-      << '\n' << "end_header" << std::endl;
-
-      if (b_extrinsics)
+  // Parse the header
+  std::string line, format;
+  std::size_t vertex_count = 0;
+  bool b_vertex_element = false, b_first_element = true;
+  struct Property { std::string name; char type; std::size_t size; };
+  std::vector<Property> properties;
+  const auto property_type = [](const std::string & type, std::size_t & size)
+  {
+    static const std::pair<const char *, char> types[] =
+    {
+      {"char", 'c'}, {"int8", 'c'}, {"uchar", 'C'}, {"uint8", 'C'},
+      {"short", 's'}, {"int16", 's'}, {"ushort", 'S'}, {"uint16", 'S'},
+      {"int", 'i'}, {"int32", 'i'}, {"uint", 'I'}, {"uint32", 'I'},
+      {"float", 'f'}, {"float32", 'f'}, {"double", 'd'}, {"float64", 'd'}
+    };
+    for (const auto & type_it : types)
+    {
+      if (type == type_it.first)
       {
-        for (const auto & view : sfm_data.GetViews())
-        {
-          // Export pose as Green points
-          if (sfm_data.IsPoseAndIntrinsicDefined(view.second.get()))
-          {
-            const geometry::Pose3 pose = sfm_data.GetPoseOrDie(view.second.get());
-            if (b_write_in_ascii)
-            {
-              stream
-                << pose.center()(0) << ' '
-                << pose.center()(1) << ' '
-                << pose.center()(2) << ' '
-                << "0 255 0\n";
-            }
-            else
-            {
-              stream.write( reinterpret_cast<const char*> ( pose.center().data() ), sizeof( Vec3 ) );
-              stream.write( reinterpret_cast<const char*> ( Vec3uc(0, 255, 0).data() ), sizeof( Vec3uc ) );
-            }
-          }
-
-          // Export pose priors as Blue points
-          if (const sfm::ViewPriors *prior = dynamic_cast<sfm::ViewPriors*>(view.second.get()))
-          {
-            if (prior->b_use_pose_center_)
-            {
-              if (b_write_in_ascii)
-              {
-                stream
-                  << prior->pose_center_(0) << ' '
-                  << prior->pose_center_(1) << ' '
-                  << prior->pose_center_(2) << ' '
-                  << "0 0 255\n";
-              }
-              else
-              {
-                stream.write( reinterpret_cast<const char*> ( prior->pose_center_.data() ), sizeof( Vec3 ) );
-                stream.write( reinterpret_cast<const char*> ( Vec3uc(0, 0, 255).data() ), sizeof( Vec3uc ) );
-              }
-            }
-          }
-        }
+        const char c = type_it.second;
+        size = (c == 'c' || c == 'C') ? 1 : (c == 's' || c == 'S') ? 2 : (c == 'd') ? 8 : 4;
+        return c;
+      }
+    }
+    return char(0);
+  };
+  if (!std::getline(stream, line) || line.compare(0, 3, "ply") != 0)
+    return false;
+  while (std::getline(stream, line))
+  {
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+    std::istringstream line_stream(line);
+    std::string keyword;
+    line_stream >> keyword;
+    if (keyword == "end_header")
+      break;
+    else if (keyword == "format")
+      line_stream >> format;
+    else if (keyword == "element")
+    {
+      std::string name;
+      line_stream >> name;
+      b_vertex_element = (name == "vertex");
+      if (b_vertex_element)
+      {
+        if (!b_first_element)
+          return false; // The vertices must come first
+        line_stream >> vertex_count;
+      }
+      b_first_element = false;
+    }
+    else if (keyword == "property" && b_vertex_element)
+    {
+      Property property;
+      std::string type;
+      line_stream >> type >> property.name;
+      property.type = property_type(type, property.size);
+      if (property.type == 0)
+        return false; // list properties are not supported for the vertices
+      properties.push_back(property);
+    }
+  }
+  const bool b_ascii = (format == "ascii");
+  if (!stream || (!b_ascii && format != "binary_little_endian"))
+    return false;
+
+  // Index of the x, y, z, red, green, blue properties
+  int indexes[6] = {-1, -1, -1, -1, -1, -1};
+  std::vector<std::size_t> offsets(properties.size() + 1, 0);
+  const char * names[6] = {"x", "y", "z", "red", "green", "blue"};
+  for (std::size_t p = 0; p < properties.size(); ++p)
+  {
+    offsets[p + 1] = offsets[p] + properties[p].size;
+    for (int i = 0; i < 6; ++i)
+      if (properties[p].name == names[i])
+        indexes[i] = static_cast<int>(p);
+  }
+  if (indexes[0] < 0 || indexes[1] < 0 || indexes[2] < 0)
+    return false;
+  const bool b_colors = indexes[3] >= 0 && indexes[4] >= 0 && indexes[5] >= 0;
+  const std::size_t vertex_size = offsets.back();
+
+  // Read the vertex data
+  std::vector<char> data;
+  std::vector<std::size_t> line_begins;
+  if (b_ascii)
+  {
+    const std::streampos data_begin = stream.tellg();
+    stream.seekg(0, std::ios::end);
+    data.resize(static_cast<std::size_t>(stream.tellg() - data_begin) + 1, '\0');
+    stream.seekg(data_begin);
+    stream.read(data.data(), data.size() - 1);
+    // List the vertex lines
+    line_begins.reserve(vertex_count);
+    std::size_t begin = 0;
+    while (line_begins.size() < vertex_count && begin + 1 < data.size())
+    {
+      line_begins.push_back(begin);
+      const char * end = static_cast<const char*>(
+        std::memchr(data.data() + begin, '\n', data.size() - 1 - begin));
+      begin = end ? (end - data.data()) + 1 : data.size() - 1;
+    }
+    if (line_begins.size() != vertex_count)
+      return false;
+  }
+  else
+  {
+    const uint16_t byte_order_test = 1;
+    if (*reinterpret_cast<const unsigned char*>(&byte_order_test) != 1)
+      return false; // The binary data is read in the host byte order
+    data.resize(vertex_count * vertex_size);
+    if (!stream.read(data.data(), data.size()))
+      return false;
+  }
+
+  points.resize(vertex_count);
+  if (colors)
+    colors->assign(vertex_count, Vec3uc(255, 255, 255));
+
+  // Binary value of a property
+  const auto binary_value = [](const char * value, char type) -> double
+  {
+    switch (type)
+    {
+      case 'c': { int8_t v; std::memcpy(&v, value, 1); return v; }
+      case 'C': { uint8_t v; std::memcpy(&v, value, 1); return v; }
+      case 's': { int16_t v; std::memcpy(&v, value, 2); return v; }
+      case 'S': { uint16_t v; std::memcpy(&v, value, 2); return v; }
+      case 'i': { int32_t v; std::memcpy(&v, value, 4); return v; }
+      case 'I': { uint32_t v; std::memcpy(&v, value, 4); return v; }
+      case 'f': { float v; std::memcpy(&v, value, 4); return v; }
+      default: { double v; std::memcpy(&v, value, 8); return v; }
+    }
+  };
+
+  bool bOk = true;
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for schedule(static) reduction(&&:bOk)
+#endif
+  for (int i = 0; i < static_cast<int>(vertex_count); ++i)
+  {
+    double values[6] = {0, 0, 0, 255, 255, 255};
+    if (b_ascii)
+    {
+      // Parse the properties up to the last needed one
+      const char * text = data.data() + line_begins[i];
+      const int last_index = *std::max_element(indexes, indexes + (b_colors ? 6 : 3));
+      for (int p = 0; p <= last_index && bOk; ++p)
+      {
+        char * end;
+        const double value = std::strtod(text, &end);
+        bOk = (end != text);
+        text = end;
+        for (int k = 0; k < 6; ++k)
+          if (indexes[k] == p)
+            values[k] = value;
       }
+    }
+    else
+    {
+      const char * vertex_data = data.data() + std::size_t(i) * vertex_size;
+      for (int k = 0; k < (b_colors ? 6 : 3); ++k)
+        values[k] = binary_value(vertex_data + offsets[indexes[k]], properties[indexes[k]].type);
+    }
+    points[i] = Vec3(values[0], values[1], values[2]);
+    if (colors)
+      (*colors)[i] = Vec3(values[3], values[4], values[5]).cast<unsigned char>();
+  }
+  return bOk;
+}
+
+/// Save the structure and camera positions of a SfM_Data container as 3D points in a PLY ASCII/BIN file.
+inline bool Save_PLY
+(
+  const SfM_Data & sfm_data,
+  const std::string & filename,
+  ESfM_Data flags_part,
+  bool b_write_in_ascii = false
+)
+{
+  const bool b_structure = (flags_part & STRUCTURE) == STRUCTURE;
+  const bool b_control_points = (flags_part & CONTROL_POINTS) == CONTROL_POINTS;
+  const bool b_extrinsics = (flags_part & EXTRINSICS) == EXTRINSICS;
 
-      if (b_structure)
+  if (!(b_structure || b_extrinsics || b_control_points))
+    return false; // No 3D points to display, so it would produce an empty PLY file
+
+  // List the vertices:
+  // - the poses as Green points and the pose priors as Blue points,
+  // - the structure points as White points,
+  // - the GCP as Red points.
+  std::vector<std::pair<Vec3, Vec3uc>> camera_vertices;
+  if (b_extrinsics)
+  {
+    for (const auto & view : sfm_data.GetViews())
+    {
+      if (sfm_data.IsPoseAndIntrinsicDefined(view.second.get()))
       {
-        // Export structure points as White points
-        const Landmarks & landmarks = sfm_data.GetLandmarks();
-        for ( const auto & iterLandmarks : landmarks )
-        {
-          if (b_write_in_ascii)
-          {
-            stream
-              << iterLandmarks.second.X(0) << ' '
-              << iterLandmarks.second.X(1) << ' '
-              << iterLandmarks.second.X(2) << ' '
-              << "255 255 255\n";
-          }
-          else
-          {
-            stream.write( reinterpret_cast<const char*> ( iterLandmarks.second.X.data() ), sizeof( Vec3 ) );
-            stream.write( reinterpret_cast<const char*> ( Vec3uc(255, 255, 255).data() ), sizeof( Vec3uc ) );
-          }
-        }
+        const geometry::Pose3 pose = sfm_data.GetPoseOrDie(view.second.get());
+        camera_vertices.emplace_back(pose.center(), Vec3uc(0, 255, 0));
       }
 
-      if (b_control_points)
+      if (const sfm::ViewPriors *prior = dynamic_cast<sfm::ViewPriors*>(view.second.get()))
       {
-        // Export GCP as Red points
-        const Landmarks & landmarks = sfm_data.GetControl_Points();
-        for ( const auto & iterGCP : landmarks )
-        {
-          if (b_write_in_ascii)
-          {
-            stream
-              << iterGCP.second.X(0) << ' '
-              << iterGCP.second.X(1) << ' '
-              << iterGCP.second.X(2) << ' '
-              << "255 0 0\n";
-          }
-          else
-          {
-            stream.write( reinterpret_cast<const char*> ( iterGCP.second.X.data() ), sizeof( Vec3 ) );
-            stream.write( reinterpret_cast<const char*> ( Vec3uc(255, 0, 0).data() ), sizeof( Vec3uc ) );
-          }
-        }
+        if (prior->b_use_pose_center_)
+          camera_vertices.emplace_back(prior->pose_center_, Vec3uc(0, 0, 255));
       }
+    }
+  }
 
-      stream.flush();
-      bOk = stream.good();
-      stream.close();
+  std::vector<const Vec3 *> points;
+  points.reserve(
+      (b_structure ? sfm_data.GetLandmarks().size() : 0)
+    + (b_control_points ? sfm_data.GetControl_Points().size() : 0));
+  if (b_structure)
+  {
+    for (const auto & iterLandmarks : sfm_data.GetLandmarks())
+      points.push_back(&iterLandmarks.second.X);
   }
-  return bOk;
+  const std::size_t control_points_begin = points.size();
+  if (b_control_points)
+  {
+    for (const auto & iterGCP : sfm_data.GetControl_Points())
+      points.push_back(&iterGCP.second.X);
+  }
+
+  return Save_PLY_Vertices(
+    filename,
+    camera_vertices.size() + points.size(),
+    [&](std::size_t i, Vec3 & X, Vec3uc & color)
+    {
+      if (i < camera_vertices.size())
+      {
+        X = camera_vertices[i].first;
+        color = camera_vertices[i].second;
+        return;
+      }
+      i -= camera_vertices.size();
+      X = *points[i];
+      color = (i < control_points_begin) ? Vec3uc(255, 255, 255) : Vec3uc(255, 0, 0);
+    },
+    b_write_in_ascii);
 }
 
 } // namespace sfm
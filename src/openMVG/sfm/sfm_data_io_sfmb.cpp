@@ -0,0 +1,681 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/sfm/sfm_data_io_sfmb.hpp"
+
+#include "openMVG/sfm/sfm_data.hpp"
+#include "openMVG/sfm/sfm_data_io_cereal.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace openMVG {
+namespace sfm {
+
+namespace {
+
+const char kMagic[8] = {'O', 'M', 'V', 'G', 'S', 'F', 'M', 'B'};
+const uint32_t kVersion = 1;
+const uint32_t kByteOrderTag = 0x01020304;
+/// Alignment of the sections and of their columns
+const uint64_t kAlignment = 64;
+/// Section type of the metadata (the other types are ESfM_Data values)
+const uint32_t kMetadataSection = 0;
+
+struct FileHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint32_t section_count;
+  uint32_t reserved;
+};
+
+struct Section
+{
+  uint32_t type;
+  uint32_t reserved;
+  uint64_t offset;
+  uint64_t size;
+};
+
+static_assert(sizeof(FileHeader) == 24 && sizeof(Section) == 24,
+  "The .sfmb header structures must not be padded");
+
+inline uint64_t Align(uint64_t offset)
+{
+  return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+inline bool IsLittleEndian()
+{
+  const uint32_t value = 1;
+  char first_byte;
+  std::memcpy(&first_byte, &value, 1);
+  return first_byte == 1;
+}
+
+/// Read and check the file header and the section table
+/// (the sections must lie in the file)
+bool ReadSectionTable(std::istream & stream, std::vector<Section> & sections)
+{
+  FileHeader header;
+  if (!stream.read(reinterpret_cast<char*>(&header), sizeof(FileHeader)) ||
+      std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0)
+  {
+    std::cerr << "Invalid .sfmb file header" << std::endl;
+    return false;
+  }
+  if (header.version != kVersion)
+  {
+    std::cerr << "Unsupported .sfmb version: " << header.version << std::endl;
+    return false;
+  }
+  if (header.byte_order != kByteOrderTag)
+  {
+    std::cerr << "Unsupported .sfmb byte order" << std::endl;
+    return false;
+  }
+
+  const std::istream::pos_type table_position = stream.tellg();
+  if (!stream.seekg(0, std::ios::end))
+    return false;
+  const uint64_t file_size = static_cast<uint64_t>(stream.tellg());
+  if (!stream.seekg(table_position) ||
+      header.section_count > (file_size - sizeof(FileHeader)) / sizeof(Section))
+  {
+    std::cerr << "Invalid .sfmb section table" << std::endl;
+    return false;
+  }
+  sections.resize(header.section_count);
+  if (!stream.read(reinterpret_cast<char*>(sections.data()),
+                   sections.size() * sizeof(Section)))
+    return false;
+  for (const Section & section : sections)
+  {
+    if (section.offset > file_size || section.size > file_size - section.offset)
+    {
+      std::cerr << "Invalid .sfmb section range: " << section.type << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+const Section * FindSection(const std::vector<Section> & sections, uint32_t type)
+{
+  const auto it = std::find_if(sections.cbegin(), sections.cend(),
+    [type](const Section & section) { return section.type == type; });
+  return it != sections.cend() ? &(*it) : nullptr;
+}
+
+/// Raw memory output (same interface as std::ostream::write)
+struct MemoryStream
+{
+  char * cursor;
+
+  void write(const char * data, std::streamsize size)
+  {
+    std::memcpy(cursor, data, size);
+    cursor += size;
+  }
+};
+
+/// Sequential buffered writer of the columns of a section
+template <typename OStream>
+class SectionWriter
+{
+public:
+  explicit SectionWriter(OStream & stream): stream_(stream), position_(0)
+  {
+    buffer_.reserve(1 << 20);
+  }
+
+  ~SectionWriter() { Flush(); }
+
+  template <typename T>
+  void Write(const T * data, std::size_t count)
+  {
+    const std::size_t size = count * sizeof(T);
+    if (buffer_.size() + size > buffer_.capacity())
+      Flush();
+    buffer_.insert(buffer_.end(),
+      reinterpret_cast<const char*>(data), reinterpret_cast<const char*>(data) + size);
+    position_ += size;
+  }
+
+  /// Pad with zeros up to a section offset
+  void Seek(uint64_t offset)
+  {
+    static const char zeros[kAlignment] = {0};
+    while (position_ < offset)
+      Write(zeros, std::min<uint64_t>(offset - position_, kAlignment));
+  }
+
+  void Flush()
+  {
+    if (!buffer_.empty())
+      stream_.write(buffer_.data(), buffer_.size());
+    buffer_.clear();
+  }
+
+private:
+  OStream & stream_;
+  uint64_t position_;
+  std::vector<char> buffer_;
+};
+
+/// Write a landmark section (see Landmarks_Columnar::Layout)
+template <typename OStream>
+void WriteLandmarkSection(const Landmarks & landmarks, OStream & stream)
+{
+  std::vector<const Landmarks::value_type *> sorted_landmarks;
+  sorted_landmarks.reserve(landmarks.size());
+  uint64_t counts[2] = {landmarks.size(), 0};
+  for (const auto & landmark_it : landmarks)
+  {
+    sorted_landmarks.push_back(&landmark_it);
+    counts[1] += landmark_it.second.obs.size();
+  }
+  std::sort(sorted_landmarks.begin(), sorted_landmarks.end(),
+    [](const Landmarks::value_type * a, const Landmarks::value_type * b)
+    { return a->first < b->first; });
+  const Landmarks_Columnar::Layout layout(counts[0], counts[1]);
+
+  SectionWriter<OStream> writer(stream);
+  writer.Write(counts, 2);
+
+  writer.Seek(layout.ids);
+  for (const auto * landmark_it : sorted_landmarks)
+    writer.Write(&landmark_it->first, 1);
+
+  writer.Seek(layout.X);
+  for (const auto * landmark_it : sorted_landmarks)
+    writer.Write(landmark_it->second.X.data(), 3);
+
+  writer.Seek(layout.observation_offsets);
+  uint64_t offset = 0;
+  writer.Write(&offset, 1);
+  for (const auto * landmark_it : sorted_landmarks)
+  {
+    offset += landmark_it->second.obs.size();
+    writer.Write(&offset, 1);
+  }
+
+  // The observation columns are written by ascending view ids
+  std::vector<std::pair<IndexT, const Observation *>> observations;
+  const auto sorted_observations = [&observations](const Landmark & landmark)
+    -> const std::vector<std::pair<IndexT, const Observation *>> &
+  {
+    observations.clear();
+    for (const auto & obs_it : landmark.obs)
+      observations.emplace_back(obs_it.first, &obs_it.second);
+    std::sort(observations.begin(), observations.end());
+    return observations;
+  };
+
+  writer.Seek(layout.observation_view_ids);
+  for (const auto * landmark_it : sorted_landmarks)
+    for (const auto & obs : sorted_observations(landmark_it->second))
+      writer.Write(&obs.first, 1);
+
+  writer.Seek(layout.observation_feat_ids);
+  for (const auto * landmark_it : sorted_landmarks)
+    for (const auto & obs : sorted_observations(landmark_it->second))
+      writer.Write(&obs.second->id_feat, 1);
+
+  writer.Seek(layout.observation_x);
+  for (const auto * landmark_it : sorted_landmarks)
+    for (const auto & obs : sorted_observations(landmark_it->second))
+      writer.Write(obs.second->x.data(), 2);
+
+  writer.Seek(layout.size);
+}
+
+/// Column layout of the EXTRINSICS section:
+///  a header (pose count), ids, rotations (column major), centers
+struct PosesLayout
+{
+  explicit PosesLayout(uint64_t pose_count):
+    ids(kAlignment),
+    rotations(Align(ids + pose_count * sizeof(IndexT))),
+    centers(Align(rotations + pose_count * 9 * sizeof(double))),
+    size(Align(centers + pose_count * 3 * sizeof(double)))
+  {}
+
+  uint64_t ids, rotations, centers, size;
+};
+
+void WritePosesSection(const Poses & poses, std::ostream & stream)
+{
+  std::vector<const Poses::value_type *> sorted_poses;
+  sorted_poses.reserve(poses.size());
+  for (const auto & pose_it : poses)
+    sorted_poses.push_back(&pose_it);
+  std::sort(sorted_poses.begin(), sorted_poses.end(),
+    [](const Poses::value_type * a, const Poses::value_type * b)
+    { return a->first < b->first; });
+  const uint64_t pose_count = sorted_poses.size();
+  const PosesLayout layout(pose_count);
+
+  SectionWriter<std::ostream> writer(stream);
+  writer.Write(&pose_count, 1);
+  writer.Seek(layout.ids);
+  for (const auto * pose_it : sorted_poses)
+    writer.Write(&pose_it->first, 1);
+  writer.Seek(layout.rotations);
+  for (const auto * pose_it : sorted_poses)
+    writer.Write(pose_it->second.rotation().data(), 9);
+  writer.Seek(layout.centers);
+  for (const auto * pose_it : sorted_poses)
+    writer.Write(pose_it->second.center().data(), 3);
+  writer.Seek(layout.size);
+}
+
+bool ReadPosesSection(std::istream & stream, uint64_t section_size, Poses & poses)
+{
+  std::vector<uint64_t> buffer((section_size + 7) / 8);
+  if (!stream.read(reinterpret_cast<char*>(buffer.data()), section_size))
+    return false;
+  const char * section = reinterpret_cast<const char*>(buffer.data());
+
+  const uint64_t pose_count = buffer.empty() ? 0 : buffer[0];
+  // The count is bounded by the section size (no overflow of the layout)
+  if (pose_count > section_size / (sizeof(IndexT) + 12 * sizeof(double)))
+    return false;
+  const PosesLayout layout(pose_count);
+  if (section_size < layout.size)
+    return false;
+  const IndexT * ids = reinterpret_cast<const IndexT*>(section + layout.ids);
+  const double * rotations = reinterpret_cast<const double*>(section + layout.rotations);
+  const double * centers = reinterpret_cast<const double*>(section + layout.centers);
+  for (uint64_t i = 0; i < pose_count; ++i)
+  {
+    poses[ids[i]] = geometry::Pose3(
+      Eigen::Map<const Mat3>(rotations + 9 * i),
+      Eigen::Map<const Vec3>(centers + 3 * i));
+  }
+  return true;
+}
+
+} // namespace
+
+/// The memory of a landmark section: an owned buffer or a mapped file range
+struct Landmarks_Columnar::Storage
+{
+  /// Owned buffer (uint64_t for the column alignment)
+  std::vector<uint64_t> buffer;
+  void * mapped_address = nullptr;
+  std::size_t mapped_length = 0;
+
+  ~Storage()
+  {
+    if (mapped_address)
+    {
+#ifdef _WIN32
+      UnmapViewOfFile(mapped_address);
+#else
+      munmap(mapped_address, mapped_length);
+#endif
+    }
+  }
+
+  char * Allocate(uint64_t size)
+  {
+    buffer.resize((size + 7) / 8);
+    return reinterpret_cast<char*>(buffer.data());
+  }
+
+  /// Map (read only) a file range, return nullptr on failure
+  const char * Map(const std::string & filename, uint64_t offset, uint64_t size)
+  {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+      nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+      return nullptr;
+    LARGE_INTEGER file_size;
+    HANDLE mapping = nullptr;
+    if (GetFileSizeEx(file, &file_size) &&
+        static_cast<uint64_t>(file_size.QuadPart) >= offset + size)
+      mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file); // the mapping keeps a reference to the file
+    if (!mapping)
+      return nullptr;
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+    const uint64_t begin =
+      offset / system_info.dwAllocationGranularity * system_info.dwAllocationGranularity;
+    void * address = MapViewOfFile(mapping, FILE_MAP_READ,
+      static_cast<DWORD>(begin >> 32), static_cast<DWORD>(begin & 0xFFFFFFFF),
+      static_cast<SIZE_T>(offset + size - begin));
+    CloseHandle(mapping); // the view keeps a reference to the mapping
+    if (!address)
+      return nullptr;
+#else
+    const int file = open(filename.c_str(), O_RDONLY);
+    if (file < 0)
+      return nullptr;
+    struct stat file_stat;
+    if (fstat(file, &file_stat) != 0 ||
+        static_cast<uint64_t>(file_stat.st_size) < offset + size)
+    {
+      close(file);
+      return nullptr;
+    }
+    const uint64_t page_size = sysconf(_SC_PAGESIZE);
+    const uint64_t begin = offset / page_size * page_size;
+    void * address = mmap(nullptr, offset + size - begin, PROT_READ, MAP_PRIVATE,
+                          file, static_cast<off_t>(begin));
+    close(file); // the mapping keeps a reference to the file
+    if (address == MAP_FAILED)
+      return nullptr;
+#endif
+    mapped_address = address;
+    mapped_length = offset + size - begin;
+    return static_cast<const char*>(address) + (offset - begin);
+  }
+
+  /// Read a file range in the owned buffer, return nullptr on failure
+  const char * Read(const std::string & filename, uint64_t offset, uint64_t size)
+  {
+    std::ifstream stream(filename.c_str(), std::ios::binary | std::ios::in);
+    if (!stream.is_open())
+      return nullptr;
+    char * data = Allocate(size);
+    if (!stream.seekg(offset) || !stream.read(data, size))
+      return nullptr;
+    return data;
+  }
+};
+
+Landmarks_Columnar::Layout::Layout
+(
+  uint64_t landmark_count,
+  uint64_t observation_count
+):
+  ids(kAlignment),
+  X(Align(ids + landmark_count * sizeof(IndexT))),
+  observation_offsets(Align(X + landmark_count * 3 * sizeof(double))),
+  observation_view_ids(Align(observation_offsets + (landmark_count + 1) * sizeof(uint64_t))),
+  observation_feat_ids(Align(observation_view_ids + observation_count * sizeof(IndexT))),
+  observation_x(Align(observation_feat_ids + observation_count * sizeof(IndexT))),
+  size(Align(observation_x + observation_count * 2 * sizeof(double)))
+{
+}
+
+Landmarks_Columnar::Landmarks_Columnar():
+  landmark_count_(0), observation_count_(0),
+  ids_(nullptr), X_(nullptr), observation_offsets_(nullptr),
+  observation_view_ids_(nullptr), observation_feat_ids_(nullptr),
+  observation_x_(nullptr)
+{
+}
+
+Landmarks_Columnar::~Landmarks_Columnar() = default;
+
+Landmarks_Columnar::Landmarks_Columnar(Landmarks_Columnar &&) = default;
+
+Landmarks_Columnar & Landmarks_Columnar::operator=(Landmarks_Columnar &&) = default;
+
+Landmarks_Columnar::Landmarks_Columnar(const Landmarks & landmarks):
+  Landmarks_Columnar()
+{
+  uint64_t observation_count = 0;
+  for (const auto & landmark_it : landmarks)
+    observation_count += landmark_it.second.obs.size();
+  const Layout layout(landmarks.size(), observation_count);
+
+  storage_.reset(new Storage);
+  MemoryStream stream{storage_->Allocate(layout.size)};
+  WriteLandmarkSection(landmarks, stream);
+  SetColumns(reinterpret_cast<const char*>(storage_->buffer.data()), layout.size);
+}
+
+bool Landmarks_Columnar::Map(const std::string & filename, ESfM_Data part)
+{
+  *this = Landmarks_Columnar();
+
+  std::vector<Section> sections;
+  {
+    std::ifstream stream(filename.c_str(), std::ios::binary | std::ios::in);
+    if (!stream.is_open() || !ReadSectionTable(stream, sections))
+      return false;
+  }
+  const Section * section = FindSection(sections, part);
+  if (!section || (part != STRUCTURE && part != CONTROL_POINTS))
+    return false;
+
+  // Map the section, or read it if the file cannot be mapped
+  storage_.reset(new Storage);
+  const char * data = storage_->Map(filename, section->offset, section->size);
+  if (!data)
+    data = storage_->Read(filename, section->offset, section->size);
+  if (!data || !SetColumns(data, section->size))
+  {
+    *this = Landmarks_Columnar();
+    return false;
+  }
+  return true;
+}
+
+bool Landmarks_Columnar::SetColumns(const char * section, uint64_t section_size)
+{
+  if (section_size < kAlignment)
+    return false;
+  uint64_t counts[2];
+  std::memcpy(counts, section, sizeof(counts));
+  // The counts are bounded by the section size (no overflow of the layout)
+  const uint64_t landmark_size = sizeof(IndexT) + 3 * sizeof(double) + sizeof(uint64_t);
+  const uint64_t observation_size = 2 * sizeof(IndexT) + 2 * sizeof(double);
+  if (section_size > std::numeric_limits<uint64_t>::max() / 2 ||
+      counts[0] > section_size / landmark_size ||
+      counts[1] > (section_size - counts[0] * landmark_size) / observation_size)
+    return false;
+  const Layout layout(counts[0], counts[1]);
+  if (section_size < layout.size)
+    return false;
+
+  // The observation offsets must be sorted, from 0 to the observation count
+  const uint64_t * observation_offsets =
+    reinterpret_cast<const uint64_t*>(section + layout.observation_offsets);
+  if (observation_offsets[0] != 0 || observation_offsets[counts[0]] != counts[1])
+    return false;
+  for (uint64_t i = 0; i < counts[0]; ++i)
+  {
+    if (observation_offsets[i] > observation_offsets[i + 1])
+      return false;
+  }
+
+  landmark_count_ = counts[0];
+  observation_count_ = counts[1];
+  ids_ = reinterpret_cast<const IndexT*>(section + layout.ids);
+  X_ = reinterpret_cast<const double*>(section + layout.X);
+  observation_offsets_ = observation_offsets;
+  observation_view_ids_ = reinterpret_cast<const IndexT*>(section + layout.observation_view_ids);
+  observation_feat_ids_ = reinterpret_cast<const IndexT*>(section + layout.observation_feat_ids);
+  observation_x_ = reinterpret_cast<const double*>(section + layout.observation_x);
+  return true;
+}
+
+void Landmarks_Columnar::Export(Landmarks & landmarks) const
+{
+  for (std::size_t i = 0; i < landmark_count_; ++i)
+  {
+    Landmark & landmark = landmarks[ids_[i]];
+    landmark.X = X(i);
+    for (std::size_t j = ObservationBegin(i); j < ObservationEnd(i); ++j)
+    {
+      landmark.obs[observation_view_ids_[j]] =
+        Observation(ObservationX(j), observation_feat_ids_[j]);
+    }
+  }
+}
+
+bool Load_SFMB(
+  SfM_Data & sfm_data,
+  const std::string & filename,
+  ESfM_Data flags_part)
+{
+  std::ifstream stream(filename.c_str(), std::ios::binary | std::ios::in);
+  if (!stream.is_open())
+    return false;
+
+  std::vector<Section> sections;
+  if (!ReadSectionTable(stream, sections))
+    return false;
+
+  // Only the requested sections are read, the other ones are skipped
+  for (const Section & section : sections)
+  {
+    if (section.type != kMetadataSection && (flags_part & section.type) != section.type)
+      continue;
+
+    if (!stream.seekg(section.offset))
+      return false;
+    bool bStatus = true;
+    switch (section.type)
+    {
+      case kMetadataSection:
+      {
+        uint64_t length = 0;
+        bStatus = section.size >= sizeof(length) &&
+          stream.read(reinterpret_cast<char*>(&length), sizeof(length)) &&
+          length <= section.size - sizeof(length);
+        if (bStatus)
+        {
+          sfm_data.s_root_path.resize(length);
+          bStatus = static_cast<bool>(stream.read(&sfm_data.s_root_path[0], length));
+        }
+      }
+      break;
+      case VIEWS:
+      case INTRINSICS:
+        bStatus = Load_Cereal_Part(sfm_data, stream, ESfM_Data(section.type));
+      break;
+      case EXTRINSICS:
+        bStatus = ReadPosesSection(stream, section.size, sfm_data.poses);
+      break;
+      case STRUCTURE:
+      case CONTROL_POINTS:
+      {
+        Landmarks_Columnar landmarks;
+        bStatus = landmarks.Map(filename, ESfM_Data(section.type));
+        if (bStatus)
+        {
+          landmarks.Export(section.type == STRUCTURE ?
+            sfm_data.structure : sfm_data.control_points);
+        }
+      }
+      break;
+      default: // Unknown section (written by a later version)
+      break;
+    }
+    if (!bStatus)
+    {
+      std::cerr << "Cannot read the .sfmb section: " << section.type << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Save_SFMB(
+  const SfM_Data & sfm_data,
+  const std::string & filename,
+  ESfM_Data flags_part)
+{
+  if (!IsLittleEndian())
+  {
+    std::cerr << "The .sfmb format is only supported on little endian hosts" << std::endl;
+    return false;
+  }
+
+  // Use a large stream buffer to limit the write calls
+  std::vector<char> stream_buffer(1 << 22);
+  std::ofstream stream;
+  stream.rdbuf()->pubsetbuf(stream_buffer.data(), stream_buffer.size());
+  stream.open(filename.c_str(), std::ios::binary | std::ios::out);
+  if (!stream.is_open())
+    return false;
+
+  std::vector<Section> sections(1, Section{kMetadataSection, 0, 0, 0});
+  for (const ESfM_Data part : {VIEWS, INTRINSICS, EXTRINSICS, STRUCTURE, CONTROL_POINTS})
+  {
+    if ((flags_part & part) == part)
+      sections.push_back(Section{static_cast<uint32_t>(part), 0, 0, 0});
+  }
+
+  // The header and the section table are written once the sections are known
+  FileHeader header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.byte_order = kByteOrderTag;
+  header.section_count = static_cast<uint32_t>(sections.size());
+  header.reserved = 0;
+  const uint64_t header_size = sizeof(FileHeader) + sections.size() * sizeof(Section);
+  const std::vector<char> zeros(Align(header_size), 0);
+  stream.write(zeros.data(), zeros.size());
+
+  for (Section & section : sections)
+  {
+    section.offset = static_cast<uint64_t>(stream.tellp());
+    switch (section.type)
+    {
+      case kMetadataSection:
+      {
+        const uint64_t length = sfm_data.s_root_path.size();
+        stream.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        stream.write(sfm_data.s_root_path.data(), length);
+      }
+      break;
+      case VIEWS:
+      case INTRINSICS:
+        Save_Cereal_Part(sfm_data, stream, ESfM_Data(section.type));
+      break;
+      case EXTRINSICS:
+        WritePosesSection(sfm_data.poses, stream);
+      break;
+      case STRUCTURE:
+        WriteLandmarkSection(sfm_data.structure, stream);
+      break;
+      case CONTROL_POINTS:
+        WriteLandmarkSection(sfm_data.control_points, stream);
+      break;
+    }
+    section.size = static_cast<uint64_t>(stream.tellp()) - section.offset;
+    // Align the next section
+    stream.write(zeros.data(), Align(section.size) - section.size);
+  }
+
+  stream.seekp(0);
+  stream.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+  stream.write(reinterpret_cast<const char*>(sections.data()),
+               sections.size() * sizeof(Section));
+  stream.close();
+  return !stream.fail();
+}
+
+} // namespace sfm
+} // namespace openMVG
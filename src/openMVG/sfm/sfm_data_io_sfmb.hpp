@@ -0,0 +1,135 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_SFM_SFM_DATA_IO_SFMB_HPP
+#define OPENMVG_SFM_SFM_DATA_IO_SFMB_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "openMVG/numeric/eigen_alias_definition.hpp"
+#include "openMVG/sfm/sfm_data_io.hpp"
+#include "openMVG/sfm/sfm_landmark.hpp"
+
+namespace openMVG {
+namespace sfm {
+
+struct SfM_Data;
+
+/// Sectioned binary SfM_Data container (.sfmb)
+//--
+// The file starts with a header and a section table, then every SfM_Data part
+//  is stored in its own section (aligned on 64 bytes):
+// - the metadata section (version, root path),
+// - the VIEWS and INTRINSICS sections (cereal portable binary archives, since
+//    their objects are polymorphic),
+// - the EXTRINSICS section (columns of pose ids, rotations, centers),
+// - the STRUCTURE and CONTROL_POINTS sections (columnar landmark store).
+// The sections that are not requested by the ESfM_Data flags are skipped
+//  without being read, and the landmark sections can be memory mapped
+//  (see Landmarks_Columnar).
+// The data is stored in little endian order, the elements are sorted by ids.
+//--
+
+/// Load a SfM_Data scene from a sectioned binary file
+bool Load_SFMB(
+  SfM_Data & sfm_data,
+  const std::string & filename,
+  ESfM_Data flags_part);
+
+/// Save a SfM_Data scene to a sectioned binary file
+bool Save_SFMB(
+  const SfM_Data & sfm_data,
+  const std::string & filename,
+  ESfM_Data flags_part);
+
+/**
+* @brief Columnar (structure of arrays) landmark store.
+* The landmarks are sorted by ascending ids and their observations by
+*  ascending view ids. The columns are either owned or memory mapped from the
+*  STRUCTURE or CONTROL_POINTS section of a .sfmb file.
+*/
+class Landmarks_Columnar
+{
+public:
+  Landmarks_Columnar();
+  ~Landmarks_Columnar();
+
+  Landmarks_Columnar(Landmarks_Columnar &&);
+  Landmarks_Columnar & operator=(Landmarks_Columnar &&);
+
+  /// Build the store from landmarks
+  explicit Landmarks_Columnar(const Landmarks & landmarks);
+
+  /// Memory map (read only) the landmarks of a .sfmb file
+  /// @param[in] filename The .sfmb file
+  /// @param[in] part STRUCTURE or CONTROL_POINTS
+  /// @return false if the file or its section cannot be mapped
+  bool Map(const std::string & filename, ESfM_Data part = STRUCTURE);
+
+  /// Copy the store into landmarks
+  void Export(Landmarks & landmarks) const;
+
+  /// Number of landmarks
+  std::size_t size() const { return landmark_count_; }
+  /// Number of observations (of all the landmarks)
+  std::size_t ObservationCount() const { return observation_count_; }
+
+  /// Id of the i-th landmark
+  IndexT Id(std::size_t i) const { return ids_[i]; }
+  /// 3D position of the i-th landmark
+  Eigen::Map<const Vec3> X(std::size_t i) const { return Eigen::Map<const Vec3>(X_ + 3 * i); }
+
+  /// The observations of the i-th landmark are the [ObservationBegin(i), ObservationEnd(i)[ ones
+  std::size_t ObservationBegin(std::size_t i) const { return observation_offsets_[i]; }
+  std::size_t ObservationEnd(std::size_t i) const { return observation_offsets_[i + 1]; }
+
+  /// View id of the j-th observation
+  IndexT ObservationViewId(std::size_t j) const { return observation_view_ids_[j]; }
+  /// Feature id of the j-th observation
+  IndexT ObservationFeatId(std::size_t j) const { return observation_feat_ids_[j]; }
+  /// Image position of the j-th observation
+  Eigen::Map<const Vec2> ObservationX(std::size_t j) const
+  {
+    return Eigen::Map<const Vec2>(observation_x_ + 2 * j);
+  }
+
+  /// Column layout of a landmark section
+  struct Layout
+  {
+    explicit Layout(uint64_t landmark_count = 0, uint64_t observation_count = 0);
+
+    uint64_t ids, X, observation_offsets,
+      observation_view_ids, observation_feat_ids, observation_x;
+    /// Section size
+    uint64_t size;
+  };
+
+private:
+  /// Set the column pointers from a landmark section
+  bool SetColumns(const char * section, uint64_t section_size);
+
+  uint64_t landmark_count_, observation_count_;
+  const IndexT * ids_;
+  const double * X_;
+  const uint64_t * observation_offsets_;
+  const IndexT * observation_view_ids_;
+  const IndexT * observation_feat_ids_;
+  const double * observation_x_;
+
+  /// The storage: an owned buffer or a mapped file
+  struct Storage;
+  std::unique_ptr<Storage> storage_;
+};
+
+} // namespace sfm
+} // namespace openMVG
+
+#endif // OPENMVG_SFM_SFM_DATA_IO_SFMB_HPP
@@ -6,15 +6,30 @@
 // License, v. 2.0. If a copy of the MPL was not distributed with this
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
+// The <cereal/archives> headers are special and must be included first.
+#include <cereal/archives/json.hpp>
+
 #include "openMVG/cameras/Camera_Pinhole.hpp"
 #include "openMVG/sfm/sfm_data.hpp"
 #include "openMVG/sfm/sfm_data_io.hpp"
+#include "openMVG/sfm/sfm_data_io_cereal.hpp"
+#include "openMVG/sfm/sfm_data_io_json.hpp"
+#include "openMVG/sfm/sfm_data_io_ply.hpp"
+#include "openMVG/sfm/sfm_data_io_sfmb.hpp"
 #include "openMVG/cameras/Camera_Intrinsics.hpp"
+#include "openMVG/numeric/numeric.h"
 
 #include "testing/testing.h"
 #include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
 
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <limits>
 #include <sstream>
+#include <utility>
+#include <vector>
 
 using namespace openMVG;
 using namespace openMVG::cameras;
@@ -63,7 +78,7 @@ SfM_Data create_test_scene(IndexT viewsCount, bool bSharedIntrinsic)
 
 TEST(SfM_Data_IO, SAVE_LOAD_JSON) {
 
-  const std::vector<std::string> ext_Type = {"json", "bin", "xml"};
+  const std::vector<std::string> ext_Type = {"json", "bin", "xml", "sfmb"};
 
   for (size_t i=0; i < ext_Type.size(); ++i)
   {
@@ -164,6 +179,251 @@ TEST(SfM_Data_IO, SAVE_LOAD_JSON) {
   }
 }
 
+TEST(SfM_Data_IO, SAVE_LOAD_JSON_Values) {
+
+  // Enough landmarks to be written by several chunks
+  SfM_Data sfm_data = create_test_scene(3, false);
+  sfm_data.poses[1] = Pose3(RotationAroundX(0.1) * RotationAroundZ(-0.3), Vec3(0.1, 1e-8, -3e10));
+  for (IndexT i = 0; i < 5000; ++i)
+  {
+    Landmark & landmark = sfm_data.structure[i * 3];
+    landmark.X = Vec3(i / 7.0, -1e-5 * i, i);
+    for (IndexT j = 0; j < i % 4; ++j)
+      landmark.obs[j] = Observation(Vec2(i / 3.0, j), i + j);
+  }
+  sfm_data.control_points[7] = sfm_data.structure[3];
+
+  using Save_Function = std::function<bool(const SfM_Data &, const std::string &, ESfM_Data)>;
+  using Load_Function = std::function<bool(SfM_Data &, const std::string &, ESfM_Data)>;
+  // The streaming JSON files and the Cereal JSON files are interchangeable:
+  // - streaming writer and reader,
+  // - streaming writer, Cereal reader,
+  // - Cereal writer, streaming reader.
+  const std::vector<std::pair<Save_Function, Load_Function>> save_load_functions = {
+    {Save_JSON, Load_JSON},
+    {Save_JSON, Load_Cereal<cereal::JSONInputArchive>},
+    {Save_Cereal<cereal::JSONOutputArchive>, Load_JSON}
+  };
+
+  const std::string filename = "SAVE_LOAD_VALUES.json";
+  for (const auto & save_load : save_load_functions)
+  {
+    EXPECT_TRUE( save_load.first(sfm_data, filename, ALL) );
+
+    SfM_Data sfm_data_load;
+    EXPECT_TRUE( save_load.second(sfm_data_load, filename, ALL) );
+    EXPECT_EQ( sfm_data.views.size(), sfm_data_load.views.size() );
+    for (const auto & view_it : sfm_data.views)
+    {
+      const View & view = *sfm_data_load.views.at(view_it.first);
+      EXPECT_EQ( view_it.second->s_Img_path, view.s_Img_path );
+      EXPECT_EQ( view_it.second->id_intrinsic, view.id_intrinsic );
+      EXPECT_EQ( view_it.second->id_pose, view.id_pose );
+    }
+    EXPECT_EQ( sfm_data.intrinsics.size(), sfm_data_load.intrinsics.size() );
+    for (const auto & intrinsic_it : sfm_data.intrinsics)
+    {
+      EXPECT_TRUE( intrinsic_it.second->getParams() ==
+        sfm_data_load.intrinsics.at(intrinsic_it.first)->getParams() );
+    }
+    EXPECT_EQ( sfm_data.poses.size(), sfm_data_load.poses.size() );
+    for (const auto & pose_it : sfm_data.poses)
+    {
+      const Pose3 & pose = sfm_data_load.poses.at(pose_it.first);
+      EXPECT_MATRIX_NEAR( pose_it.second.rotation(), pose.rotation(), 0.0 );
+      EXPECT_MATRIX_NEAR( pose_it.second.center(), pose.center(), 0.0 );
+    }
+    EXPECT_EQ( sfm_data.structure.size(), sfm_data_load.structure.size() );
+    for (const auto & landmark_it : sfm_data.structure)
+    {
+      const Landmark & landmark = sfm_data_load.structure.at(landmark_it.first);
+      EXPECT_MATRIX_NEAR( landmark_it.second.X, landmark.X, 0.0 );
+      EXPECT_EQ( landmark_it.second.obs.size(), landmark.obs.size() );
+      for (const auto & obs_it : landmark_it.second.obs)
+      {
+        EXPECT_EQ( obs_it.second.id_feat, landmark.obs.at(obs_it.first).id_feat );
+        EXPECT_MATRIX_NEAR( obs_it.second.x, landmark.obs.at(obs_it.first).x, 0.0 );
+      }
+    }
+    EXPECT_EQ( 1, sfm_data_load.control_points.size() );
+
+    // LOAD (only a subpart)
+    SfM_Data sfm_data_part;
+    EXPECT_TRUE( save_load.second(sfm_data_part, filename, ESfM_Data(EXTRINSICS | STRUCTURE | CONTROL_POINTS)) );
+    EXPECT_EQ( 0, sfm_data_part.views.size() );
+    EXPECT_EQ( 0, sfm_data_part.intrinsics.size() );
+    EXPECT_EQ( sfm_data.poses.size(), sfm_data_part.poses.size() );
+    EXPECT_EQ( sfm_data.structure.size(), sfm_data_part.structure.size() );
+    EXPECT_EQ( 1, sfm_data_part.control_points.size() );
+  }
+}
+
+TEST(SfM_Data_IO, SFMB_Landmarks_Columnar) {
+
+  // Landmarks with unsorted ids and observations
+  Landmarks landmarks;
+  for (IndexT i = 0; i < 100; ++i)
+  {
+    Landmark & landmark = landmarks[(i * 37) % 101];
+    landmark.X = Vec3(i, 2 * i, 3 * i);
+    for (IndexT j = 0; j < i % 5; ++j)
+      landmark.obs[(j * 3 + i) % 7] = Observation(Vec2(i, j), i + j);
+  }
+
+  SfM_Data sfm_data = create_test_scene(2, true);
+  sfm_data.structure = landmarks;
+  const std::string filename = "SAVE_LOAD_COLUMNAR.sfmb";
+  EXPECT_TRUE( Save(sfm_data, filename, ALL) );
+
+  for (const bool b_mapped : {false, true})
+  {
+    Landmarks_Columnar columnar;
+    if (b_mapped)
+    {
+      EXPECT_TRUE( columnar.Map(filename, STRUCTURE) );
+    }
+    else
+    {
+      columnar = Landmarks_Columnar(landmarks);
+    }
+
+    EXPECT_EQ( landmarks.size(), columnar.size() );
+    std::size_t observation_count = 0;
+    for (std::size_t i = 0; i < columnar.size(); ++i)
+    {
+      // Sorted ids and view ids
+      if (i > 0)
+      {
+        EXPECT_TRUE( columnar.Id(i - 1) < columnar.Id(i) );
+      }
+      for (std::size_t j = columnar.ObservationBegin(i) + 1; j < columnar.ObservationEnd(i); ++j)
+      {
+        EXPECT_TRUE( columnar.ObservationViewId(j - 1) < columnar.ObservationViewId(j) );
+      }
+
+      const Landmark & landmark = landmarks.at(columnar.Id(i));
+      EXPECT_MATRIX_NEAR( landmark.X, columnar.X(i), 1e-16 );
+      EXPECT_EQ( landmark.obs.size(), columnar.ObservationEnd(i) - columnar.ObservationBegin(i) );
+      for (std::size_t j = columnar.ObservationBegin(i); j < columnar.ObservationEnd(i); ++j)
+      {
+        const Observation & obs = landmark.obs.at(columnar.ObservationViewId(j));
+        EXPECT_EQ( obs.id_feat, columnar.ObservationFeatId(j) );
+        EXPECT_MATRIX_NEAR( obs.x, columnar.ObservationX(j), 1e-16 );
+      }
+      observation_count += landmark.obs.size();
+    }
+    EXPECT_EQ( observation_count, columnar.ObservationCount() );
+
+    Landmarks exported;
+    columnar.Export(exported);
+    EXPECT_EQ( landmarks.size(), exported.size() );
+  }
+
+  // The control points section is not saved
+  Landmarks_Columnar columnar;
+  EXPECT_TRUE( Save(sfm_data, filename, ESfM_Data(VIEWS | STRUCTURE)) );
+  EXPECT_FALSE( columnar.Map(filename, CONTROL_POINTS) );
+  EXPECT_EQ( 0, columnar.size() );
+
+  // Load the saved parts
+  SfM_Data sfm_data_load;
+  EXPECT_TRUE( Load(sfm_data_load, filename, ESfM_Data(VIEWS | STRUCTURE)) );
+  EXPECT_EQ( sfm_data.views.size(), sfm_data_load.views.size() );
+  EXPECT_EQ( landmarks.size(), sfm_data_load.structure.size() );
+}
+
+// Byte offset of a section (type, offset, size) in the .sfmb section table
+static std::size_t SFMB_SectionEntry(const std::string & bytes, uint32_t type)
+{
+  uint32_t section_count;
+  std::memcpy(&section_count, &bytes[16], sizeof(section_count));
+  for (std::size_t i = 0; i < section_count; ++i)
+  {
+    uint32_t section_type;
+    std::memcpy(&section_type, &bytes[24 + 24 * i], sizeof(section_type));
+    if (section_type == type)
+      return 24 + 24 * i;
+  }
+  return 0;
+}
+
+template <typename T>
+static T SFMB_Get(const std::string & bytes, std::size_t position)
+{
+  T value;
+  std::memcpy(&value, &bytes[position], sizeof(T));
+  return value;
+}
+
+template <typename T>
+static void SFMB_Set(std::string & bytes, std::size_t position, T value)
+{
+  std::memcpy(&bytes[position], &value, sizeof(T));
+}
+
+TEST(SfM_Data_IO, SFMB_Corrupted) {
+
+  SfM_Data sfm_data = create_test_scene(2, true);
+  for (IndexT i = 1; i < 10; ++i)
+  {
+    sfm_data.structure[i].X = Vec3(i, i, i);
+    sfm_data.structure[i].obs[0] = Observation(Vec2(i, i), i);
+    sfm_data.structure[i].obs[1] = Observation(Vec2(i, i), i);
+  }
+  const std::string filename = "SAVE_LOAD_CORRUPTED.sfmb";
+  const ESfM_Data parts = ESfM_Data(EXTRINSICS | STRUCTURE);
+  EXPECT_TRUE( Save(sfm_data, filename, parts) );
+
+  std::string bytes;
+  {
+    std::ifstream stream(filename.c_str(), std::ios::binary);
+    bytes.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+  }
+  const std::size_t structure_entry = SFMB_SectionEntry(bytes, STRUCTURE);
+  const std::size_t metadata_entry = SFMB_SectionEntry(bytes, 0);
+  const std::size_t poses_entry = SFMB_SectionEntry(bytes, EXTRINSICS);
+  EXPECT_TRUE( structure_entry > 0 && poses_entry > 0 );
+  const uint64_t structure = SFMB_Get<uint64_t>(bytes, structure_entry + 8);
+  const Landmarks_Columnar::Layout layout(sfm_data.structure.size(), 2 * sfm_data.structure.size());
+  const std::size_t observation_offsets = structure + layout.observation_offsets;
+
+  // Every corruption is reported (no out of range access)
+  // (second: the landmark section cannot be mapped either)
+  const std::vector<std::pair<std::function<void(std::string &)>, bool>> corruptions = {
+    // Truncated file
+    {[&](std::string & b) { b.resize(structure + layout.size / 2); }, true},
+    // Section outside of the file (the range end overflows)
+    {[&](std::string & b) { SFMB_Set<uint64_t>(b, structure_entry + 16, ~uint64_t(0)); }, true},
+    // Too many sections
+    {[&](std::string & b) { SFMB_Set<uint32_t>(b, 16, ~uint32_t(0)); }, true},
+    // Landmark and observation counts larger than the section
+    {[&](std::string & b) { SFMB_Set<uint64_t>(b, structure, uint64_t(1) << 61); }, true},
+    {[&](std::string & b) { SFMB_Set<uint64_t>(b, structure + 8, ~uint64_t(0) / 8); }, true},
+    // Unsorted observation offsets
+    {[&](std::string & b) { SFMB_Set<uint64_t>(b, observation_offsets + 8, uint64_t(5)); }, true},
+    // Observation offset out of the observations
+    {[&](std::string & b) { SFMB_Set<uint64_t>(b, observation_offsets + 16, ~uint64_t(0)); }, true},
+    // Too large pose count and root path length
+    {[&](std::string & b)
+      { SFMB_Set<uint64_t>(b, SFMB_Get<uint64_t>(b, poses_entry + 8), uint64_t(1) << 60); }, false},
+    {[&](std::string & b)
+      { SFMB_Set<uint64_t>(b, SFMB_Get<uint64_t>(b, metadata_entry + 8), ~uint64_t(0)); }, false}
+  };
+  for (const auto & corruption : corruptions)
+  {
+    std::string corrupted_bytes = bytes;
+    corruption.first(corrupted_bytes);
+    {
+      std::ofstream stream(filename.c_str(), std::ios::binary);
+      stream.write(corrupted_bytes.data(), corrupted_bytes.size());
+    }
+    SfM_Data sfm_data_load;
+    EXPECT_FALSE( Load(sfm_data_load, filename, parts) );
+    Landmarks_Columnar columnar;
+    EXPECT_EQ( !corruption.second, columnar.Map(filename, STRUCTURE) );
+  }
+}
+
 TEST(SfM_Data_IO, SAVE_PLY) {
 
   // SAVE as PLY
@@ -180,6 +440,70 @@ TEST(SfM_Data_IO, SAVE_PLY) {
   }
 }
 
+TEST(SfM_Data_IO, SAVE_LOAD_PLY_Vertices) {
+
+  // Enough vertices to be written by several chunks
+  std::vector<Vec3> points(40000);
+  for (size_t i = 0; i < points.size(); ++i)
+    points[i] = Vec3(i / 3.0, -1.0 * i, 1e-3 * i);
+
+  for (const bool b_ascii : {true, false})
+  {
+    const std::string filename = "SAVE_LOAD_VERTICES.ply";
+    EXPECT_TRUE( Save_PLY_Vertices(filename, points.size(),
+      [&](size_t i, Vec3 & X, Vec3uc & color)
+      {
+        X = points[i];
+        color = Vec3uc(i % 256, 0, 255);
+      },
+      b_ascii) );
+
+    std::vector<Vec3> points_load;
+    std::vector<Vec3uc> colors_load;
+    EXPECT_TRUE( Load_PLY_Vertices(filename, points_load, &colors_load) );
+    EXPECT_EQ( points.size(), points_load.size() );
+    EXPECT_EQ( points.size(), colors_load.size() );
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+      EXPECT_MATRIX_NEAR( points[i], points_load[i], 1e-10 );
+      EXPECT_EQ( i % 256, colors_load[i](0) );
+      EXPECT_EQ( 255, colors_load[i](2) );
+    }
+  }
+
+  // Load a SfM_Data PLY export (structure and poses)
+  const SfM_Data sfm_data = create_test_scene(2, true);
+  EXPECT_TRUE( Save(sfm_data, "SAVE_LOAD.ply", ESfM_Data(EXTRINSICS | STRUCTURE)) );
+  std::vector<Vec3> points_load;
+  EXPECT_TRUE( Load_PLY_Vertices("SAVE_LOAD.ply", points_load) );
+  EXPECT_EQ( 3, points_load.size() ); // 2 poses, 1 landmark
+}
+
+TEST(SfM_Data_IO, SAVE_LOAD_PLY_Vertices_Large) {
+
+  // The longest ASCII lines (the fixed notation of the largest coordinates)
+  const std::vector<Vec3> points = {
+    Vec3(1e21, -1e21, 1e-21),
+    Vec3(std::numeric_limits<double>::max(), -std::numeric_limits<double>::max(), -1e300)
+  };
+  const std::string filename = "SAVE_LOAD_VERTICES_LARGE.ply";
+  EXPECT_TRUE( Save_PLY_Vertices(filename, points.size(),
+    [&](size_t i, Vec3 & X, Vec3uc & color)
+    {
+      X = points[i];
+      color = Vec3uc(255, 255, 255);
+    },
+    true) );
+
+  std::vector<Vec3> points_load;
+  EXPECT_TRUE( Load_PLY_Vertices(filename, points_load) );
+  EXPECT_EQ( points.size(), points_load.size() );
+  for (size_t i = 0; i < points.size(); ++i)
+  {
+    EXPECT_MATRIX_NEAR( points[i], points_load[i], std::abs(points[i](0)) * 1e-15 );
+  }
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
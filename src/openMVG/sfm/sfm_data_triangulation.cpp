@@ -8,8 +8,11 @@
 
 #include "openMVG/sfm/sfm_data_triangulation.hpp"
 
-#include <deque>
-#include <functional>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
 
 #include "openMVG/geometry/pose3.hpp"
 #include "openMVG/multiview/triangulation_nview.hpp"
@@ -41,110 +44,302 @@ SfM_Data_Structure_Computation_Blind::SfM_Data_Structure_Computation_Blind
 {
 }
 
-/// Triangulate a given set of observations
-bool track_triangulation
+namespace {
+
+/// Observation of a track flattened with the data required by the
+/// triangulation and the validation of the landmark.
+/// Per observation data (bearing vectors, triangulation term) are computed
+/// once per track and then reused by every hypothesis.
+struct TrackObservation
+{
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  /// Id of the view of the observation
+  IndexT view_id;
+  /// Intrinsic of the view (nullptr if the view has no pose or intrinsic)
+  const IntrinsicBase * cam;
+  /// Pose of the view
+  const Pose3 * pose;
+  /// Observed image position
+  const Vec2 * x;
+  /// Bearing vector of the observed position (used by the cheirality test)
+  Vec3 bearing;
+  /// Algebraic triangulation term of the undistorted observation
+  Mat4 triangulation_term;
+};
+
+using TrackObservations =
+  std::vector<TrackObservation, Eigen::aligned_allocator<TrackObservation>>;
+
+/// Scratch buffers reused from one track to another by a thread
+/// (avoid per track memory allocations)
+struct TriangulationScratch
+{
+  TrackObservations observations;
+  std::vector<std::uint32_t> indexes;
+  std::vector<std::uint32_t> samples;
+  std::vector<std::uint32_t> inliers;
+};
+
+/// Flatten the observations of a track (in the observation iteration order)
+void flatten_track
 (
   const SfM_Data & sfm_data,
   const Observations & obs,
+  TrackObservations & flat_obs
+)
+{
+  flat_obs.resize(obs.size());
+  auto flat_obs_it = flat_obs.begin();
+  for (const auto & observation : obs)
+  {
+    TrackObservation & flat = *(flat_obs_it++);
+    flat.view_id = observation.first;
+    flat.x = &observation.second.x;
+    flat.cam = nullptr;
+    flat.pose = nullptr;
+
+    const View * view = sfm_data.views.at(observation.first).get();
+    if (!sfm_data.IsPoseAndIntrinsicDefined(view))
+      continue;
+    flat.cam = sfm_data.GetIntrinsics().at(view->id_intrinsic).get();
+    flat.pose = &sfm_data.GetPoses().at(view->id_pose);
+    flat.bearing = (*flat.cam)(observation.second.x);
+    flat.triangulation_term = TriangulateNViewAlgebraicTerm(
+      (*flat.cam)(flat.cam->get_ud_pixel(observation.second.x)),
+      flat.pose->asMatrix());
+  }
+}
+
+/// Triangulate the valid observations of a flattened track listed by indexes
+bool track_triangulation
+(
+  const TrackObservations & flat_obs,
+  const std::vector<std::uint32_t> & indexes,
   Vec3 & X
 )
 {
-  if (obs.size() >= 2)
+  if (indexes.size() < 2)
+    return false;
+
+  Mat4 AtA = Mat4::Zero();
+  int nb_valid_obs = 0;
+  for (const auto index : indexes)
   {
-    std::vector<Vec3> bearing;
-    std::vector<Mat34> poses;
-    bearing.reserve(obs.size());
-    poses.reserve(obs.size());
-    for (const auto& observation : obs)
-    {
-      const View * view = sfm_data.views.at(observation.first).get();
-      if (!sfm_data.IsPoseAndIntrinsicDefined(view))
-        continue;
-      const IntrinsicBase * cam = sfm_data.GetIntrinsics().at(view->id_intrinsic).get();
-      const Pose3 pose = sfm_data.GetPoseOrDie(view);
-      bearing.emplace_back((*cam)(cam->get_ud_pixel(observation.second.x)));
-      poses.emplace_back(pose.asMatrix());
-    }
-    if (bearing.size() >= 2)
-    {
-      const Eigen::Map<const Mat3X> bearing_matrix(bearing[0].data(), 3, bearing.size());
-      Vec4 Xhomogeneous;
-      if (TriangulateNViewAlgebraic
-      (
-        bearing_matrix,
-        poses,
-        &Xhomogeneous))
-      {
-        X = Xhomogeneous.hnormalized();
-        return true;
-      }
-    }
+    const TrackObservation & flat = flat_obs[index];
+    if (!flat.cam)
+      continue;
+    AtA += flat.triangulation_term;
+    ++nb_valid_obs;
+  }
+  if (nb_valid_obs < 2)
+    return false;
+
+  Vec4 Xhomogeneous;
+  if (TriangulateNViewAlgebraic(AtA, &Xhomogeneous))
+  {
+    X = Xhomogeneous.hnormalized();
+    return true;
   }
   return false;
 }
 
-// Test if a predicate is true for each observation
+/// Cheirality test (depth test) of an observation
+inline bool cheirality_predicate
+(
+  const TrackObservation & flat,
+  const Vec3 & X
+)
+{
+  return CheiralityTest(flat.bearing, *flat.pose, X);
+}
+
+/// Cheirality test and squared residual error of an observation
+inline bool residual_and_cheirality_predicate
+(
+  const TrackObservation & flat,
+  const Vec3 & X,
+  const double squared_pixel_threshold
+)
+{
+  return cheirality_predicate(flat, X) &&
+    flat.cam->residual((*flat.pose)(X), *flat.x).squaredNorm() < squared_pixel_threshold;
+}
+
+// Test if a predicate is true for each valid observation listed by indexes
 // i.e: predicate could be:
 // - cheirality test (depth test): cheirality_predicate
-// - cheirality and residual error: ResidualAndCheiralityPredicate::predicate
+// - cheirality and residual error: residual_and_cheirality_predicate
+template <typename Predicate>
 bool track_check_predicate
 (
-  const Observations & obs,
-  const SfM_Data & sfm_data,
-  const Vec3 & X,
-  std::function<bool(
-    const IntrinsicBase&,
-    const Pose3&,
-    const Vec2&,
-    const Vec3&)> predicate
+  const TrackObservations & flat_obs,
+  const std::vector<std::uint32_t> & indexes,
+  const Predicate & predicate
 )
 {
   bool visibility = false; // assume that no observation has been looked yet
-  for (const auto & obs_it : obs)
+  for (const auto index : indexes)
   {
-    const View * view = sfm_data.views.at(obs_it.first).get();
-    if (!sfm_data.IsPoseAndIntrinsicDefined(view))
+    const TrackObservation & flat = flat_obs[index];
+    if (!flat.cam)
       continue;
     visibility = true; // at least an observation is evaluated
-    const IntrinsicBase * cam = sfm_data.intrinsics.at(view->id_intrinsic).get();
-    const Pose3 pose = sfm_data.GetPoseOrDie(view);
-    if (!predicate(*cam, pose, obs_it.second.x, X))
+    if (!predicate(flat))
       return false;
   }
   return visibility;
 }
 
-bool cheirality_predicate
+/// Fill the indexes of all the observations of a flattened track
+void all_indexes
 (
-  const IntrinsicBase& cam,
-  const Pose3& pose,
-  const Vec2& x,
-  const Vec3& X
+  const TrackObservations & flat_obs,
+  std::vector<std::uint32_t> & indexes
 )
 {
-  return CheiralityTest(cam(x), pose, X);
+  indexes.resize(flat_obs.size());
+  std::iota(indexes.begin(), indexes.end(), 0);
 }
 
-struct ResidualAndCheiralityPredicate
+/// List the landmarks of a scene, so they can be processed by a parallel loop
+std::vector<std::pair<IndexT, Landmark*>> list_landmarks
+(
+  Landmarks & landmarks
+)
 {
-  const double squared_pixel_threshold_;
-
-  ResidualAndCheiralityPredicate(const double squared_pixel_threshold)
-    :squared_pixel_threshold_(squared_pixel_threshold){}
-
-  bool predicate
-  (
-    const IntrinsicBase& cam,
-    const Pose3& pose,
-    const Vec2& x,
-    const Vec3& X
-  )
+  std::vector<std::pair<IndexT, Landmark*>> landmark_list;
+  landmark_list.reserve(landmarks.size());
+  for (auto & landmark_it : landmarks)
   {
-    const Vec2 residual = cam.residual(pose(X), x);
-    return CheiralityTest(cam(x), pose, X) &&
-           residual.squaredNorm() < squared_pixel_threshold_;
+    landmark_list.emplace_back(landmark_it.first, &landmark_it.second);
   }
-};
+  return landmark_list;
+}
+
+/// Robustly try to estimate the best 3D point using a ransac scheme
+/// A point must be seen in at least min_required_inliers views
+/// Return true for a successful triangulation
+bool robust_track_triangulation
+(
+  const SfM_Data & sfm_data,
+  const Observations & obs,
+  const double max_reprojection_error,
+  const IndexT min_required_inliers,
+  const IndexT min_sample_index,
+  Landmark & landmark, // X & valid observations
+  TriangulationScratch & scratch
+)
+{
+  if (obs.size() < min_required_inliers || obs.size() < min_sample_index)
+  {
+    return false;
+  }
+
+  const double dSquared_pixel_threshold = Square(max_reprojection_error);
+
+  // Predicate to validate a sample (cheirality and residual error)
+  Vec3 X;
+  const auto predicate = [&X, dSquared_pixel_threshold](const TrackObservation & flat)
+  {
+    return residual_and_cheirality_predicate(flat, X, dSquared_pixel_threshold);
+  };
+
+  flatten_track(sfm_data, obs, scratch.observations);
+  const TrackObservations & flat_obs = scratch.observations;
+
+  // Handle the case where all observations must be used
+  if (min_required_inliers == min_sample_index &&
+      obs.size() == min_required_inliers)
+  {
+    // Generate the 3D point hypothesis by triangulating all the observations
+    all_indexes(flat_obs, scratch.indexes);
+    if (track_triangulation(flat_obs, scratch.indexes, X) &&
+        track_check_predicate(flat_obs, scratch.indexes, predicate))
+    {
+      landmark.X = X;
+      landmark.obs = obs;
+      return true;
+    }
+    return false;
+  }
+
+  // else we perform a robust estimation since
+  //  there is more observations than the minimal number of required sample.
+
+  const IndexT nbIter = obs.size() * 2; // TODO: automatic computation of the number of iterations?
+
+  // - Ransac variables
+  Vec3 best_model = Vec3::Zero();
+  std::vector<std::uint32_t> & best_inlier_set = scratch.indexes;
+  best_inlier_set.clear();
+  double best_error = std::numeric_limits<double>::max();
+
+  //--
+  // Random number generation
+  std::mt19937 random_generator(std::mt19937::default_seed);
+
+  // - Ransac loop
+  for (IndexT i = 0; i < nbIter; ++i)
+  {
+    robust::UniformSample(min_sample_index, obs.size(), random_generator, &scratch.samples);
+    // Hypothesis generation (observations are used in the track order)
+    std::sort(scratch.samples.begin(), scratch.samples.end());
+
+    if (!track_triangulation(flat_obs, scratch.samples, X))
+      continue;
+
+    // Test validity of the hypothesis
+    if (!track_check_predicate(flat_obs, scratch.samples, predicate))
+      continue;
+
+    std::vector<std::uint32_t> & inlier_set = scratch.inliers;
+    inlier_set.clear();
+    double current_error = 0.0;
+    // inlier/outlier classification according pixel residual errors.
+    for (std::uint32_t index = 0; index < flat_obs.size(); ++index)
+    {
+      const TrackObservation & flat = flat_obs[index];
+      if (!flat.cam)
+        continue;
+      if (!cheirality_predicate(flat, X))
+        continue;
+      const double residual_sq = flat.cam->residual((*flat.pose)(X), *flat.x).squaredNorm();
+      if (residual_sq < dSquared_pixel_threshold)
+      {
+        inlier_set.push_back(index);
+        current_error += residual_sq;
+      }
+      else
+      {
+        current_error += dSquared_pixel_threshold;
+      }
+    }
+    // Does the hypothesis:
+    // - is the best one we have seen so far.
+    // - has sufficient inliers.
+    if (current_error < best_error &&
+      inlier_set.size() >= min_required_inliers)
+    {
+      best_model = X;
+      best_inlier_set.swap(inlier_set);
+      best_error = current_error;
+    }
+  }
+  if (!best_inlier_set.empty() && best_inlier_set.size() >= min_required_inliers)
+  {
+    // Update information (3D landmark position & valid observations)
+    landmark.X = best_model;
+    for (const std::uint32_t & index : best_inlier_set)
+    {
+      const IndexT view_id = flat_obs[index].view_id;
+      landmark.obs[view_id] = obs.at(view_id);
+    }
+  }
+  return !best_inlier_set.empty();
+}
+
+} // namespace
 
 void SfM_Data_Structure_Computation_Blind::triangulate
 (
@@ -152,56 +347,59 @@ void SfM_Data_Structure_Computation_Blind::triangulate
 )
 const
 {
-  std::deque<IndexT> rejectedId;
+  const std::vector<std::pair<IndexT, Landmark*>> landmarks =
+    list_landmarks(sfm_data.structure);
+  std::vector<char> keep(landmarks.size(), 0);
+
   std::unique_ptr<C_Progress> my_progress_bar;
   if (bConsole_verbose_)
     my_progress_bar.reset(
       new C_Progress_display(
-        sfm_data.structure.size(),
+        landmarks.size(),
         std::cout,
         "Blind triangulation progress:\n" ));
 #ifdef OPENMVG_USE_OPENMP
   #pragma omp parallel
 #endif
-  for (auto& tracks_it :sfm_data.structure)
   {
+    TriangulationScratch scratch;
 #ifdef OPENMVG_USE_OPENMP
-  #pragma omp single nowait
+    #pragma omp for schedule(dynamic, 64)
 #endif
+    for (int i = 0; i < static_cast<int>(landmarks.size()); ++i)
     {
       if (bConsole_verbose_)
       {
+#ifdef OPENMVG_USE_OPENMP
+        #pragma omp critical
+#endif
         ++(*my_progress_bar);
       }
 
-      const Observations & obs = tracks_it.second.obs;
-      bool bKeep = false;
+      Landmark & landmark = *landmarks[i].second;
+      flatten_track(sfm_data, landmark.obs, scratch.observations);
+      all_indexes(scratch.observations, scratch.indexes);
+
+      // Generate the track 3D hypothesis
+      Vec3 X;
+      if (track_triangulation(scratch.observations, scratch.indexes, X))
       {
-        // Generate the track 3D hypothesis
-        Vec3 X;
-        if (track_triangulation(sfm_data, obs, X))
+        // Keep the point only if it has a positive depth for all obs
+        if (track_check_predicate(scratch.observations, scratch.indexes,
+              [&X](const TrackObservation & flat)
+              { return cheirality_predicate(flat, X); }))
         {
-          // Keep the point only if it has a positive depth for all obs
-          if (track_check_predicate(obs, sfm_data, X, cheirality_predicate))
-          {
-            tracks_it.second.X = X;
-            bKeep = true;
-          }
+          landmark.X = X;
+          keep[i] = 1;
         }
       }
-      if (!bKeep)
-      {
-#ifdef OPENMVG_USE_OPENMP
-        #pragma omp critical
-#endif
-        rejectedId.push_front(tracks_it.first);
-      }
     }
   }
   // Erase the unsuccessful triangulated tracks
-  for (auto& it : rejectedId)
+  for (size_t i = 0; i < landmarks.size(); ++i)
   {
-    sfm_data.structure.erase(it);
+    if (!keep[i])
+      sfm_data.structure.erase(landmarks[i].first);
   }
 }
 
@@ -237,63 +435,52 @@ void SfM_Data_Structure_Computation_Robust::robust_triangulation
 )
 const
 {
-  std::deque<IndexT> rejectedId;
+  const std::vector<std::pair<IndexT, Landmark*>> landmarks =
+    list_landmarks(sfm_data.structure);
+  std::vector<char> keep(landmarks.size(), 0);
+
   std::unique_ptr<C_Progress_display> my_progress_bar;
   if (bConsole_verbose_)
     my_progress_bar.reset(
       new C_Progress_display(
-        sfm_data.structure.size(),
+        landmarks.size(),
         std::cout,
         "Robust triangulation progress:\n" ));
 #ifdef OPENMVG_USE_OPENMP
   #pragma omp parallel
 #endif
-  for (auto& tracks_it :sfm_data.structure)
   {
+    TriangulationScratch scratch;
 #ifdef OPENMVG_USE_OPENMP
-  #pragma omp single nowait
+    #pragma omp for schedule(dynamic, 64)
 #endif
+    for (int i = 0; i < static_cast<int>(landmarks.size()); ++i)
     {
       if (bConsole_verbose_)
       {
-        ++(*my_progress_bar);
-      }
-      Landmark landmark;
-      if (robust_triangulation(sfm_data, tracks_it.second.obs, landmark))
-      {
-        tracks_it.second = landmark;
-      }
-      else
-      {
-        // Track must be deleted
 #ifdef OPENMVG_USE_OPENMP
         #pragma omp critical
 #endif
-        rejectedId.push_front(tracks_it.first);
+        ++(*my_progress_bar);
+      }
+      Landmark & landmark = *landmarks[i].second;
+      Landmark robust_landmark;
+      if (robust_track_triangulation(
+            sfm_data, landmark.obs,
+            max_reprojection_error_, min_required_inliers_, min_sample_index_,
+            robust_landmark, scratch))
+      {
+        landmark = std::move(robust_landmark);
+        keep[i] = 1;
       }
     }
   }
   // Erase the unsuccessful triangulated tracks
-  for (auto& it : rejectedId)
-  {
-    sfm_data.structure.erase(it);
-  }
-}
-
-Observations ObservationsSampler
-(
-  const Observations & obs,
-  const std::vector<std::uint32_t> & samples
-)
-{
-  Observations sampled_obs;
-  for (const auto& idx : samples)
+  for (size_t i = 0; i < landmarks.size(); ++i)
   {
-    Observations::const_iterator obs_it = obs.cbegin();
-    std::advance(obs_it, idx);
-    sampled_obs.insert(*obs_it);
+    if (!keep[i])
+      sfm_data.structure.erase(landmarks[i].first);
   }
-  return sampled_obs;
 }
 
 /// Robustly try to estimate the best 3D point using a ransac scheme
@@ -307,113 +494,11 @@ bool SfM_Data_Structure_Computation_Robust::robust_triangulation
 )
 const
 {
-  if (obs.size() < min_required_inliers_ || obs.size() < min_sample_index_)
-  {
-    return false;
-  }
-
-  const double dSquared_pixel_threshold = Square(max_reprojection_error_);
-
-  // Predicate to validate a sample (cheirality and residual error)
-  ResidualAndCheiralityPredicate predicate(dSquared_pixel_threshold);
-  auto predicate_binding = std::bind(&ResidualAndCheiralityPredicate::predicate,
-                                     predicate,
-                                     std::placeholders::_1,
-                                     std::placeholders::_2,
-                                     std::placeholders::_3,
-                                     std::placeholders::_4);
-
-  // Handle the case where all observations must be used
-  if (min_required_inliers_ == min_sample_index_ &&
-      obs.size() == min_required_inliers_)
-  {
-    // Generate the 3D point hypothesis by triangulating all the observations
-    Vec3 X;
-    if (track_triangulation(sfm_data, obs, X) &&
-        track_check_predicate(obs, sfm_data, X, predicate_binding))
-    {
-      landmark.X = X;
-      landmark.obs = obs;
-      return true;
-    }
-    return false;
-  }
-
-  // else we perform a robust estimation since
-  //  there is more observations than the minimal number of required sample.
-
-  const IndexT nbIter = obs.size() * 2; // TODO: automatic computation of the number of iterations?
-
-  // - Ransac variables
-  Vec3 best_model = Vec3::Zero();
-  std::deque<IndexT> best_inlier_set;
-  double best_error = std::numeric_limits<double>::max();
-
-  //--
-  // Random number generation
-  std::mt19937 random_generator(std::mt19937::default_seed);
-
-  // - Ransac loop
-  for (IndexT i = 0; i < nbIter; ++i)
-  {
-    std::vector<uint32_t> samples;
-    robust::UniformSample(min_sample_index_, obs.size(), random_generator, &samples);
-
-    Vec3 X;
-    // Hypothesis generation
-    const auto minimal_sample = ObservationsSampler(obs, samples);
-
-    if (!track_triangulation(sfm_data, minimal_sample, X))
-      continue;
-
-    // Test validity of the hypothesis
-    if (!track_check_predicate(minimal_sample, sfm_data, X, predicate_binding))
-      continue;
-
-    std::deque<IndexT> inlier_set;
-    double current_error = 0.0;
-    // inlier/outlier classification according pixel residual errors.
-    for (const auto & obs_it : obs)
-    {
-      const View * view = sfm_data.views.at(obs_it.first).get();
-      if (!sfm_data.IsPoseAndIntrinsicDefined(view))
-        continue;
-      const IntrinsicBase & cam =  *sfm_data.GetIntrinsics().at(view->id_intrinsic).get();
-      const Pose3 pose = sfm_data.GetPoseOrDie(view);
-      if (!CheiralityTest(cam(obs_it.second.x), pose, X))
-        continue;
-      const double residual_sq = cam.residual(pose(X), obs_it.second.x).squaredNorm();
-      if (residual_sq < dSquared_pixel_threshold)
-      {
-        inlier_set.push_front(obs_it.first);
-        current_error += residual_sq;
-      }
-      else
-      {
-        current_error += dSquared_pixel_threshold;
-      }
-    }
-    // Does the hypothesis:
-    // - is the best one we have seen so far.
-    // - has sufficient inliers.
-    if (current_error < best_error &&
-      inlier_set.size() >= min_required_inliers_)
-    {
-      best_model = X;
-      best_inlier_set = inlier_set;
-      best_error = current_error;
-    }
-  }
-  if (!best_inlier_set.empty() && best_inlier_set.size() >= min_required_inliers_)
-  {
-    // Update information (3D landmark position & valid observations)
-    landmark.X = best_model;
-    for (const IndexT & val : best_inlier_set)
-    {
-      landmark.obs[val] = obs.at(val);
-    }
-  }
-  return !best_inlier_set.empty();
+  TriangulationScratch scratch;
+  return robust_track_triangulation(
+    sfm_data, obs,
+    max_reprojection_error_, min_required_inliers_, min_sample_index_,
+    landmark, scratch);
 }
 
 } // namespace sfm
@@ -10,14 +10,23 @@
 // Test summary:
 //-----------------
 // - Test sfm_data track triangulation
+// - Test the flattened track triangulation against a per observation
+//   reference implementation (noisy, behind camera and degenerate tracks)
 //-----------------
 
+#include "openMVG/multiview/triangulation_nview.hpp"
+#include "openMVG/robust_estimation/rand_sampling.hpp"
 #include "openMVG/sfm/pipelines/pipelines_test.hpp"
 #include "openMVG/sfm/sfm_data_triangulation.hpp"
 
 #include "testing/testing.h"
 
+#include <deque>
+#include <random>
+
 using namespace openMVG;
+using namespace openMVG::cameras;
+using namespace openMVG::geometry;
 using namespace openMVG::sfm;
 
 TEST(SFM_DATA_TRIANGULATION, BLIND) {
@@ -110,6 +119,287 @@ TEST(SFM_DATA_TRIANGULATION, ROBUST) {
 
 }
 
+//--
+// Reference implementation: triangulation of the observations of a track one
+// by one (without the flattened track data).
+//--
+
+bool reference_track_triangulation
+(
+  const SfM_Data & sfm_data,
+  const Observations & obs,
+  Vec3 & X
+)
+{
+  std::vector<Vec3> bearing;
+  std::vector<Mat34> poses;
+  for (const auto& observation : obs)
+  {
+    const View * view = sfm_data.views.at(observation.first).get();
+    if (!sfm_data.IsPoseAndIntrinsicDefined(view))
+      continue;
+    const IntrinsicBase * cam = sfm_data.GetIntrinsics().at(view->id_intrinsic).get();
+    bearing.emplace_back((*cam)(cam->get_ud_pixel(observation.second.x)));
+    poses.emplace_back(sfm_data.GetPoseOrDie(view).asMatrix());
+  }
+  if (bearing.size() < 2)
+    return false;
+  const Eigen::Map<const Mat3X> bearing_matrix(bearing[0].data(), 3, bearing.size());
+  Vec4 Xhomogeneous;
+  if (!TriangulateNViewAlgebraic(bearing_matrix, poses, &Xhomogeneous))
+    return false;
+  X = Xhomogeneous.hnormalized();
+  return true;
+}
+
+// Return true if the point is in front of all the cameras and (if the
+// threshold is positive) has a residual lower than the threshold
+bool reference_track_check
+(
+  const SfM_Data & sfm_data,
+  const Observations & obs,
+  const Vec3 & X,
+  const double squared_pixel_threshold
+)
+{
+  bool visibility = false;
+  for (const auto & obs_it : obs)
+  {
+    const View * view = sfm_data.views.at(obs_it.first).get();
+    if (!sfm_data.IsPoseAndIntrinsicDefined(view))
+      continue;
+    visibility = true;
+    const IntrinsicBase & cam = *sfm_data.GetIntrinsics().at(view->id_intrinsic).get();
+    const Pose3 pose = sfm_data.GetPoseOrDie(view);
+    if (!CheiralityTest(cam(obs_it.second.x), pose, X))
+      return false;
+    if (squared_pixel_threshold > 0 &&
+        cam.residual(pose(X), obs_it.second.x).squaredNorm() >= squared_pixel_threshold)
+      return false;
+  }
+  return visibility;
+}
+
+bool reference_robust_triangulation
+(
+  const SfM_Data & sfm_data,
+  const Observations & obs,
+  const double max_reprojection_error,
+  const IndexT min_required_inliers,
+  const IndexT min_sample_index,
+  Landmark & landmark
+)
+{
+  if (obs.size() < min_required_inliers || obs.size() < min_sample_index)
+    return false;
+
+  const double dSquared_pixel_threshold = Square(max_reprojection_error);
+  if (min_required_inliers == min_sample_index &&
+      obs.size() == min_required_inliers)
+  {
+    Vec3 X;
+    if (reference_track_triangulation(sfm_data, obs, X) &&
+        reference_track_check(sfm_data, obs, X, dSquared_pixel_threshold))
+    {
+      landmark.X = X;
+      landmark.obs = obs;
+      return true;
+    }
+    return false;
+  }
+
+  Vec3 best_model = Vec3::Zero();
+  std::deque<IndexT> best_inlier_set;
+  double best_error = std::numeric_limits<double>::max();
+  std::mt19937 random_generator(std::mt19937::default_seed);
+  for (IndexT i = 0; i < obs.size() * 2; ++i)
+  {
+    std::vector<uint32_t> samples;
+    robust::UniformSample(min_sample_index, obs.size(), random_generator, &samples);
+    Observations minimal_sample;
+    for (const auto& idx : samples)
+    {
+      Observations::const_iterator obs_it = obs.cbegin();
+      std::advance(obs_it, idx);
+      minimal_sample.insert(*obs_it);
+    }
+
+    Vec3 X;
+    if (!reference_track_triangulation(sfm_data, minimal_sample, X) ||
+        !reference_track_check(sfm_data, minimal_sample, X, dSquared_pixel_threshold))
+      continue;
+
+    std::deque<IndexT> inlier_set;
+    double current_error = 0.0;
+    for (const auto & obs_it : obs)
+    {
+      const View * view = sfm_data.views.at(obs_it.first).get();
+      if (!sfm_data.IsPoseAndIntrinsicDefined(view))
+        continue;
+      const IntrinsicBase & cam = *sfm_data.GetIntrinsics().at(view->id_intrinsic).get();
+      const Pose3 pose = sfm_data.GetPoseOrDie(view);
+      if (!CheiralityTest(cam(obs_it.second.x), pose, X))
+        continue;
+      const double residual_sq = cam.residual(pose(X), obs_it.second.x).squaredNorm();
+      if (residual_sq < dSquared_pixel_threshold)
+      {
+        inlier_set.push_front(obs_it.first);
+        current_error += residual_sq;
+      }
+      else
+      {
+        current_error += dSquared_pixel_threshold;
+      }
+    }
+    if (current_error < best_error && inlier_set.size() >= min_required_inliers)
+    {
+      best_model = X;
+      best_inlier_set = inlier_set;
+      best_error = current_error;
+    }
+  }
+  if (!best_inlier_set.empty() && best_inlier_set.size() >= min_required_inliers)
+  {
+    landmark.X = best_model;
+    for (const IndexT & val : best_inlier_set)
+      landmark.obs[val] = obs.at(val);
+  }
+  return !best_inlier_set.empty();
+}
+
+// Scene with noisy observations, outliers, points behind a camera and
+// degenerate tracks (parallel rays, single observation)
+SfM_Data ReferenceScene()
+{
+  const int nviews = 6;
+  const int npoints = 64;
+  const nViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+  SfM_Data sfm_data = getInputScene(d, config, cameras::PINHOLE_CAMERA);
+
+  // Noise and outliers
+  std::mt19937 random_generator(std::mt19937::default_seed);
+  std::normal_distribution<double> noise(0.0, 0.5);
+  for (auto & landmark_it : sfm_data.structure)
+  {
+    for (auto & obs_it : landmark_it.second.obs)
+    {
+      obs_it.second.x += Vec2(noise(random_generator), noise(random_generator));
+      if ((landmark_it.first + obs_it.first) % 7 == 0)
+        obs_it.second.x += Vec2(40.0, -25.0);
+    }
+  }
+
+  // A view sharing the pose of the view 0 (its rays are parallel to the
+  // rays of the view 0)
+  sfm_data.views[nviews] = std::make_shared<View>
+    ("", nviews, 0, 0, config._cx *2, config._cy *2);
+
+  const IntrinsicBase & cam = *sfm_data.GetIntrinsics().at(0);
+  IndexT landmark_id = npoints;
+  for (int i = 0; i < 8; ++i)
+  {
+    const Vec3 X = sfm_data.structure.at(i).X;
+
+    // Point mirrored behind the camera 0: same projection in the view 0
+    {
+      const Vec3 X_behind = 2.0 * sfm_data.poses.at(0).center() - X;
+      Landmark & landmark = sfm_data.structure[landmark_id++];
+      for (int j = 0; j < nviews; ++j)
+      {
+        const Pose3 & pose = sfm_data.poses.at(j);
+        landmark.obs[j] = Observation(cam.project(pose(j == 0 ? X : X_behind)), i);
+      }
+    }
+    // Parallel rays (same observation in the views 0 and nviews)
+    {
+      const Vec2 x = cam.project(sfm_data.poses.at(0)(X));
+      Landmark & landmark = sfm_data.structure[landmark_id++];
+      landmark.obs[0] = Observation(x, i);
+      landmark.obs[nviews] = Observation(x, i);
+      if (i % 2)
+        landmark.obs[nviews].x += Vec2(0.0, 1e-12);
+    }
+    // Single observation
+    {
+      Landmark & landmark = sfm_data.structure[landmark_id++];
+      landmark.obs[1] = Observation(cam.project(sfm_data.poses.at(1)(X)), i);
+    }
+  }
+  return sfm_data;
+}
+
+bool SamePoint(const Vec3 & X, const Vec3 & X_ref)
+{
+  return (X - X_ref).norm() <= 1e-8 * std::max(1.0, X_ref.norm());
+}
+
+TEST(SFM_DATA_TRIANGULATION, BLIND_VS_REFERENCE) {
+
+  const SfM_Data sfm_data = ReferenceScene();
+
+  SfM_Data sfm_data_2 = sfm_data;
+  SfM_Data_Structure_Computation_Blind triangulation_engine;
+  triangulation_engine.triangulate(sfm_data_2);
+
+  int nb_kept = 0, nb_rejected = 0;
+  for (const auto & landmark_it : sfm_data.structure)
+  {
+    Vec3 X_ref;
+    const bool bKeep =
+      reference_track_triangulation(sfm_data, landmark_it.second.obs, X_ref) &&
+      reference_track_check(sfm_data, landmark_it.second.obs, X_ref, -1.0);
+    const auto it = sfm_data_2.structure.find(landmark_it.first);
+    EXPECT_EQ(bKeep, it != sfm_data_2.structure.end());
+    if (bKeep && it != sfm_data_2.structure.end())
+    {
+      EXPECT_TRUE(SamePoint(it->second.X, X_ref));
+      EXPECT_EQ(landmark_it.second.obs.size(), it->second.obs.size());
+    }
+    bKeep ? ++nb_kept : ++nb_rejected;
+  }
+  // Both cases are covered by the scene
+  EXPECT_TRUE(nb_kept > 0);
+  EXPECT_TRUE(nb_rejected > 0);
+}
+
+TEST(SFM_DATA_TRIANGULATION, ROBUST_VS_REFERENCE) {
+
+  const SfM_Data sfm_data = ReferenceScene();
+
+  for (const IndexT min_required_inliers : {2, 3})
+  {
+    const double max_reprojection_error = 4.0;
+    SfM_Data_Structure_Computation_Robust triangulation_engine(
+      max_reprojection_error, min_required_inliers, min_required_inliers);
+
+    SfM_Data sfm_data_2 = sfm_data;
+    triangulation_engine.triangulate(sfm_data_2);
+
+    int nb_kept = 0, nb_rejected = 0;
+    for (const auto & landmark_it : sfm_data.structure)
+    {
+      Landmark landmark_ref;
+      const bool bKeep = reference_robust_triangulation(
+        sfm_data, landmark_it.second.obs,
+        max_reprojection_error, min_required_inliers, min_required_inliers,
+        landmark_ref);
+      const auto it = sfm_data_2.structure.find(landmark_it.first);
+      EXPECT_EQ(bKeep, it != sfm_data_2.structure.end());
+      if (bKeep && it != sfm_data_2.structure.end())
+      {
+        EXPECT_TRUE(SamePoint(it->second.X, landmark_ref.X));
+        EXPECT_EQ(landmark_ref.obs.size(), it->second.obs.size());
+        for (const auto & obs_it : landmark_ref.obs)
+          EXPECT_EQ(1, it->second.obs.count(obs_it.first));
+      }
+      bKeep ? ++nb_kept : ++nb_rejected;
+    }
+    EXPECT_TRUE(nb_kept > 0);
+    EXPECT_TRUE(nb_rejected > 0);
+  }
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
@@ -11,6 +11,7 @@
 
 #include <array>
 #include <bitset>
+#include <cstdint>
 
 #if defined _MSC_VER
   #include <intrin.h>
@@ -37,6 +38,9 @@ class CpuInstructionSet
   bool m_SSE42 = false;
   bool m_AVX = false;
   bool m_AVX2 = false;
+  bool m_FMA = false;
+  bool m_AVX512F = false;
+  bool m_AVX512BW = false;
   bool m_POPCNT = false;
 
   public:
@@ -59,17 +63,27 @@ class CpuInstructionSet
       m_SSE2 = Edx[26];
 
       const std::bitset<32> Ecx (cpui[2]);
-      m_AVX = Ecx[28];
       m_SSE3 = Edx[0];
       m_SSE41 = Ecx[19];
       m_SSE42 = Ecx[20];
       m_POPCNT = Ecx[23];
 
+      // The AVX registers can only be used if the OS saves them on context
+      //  switches (OSXSAVE, then the XCR0 register: YMM state, then opmask and
+      //  ZMM states for AVX-512)
+      const uint64_t xcr0 = Ecx[27] ? internal_xgetbv() : 0;
+      const bool os_ymm = (xcr0 & 0x6) == 0x6;
+      const bool os_zmm = os_ymm && (xcr0 & 0xE0) == 0xE0;
+      m_AVX = Ecx[28] && os_ymm;
+      m_FMA = Ecx[12] && os_ymm;
+
       if (nIds > 6)
       {
         internal_cpuid(cpui.data(), 7);
         const std::bitset<32> Ebx (cpui[1]);
-        m_AVX2 = Ebx[5];
+        m_AVX2 = Ebx[5] && os_ymm;
+        m_AVX512F = Ebx[16] && os_zmm;
+        m_AVX512BW = Ebx[30] && os_zmm;
       }
     }
   }
@@ -109,6 +123,21 @@ class CpuInstructionSet
     return m_AVX2;
   }
 
+  bool supportFMA() const
+  {
+    return m_FMA;
+  }
+
+  bool supportAVX512F() const
+  {
+    return m_AVX512F;
+  }
+
+  bool supportAVX512BW() const
+  {
+    return m_AVX512BW;
+  }
+
   bool supportPOPCNT() const
   {
     return m_POPCNT;
@@ -127,6 +156,20 @@ private:
     #endif
     return false;
   }
+
+  // Extended control register XCR0 (only valid if OSXSAVE is set)
+  static uint64_t internal_xgetbv()
+  {
+    #if defined __GNUC__
+    uint32_t eax, edx;
+    __asm__ __volatile__ ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+    #endif
+    #if defined _MSC_VER
+    return _xgetbv(0);
+    #endif
+    return 0;
+  }
 };
 
 } // namespace system
@@ -0,0 +1,315 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/features/descriptor.hpp"
+#include "openMVG/matching/matcher_brute_force.hpp"
+#include "openMVG/matching/matcher_brute_force_batched.hpp"
+#include "openMVG/matching/matcher_cascade_hashing.hpp"
+#include "openMVG/matching/matcher_kdtree_flann.hpp"
+#include "openMVG/system/timer.hpp"
+
+#include "third_party/cmdLine/cmdLine.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace openMVG;
+using namespace openMVG::matching;
+
+// Matches kept by the distance ratio test
+static IndMatches RatioTestMatches
+(
+  const IndMatches & nn_indices,
+  const std::vector<float> & nn_distances,
+  const float distance_ratio
+)
+{
+  IndMatches matches;
+  for (size_t i = 0; i < nn_indices.size(); i += 2)
+  {
+    if (nn_distances[i] < Square(distance_ratio) * nn_distances[i + 1])
+      matches.push_back(nn_indices[i]);
+  }
+  return matches;
+}
+
+// Fraction of the exact matches found by the approximate matching
+static double Recall
+(
+  const IndMatches & exact_matches,
+  IndMatches matches
+)
+{
+  if (exact_matches.empty())
+    return 1.0;
+  std::sort(matches.begin(), matches.end());
+  int count = 0;
+  for (const auto & match : exact_matches)
+    count += std::binary_search(matches.cbegin(), matches.cend(), match);
+  return count / static_cast<double>(exact_matches.size());
+}
+
+struct BenchmarkResult
+{
+  double build_ms = 0.0;
+  double search_ms = 0.0;
+  IndMatches matches; // Ratio test matches
+};
+
+/// Build the matcher on the database and search the 2 nearest neighbors of the queries
+template <typename MatcherT, typename Scalar>
+static bool RunMatcher
+(
+  MatcherT & matcher,
+  const std::vector<Scalar> & database,
+  const std::vector<Scalar> & queries,
+  const int dimension,
+  const float distance_ratio,
+  BenchmarkResult & result
+)
+{
+  system::Timer timer;
+  if (!matcher.Build(database.data(), database.size() / dimension, dimension))
+    return false;
+  result.build_ms = timer.elapsedMs();
+
+  timer.reset();
+  IndMatches nn_indices;
+  std::vector<typename MatcherT::DistanceType> nn_distances;
+  if (!matcher.SearchNeighbours(queries.data(), queries.size() / dimension,
+        &nn_indices, &nn_distances, 2))
+    return false;
+  result.search_ms = timer.elapsedMs();
+
+  result.matches = RatioTestMatches(nn_indices,
+    std::vector<float>(nn_distances.cbegin(), nn_distances.cend()), distance_ratio);
+  return true;
+}
+
+static void PrintResult
+(
+  const std::string & name,
+  const BenchmarkResult & result,
+  const IndMatches & exact_matches,
+  const double reference_ms
+)
+{
+  std::cout << std::left << std::setw(36) << name << std::right << std::fixed
+    << std::setw(10) << std::setprecision(1) << result.build_ms
+    << std::setw(12) << std::setprecision(1) << result.search_ms
+    << std::setw(10) << std::setprecision(3) << Recall(exact_matches, result.matches)
+    << std::setw(10) << std::setprecision(1) << reference_ms / (result.build_ms + result.search_ms) << "x"
+    << std::endl;
+}
+
+template <typename Scalar>
+static void Benchmark
+(
+  const std::vector<Scalar> & database,
+  const std::vector<Scalar> & queries,
+  const int dimension,
+  const float distance_ratio,
+  const double target_recall
+)
+{
+  std::cout
+    << "\n" << database.size() / dimension << " database x " << queries.size() / dimension
+    << " query descriptors (" << dimension << " x "
+    << (std::is_same<Scalar, float>::value ? "float" : "unsigned char") << ")\n"
+    << std::left << std::setw(36) << "Matcher" << std::right
+    << std::setw(10) << "Build(ms)" << std::setw(12) << "Search(ms)"
+    << std::setw(10) << "Recall" << std::setw(11) << "Speedup" << std::endl;
+
+  // Reference: one distance at a time brute force matching
+  BenchmarkResult reference;
+  {
+    ArrayMatcherBruteForce<Scalar, L2<Scalar>> matcher;
+    if (!RunMatcher(matcher, database, queries, dimension, distance_ratio, reference))
+      return;
+  }
+  const IndMatches & exact_matches = reference.matches;
+  const double reference_ms = reference.build_ms + reference.search_ms;
+  PrintResult("BruteForce (reference)", reference, exact_matches, reference_ms);
+
+  // Batched brute force kernels
+  const std::pair<EBruteForceKernel, std::string> kernels[] = {
+    {EBruteForceKernel::GENERIC, "BruteForceBatched GENERIC"},
+    {EBruteForceKernel::AVX2, "BruteForceBatched AVX2"},
+    {EBruteForceKernel::AVX512, "BruteForceBatched AVX512"}};
+  for (const auto & kernel : kernels)
+  {
+    if (!internal::IsSupported(kernel.first))
+    {
+      std::cout << std::left << std::setw(36) << kernel.second << "not supported by the CPU" << std::endl;
+      continue;
+    }
+    ArrayMatcherBruteForceBatched<Scalar> matcher(kernel.first);
+    BenchmarkResult result;
+    if (RunMatcher(matcher, database, queries, dimension, distance_ratio, result))
+      PrintResult(kernel.second, result, exact_matches, reference_ms);
+  }
+
+  // FLANN KDTree: increase the number of checks until the target recall is reached
+  for (int checks = 8; checks <= 4096; checks *= 2)
+  {
+    ArrayMatcher_Kdtree_Flann<Scalar, flann::L2<Scalar>> matcher(checks);
+    BenchmarkResult result;
+    if (!RunMatcher(matcher, database, queries, dimension, distance_ratio, result))
+      break;
+    PrintResult("ANN_L2 (FLANN " + std::to_string(checks) + " checks)", result, exact_matches, reference_ms);
+    if (Recall(exact_matches, result.matches) >= target_recall)
+      break;
+  }
+
+  // Cascade hashing
+  {
+    ArrayMatcherCascadeHashing<Scalar, L2<Scalar>> matcher;
+    BenchmarkResult result;
+    if (RunMatcher(matcher, database, queries, dimension, distance_ratio, result))
+      PrintResult("CASCADE_HASHING_L2", result, exact_matches, reference_ms);
+  }
+}
+
+// Clustered synthetic descriptors (SIFT like value range), the queries are
+// noisy copies of some random database descriptors.
+static void SyntheticDescriptors
+(
+  const int database_count,
+  const int query_count,
+  const int dimension,
+  std::vector<unsigned char> & database,
+  std::vector<unsigned char> & queries
+)
+{
+  std::mt19937 rng(std::mt19937::default_seed);
+  std::uniform_real_distribution<float> distrib_center(0.f, 128.f);
+  std::normal_distribution<float> distrib_noise(0.f, 24.f);
+  std::uniform_int_distribution<int> distrib_index(0, database_count - 1);
+
+  const int center_count = 256;
+  std::vector<float> centers(center_count * dimension);
+  for (auto & value : centers)
+    value = distrib_center(rng);
+
+  const auto clamp = [](const float value) -> unsigned char {
+    return static_cast<unsigned char>(std::min(std::max(value, 0.f), 255.f)); };
+
+  database.resize(database_count * dimension);
+  for (int i = 0; i < database_count; ++i)
+  {
+    const float * center = &centers[(i % center_count) * dimension];
+    for (int j = 0; j < dimension; ++j)
+      database[i * dimension + j] = clamp(center[j] + distrib_noise(rng));
+  }
+  queries.resize(query_count * dimension);
+  for (int i = 0; i < query_count; ++i)
+  {
+    const unsigned char * descriptor = &database[distrib_index(rng) * dimension];
+    for (int j = 0; j < dimension; ++j)
+      queries[i * dimension + j] = clamp(descriptor[j] + 0.5f * distrib_noise(rng));
+  }
+}
+
+// Load SIFT descriptors (.desc file) as a flat array
+static bool LoadSIFTDescriptors
+(
+  const std::string & filename,
+  std::vector<unsigned char> & descriptors
+)
+{
+  using DescriptorT = features::Descriptor<unsigned char, 128>;
+  std::vector<DescriptorT, Eigen::aligned_allocator<DescriptorT>> vec_desc;
+  if (!features::loadDescsFromBinFile(filename, vec_desc) || vec_desc.empty())
+    return false;
+  descriptors.resize(vec_desc.size() * 128);
+  for (size_t i = 0; i < vec_desc.size(); ++i)
+    std::copy(vec_desc[i].data(), vec_desc[i].data() + 128, &descriptors[i * 128]);
+  return true;
+}
+
+//--
+// Descriptor matching benchmark:
+// - compare the brute force matchers (reference and batched kernels) with the
+//   approximate FLANN and cascade hashing matchers: timing and recall of the
+//   distance ratio test matches (vs. the exact matches).
+//
+int main(int argc, char **argv)
+{
+  CmdLine cmd;
+  //--
+  // Command line parameters
+  std::string sDatabase_Descriptors = "";
+  std::string sQuery_Descriptors = "";
+  int iDatabase_Count = 20000;
+  int iQuery_Count = 10000;
+  float fDist_Ratio = 0.8f;
+  double dTarget_Recall = 0.95;
+  cmd.add( make_option('d', sDatabase_Descriptors, "database_descriptors") );
+  cmd.add( make_option('q', sQuery_Descriptors, "query_descriptors") );
+  cmd.add( make_option('n', iDatabase_Count, "database_count") );
+  cmd.add( make_option('m', iQuery_Count, "query_count") );
+  cmd.add( make_option('r', fDist_Ratio, "ratio") );
+  cmd.add( make_option('t', dTarget_Recall, "target_recall") );
+  //--
+
+  //--
+  // Command line parsing
+  try {
+      cmd.process(argc, argv);
+  } catch (const std::string& s) {
+      std::cerr << "Usage: " << argv[0] << '\n'
+      << "\n[Optional]\n"
+      << "[-d|--database_descriptors] SIFT descriptor file (.desc) of the database\n"
+      << "[-q|--query_descriptors] SIFT descriptor file (.desc) of the queries\n"
+      << "  (synthetic descriptors are used if no files are given)\n"
+      << "[-n|--database_count] number of synthetic database descriptors (default 20000)\n"
+      << "[-m|--query_count] number of synthetic query descriptors (default 10000)\n"
+      << "[-r|--ratio] distance ratio of the matches (default 0.8)\n"
+      << "[-t|--target_recall] recall of the FLANN matcher (default 0.95):\n"
+      << "  the number of checks is increased until this recall is reached\n"
+      << std::endl;
+
+      std::cerr << s << std::endl;
+      return EXIT_FAILURE;
+  }
+  //--
+
+  std::vector<unsigned char> database, queries;
+  if (!sDatabase_Descriptors.empty() || !sQuery_Descriptors.empty())
+  {
+    if (!LoadSIFTDescriptors(sDatabase_Descriptors, database) ||
+        !LoadSIFTDescriptors(sQuery_Descriptors, queries))
+    {
+      std::cerr << "Cannot load the descriptor files" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  else
+  {
+    if (iDatabase_Count < 2 || iQuery_Count < 1)
+    {
+      std::cerr << "Invalid number of descriptors" << std::endl;
+      return EXIT_FAILURE;
+    }
+    SyntheticDescriptors(iDatabase_Count, iQuery_Count, 128, database, queries);
+  }
+
+  // unsigned char (SIFT) and float descriptors
+  Benchmark(database, queries, 128, fDist_Ratio, dTarget_Recall);
+  Benchmark(
+    std::vector<float>(database.cbegin(), database.cend()),
+    std::vector<float>(queries.cbegin(), queries.cend()),
+    128, fDist_Ratio, dTarget_Recall);
+
+  return EXIT_SUCCESS;
+}
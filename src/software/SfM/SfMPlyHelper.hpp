@@ -10,9 +10,8 @@
 #define OPENMVG_SFM_PLY_HELPER_H
 
 #include "openMVG/numeric/numeric.h"
+#include "openMVG/sfm/sfm_data_io_ply.hpp"
 
-#include <fstream>
-#include <iomanip>
 #include <string>
 #include <vector>
 
@@ -25,37 +24,19 @@ bool
 exportToPly
 (
   const std::vector<Vec3> & vec_points,
-  const std::string & sFileName
+  const std::string & sFileName,
+  bool b_write_in_ascii = false
 )
 {
-  std::ofstream outfile(sFileName.c_str());
-  if (!outfile.is_open())
-    return false;
-
-  outfile << "ply"
-    << std::endl << "format ascii 1.0"
-    << std::endl << "element vertex " << vec_points.size()
-    << std::endl << "property double x"
-    << std::endl << "property double y"
-    << std::endl << "property double z"
-    << std::endl << "property uchar red"
-    << std::endl << "property uchar green"
-    << std::endl << "property uchar blue"
-    << std::endl << "end_header" << std::endl;
-
-  outfile << std::fixed << std::setprecision (std::numeric_limits<double>::digits10 + 1);
-
-  for (size_t i=0; i < vec_points.size(); ++i)
-  {
-    outfile
-      << vec_points[i](0) << ' '
-      << vec_points[i](1) << ' '
-      << vec_points[i](2) << ' '
-      << "255 255 255" << "\n";
-  }
-  const bool bOk = outfile.good();
-  outfile.close();
-  return bOk;
+  return sfm::Save_PLY_Vertices(
+    sFileName,
+    vec_points.size(),
+    [&](std::size_t i, Vec3 & X, sfm::Vec3uc & color)
+    {
+      X = vec_points[i];
+      color = sfm::Vec3uc(255, 255, 255);
+    },
+    b_write_in_ascii);
 }
 
 /// Export 3D point vector and camera position to PLY format
@@ -64,55 +45,40 @@ inline bool exportToPly
   const std::vector<Vec3> & vec_points,
   const std::vector<Vec3> & vec_camPos,
   const std::string & sFileName,
-  const std::vector<Vec3> * vec_coloredPoints = nullptr
+  const std::vector<Vec3> * vec_coloredPoints = nullptr,
+  bool b_write_in_ascii = false
 )
 {
-  std::ofstream outfile(sFileName.c_str());
-  if (!outfile.is_open())
-    return false;
-
-  outfile << "ply"
-    << '\n' << "format ascii 1.0"
-    << '\n' << "element vertex " << vec_points.size()+vec_camPos.size()
-    << '\n' << "property double x"
-    << '\n' << "property double y"
-    << '\n' << "property double z"
-    << '\n' << "property uchar red"
-    << '\n' << "property uchar green"
-    << '\n' << "property uchar blue"
-    << '\n' << "end_header" << std::endl;
-
-  outfile << std::fixed << std::setprecision (std::numeric_limits<double>::digits10 + 1);
-
-  for (size_t i=0; i < vec_points.size(); ++i)  {
-    if (vec_coloredPoints == nullptr)
-      outfile
-        << vec_points[i](0) << ' '
-        << vec_points[i](1) << ' '
-        << vec_points[i](2) << ' '
-        << "255 255 255\n";
-    else
-      outfile
-        << vec_points[i](0) << ' '
-        << vec_points[i](1) << ' '
-        << vec_points[i](2) << ' '
-        << static_cast<int>((*vec_coloredPoints)[i](0)) << ' '
-        << static_cast<int>((*vec_coloredPoints)[i](1)) << ' '
-        << static_cast<int>((*vec_coloredPoints)[i](2))
-        << "\n";
-  }
+  return sfm::Save_PLY_Vertices(
+    sFileName,
+    vec_points.size() + vec_camPos.size(),
+    [&](std::size_t i, Vec3 & X, sfm::Vec3uc & color)
+    {
+      if (i < vec_points.size())
+      {
+        X = vec_points[i];
+        color = (vec_coloredPoints == nullptr) ?
+          sfm::Vec3uc(255, 255, 255) :
+          (*vec_coloredPoints)[i].cast<unsigned char>();
+      }
+      else
+      {
+        X = vec_camPos[i - vec_points.size()];
+        color = sfm::Vec3uc(0, 255, 0);
+      }
+    },
+    b_write_in_ascii);
+}
 
-  for (size_t i=0; i < vec_camPos.size(); ++i)  {
-    outfile
-      << vec_camPos[i](0) << ' '
-      << vec_camPos[i](1) << ' '
-      << vec_camPos[i](2) << ' '
-      << "0 255 0\n";
-  }
-  outfile.flush();
-  const bool bOk = outfile.good();
-  outfile.close();
-  return bOk;
+/// Import 3D points (and their colors) from a PLY file
+inline bool importFromPly
+(
+  const std::string & sFileName,
+  std::vector<Vec3> & vec_points,
+  std::vector<sfm::Vec3uc> * vec_colors = nullptr
+)
+{
+  return sfm::Load_PLY_Vertices(sFileName, vec_points, vec_colors);
 }
 
 } // namespace plyHelper
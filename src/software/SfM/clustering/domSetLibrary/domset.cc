@@ -217,7 +217,7 @@ void Domset::voxelGridFilter( const float &sizeX, const float &sizeY, const floa
     if ( nPts == 0 )
       continue;
 
-    Eigen::Vector3f pos;
+    Eigen::Vector3f pos = Eigen::Vector3f::Zero();
     std::set<size_t> vl;
     for ( const auto &p : voxels[ vId ] )
     {
@@ -0,0 +1,472 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "domset_sparse.h"
+#if OPENMVG_USE_OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+
+#define for_parallel(i, nIters) for (int i = 0; i < static_cast<int>(nIters); ++i)
+
+namespace nomoko
+{
+SparseDomset::SparseDomset( const std::vector<View> &_views )
+{
+  std::cout << " [ Sparse dominant set clustering of views ] " << std::endl;
+  if ( _views.size() >= std::numeric_limits<uint32_t>::max() )
+  {
+    std::cerr << "Too many views\n";
+    exit( 0 );
+  }
+  centers.reserve( _views.size() );
+  for ( const auto &view : _views )
+    centers.push_back( view.trans );
+}
+
+void SparseDomset::addPoint( const Eigen::Vector3f &pos, const std::vector<size_t> &viewList )
+{
+  const size_t numV = viewList.size();
+  if ( numV < 2 )
+    return;
+
+  std::vector<Eigen::Vector3f> rays( numV );
+  for ( size_t i = 0; i < numV; i++ )
+    rays[ i ] = ( centers[ viewList[ i ] ] - pos ).normalized();
+
+  for ( size_t i = 0; i < numV; i++ )
+  {
+    for ( size_t j = i + 1; j < numV; j++ )
+    {
+      const uint64_t v1 = std::min( viewList[ i ], viewList[ j ] );
+      const uint64_t v2 = std::max( viewList[ i ], viewList[ j ] );
+      if ( v1 == v2 )
+        continue;
+      const float cosAngle = std::max( -1.f, std::min( 1.f, rays[ i ].dot( rays[ j ] ) ) );
+      const float angle    = acos( cosAngle );
+      PairWeight &pw       = pairWeights[ ( v1 << 32 ) | v2 ];
+      pw.w += exp( -( angle * angle ) / kAngleSigma_2 );
+      ++pw.count;
+    }
+  }
+} // addPoint
+
+void SparseDomset::buildSimilarityGraph()
+{
+  const size_t numC     = centers.size();
+  const size_t numPairs = pairWeights.size();
+
+  // unpacking the view pairs
+  std::vector<uint32_t> pairs1, pairs2;
+  std::vector<float> angularSims, dists;
+  pairs1.reserve( numPairs );
+  pairs2.reserve( numPairs );
+  angularSims.reserve( numPairs );
+  dists.reserve( numPairs );
+  std::vector<size_t> degree( numC, 1 ); // self similarity
+  for ( const auto &pair_it : pairWeights )
+  {
+    const uint32_t v1 = static_cast<uint32_t>( pair_it.first >> 32 );
+    const uint32_t v2 = static_cast<uint32_t>( pair_it.first & 0xFFFFFFFF );
+    pairs1.push_back( v1 );
+    pairs2.push_back( v2 );
+    angularSims.push_back( pair_it.second.w / pair_it.second.count );
+    dists.push_back( ( centers[ v1 ] - centers[ v2 ] ).norm() );
+    ++degree[ v1 ];
+    ++degree[ v2 ];
+  }
+  std::unordered_map<uint64_t, PairWeight>().swap( pairWeights );
+  numViewPairs = numPairs;
+
+  // median distance of the covisible views
+  float medianDist = 1.f;
+  if ( numPairs > 0 )
+  {
+    std::vector<float> sortedDists = dists;
+    std::nth_element( sortedDists.begin(), sortedDists.begin() + numPairs / 2, sortedDists.end() );
+    medianDist = std::max( sortedDists[ numPairs / 2 ], std::numeric_limits<float>::epsilon() );
+  }
+
+  // filling the symmetric graph
+  rowStart.assign( numC + 1, 0 );
+  for ( size_t i = 0; i < numC; i++ )
+    rowStart[ i + 1 ] = rowStart[ i ] + degree[ i ];
+  cols.resize( rowStart[ numC ] );
+  sims.resize( rowStart[ numC ] );
+  std::vector<size_t> fill( rowStart.begin(), rowStart.end() - 1 );
+  for ( size_t i = 0; i < numC; i++ )
+  {
+    cols[ fill[ i ] ] = static_cast<uint32_t>( i );
+    sims[ fill[ i ] ] = 0.f;
+    ++fill[ i ];
+  }
+  for ( size_t p = 0; p < numPairs; p++ )
+  {
+    const float sd  = 1.f / ( 1.f + exp( -( dists[ p ] - medianDist ) / medianDist ) );
+    const float sim = angularSims[ p ] * sd;
+    const uint32_t v1 = pairs1[ p ], v2 = pairs2[ p ];
+    cols[ fill[ v1 ] ] = v2;
+    sims[ fill[ v1 ]++ ] = sim;
+    cols[ fill[ v2 ] ] = v1;
+    sims[ fill[ v2 ]++ ] = sim;
+  }
+
+  // sorting the rows, in order to find the transposed edges
+  selfEdge.resize( numC );
+#if OPENMVG_USE_OPENMP
+#pragma omp parallel for schedule( dynamic, 64 )
+#endif
+  for_parallel( i, numC )
+  {
+    std::vector<std::pair<uint32_t, float>> row;
+    row.reserve( degree[ i ] );
+    for ( size_t e = rowStart[ i ]; e < rowStart[ i + 1 ]; e++ )
+      row.emplace_back( cols[ e ], sims[ e ] );
+    std::sort( row.begin(), row.end() );
+    for ( size_t k = 0; k < row.size(); k++ )
+    {
+      const size_t e = rowStart[ i ] + k;
+      cols[ e ] = row[ k ].first;
+      sims[ e ] = row[ k ].second;
+      if ( row[ k ].first == static_cast<uint32_t>( i ) )
+        selfEdge[ i ] = e;
+    }
+  }
+
+  transposedEdge.resize( cols.size() );
+#if OPENMVG_USE_OPENMP
+#pragma omp parallel for schedule( dynamic, 64 )
+#endif
+  for_parallel( i, numC )
+  {
+    for ( size_t e = rowStart[ i ]; e < rowStart[ i + 1 ]; e++ )
+    {
+      const uint32_t j = cols[ e ];
+      const auto it = std::lower_bound( cols.begin() + rowStart[ j ],
+                                        cols.begin() + rowStart[ j + 1 ], static_cast<uint32_t>( i ) );
+      transposedEdge[ e ] = it - cols.begin();
+    }
+  }
+} // buildSimilarityGraph
+
+void SparseDomset::computeClustersAP( std::map<size_t, std::vector<size_t>> &clMap,
+                                      std::vector<float> &E )
+{
+  const size_t numX     = centers.size();
+  const size_t numEdges = cols.size();
+  const float minFloat  = std::numeric_limits<float>::lowest();
+
+  // messages are only exchanged along the edges of the similarity graph
+  std::vector<float> R( numEdges, 0.f );
+  std::vector<float> A( numEdges, 0.f );
+  for ( size_t m = 0; m < kNumIter; m++ )
+  {
+    // compute responsibilities
+#if OPENMVG_USE_OPENMP
+#pragma omp parallel for schedule( dynamic, 64 )
+#endif
+    for_parallel( i, numX )
+    {
+      // isolated views keep null messages
+      if ( rowStart[ i + 1 ] - rowStart[ i ] < 2 )
+        continue;
+      float Y = minFloat, Y2 = minFloat;
+      size_t I = rowStart[ i ];
+      for ( size_t e = rowStart[ i ]; e < rowStart[ i + 1 ]; e++ )
+      {
+        const float as = A[ e ] + sims[ e ];
+        if ( as > Y )
+        {
+          Y2 = Y;
+          Y  = as;
+          I  = e;
+        }
+        else if ( as > Y2 )
+        {
+          Y2 = as;
+        }
+      }
+      for ( size_t e = rowStart[ i ]; e < rowStart[ i + 1 ]; e++ )
+      {
+        const float r = sims[ e ] - ( ( e == I ) ? Y2 : Y );
+        R[ e ] = ( ( 1 - lambda ) * r ) + ( lambda * R[ e ] );
+      }
+    }
+
+    // compute availabilities, column k is read through the transposed edges
+    // of row k (the graph is symmetric): each edge is written by one column
+#if OPENMVG_USE_OPENMP
+#pragma omp parallel for schedule( dynamic, 64 )
+#endif
+    for_parallel( k, numX )
+    {
+      float sumRp = 0.f;
+      for ( size_t e = rowStart[ k ]; e < rowStart[ k + 1 ]; e++ )
+      {
+        if ( e != selfEdge[ k ] )
+          sumRp += std::max( 0.f, R[ transposedEdge[ e ] ] );
+      }
+      const float rkk = R[ selfEdge[ k ] ];
+      for ( size_t e = rowStart[ k ]; e < rowStart[ k + 1 ]; e++ )
+      {
+        const size_t ik = transposedEdge[ e ];
+        const float a   = ( e == selfEdge[ k ] )
+                            ? sumRp
+                            : std::min( 0.f, rkk + sumRp - std::max( 0.f, R[ ik ] ) );
+        A[ ik ] = ( ( 1 - lambda ) * a ) + ( lambda * A[ ik ] );
+      }
+    }
+  }
+
+  E.resize( numX );
+  for ( size_t i = 0; i < numX; i++ )
+    E[ i ] = std::max( 0.f, A[ selfEdge[ i ] ] + R[ selfEdge[ i ] ] );
+
+  // assigning the views to their most similar exemplar
+  // (a view without neighboring exemplar starts its own cluster)
+  std::vector<size_t> exemplar( numX );
+#if OPENMVG_USE_OPENMP
+#pragma omp parallel for schedule( dynamic, 64 )
+#endif
+  for_parallel( i, numX )
+  {
+    exemplar[ i ] = i;
+    if ( E[ i ] > 0 )
+      continue;
+    float maxSim = minFloat;
+    for ( size_t e = rowStart[ i ]; e < rowStart[ i + 1 ]; e++ )
+    {
+      if ( E[ cols[ e ] ] > 0 && sims[ e ] > maxSim )
+      {
+        maxSim        = sims[ e ];
+        exemplar[ i ] = cols[ e ];
+      }
+    }
+  }
+
+  for ( size_t i = 0; i < numX; i++ )
+    clMap[ exemplar[ i ] ].push_back( i );
+} // computeClustersAP
+
+void SparseDomset::enforceClusterSizes( std::map<size_t, std::vector<size_t>> &clMap,
+                                        const std::vector<float> &E )
+{
+  bool change = false;
+  do
+  {
+    change = false;
+
+    // enforcing min size constraints:
+    // the closest cluster of each small cluster is searched in parallel,
+    // and the merges are applied in order (sizes are checked again)
+    std::vector<std::map<size_t, std::vector<size_t>>::iterator> clusters;
+    for ( auto p = clMap.begin(); p != clMap.end(); ++p )
+      clusters.push_back( p );
+    const size_t numCl = clusters.size();
+    std::vector<int> target( numCl, -1 );
+#if OPENMVG_USE_OPENMP
+#pragma omp parallel for schedule( dynamic )
+#endif
+    for_parallel( c1, numCl )
+    {
+      const size_t size1 = clusters[ c1 ]->second.size();
+      if ( size1 >= kMinClusterSize )
+        continue;
+      const Eigen::Vector3f &center1 = centers[ clusters[ c1 ]->first ];
+      float minDist = std::numeric_limits<float>::max();
+      for ( size_t c2 = 0; c2 < numCl; c2++ )
+      {
+        if ( static_cast<int>( c2 ) == c1 )
+          continue;
+        const float dist = ( center1 - centers[ clusters[ c2 ]->first ] ).squaredNorm();
+        if ( dist < minDist && ( size1 + clusters[ c2 ]->second.size() ) < kMaxClusterSize )
+        {
+          minDist      = dist;
+          target[ c1 ] = c2;
+        }
+      }
+    }
+
+    std::vector<bool> merged( numCl, false );
+    for ( size_t c1 = 0; c1 < numCl; c1++ )
+    {
+      const int c2 = target[ c1 ];
+      if ( c2 < 0 || merged[ c2 ] )
+        continue;
+      std::vector<size_t> &cl1 = clusters[ c1 ]->second;
+      std::vector<size_t> &cl2 = clusters[ c2 ]->second;
+      if ( cl1.size() + cl2.size() < kMaxClusterSize )
+      {
+        change = true;
+        cl2.insert( cl2.end(), cl1.begin(), cl1.end() );
+        merged[ c1 ] = true;
+      }
+    }
+    for ( size_t c = 0; c < numCl; c++ )
+    {
+      if ( merged[ c ] )
+        clMap.erase( clusters[ c ] );
+    }
+
+    // enforcing max size constraints:
+    // large clusters are split in slices along their largest extent
+    std::vector<std::vector<size_t>> large;
+    for ( auto p = clMap.begin(); p != clMap.end(); )
+    {
+      if ( p->second.size() > kMaxClusterSize )
+      {
+        change = true;
+        large.emplace_back( std::move( p->second ) );
+        p = clMap.erase( p );
+      }
+      else
+      {
+        ++p;
+      }
+    }
+
+    std::vector<std::vector<std::vector<size_t>>> slices( large.size() );
+#if OPENMVG_USE_OPENMP
+#pragma omp parallel for schedule( dynamic )
+#endif
+    for_parallel( l, large.size() )
+    {
+      std::vector<size_t> &cl = large[ l ];
+      Eigen::Vector3f minPt = centers[ cl[ 0 ] ], maxPt = centers[ cl[ 0 ] ];
+      for ( const size_t vId : cl )
+      {
+        minPt = minPt.cwiseMin( centers[ vId ] );
+        maxPt = maxPt.cwiseMax( centers[ vId ] );
+      }
+      Eigen::Vector3f::Index axis;
+      ( maxPt - minPt ).maxCoeff( &axis );
+      std::sort( cl.begin(), cl.end(), [&]( const size_t v1, const size_t v2 ) {
+        return centers[ v1 ]( axis ) < centers[ v2 ]( axis );
+      } );
+      for ( auto it = cl.begin(); it < cl.end(); it += std::min<size_t>( kMaxClusterSize, cl.end() - it ) )
+      {
+        std::vector<size_t> tmp( it, it + std::min<size_t>( kMaxClusterSize, cl.end() - it ) );
+        std::sort( tmp.begin(), tmp.end() );
+        slices[ l ].emplace_back( std::move( tmp ) );
+      }
+    }
+
+    // the center of a slice is its member of highest evidence
+    for ( auto &cls : slices )
+    {
+      for ( auto &cl : cls )
+      {
+        size_t center = cl[ 0 ];
+        for ( const size_t vId : cl )
+        {
+          if ( E[ vId ] > E[ center ] )
+            center = vId;
+        }
+        clMap[ center ] = std::move( cl );
+      }
+    }
+  } while ( change );
+} // enforceClusterSizes
+
+void SparseDomset::clusterViews(
+    const size_t &minClusterSize, const size_t &maxClusterSize )
+{
+  if ( centers.empty() )
+  {
+    std::cerr << "No Views initialized \n";
+    exit( 0 );
+  }
+  kMinClusterSize = minClusterSize;
+  kMaxClusterSize = maxClusterSize;
+
+  if ( rowStart.empty() )
+    buildSimilarityGraph();
+
+  std::map<size_t, std::vector<size_t>> clMap;
+  std::vector<float> E;
+  computeClustersAP( clMap, E );
+  enforceClusterSizes( clMap, E );
+
+  // adding it to clusters vector
+  std::vector<std::vector<size_t>> clusters;
+  clusters.reserve( clMap.size() );
+  for ( auto &p : clMap )
+  {
+    std::sort( p.second.begin(), p.second.end() );
+    clusters.emplace_back( std::move( p.second ) );
+  }
+  finalClusters.swap( clusters );
+}
+
+void SparseDomset::printClusters()
+{
+  std::stringstream ss;
+  ss << "Clusters : \n";
+  for ( const auto &cl : finalClusters )
+  {
+    ss << cl.size() << " : ";
+    for ( const auto id : cl )
+    {
+      ss << id << " ";
+    }
+    ss << "\n\n";
+  }
+  std::cout << "Number of clusters = " << finalClusters.size() << std::endl;
+  std::cout << ss.str();
+}
+
+void SparseDomset::exportToPLY( const std::string &plyFilename )
+{
+  std::ofstream plyFile( plyFilename );
+  if ( !plyFile.is_open() )
+  {
+    std::cout << "Cant open " << plyFilename << " file\n";
+    return;
+  }
+
+  size_t totalViews = 0;
+  for ( const auto &cl : finalClusters )
+    totalViews += cl.size();
+
+  plyFile << "ply\n"
+          << "format ascii 1.0\n"
+          << "element vertex "
+          << totalViews << std::endl
+          << "property float x\n"
+          << "property float y\n"
+          << "property float z\n"
+          << "property uchar red\n"
+          << "property uchar green\n"
+          << "property uchar blue\n"
+          << "end_header\n";
+
+  std::mt19937 gen;
+  std::uniform_int_distribution<> dis(0, 255);
+  for ( const auto &cl : finalClusters )
+  {
+    const unsigned int
+        red   = dis(gen),
+        green = dis(gen),
+        blue  = dis(gen);
+    for ( const auto id : cl )
+    {
+      const auto &pos = centers[ id ];
+      plyFile
+          << pos( 0 ) << " " << pos( 1 ) << " " << pos( 2 ) << " "
+          << red << " " << green << " " << blue << "\n";
+    }
+  }
+}
+
+}
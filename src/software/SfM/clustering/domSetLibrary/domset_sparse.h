@@ -0,0 +1,98 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef _DOMSET_SPARSE_H_
+#define _DOMSET_SPARSE_H_
+
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <Eigen/Core>
+#include "types.h"
+
+namespace nomoko {
+  /* brief:
+     Affinity propagation clustering of views on a sparse covisibility graph.
+     The view similarities are accumulated while the points are streamed
+     (addPoint), so neither the point cloud nor a dense views x views matrix
+     is stored: the memory is linear in the number of covisible view pairs.
+     The similarity measures are the ones of Domset:
+       - mean angular similarity of the points seen by both views,
+       - sigmoid of the camera center distance around the median distance
+         (computed over the covisible view pairs).
+     */
+  class SparseDomset{
+    public:
+      explicit SparseDomset(const std::vector<View>& _views);
+
+      // adds the contribution of a point to the similarity of the views seeing it
+      void addPoint(const Eigen::Vector3f& pos, const std::vector<size_t>& viewList);
+
+      void clusterViews(const size_t& minClusterSize,
+          const size_t& maxClusterSize);
+
+      // number of covisible view pairs
+      size_t numEdges() const {
+        return rowStart.empty() ? pairWeights.size() : numViewPairs;
+      }
+
+      // export function
+      void exportToPLY(const std::string& plyFile);
+
+      const std::vector<std::vector<size_t>>& getClusters() const {
+        return finalClusters;
+      }
+
+      void printClusters();
+
+    private:
+      // accumulated angular similarity of a view pair
+      struct PairWeight {
+        float w = 0.f;
+        uint32_t count = 0;
+      };
+
+      // converts the accumulated weights to a CSR similarity graph
+      void buildSimilarityGraph();
+
+      void computeClustersAP(std::map<size_t, std::vector<size_t>>& clMap,
+          std::vector<float>& E);
+
+      void enforceClusterSizes(std::map<size_t, std::vector<size_t>>& clMap,
+          const std::vector<float>& E);
+
+      std::vector<Eigen::Vector3f> centers;
+
+      // view pair (i < j) -> accumulated weight, released once the graph is built
+      std::unordered_map<uint64_t, PairWeight> pairWeights;
+
+      // symmetric similarity graph (CSR), each row holds the self similarity
+      std::vector<size_t> rowStart;
+      std::vector<uint32_t> cols;
+      std::vector<float> sims;
+      std::vector<size_t> selfEdge;
+      std::vector<size_t> transposedEdge;
+      size_t numViewPairs = 0;
+
+      std::vector<std::vector<size_t >> finalClusters;
+
+      const float kAngleSigma = M_PI / 6.f;
+      const float kAngleSigma_2 = kAngleSigma * kAngleSigma;
+      size_t kMinClusterSize = 10;
+      size_t kMaxClusterSize = 20;
+
+      // AP constants
+      const unsigned int kNumIter = 100;
+      const float lambda = 0.5f;
+  }; // class SparseDomset
+} // namespace nomoko
+#endif // _DOMSET_SPARSE_H_
@@ -0,0 +1,115 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+// (first: the Eigen std::vector specializations must precede their use)
+#include "testing/testing.h"
+
+#include "domset.h"
+#include "domset_sparse.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace nomoko;
+
+// Two groups of <kGroupSize> views, far apart, each group looking at its own
+// row of points (the views of different groups share no point).
+static const size_t kGroupSize = 6;
+
+static void TwoGroupsScene
+(
+  std::vector<Point> & points,
+  std::vector<View> & views
+)
+{
+  points.clear();
+  views.clear();
+  for (size_t group = 0; group < 2; ++group)
+  {
+    const float offset = 100.f * group;
+    for (size_t i = 0; i < kGroupSize; ++i)
+    {
+      View view;
+      view.rot = Eigen::Matrix3f::Identity();
+      view.trans = Eigen::Vector3f(offset + 2.f * i - 5.f, 10.f, 3.f * (i % 2));
+      view.cameraId = 0;
+      views.push_back(view);
+    }
+    // Points on a line (they fall in distinct voxels of the dense Domset)
+    for (int i = 0; i < 11; ++i)
+    {
+      Point point;
+      point.pos = Eigen::Vector3f(offset + i - 5.f, 0.f, 0.f);
+      for (size_t j = 0; j < kGroupSize; ++j)
+        point.viewList.push_back(group * kGroupSize + j);
+      points.push_back(point);
+    }
+  }
+}
+
+static std::vector<std::vector<size_t>> SortedClusters
+(
+  std::vector<std::vector<size_t>> clusters
+)
+{
+  for (auto & cluster : clusters)
+    std::sort(cluster.begin(), cluster.end());
+  std::sort(clusters.begin(), clusters.end());
+  return clusters;
+}
+
+TEST(SparseDomset, NoPoint) {
+  std::vector<Point> points;
+  std::vector<View> views;
+  TwoGroupsScene(points, views);
+
+  SparseDomset domset(views);
+  EXPECT_EQ(0, domset.numEdges());
+  domset.clusterViews(2, 4);
+  EXPECT_EQ(0, domset.numEdges());
+  size_t view_count = 0;
+  for (const auto & cluster : domset.getClusters())
+    view_count += cluster.size();
+  EXPECT_EQ(views.size(), view_count);
+}
+
+TEST(SparseDomset, SameClustersAsDomset) {
+  std::vector<Point> points;
+  std::vector<View> views;
+  TwoGroupsScene(points, views);
+
+  SparseDomset sparse_domset(views);
+  for (const auto & point : points)
+    sparse_domset.addPoint(point.pos, point.viewList);
+  // All the view pairs of each group are covisible
+  const size_t pair_count = kGroupSize * (kGroupSize - 1) / 2;
+  EXPECT_EQ(2 * pair_count, sparse_domset.numEdges());
+  sparse_domset.clusterViews(kGroupSize - 2, kGroupSize + 2);
+  EXPECT_EQ(2 * pair_count, sparse_domset.numEdges());
+
+  const std::vector<Camera> cameras(1);
+  Domset domset(points, views, cameras, 0.1f);
+  domset.clusterViews(kGroupSize - 2, kGroupSize + 2);
+
+  const std::vector<std::vector<size_t>>
+    sparse_clusters = SortedClusters(sparse_domset.getClusters()),
+    clusters = SortedClusters(domset.getClusters());
+  EXPECT_TRUE(sparse_clusters == clusters);
+
+  // One cluster per group
+  EXPECT_EQ(2, sparse_clusters.size());
+  for (const auto & cluster : sparse_clusters)
+  {
+    EXPECT_EQ(kGroupSize, cluster.size());
+    EXPECT_EQ(cluster.front() / kGroupSize, cluster.back() / kGroupSize);
+  }
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
@@ -16,11 +16,14 @@
 #include <cstdlib>
 #include <iomanip>
 #include <iterator>
+#include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <vector>
 
 #include "domSetLibrary/domset.h"
+#include "domSetLibrary/domset_sparse.h"
 #include "domSetLibrary/types.h"
 
 #ifdef OPENMVG_USE_OPENMP
@@ -81,7 +84,9 @@ bool domsetImporter(
     std::vector<size_t> vIds;
     for ( const auto &it_obs : obs)
     {
-      vIds.push_back( map_view[ it_obs.first ] );
+      const auto it_view = map_view.find( it_obs.first );
+      if ( it_view != map_view.end() )
+        vIds.push_back( it_view->second );
     }
 
     nomoko::Point p;
@@ -98,54 +103,143 @@ bool domsetImporter(
   return true;
 }
 
+/**
+* @brief Stream the openMVG sfm_data landmarks to the sparse domset clustering
+* @param sfm_data openMVG dataset
+* @param[out] map_view map between views added and the global index
+* @return the sparse clustering, ready to cluster the views
+*/
+std::unique_ptr<nomoko::SparseDomset> sparseDomsetImporter(
+  const SfM_Data &sfm_data,
+  std::map<openMVG::IndexT, uint32_t> &map_view )
+{
+  openMVG::system::Timer loadDataTimer;
+
+  // adding views
+  std::vector<nomoko::View> views;
+  for ( const auto &view : sfm_data.GetViews() )
+  {
+    if ( sfm_data.IsPoseAndIntrinsicDefined( view.second.get() ) )
+    {
+      map_view[ view.first ] = views.size();
+
+      const openMVG::geometry::Pose3 poseMVG( sfm_data.GetPoseOrDie( view.second.get() ) );
+      nomoko::View v;
+      v.rot   = poseMVG.rotation().cast<float>();
+      v.trans = poseMVG.center().transpose().cast<float>();
+      views.push_back( v );
+    }
+  }
+
+  std::unique_ptr<nomoko::SparseDomset> domset( new nomoko::SparseDomset( views ) );
+
+  // streaming the landmarks (no copy of the point cloud is made)
+  std::vector<size_t> vIds;
+  for ( const auto &it_landmark : sfm_data.GetLandmarks() )
+  {
+    const Landmark &landmark = it_landmark.second;
+    vIds.clear();
+    for ( const auto &it_obs : landmark.obs )
+    {
+      const auto it_view = map_view.find( it_obs.first );
+      if ( it_view != map_view.end() )
+        vIds.push_back( it_view->second );
+    }
+    domset->addPoint( landmark.X.cast<float>(), vIds );
+  }
+
+  std::cout << std::endl
+            << "Number of views  = " << views.size() << std::endl
+            << "Number of points = " << sfm_data.GetLandmarks().size() << std::endl
+            << "Number of covisible view pairs = " << domset->numEdges() << std::endl
+            << "Loading data took (s): "
+            << loadDataTimer.elapsed() << std::endl;
+  return domset;
+}
+
+/**
+* @brief List the landmarks to export for every cluster (in one pass over the landmarks)
+*  A landmark is exported in a cluster if at least two of its views belong to it.
+* @param sfm_data The whole data set
+* @param clusters List of view for every cluster
+* @return the landmark ids of every cluster
+*/
+std::vector<std::vector<IndexT>> clusterLandmarks(
+  const SfM_Data &sfm_data,
+  const std::vector<std::set<size_t>> &clusters )
+{
+  std::map<IndexT, std::vector<uint32_t>> view_clusters;
+  for ( size_t i = 0; i < clusters.size(); ++i )
+    for ( const auto vId : clusters[ i ] )
+      view_clusters[ vId ].push_back( i );
+
+  std::vector<std::vector<IndexT>> cluster_landmarks( clusters.size() );
+  std::map<uint32_t, uint32_t> obs_per_cluster;
+  for ( const auto &it_landmark : sfm_data.GetLandmarks() )
+  {
+    obs_per_cluster.clear();
+    for ( const auto &observation : it_landmark.second.obs )
+    {
+      const auto it = view_clusters.find( observation.first );
+      if ( it != view_clusters.end() )
+        for ( const auto cl : it->second )
+          ++obs_per_cluster[ cl ];
+    }
+    for ( const auto &it : obs_per_cluster )
+    {
+      // Landmark observed in less than 2 view are ignored
+      if ( it.second >= 2 )
+        cluster_landmarks[ it.first ].push_back( it_landmark.first );
+    }
+  }
+  return cluster_landmarks;
+}
+
 /**
 * @brief Export a sfm_data file using a subset of the view of a given sfm_data
 * @param sfm_data The whole data set
 * @param outFilename Output file name
 * @param cluster List of view to consider
+* @param landmarks List of the landmarks to consider (see clusterLandmarks)
 * @retval true if success
 * @retval false if failure
 */
 bool exportData( const SfM_Data &sfm_data,
                  const std::string &outFilename,
-                 const std::set<size_t> &cluster )
+                 const std::set<size_t> &cluster,
+                 const std::vector<IndexT> &landmarks )
 {
   SfM_Data cl_sfm_data;
   cl_sfm_data.s_root_path = sfm_data.s_root_path;
 
   // Copy the view (only the requested ones)
-  for ( const auto view : sfm_data.GetViews() )
+  for ( const auto vId : cluster )
   {
-    const bool inCluster = cluster.find(view.first) != cluster.end();
-    if ( inCluster && sfm_data.IsPoseAndIntrinsicDefined( view.second.get() ) )
+    const auto view = sfm_data.GetViews().find( vId );
+    if ( view != sfm_data.GetViews().end() && sfm_data.IsPoseAndIntrinsicDefined( view->second.get() ) )
     {
-      cl_sfm_data.poses[ view.first ] = sfm_data.GetPoseOrDie( view.second.get() );
-      cl_sfm_data.views[ view.first ] = view.second;
+      cl_sfm_data.poses[ view->first ] = sfm_data.GetPoseOrDie( view->second.get() );
+      cl_sfm_data.views[ view->first ] = view->second;
 
-      const auto intrinsic  = sfm_data.GetIntrinsics().at( view.second.get()->id_intrinsic );
-      if (cl_sfm_data.intrinsics.count(view.second.get()->id_intrinsic) == 0)
-        cl_sfm_data.intrinsics[ view.second.get()->id_intrinsic ] = intrinsic;
+      const auto intrinsic  = sfm_data.GetIntrinsics().at( view->second.get()->id_intrinsic );
+      if (cl_sfm_data.intrinsics.count(view->second.get()->id_intrinsic) == 0)
+        cl_sfm_data.intrinsics[ view->second.get()->id_intrinsic ] = intrinsic;
     }
   }
 
-  // Copy observations that have relation with the considered view
-  for ( const auto &it_landmark : sfm_data.GetLandmarks() )
+  // Copy the observations that have relation with the considered view
+  for ( const auto landmarkId : landmarks )
   {
-    const Landmark &landmark = it_landmark.second;
-    Observations obs;
+    const Landmark &landmark = sfm_data.GetLandmarks().at( landmarkId );
+    Landmark &cl_landmark = cl_sfm_data.structure[ landmarkId ];
+    cl_landmark.X = landmark.X;
     for ( const auto &observation : landmark.obs )
     {
-      const auto &it = cl_sfm_data.views.find( observation.first );
-      if ( it != cl_sfm_data.views.end() )
+      if ( cl_sfm_data.views.count( observation.first ) )
       {
-        obs[ observation.first ] = observation.second;
+        cl_landmark.obs[ observation.first ] = observation.second;
       }
     }
-    // Landmark observed in less than 3 view are ignored
-    if ( obs.size() < 2 )
-      continue;
-    cl_sfm_data.structure[ it_landmark.first ].X   = landmark.X;
-    cl_sfm_data.structure[ it_landmark.first ].obs = obs;
   }
 
   return Save( cl_sfm_data, outFilename, ESfM_Data( ALL ) );
@@ -170,6 +264,7 @@ int main( int argc, char **argv )
   cmd.add( make_option( 'l', clusterSizeLowerBound, "cluster_size_lower_bound" ) );
   cmd.add( make_option( 'u', clusterSizeUpperBound, "cluster_size_upper_bound" ) );
   cmd.add( make_option( 'v', voxelGridSize, "voxel_grid_size" ) );
+  cmd.add( make_switch( 's', "sparse" ) );
 
   try
   {
@@ -185,6 +280,9 @@ int main( int argc, char **argv )
               << "[-l|--cluster_size_lower_bound] lower bound to cluster size\n"
               << "[-u|--cluster_size_upper_bound] upper bound to cluster size\n"
               << "[-v|--voxel_grid_size] voxel grid size\n"
+              << "[-s|--sparse] cluster the views on their sparse covisibility graph\n"
+              << "  (memory linear in the number of covisible view pairs, for large scenes;\n"
+              << "   the voxel grid size is unused)\n"
               << std::endl;
 
     std::cerr << s << std::endl;
@@ -197,7 +295,8 @@ int main( int argc, char **argv )
             << "[Cluster size:"         << std::endl
             << "    Lower bound   = "   << clusterSizeLowerBound << std::endl
             << "    Upper bound]   = "  << clusterSizeUpperBound << std::endl
-            << "[Voxel grid size]  = "  << voxelGridSize << std::endl;
+            << "[Voxel grid size]  = "  << voxelGridSize << std::endl
+            << "[Sparse]           = "  << cmd.used( 's' ) << std::endl;
 
   if ( sSfM_Data_Filename.empty() )
   {
@@ -222,38 +321,59 @@ int main( int argc, char **argv )
     return EXIT_FAILURE;
   }
 
-  // loading data
-  std::vector<nomoko::Camera> cameras; // stores the various camera intrinsic parameters
-  std::vector<nomoko::View> views;     // stores the poses for each view
-  std::vector<nomoko::Point> points;   // 3d point positions
-
   std::map<openMVG::IndexT, uint32_t> origViewMap; // need to keep track of original views ids
-  if ( !domsetImporter( sfm_data, cameras, views, points, origViewMap ) )
+  std::vector<std::vector<size_t>> clusters;
+  const std::string viewOut = sOutDir + "/views.ply";
+  if ( cmd.used( 's' ) )
   {
-    std::cerr << "Error: can't import data" << std::endl;
-    return EXIT_FAILURE;
+    std::unique_ptr<nomoko::SparseDomset> domset = sparseDomsetImporter( sfm_data, origViewMap );
+
+    //---------------------------------------
+    // clustering views process
+    //---------------------------------------
+    openMVG::system::Timer clusteringTimer;
+
+    domset->clusterViews( clusterSizeLowerBound, clusterSizeUpperBound );
+
+    std::cout << "Clustering view took (s): "
+              << clusteringTimer.elapsed() << std::endl;
+
+    // export to ply to visualize
+    domset->exportToPLY( viewOut );
+    clusters = domset->getClusters();
   }
+  else
+  {
+    // loading data
+    std::vector<nomoko::Camera> cameras; // stores the various camera intrinsic parameters
+    std::vector<nomoko::View> views;     // stores the poses for each view
+    std::vector<nomoko::Point> points;   // 3d point positions
 
-  //---------------------------------------
-  // clustering views process
-  //---------------------------------------
-  openMVG::system::Timer clusteringTimer;
+    if ( !domsetImporter( sfm_data, cameras, views, points, origViewMap ) )
+    {
+      std::cerr << "Error: can't import data" << std::endl;
+      return EXIT_FAILURE;
+    }
 
-  nomoko::Domset domset( points, views, cameras, voxelGridSize );
-  domset.clusterViews( clusterSizeLowerBound, clusterSizeUpperBound );
+    //---------------------------------------
+    // clustering views process
+    //---------------------------------------
+    openMVG::system::Timer clusteringTimer;
 
-  std::cout << "Clustering view took (s): "
-            << clusteringTimer.elapsed() << std::endl;
+    nomoko::Domset domset( points, views, cameras, voxelGridSize );
+    domset.clusterViews( clusterSizeLowerBound, clusterSizeUpperBound );
 
-  // export to ply to visualize
-  const std::string viewOut = sOutDir + "/views.ply";
-  domset.exportToPLY( viewOut );
+    std::cout << "Clustering view took (s): "
+              << clusteringTimer.elapsed() << std::endl;
+
+    // export to ply to visualize
+    domset.exportToPLY( viewOut );
+    clusters = domset.getClusters();
+  }
 
   // Retrieve the cluster and export them
   std::vector<std::set<size_t>> finalClusters;
   {
-    const std::vector<std::vector<size_t>> clusters = domset.getClusters();
-
     // Remap the camera index from contiguous to original view Id
     std::map<openMVG::IndexT, uint32_t> origViewMap_reverse;
     for (const auto& it : origViewMap) {
@@ -272,6 +392,9 @@ int main( int argc, char **argv )
   const size_t numClusters = finalClusters.size();
   std::cout << "Number of clusters = " << numClusters << std::endl;
 
+  const std::vector<std::vector<IndexT>> finalClustersLandmarks =
+    clusterLandmarks( sfm_data, finalClusters );
+
 #ifdef OPENMVG_USE_OPENMP
 #pragma omp parallel for
 #endif
@@ -291,7 +414,7 @@ int main( int argc, char **argv )
       std::cout << ss.str();
     }
 
-    if ( !exportData( sfm_data, filename.str(), finalClusters[ i ] ) )
+    if ( !exportData( sfm_data, filename.str(), finalClusters[ i ], finalClustersLandmarks[ i ] ) )
     {
       std::stringstream str;
       str << "Could not write cluster : " << filename.str() << std::endl;
@@ -0,0 +1,82 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_SOFTWARE_SFM_EXPORT_LANDMARKS_STREAM_HPP
+#define OPENMVG_SOFTWARE_SFM_EXPORT_LANDMARKS_STREAM_HPP
+
+#include "openMVG/sfm/sfm_landmark.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace openMVG {
+namespace sfm {
+
+/**
+* @brief Export the landmarks chunk by chunk:
+*  - the landmarks of a chunk are converted in parallel to the exported type,
+*  - the converted landmarks are then written in the landmarks order.
+* So only one chunk of converted data is in memory at once, whatever the scene
+* size.
+*
+* @param landmarks The landmarks to export
+* @param convert Functor bool(const Landmarks::value_type &, T &), return false
+*   to skip a landmark (it is called concurrently, and the T instances are
+*   reused from one chunk to the other, so they must be fully set)
+* @param write Functor void(const T &), writes a converted landmark
+* @param chunk_size Number of landmarks converted at once
+* @return the number of written landmarks
+*/
+template <typename T, typename ConvertFunctor, typename WriteFunctor>
+std::size_t StreamLandmarks
+(
+  const Landmarks & landmarks,
+  ConvertFunctor convert,
+  WriteFunctor write,
+  const std::size_t chunk_size = 1 << 16
+)
+{
+  std::vector<const Landmarks::value_type *> chunk;
+  std::vector<T> converted;
+  std::vector<unsigned char> valid;
+  chunk.reserve(chunk_size);
+
+  std::size_t count = 0;
+  auto it = landmarks.begin();
+  while (it != landmarks.end())
+  {
+    chunk.clear();
+    for (; it != landmarks.end() && chunk.size() < chunk_size; ++it)
+      chunk.push_back(&(*it));
+
+    converted.resize(chunk.size());
+    valid.resize(chunk.size());
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp parallel for schedule(dynamic, 256)
+#endif
+    for (int i = 0; i < static_cast<int>(chunk.size()); ++i)
+    {
+      valid[i] = convert(*chunk[i], converted[i]);
+    }
+
+    for (std::size_t i = 0; i < chunk.size(); ++i)
+    {
+      if (valid[i])
+      {
+        write(converted[i]);
+        ++count;
+      }
+    }
+  }
+  return count;
+}
+
+} // namespace sfm
+} // namespace openMVG
+
+#endif // OPENMVG_SOFTWARE_SFM_EXPORT_LANDMARKS_STREAM_HPP
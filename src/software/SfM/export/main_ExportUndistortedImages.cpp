@@ -16,8 +16,12 @@
 #include "third_party/progress/progress_display.hpp"
 #include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
 
+#include <algorithm>
 #include <cstdlib>
+#include <map>
+#include <memory>
 #include <string>
+#include <vector>
 
 #ifdef OPENMVG_USE_OPENMP
 #include <omp.h>
@@ -29,10 +33,6 @@ using namespace openMVG::geometry;
 using namespace openMVG::image;
 using namespace openMVG::sfm;
 
-#ifdef OPENMVG_USE_OPENMP
-#include <omp.h>
-#endif
-
 int main(int argc, char *argv[]) {
 
   CmdLine cmd;
@@ -81,76 +81,125 @@ int main(int argc, char *argv[]) {
     return EXIT_FAILURE;
   }
 
+  // Collect the views to export (those with valid Intrinsics).
+  // Views are ordered by intrinsic, so views sharing an intrinsic are
+  // processed together and reuse the same undistortion remapping.
+  std::vector<const View*> views_to_export;
+  for (const auto & view_it : sfm_data.GetViews())
+  {
+    const View * view = view_it.second.get();
+    // Check if the view is in reconstruction
+    if (bExportOnlyReconstructedViews && !sfm_data.IsPoseAndIntrinsicDefined(view))
+      continue;
+
+    const bool bIntrinsicDefined = view->id_intrinsic != UndefinedIndexT &&
+      sfm_data.GetIntrinsics().find(view->id_intrinsic) != sfm_data.GetIntrinsics().end();
+    if (!bIntrinsicDefined)
+      continue;
+
+    views_to_export.push_back(view);
+  }
+  std::stable_sort(views_to_export.begin(), views_to_export.end(),
+    [](const View * a, const View * b) { return a->id_intrinsic < b->id_intrinsic; });
+
   bool bOk = true;
   {
     system::Timer timer;
-    // Export views as undistorted images (those with valid Intrinsics)
+    // Export views as undistorted images
     Image<RGBColor> image, image_ud;
     Image<uint8_t> image_gray, image_gray_ud;
-    C_Progress_display my_progress_bar( sfm_data.GetViews().size(), std::cout, "\n- EXTRACT UNDISTORTED IMAGES -\n" );
+    C_Progress_display my_progress_bar( views_to_export.size(), std::cout, "\n- EXTRACT UNDISTORTED IMAGES -\n" );
 
     #ifdef OPENMVG_USE_OPENMP
     const unsigned int nb_max_thread = omp_get_max_threads();
+    const int nb_batch_views = 2 * (iNumThreads > 0 ? iNumThreads : nb_max_thread);
+    #else
+    const int nb_batch_views = 1;
     #endif
 
+    // The views are exported by batches of consecutive intrinsics:
+    // - the remappings of the batch intrinsics are computed first (each
+    //   remapping computation is multithreaded),
+    // - then the views of the batch are exported in parallel,
+    // - the remappings are released before the next batch.
+    size_t batch_begin = 0;
+    while (batch_begin < views_to_export.size())
+    {
+      // Collect whole intrinsic groups until the batch has enough views to
+      // keep all the threads busy
+      std::map<IndexT, std::unique_ptr<const Undistortion_Remap>> remaps;
+      size_t batch_end = batch_begin;
+      while (batch_end < views_to_export.size() &&
+        (static_cast<int>(batch_end - batch_begin) < nb_batch_views ||
+         views_to_export[batch_end]->id_intrinsic == views_to_export[batch_end - 1]->id_intrinsic))
+      {
+        const IndexT id_intrinsic = views_to_export[batch_end]->id_intrinsic;
+        const IntrinsicBase * cam = sfm_data.GetIntrinsics().at(id_intrinsic).get();
+        if (cam->have_disto() && remaps.count(id_intrinsic) == 0)
+        {
+          remaps[id_intrinsic].reset(new Undistortion_Remap(cam));
+        }
+        ++batch_end;
+      }
+
+      // Each thread decodes, remaps and encodes its own view, so the I/O of
+      // some views overlaps with the remapping of the others.
 #ifdef OPENMVG_USE_OPENMP
-    omp_set_num_threads(iNumThreads);
-    #pragma omp parallel for schedule(dynamic) if (iNumThreads > 0) private(image, image_ud, image_gray, image_gray_ud)
+      omp_set_num_threads(iNumThreads);
+      #pragma omp parallel for schedule(dynamic) if (iNumThreads > 0) private(image, image_ud, image_gray, image_gray_ud)
 #endif
-    for (int i = 0; i < static_cast<int>(sfm_data.views.size()); ++i)
-    {
+      for (int i = static_cast<int>(batch_begin); i < static_cast<int>(batch_end); ++i)
+      {
 #ifdef OPENMVG_USE_OPENMP
-      if (iNumThreads == 0) omp_set_num_threads(nb_max_thread);
+        if (iNumThreads == 0) omp_set_num_threads(nb_max_thread);
 #endif
-      Views::const_iterator iterViews = sfm_data.views.begin();
-      std::advance(iterViews, i);
-
-      const View * view = iterViews->second.get();
-      // Check if the view is in reconstruction
-      if (bExportOnlyReconstructedViews && !sfm_data.IsPoseAndIntrinsicDefined(view))
-        continue;
+        const View * view = views_to_export[i];
 
-      const bool bIntrinsicDefined = view->id_intrinsic != UndefinedIndexT &&
-        sfm_data.GetIntrinsics().find(view->id_intrinsic) != sfm_data.GetIntrinsics().end();
-      if (!bIntrinsicDefined)
-        continue;
+        const std::string srcImage = stlplus::create_filespec(sfm_data.s_root_path, view->s_Img_path);
+        const std::string dstImage = stlplus::create_filespec(
+          sOutDir, stlplus::filename_part(srcImage));
 
-      Intrinsics::const_iterator iterIntrinsic = sfm_data.GetIntrinsics().find(view->id_intrinsic);
-
-      const std::string srcImage = stlplus::create_filespec(sfm_data.s_root_path, view->s_Img_path);
-      const std::string dstImage = stlplus::create_filespec(
-        sOutDir, stlplus::filename_part(srcImage));
-
-      const IntrinsicBase * cam = iterIntrinsic->second.get();
-      if (cam->have_disto())
-      {
-        // undistort the image and save it
-        if (ReadImage( srcImage.c_str(), &image))
+        const IntrinsicBase * cam = sfm_data.GetIntrinsics().at(view->id_intrinsic).get();
+        if (cam->have_disto())
         {
-          UndistortImage(image, cam, image_ud, BLACK);
-          const bool bRes = WriteImage(dstImage.c_str(), image_ud);
+          const Undistortion_Remap & remap = *remaps.at(view->id_intrinsic);
+
+          // undistort the image and save it
+          // (fallback to the on the fly undistortion if the image size does not
+          //  match the intrinsic one)
+          if (ReadImage( srcImage.c_str(), &image))
+          {
+            if (!UndistortImage(image, remap, image_ud, BLACK))
+              UndistortImage(image, cam, image_ud, BLACK);
+            const bool bRes = WriteImage(dstImage.c_str(), image_ud);
 #ifdef OPENMVG_USE_OPENMP
-          #pragma omp critical
+            #pragma omp critical
 #endif
-          bOk &= bRes;
+            bOk &= bRes;
+          }
+          // If RGBColor reading fails, we try to read a gray image
+          else if (ReadImage( srcImage.c_str(), &image_gray))
+          {
+            if (!UndistortImage(image_gray, remap, image_gray_ud, BLACK))
+              UndistortImage(image_gray, cam, image_gray_ud, BLACK);
+            const bool bRes = WriteImage(dstImage.c_str(), image_gray_ud);
+#ifdef OPENMVG_USE_OPENMP
+            #pragma omp critical
+#endif
+            bOk &= bRes;
+          }
         }
-        else // If RGBColor reading fails, we try to read a gray image
-        if (ReadImage( srcImage.c_str(), &image_gray))
+        else // (no distortion)
         {
-          UndistortImage(image_gray, cam, image_gray_ud, BLACK);
-          const bool bRes = WriteImage(dstImage.c_str(), image_gray_ud);
+          // copy the image since there is no distortion
+          stlplus::file_copy(srcImage, dstImage);
+        }
 #ifdef OPENMVG_USE_OPENMP
-          #pragma omp critical
+        #pragma omp critical
 #endif
-          bOk &= bRes;
-        }
-      }
-      else // (no distortion)
-      {
-        // copy the image since there is no distortion
-        stlplus::file_copy(srcImage, dstImage);
+        ++my_progress_bar;
       }
-      ++my_progress_bar;
+      batch_begin = batch_end;
     }
     std::cout << "Task done in (s): " << timer.elapsed() << std::endl;
   }
@@ -21,11 +21,17 @@
 #include "third_party/progress/progress_display.hpp"
 #include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
 
+#include "landmarks_stream.hpp"
+
+#include <algorithm>
 #include <cstdlib>
 #include <cmath>
+#include <future>
 #include <iterator>
 #include <iomanip>
 #include <fstream>
+#include <string>
+#include <vector>
 
 using namespace openMVG;
 using namespace openMVG::cameras;
@@ -75,6 +81,7 @@ bool exportToPMVSFormat(
     Hash_Map<IndexT, IndexT> map_viewIdToContiguous;
 
     // Export valid views as Projective Cameras:
+    std::vector<const View*> valid_views;
     for (Views::const_iterator iter = sfm_data.GetViews().begin();
         iter != sfm_data.GetViews().end(); ++iter, ++my_progress_bar)
     {
@@ -82,16 +89,22 @@ bool exportToPMVSFormat(
       if (!sfm_data.IsPoseAndIntrinsicDefined(view))
         continue;
 
-      const Pose3 pose = sfm_data.GetPoseOrDie(view);
-      Intrinsics::const_iterator iterIntrinsic = sfm_data.GetIntrinsics().find(view->id_intrinsic);
-
       // View Id re-indexing
       map_viewIdToContiguous.insert(std::make_pair(view->id_view, map_viewIdToContiguous.size()));
+      valid_views.push_back(view);
+    }
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < static_cast<int>(valid_views.size()); ++i)
+    {
+      const View * view = valid_views[i];
+      const Pose3 pose = sfm_data.GetPoseOrDie(view);
+      Intrinsics::const_iterator iterIntrinsic = sfm_data.GetIntrinsics().find(view->id_intrinsic);
 
       // We have a valid view with a corresponding camera & pose
       const Mat34 P = iterIntrinsic->second->get_projective_equivalent(pose);
       std::ostringstream os;
-      os << std::setw(8) << std::setfill('0') << map_viewIdToContiguous[view->id_view];
+      os << std::setw(8) << std::setfill('0') << i;
       std::ofstream file(
         stlplus::create_filespec(stlplus::folder_append_separator(sOutDirectory) + "txt",
         os.str() ,"txt").c_str());
@@ -118,7 +131,7 @@ bool exportToPMVSFormat(
       // We have a valid view with a corresponding camera & pose
       const std::string srcImage = stlplus::create_filespec(sfm_data.s_root_path, view->s_Img_path);
       std::ostringstream os;
-      os << std::setw(8) << std::setfill('0') << map_viewIdToContiguous[view->id_view];
+      os << std::setw(8) << std::setfill('0') << map_viewIdToContiguous.at(view->id_view);
       const std::string dstImage = stlplus::create_filespec(
         stlplus::folder_append_separator(sOutDirectory) + "visualize", os.str(),"jpg");
 
@@ -126,9 +139,11 @@ bool exportToPMVSFormat(
       if (cam->have_disto())
       {
         // undistort the image and save it
-        ReadImage( srcImage.c_str(), &image);
-        UndistortImage(image, cam, image_ud, BLACK);
-        WriteImage(dstImage.c_str(), image_ud);
+        if (ReadImage( srcImage.c_str(), &image))
+        {
+          UndistortImage(image, cam, image_ud, BLACK);
+          WriteImage(dstImage.c_str(), image_ud);
+        }
       }
       else // (no distortion)
       {
@@ -140,8 +155,8 @@ bool exportToPMVSFormat(
         }
         else
         {
-          ReadImage( srcImage.c_str(), &image);
-          WriteImage( dstImage.c_str(), image);
+          if (ReadImage( srcImage.c_str(), &image))
+            WriteImage( dstImage.c_str(), image);
         }
       }
     }
@@ -165,42 +180,65 @@ bool exportToPMVSFormat(
 
     if (b_VisData)
     {
-      std::map<IndexT, std::set<IndexT>> view_shared;
       // From the structure observations, list the putatives pairs (symmetric)
-      for (Landmarks::const_iterator itL = sfm_data.GetLandmarks().begin();
-        itL != sfm_data.GetLandmarks().end(); ++itL)
+      // The neighbor lists are made unique each time they double in size,
+      //  so their memory stays close to the covisibility graph size.
+      std::vector<std::vector<IndexT>> view_shared(map_viewIdToContiguous.size());
+      std::vector<size_t> view_shared_unique_size(map_viewIdToContiguous.size(), 0);
+      const auto make_unique = [&](const IndexT id)
       {
-        const Landmark & landmark = itL->second;
-        const Observations & obs = landmark.obs;
-        for (Observations::const_iterator itOb = obs.begin();
-          itOb != obs.end(); ++itOb)
+        std::vector<IndexT> & neighbors = view_shared[id];
+        std::sort(neighbors.begin(), neighbors.end());
+        neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+        view_shared_unique_size[id] = neighbors.size();
+      };
+      StreamLandmarks<std::vector<IndexT>>(
+        sfm_data.GetLandmarks(),
+        [&](const Landmarks::value_type & landmark, std::vector<IndexT> & view_ids)
         {
-          const IndexT viewId = itOb->first;
-          Observations::const_iterator itOb2 = itOb;
-          ++itOb2;
-          for (; itOb2 != obs.end(); ++itOb2)
+          view_ids.clear();
+          for (const auto & obs_it : landmark.second.obs)
           {
-            const IndexT viewId2 = itOb2->first;
-            view_shared[map_viewIdToContiguous[viewId]].insert(map_viewIdToContiguous[viewId2]);
-            view_shared[map_viewIdToContiguous[viewId2]].insert(map_viewIdToContiguous[viewId]);
+            const auto it = map_viewIdToContiguous.find(obs_it.first);
+            if (it != map_viewIdToContiguous.end())
+              view_ids.push_back(it->second);
           }
-        }
-      }
+          return view_ids.size() > 1;
+        },
+        [&](const std::vector<IndexT> & view_ids)
+        {
+          for (const IndexT viewId : view_ids)
+          {
+            std::vector<IndexT> & neighbors = view_shared[viewId];
+            for (const IndexT viewId2 : view_ids)
+            {
+              if (viewId2 != viewId)
+                neighbors.push_back(viewId2);
+            }
+            if (neighbors.size() > 2 * std::max<size_t>(view_shared_unique_size[viewId], 256))
+              make_unique(viewId);
+          }
+        });
+      #pragma omp parallel for schedule(dynamic)
+      for (int i = 0; i < static_cast<int>(view_shared.size()); ++i)
+        make_unique(i);
+
       // Export the vis.dat file
       std::ostringstream osVisData;
       osVisData
         << "VISDATA" << os.widen('\n')
-        << view_shared.size() << os.widen('\n'); // #images
+        << view_shared.size() - std::count(view_shared_unique_size.begin(), view_shared_unique_size.end(), 0)
+        << os.widen('\n'); // #images
       // Export view shared visibility
-      for (std::map<IndexT, std::set<IndexT>>::const_iterator it = view_shared.begin();
-        it != view_shared.end(); ++it)
+      for (size_t i = 0; i < view_shared.size(); ++i)
       {
-        const std::set<IndexT> & setView = it->second;
-        osVisData << it->first << ' ' << setView.size();
-        for (std::set<IndexT>::const_iterator itV = setView.begin();
-          itV != setView.end(); ++itV)
+        const std::vector<IndexT> & setView = view_shared[i];
+        if (setView.empty())
+          continue;
+        osVisData << i << ' ' << setView.size();
+        for (const IndexT viewId : setView)
         {
-          osVisData << ' ' << *itV;
+          osVisData << ' ' << viewId;
         }
         osVisData << os.widen('\n');
       }
@@ -290,25 +328,42 @@ bool exportToBundlerFormat(
       }
     }
     // Export structure and visibility
-    for (Landmarks::const_iterator iter = sfm_data.GetLandmarks().begin();
-      iter != sfm_data.GetLandmarks().end(); ++iter)
-    {
-      const Landmark & landmark = iter->second;
-      const Observations & obs = landmark.obs;
-      const Vec3 & X = landmark.X;
-      // X, color, obsCount
-      os << X[0] << " " << X[1] << " " << X[2] << os.widen('\n')
-         <<  "255 255 255" << os.widen('\n')
-         << obs.size() << " ";
-      for (Observations::const_iterator iterObs = obs.begin();
-        iterObs != obs.end(); ++iterObs)
+    // (the landmarks are formatted in parallel, and written in order)
+    StreamLandmarks<std::string>(
+      sfm_data.GetLandmarks(),
+      [&](const Landmarks::value_type & landmark_it, std::string & landmark_str)
       {
-        const Observation & ob = iterObs->second;
-        // ViewId, FeatId, x, y
-        os << map_viewIdToContiguous[iterObs->first] << " " << ob.id_feat << " " << ob.x(0) << " " << ob.x(1) << " ";
-      }
-      os << os.widen('\n');
-    }
+        const Landmark & landmark = landmark_it.second;
+        const Observations & obs = landmark.obs;
+        const Vec3 & X = landmark.X;
+        // Observations of the views without a pose are not exported
+        size_t obsCount = 0;
+        for (const auto & obs_it : obs)
+          obsCount += map_viewIdToContiguous.count(obs_it.first);
+
+        std::ostringstream osLandmark;
+        // X, color, obsCount
+        osLandmark << X[0] << " " << X[1] << " " << X[2] << osLandmark.widen('\n')
+          <<  "255 255 255" << osLandmark.widen('\n')
+          << obsCount << " ";
+        for (Observations::const_iterator iterObs = obs.begin();
+          iterObs != obs.end(); ++iterObs)
+        {
+          const auto it = map_viewIdToContiguous.find(iterObs->first);
+          if (it == map_viewIdToContiguous.end())
+            continue;
+          const Observation & ob = iterObs->second;
+          // ViewId, FeatId, x, y
+          osLandmark << it->second << " " << ob.id_feat << " " << ob.x(0) << " " << ob.x(1) << " ";
+        }
+        osLandmark << osLandmark.widen('\n');
+        landmark_str = osLandmark.str();
+        return true;
+      },
+      [&](const std::string & landmark_str)
+      {
+        os << landmark_str;
+      });
     os.close();
     osList.close();
   }
@@ -358,20 +413,27 @@ int main(int argc, char *argv[]) {
   }
 
   {
-    exportToPMVSFormat(sfm_data,
-      stlplus::folder_append_separator(sOutDir) + "PMVS",
+    const std::string sPMVSDir = stlplus::folder_append_separator(sOutDir) + "PMVS";
+    if (!stlplus::folder_exists(sPMVSDir))
+      stlplus::folder_create(sPMVSDir);
+
+    // The bundler file (structure) is written while the images are exported
+    std::future<bool> bundler_exported = std::async(std::launch::async, [&]
+    {
+      return exportToBundlerFormat(sfm_data,
+        stlplus::folder_append_separator(sPMVSDir) + "bundle.rd.out",
+        stlplus::folder_append_separator(sPMVSDir) + "list.txt"
+        );
+    });
+
+    const bool bPMVSExported = exportToPMVSFormat(sfm_data,
+      sPMVSDir,
       resolution,
       CPU,
       bVisData);
 
-    exportToBundlerFormat(sfm_data,
-      stlplus::folder_append_separator(sOutDir) +
-      stlplus::folder_append_separator("PMVS") + "bundle.rd.out",
-      stlplus::folder_append_separator(sOutDir) +
-      stlplus::folder_append_separator("PMVS") + "list.txt"
-      );
-
-    return EXIT_SUCCESS;
+    if (bundler_exported.get() && bPMVSExported)
+      return EXIT_SUCCESS;
   }
 
   // Exit program
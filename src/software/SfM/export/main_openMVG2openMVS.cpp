@@ -19,107 +19,31 @@
 #include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
 #include "third_party/progress/progress_display.hpp"
 
+#include "landmarks_stream.hpp"
+
 using namespace openMVG;
 using namespace openMVG::cameras;
 using namespace openMVG::geometry;
 using namespace openMVG::image;
 using namespace openMVG::sfm;
 
+#include <algorithm>
 #include <atomic>
 #include <cstdlib>
+#include <future>
 #include <string>
 
 #ifdef OPENMVG_USE_OPENMP
 #include <omp.h>
 #endif
 
-bool exportToOpenMVS(
+/// Export the calibrated views as undistorted images (copy the other ones)
+bool exportUndistortedImages(
   const SfM_Data & sfm_data,
-  const std::string & sOutFile,
   const std::string & sOutDir,
   const int iNumThreads = 0
   )
 {
-  // Create undistorted images directory structure
-  if (!stlplus::is_folder(sOutDir))
-  {
-    stlplus::folder_create(sOutDir);
-    if (!stlplus::is_folder(sOutDir))
-    {
-      std::cerr << "Cannot access to one of the desired output directory" << std::endl;
-      return false;
-    }
-  }
-
-  // Export data :
-  MVS::Interface scene;
-  size_t nPoses(0);
-  const uint32_t nViews((uint32_t)sfm_data.GetViews().size());
-
-  C_Progress_display my_progress_bar(nViews,
-      std::cout, "\n- PROCESS VIEWS -\n");
-
-  // OpenMVG can have not contiguous index, use a map to create the required OpenMVS contiguous ID index
-  std::map<openMVG::IndexT, uint32_t> map_intrinsic, map_view;
-
-  // define a platform with all the intrinsic group
-  for (const auto& intrinsic: sfm_data.GetIntrinsics())
-  {
-    if (isPinhole(intrinsic.second->getType()))
-    {
-      const Pinhole_Intrinsic * cam = dynamic_cast<const Pinhole_Intrinsic*>(intrinsic.second.get());
-      if (map_intrinsic.count(intrinsic.first) == 0)
-        map_intrinsic.insert(std::make_pair(intrinsic.first, scene.platforms.size()));
-      MVS::Interface::Platform platform;
-      // add the camera
-      MVS::Interface::Platform::Camera camera;
-      camera.K = cam->K();
-      // sub-pose
-      camera.R = Mat3::Identity();
-      camera.C = Vec3::Zero();
-      platform.cameras.push_back(camera);
-      scene.platforms.push_back(platform);
-    }
-  }
-
-  // define images & poses
-  scene.images.reserve(nViews);
-  for (const auto& view : sfm_data.GetViews())
-  {
-    map_view[view.first] = scene.images.size();
-    MVS::Interface::Image image;
-    const std::string srcImage = stlplus::create_filespec(sfm_data.s_root_path, view.second->s_Img_path);
-    image.name = stlplus::create_filespec(sOutDir, view.second->s_Img_path);
-    image.platformID = map_intrinsic.at(view.second->id_intrinsic);
-    MVS::Interface::Platform& platform = scene.platforms[image.platformID];
-    image.cameraID = 0;
-    if (!stlplus::is_file(srcImage))
-    {
-      std::cout << "Cannot read the corresponding image: " << srcImage << std::endl;
-      return EXIT_FAILURE;
-    }
-    if (sfm_data.IsPoseAndIntrinsicDefined(view.second.get()))
-    {
-      MVS::Interface::Platform::Pose pose;
-      image.poseID = platform.poses.size();
-      const openMVG::geometry::Pose3 poseMVG(sfm_data.GetPoseOrDie(view.second.get()));
-      pose.R = poseMVG.rotation();
-      pose.C = poseMVG.center();
-      platform.poses.push_back(pose);
-      ++nPoses;
-    }
-    else
-    {
-      // image have not valid pose, so set an undefined pose
-      image.poseID = NO_ID;
-      // just copy the image
-      //stlplus::file_copy(srcImage, image.name);
-    }
-    scene.images.emplace_back(image);
-    ++my_progress_bar;
-  }
-
-  // Export undistorted images
   C_Progress_display my_progress_bar_images(sfm_data.views.size(),
       std::cout, "\n- UNDISTORT IMAGES -\n" );
   std::atomic<bool> bOk(true); // Use a boolean to track the status of the loop process
@@ -171,6 +95,8 @@ bool exportToOpenMVS(
         }
         catch (const std::bad_alloc& e)
         {
+          std::cerr << "Catched a memory error in the image conversion."
+            << " Please consider to use less threads ([-n|--numThreads])." << std::endl;
           bOk = false;
         }
       }
@@ -186,78 +112,184 @@ bool exportToOpenMVS(
       stlplus::file_copy(srcImage, imageName);
     }
   }
+  return bOk;
+}
 
-  if (!bOk)
-  {
-    std::cerr << "Catched a memory error in the image conversion."
-     << " Please consider to use less threads ([-n|--numThreads])." << std::endl;
-    return EXIT_FAILURE;
-  }
+/// Write the OpenMVS scene file, the vertices are streamed from the landmarks
+/// (the layout is the one of MVS::Interface::serialize for MVSI_PROJECT_VER)
+bool saveOpenMVSScene(
+  const SfM_Data & sfm_data,
+  const MVS::Interface & scene, // scene without vertices
+  const std::map<openMVG::IndexT, uint32_t> & map_view,
+  const std::string & sOutFile,
+  size_t & nVertices
+  )
+{
+  std::ofstream stream(sOutFile, std::ofstream::binary);
+  if (!stream.is_open())
+    return false;
+
+  // write header
+  const uint32_t version(MVSI_PROJECT_VER);
+  stream.write(MVSI_PROJECT_ID, 4);
+  stream.write((const char*)&version, sizeof(uint32_t));
+  const uint32_t reserved(0);
+  stream.write((const char*)&reserved, sizeof(uint32_t));
+
+  MVS::ARCHIVE::ArchiveSave serializer(stream, version);
+  serializer & scene.platforms;
+  serializer & scene.images;
 
   // define structure
-  scene.vertices.reserve(sfm_data.GetLandmarks().size());
-  for (const auto& vertex: sfm_data.GetLandmarks())
-  {
-    const Landmark & landmark = vertex.second;
-    MVS::Interface::Vertex vert;
-    MVS::Interface::Vertex::ViewArr& views = vert.views;
-    for (const auto& observation: landmark.obs)
+  // (the vertex count is known once the landmarks are written)
+  const std::streampos vertices_count_pos = stream.tellp();
+  nVertices = 0;
+  serializer & nVertices;
+  nVertices = StreamLandmarks<MVS::Interface::Vertex>(
+    sfm_data.GetLandmarks(),
+    [&](const Landmarks::value_type & vertex, MVS::Interface::Vertex & vert)
     {
-      const auto it(map_view.find(observation.first));
-      if (it != map_view.end()) {
-        MVS::Interface::Vertex::View view;
-        view.imageID = it->second;
-        view.confidence = 0;
-        views.push_back(view);
-      }
-    }
-    if (views.size() < 2)
-      continue;
-    std::sort(
-      views.begin(), views.end(),
-      [] (const MVS::Interface::Vertex::View& view0, const MVS::Interface::Vertex::View& view1)
+      const Landmark & landmark = vertex.second;
+      MVS::Interface::Vertex::ViewArr& views = vert.views;
+      views.clear();
+      for (const auto& observation: landmark.obs)
       {
-        return view0.imageID < view1.imageID;
+        const auto it(map_view.find(observation.first));
+        if (it != map_view.end()) {
+          MVS::Interface::Vertex::View view;
+          view.imageID = it->second;
+          view.confidence = 0;
+          views.push_back(view);
+        }
       }
-    );
-    vert.X = landmark.X.cast<float>();
-    scene.vertices.push_back(vert);
+      if (views.size() < 2)
+        return false;
+      std::sort(
+        views.begin(), views.end(),
+        [] (const MVS::Interface::Vertex::View& view0, const MVS::Interface::Vertex::View& view1)
+        {
+          return view0.imageID < view1.imageID;
+        }
+      );
+      vert.X = landmark.X.cast<float>();
+      return true;
+    },
+    [&](const MVS::Interface::Vertex & vert)
+    {
+      serializer & vert;
+    });
+  const std::streampos end_pos = stream.tellp();
+  stream.seekp(vertices_count_pos);
+  serializer & nVertices;
+  stream.seekp(end_pos);
+
+  serializer & scene.verticesNormal;
+  serializer & scene.verticesColor;
+  serializer & scene.lines;
+  serializer & scene.linesNormal;
+  serializer & scene.linesColor;
+  serializer & scene.transform;
+  return stream.good();
+}
+
+bool exportToOpenMVS(
+  const SfM_Data & sfm_data,
+  const std::string & sOutFile,
+  const std::string & sOutDir,
+  const int iNumThreads = 0
+  )
+{
+  // Create undistorted images directory structure
+  if (!stlplus::is_folder(sOutDir))
+  {
+    stlplus::folder_create(sOutDir);
+    if (!stlplus::is_folder(sOutDir))
+    {
+      std::cerr << "Cannot access to one of the desired output directory" << std::endl;
+      return false;
+    }
   }
 
-  // normalize camera intrinsics
-  for (size_t p=0; p<scene.platforms.size(); ++p)
+  // Export data :
+  MVS::Interface scene;
+  size_t nPoses(0);
+  const uint32_t nViews((uint32_t)sfm_data.GetViews().size());
+
+  // OpenMVG can have not contiguous index, use a map to create the required OpenMVS contiguous ID index
+  std::map<openMVG::IndexT, uint32_t> map_intrinsic, map_view;
+
+  // define a platform with all the intrinsic group
+  for (const auto& intrinsic: sfm_data.GetIntrinsics())
   {
-    MVS::Interface::Platform& platform = scene.platforms[p];
-    for (size_t c=0; c<platform.cameras.size(); ++c) {
-      MVS::Interface::Platform::Camera& camera = platform.cameras[c];
-      // find one image using this camera
-      MVS::Interface::Image* pImage(nullptr);
-      for (MVS::Interface::Image& image: scene.images)
-      {
-        if (image.platformID == p && image.cameraID == c && image.poseID != NO_ID)
-        {
-          pImage = &image;
-          break;
-        }
-      }
-      if (!pImage)
-      {
-        std::cerr << "error: no image using camera " << c << " of platform " << p << std::endl;
-        continue;
-      }
-      // read image meta-data
-      ImageHeader imageHeader;
-      ReadImageHeader(pImage->name.c_str(), &imageHeader);
-      const double fScale(1.0/std::max(imageHeader.width, imageHeader.height));
+    if (isPinhole(intrinsic.second->getType()))
+    {
+      const Pinhole_Intrinsic * cam = dynamic_cast<const Pinhole_Intrinsic*>(intrinsic.second.get());
+      if (map_intrinsic.count(intrinsic.first) == 0)
+        map_intrinsic.insert(std::make_pair(intrinsic.first, scene.platforms.size()));
+      MVS::Interface::Platform platform;
+      // add the camera
+      MVS::Interface::Platform::Camera camera;
+      camera.K = cam->K();
+      // normalize camera intrinsics
+      // (the undistorted images have the size of the intrinsic)
+      const double fScale(1.0/std::max(cam->w(), cam->h()));
       camera.K(0, 0) *= fScale;
       camera.K(1, 1) *= fScale;
       camera.K(0, 2) *= fScale;
       camera.K(1, 2) *= fScale;
+      // sub-pose
+      camera.R = Mat3::Identity();
+      camera.C = Vec3::Zero();
+      platform.cameras.push_back(camera);
+      scene.platforms.push_back(platform);
+    }
+  }
+
+  // define images & poses
+  scene.images.reserve(nViews);
+  for (const auto& view : sfm_data.GetViews())
+  {
+    map_view[view.first] = scene.images.size();
+    MVS::Interface::Image image;
+    const std::string srcImage = stlplus::create_filespec(sfm_data.s_root_path, view.second->s_Img_path);
+    image.name = stlplus::create_filespec(sOutDir, view.second->s_Img_path);
+    image.platformID = map_intrinsic.at(view.second->id_intrinsic);
+    MVS::Interface::Platform& platform = scene.platforms[image.platformID];
+    image.cameraID = 0;
+    if (!stlplus::is_file(srcImage))
+    {
+      std::cout << "Cannot read the corresponding image: " << srcImage << std::endl;
+      return false;
     }
+    if (sfm_data.IsPoseAndIntrinsicDefined(view.second.get()))
+    {
+      MVS::Interface::Platform::Pose pose;
+      image.poseID = platform.poses.size();
+      const openMVG::geometry::Pose3 poseMVG(sfm_data.GetPoseOrDie(view.second.get()));
+      pose.R = poseMVG.rotation();
+      pose.C = poseMVG.center();
+      platform.poses.push_back(pose);
+      ++nPoses;
+    }
+    else
+    {
+      // image have not valid pose, so set an undefined pose
+      image.poseID = NO_ID;
+      // just copy the image
+      //stlplus::file_copy(srcImage, image.name);
+    }
+    scene.images.emplace_back(image);
   }
 
+  // Export the undistorted images while the scene file is written
+  std::future<bool> images_exported = std::async(std::launch::async,
+    [&]{ return exportUndistortedImages(sfm_data, sOutDir, iNumThreads); });
+
   // write OpenMVS data
-  if (!MVS::ARCHIVE::SerializeSave(scene, sOutFile))
+  size_t nVertices(0);
+  const bool bSceneSaved = saveOpenMVSScene(sfm_data, scene, map_view, sOutFile, nVertices);
+
+  if (!images_exported.get() || !bSceneSaved)
     return false;
 
   std::cout
@@ -269,7 +301,7 @@ bool exportToOpenMVS(
     }
   std::cout
     << "  " << scene.images.size() << " images (" << nPoses << " calibrated)\n"
-    << "  " << scene.vertices.size() << " Landmarks\n";
+    << "  " << nVertices << " Landmarks\n";
   return true;
 }
 
@@ -10,6 +10,7 @@
 #include "openMVG/features/akaze/image_describer_akaze.hpp"
 #include "openMVG/features/descriptor.hpp"
 #include "openMVG/features/feature.hpp"
+#include "openMVG/features/regions_factory.hpp"
 #include "openMVG/matching/indMatch.hpp"
 #include "openMVG/matching/indMatch_utils.hpp"
 #include "openMVG/matching_image_collection/Matcher_Regions.hpp"
@@ -23,6 +24,7 @@
 #include "openMVG/matching_image_collection/E_ACRobust_Angular.hpp"
 #include "openMVG/matching_image_collection/Eo_Robust.hpp"
 #include "openMVG/matching_image_collection/H_ACRobust.hpp"
+#include "openMVG/matching_image_collection/KVLD_Filter.hpp"
 #include "openMVG/matching_image_collection/Pair_Builder.hpp"
 #include "openMVG/matching/pairwiseAdjacencyDisplay.hpp"
 #include "openMVG/sfm/sfm_data.hpp"
@@ -51,7 +53,8 @@ enum EGeometricModel
   ESSENTIAL_MATRIX   = 1,
   HOMOGRAPHY_MATRIX  = 2,
   ESSENTIAL_MATRIX_ANGULAR = 3,
-  ESSENTIAL_MATRIX_ORTHO = 4
+  ESSENTIAL_MATRIX_ORTHO = 4,
+  KVLD_FILTER = 5
 };
 
 enum EPairMode
@@ -61,6 +64,107 @@ enum EPairMode
   PAIR_FROM_FILE  = 2
 };
 
+/// Train a product quantizer on a sample of the descriptors of the views
+template <typename RegionsT>
+std::shared_ptr<matching::ProductQuantizer> TrainProductQuantizer
+(
+  const SfM_Data & sfm_data,
+  const std::string & sMatchesDirectory,
+  const int code_size
+)
+{
+  using T = typename RegionsT::DescriptorT::bin_type;
+  const size_t max_descriptor_count = 100000;
+  const size_t view_step = std::max<size_t>(1, sfm_data.GetViews().size() / 100);
+
+  std::vector<typename RegionsT::DescriptorT,
+    Eigen::aligned_allocator<typename RegionsT::DescriptorT>> descriptors;
+  size_t view_index = 0;
+  for (const auto & view_it : sfm_data.GetViews())
+  {
+    if (view_index++ % view_step != 0 || descriptors.size() >= max_descriptor_count)
+      continue;
+    const std::string basename = stlplus::basename_part(view_it.second->s_Img_path);
+    RegionsT regions;
+    if (regions.Load(
+          stlplus::create_filespec(sMatchesDirectory, basename, ".feat"),
+          stlplus::create_filespec(sMatchesDirectory, basename, ".desc")))
+    {
+      descriptors.insert(descriptors.end(),
+        regions.Descriptors().cbegin(), regions.Descriptors().cend());
+    }
+  }
+  descriptors.resize(std::min(descriptors.size(), max_descriptor_count));
+
+  clustering::KMeansMatrix<T> data(descriptors.size(), RegionsT::DescriptorT::static_size);
+  for (size_t i = 0; i < descriptors.size(); ++i)
+    data.row(i) = descriptors[i].transpose();
+
+  std::cout << "Training the product quantizer on " << descriptors.size() << " descriptors" << std::endl;
+  auto quantizer = std::make_shared<matching::ProductQuantizer>();
+  if (!quantizer->Train(data, code_size))
+    return nullptr;
+  return quantizer;
+}
+
+/// Create the regions type that stores the descriptors in a compact form
+/// (the descriptors are converted while the regions are loaded)
+std::unique_ptr<features::Regions> CompactRegionsType
+(
+  const std::string & sDescriptorStorage,
+  const features::Regions & regions_type,
+  const SfM_Data & sfm_data,
+  const std::string & sMatchesDirectory
+)
+{
+  using namespace openMVG::features;
+  if (sDescriptorStorage == "UCHAR" || sDescriptorStorage == "HALF")
+  {
+    if (!dynamic_cast<const AKAZE_Float_Regions *>(&regions_type))
+    {
+      std::cerr << "UCHAR and HALF storages are available for AKAZE_FLOAT regions only" << std::endl;
+      return nullptr;
+    }
+    if (sDescriptorStorage == "UCHAR")
+      return std::unique_ptr<Regions>(new AKAZE_Float_Uchar_Regions);
+    return std::unique_ptr<Regions>(new AKAZE_Float_Half_Regions);
+  }
+  if (sDescriptorStorage == "PQ8" || sDescriptorStorage == "PQ16")
+  {
+    const int code_size = (sDescriptorStorage == "PQ8") ? 8 : 16;
+    std::shared_ptr<matching::ProductQuantizer> quantizer;
+    std::unique_ptr<Regions> pq_regions_type;
+    if (dynamic_cast<const SIFT_Regions *>(&regions_type))
+    {
+      quantizer = TrainProductQuantizer<SIFT_Regions>(sfm_data, sMatchesDirectory, code_size);
+      pq_regions_type.reset(new SIFT_PQ_Regions(quantizer));
+    }
+    else if (dynamic_cast<const AKAZE_Float_Regions *>(&regions_type))
+    {
+      quantizer = TrainProductQuantizer<AKAZE_Float_Regions>(sfm_data, sMatchesDirectory, code_size);
+      pq_regions_type.reset(new AKAZE_Float_PQ_Regions(quantizer));
+    }
+    else if (dynamic_cast<const AKAZE_Liop_Regions *>(&regions_type))
+    {
+      quantizer = TrainProductQuantizer<AKAZE_Liop_Regions>(sfm_data, sMatchesDirectory, code_size);
+      pq_regions_type.reset(new AKAZE_Liop_PQ_Regions(quantizer));
+    }
+    else
+    {
+      std::cerr << "Product quantization is not available for this regions type" << std::endl;
+      return nullptr;
+    }
+    if (!quantizer)
+    {
+      std::cerr << "Cannot train the product quantizer (not enough descriptors)" << std::endl;
+      return nullptr;
+    }
+    return pq_regions_type;
+  }
+  std::cerr << "Unknown descriptor storage: " << sDescriptorStorage << std::endl;
+  return nullptr;
+}
+
 /// Compute corresponding features between a series of views:
 /// - Load view images description (regions: features & descriptors)
 /// - Compute putative local feature matches (descriptors matching)
@@ -79,8 +183,10 @@ int main(int argc, char **argv)
   std::string sNearestMatchingMethod = "AUTO";
   bool bForce = false;
   bool bGuided_matching = false;
+  bool bGMS_prefilter = false;
   int imax_iteration = 2048;
   unsigned int ui_max_cache_size = 0;
+  std::string sDescriptorStorage = "";
 
   //required
   cmd.add( make_option('i', sSfM_Data_Filename, "input_file") );
@@ -93,8 +199,10 @@ int main(int argc, char **argv)
   cmd.add( make_option('n', sNearestMatchingMethod, "nearest_matching_method") );
   cmd.add( make_option('f', bForce, "force") );
   cmd.add( make_option('m', bGuided_matching, "guided_matching") );
+  cmd.add( make_option('G', bGMS_prefilter, "gms_prefilter") );
   cmd.add( make_option('I', imax_iteration, "max_iteration") );
   cmd.add( make_option('c', ui_max_cache_size, "cache_size") );
+  cmd.add( make_option('q', sDescriptorStorage, "descriptor_storage") );
 
 
   try {
@@ -115,6 +223,7 @@ int main(int argc, char **argv)
       << "   h: homography matrix.\n"
       << "   a: essential matrix with an angular parametrization,\n"
       << "   o: orthographic essential matrix.\n"
+      << "   k: K-VLD filter (photometric & geometric consistency of the neighbor matches).\n"
       << "[-v|--video_mode_matching]\n"
       << "  (sequence matching with an overlap of X images)\n"
       << "   X: with match 0 with (1->X), ...]\n"
@@ -134,9 +243,18 @@ int main(int argc, char **argv)
       << "    BRUTEFORCEHAMMING: BruteForce Hamming matching.\n"
       << "[-m|--guided_matching]\n"
       << "  use the found model to improve the pairwise correspondences.\n"
+      << "[-G|--gms_prefilter]\n"
+      << "  discard most of the outlier putative matches with a GMS filter\n"
+      << "  (Grid-based Motion Statistics) before the robust model estimation.\n"
       << "[-c|--cache_size]\n"
       << "  Use a regions cache (only cache_size regions will be stored in memory)\n"
-      << "  If not used, all regions will be load in memory."
+      << "  If not used, all regions will be load in memory.\n"
+      << "[-q|--descriptor_storage]\n"
+      << "  Store the descriptors in memory in a compact form:\n"
+      << "    UCHAR: float descriptors stored as unsigned char (AKAZE_FLOAT),\n"
+      << "    HALF: float descriptors stored as half float (AKAZE_FLOAT),\n"
+      << "    PQ8, PQ16: product quantization codes of 8 or 16 bytes\n"
+      << "      (matched by brute force on the codes)."
       << std::endl;
 
       std::cerr << s << std::endl;
@@ -155,7 +273,9 @@ int main(int argc, char **argv)
             << "--pair_list " << sPredefinedPairList << "\n"
             << "--nearest_matching_method " << sNearestMatchingMethod << "\n"
             << "--guided_matching " << bGuided_matching << "\n"
-            << "--cache_size " << ((ui_max_cache_size == 0) ? "unlimited" : std::to_string(ui_max_cache_size)) << std::endl;
+            << "--gms_prefilter " << bGMS_prefilter << "\n"
+            << "--cache_size " << ((ui_max_cache_size == 0) ? "unlimited" : std::to_string(ui_max_cache_size)) << "\n"
+            << "--descriptor_storage " << (sDescriptorStorage.empty() ? "default" : sDescriptorStorage) << std::endl;
 
   EPairMode ePairmode = (iMatchingVideoMode == -1 ) ? PAIR_EXHAUSTIVE : PAIR_CONTIGUOUS;
 
@@ -196,6 +316,10 @@ int main(int argc, char **argv)
       eGeometricModelToCompute = ESSENTIAL_MATRIX_ORTHO;
       sGeometricMatchesFilename = "matches.o.bin";
     break;
+    case 'k': case 'K':
+      eGeometricModelToCompute = KVLD_FILTER;
+      sGeometricMatchesFilename = "matches.k.bin";
+    break;
     default:
       std::cerr << "Unknown geometric model" << std::endl;
       return EXIT_FAILURE;
@@ -231,6 +355,16 @@ int main(int argc, char **argv)
       << sImage_describer << " regions type file." << std::endl;
     return EXIT_FAILURE;
   }
+  if (!sDescriptorStorage.empty())
+  {
+    regions_type = CompactRegionsType(sDescriptorStorage, *regions_type, sfm_data, sMatchesDirectory);
+    if (!regions_type)
+      return EXIT_FAILURE;
+  }
+  // The product quantized and the half float regions can only be matched by brute force
+  const bool bBruteForceOnly =
+    dynamic_cast<const features::PQ_Regions_Base *>(regions_type.get()) != nullptr
+    || regions_type->Type_id() == typeid(Eigen::half).name();
 
   //---------------------------------------
   // a. Compute putative descriptor matches
@@ -307,7 +441,12 @@ int main(int argc, char **argv)
 
     // Allocate the right Matcher according the Matching requested method
     std::unique_ptr<Matcher> collectionMatcher;
-    if (sNearestMatchingMethod == "AUTO")
+    if (bBruteForceOnly)
+    {
+      std::cout << "Using BRUTE_FORCE_L2 matcher (compact descriptor storage)" << std::endl;
+      collectionMatcher.reset(new Matcher_Regions(fDistRatio, BRUTE_FORCE_L2));
+    }
+    else if (sNearestMatchingMethod == "AUTO")
     {
       if (regions_type->IsScalar())
       {
@@ -396,7 +535,7 @@ int main(int argc, char **argv)
     std::set<IndexT> set_ViewIds;
     std::transform(sfm_data.GetViews().begin(), sfm_data.GetViews().end(),
       std::inserter(set_ViewIds, set_ViewIds.begin()), stl::RetrieveKey());
-    graph::indexedGraph putativeGraph(set_ViewIds, getPairs(map_PutativesMatches));
+    graph::CsrGraph putativeGraph(set_ViewIds, map_PutativesMatches);
     graph::exportToGraphvizData(
       stlplus::create_filespec(sMatchesDirectory, "putative_matches"),
       putativeGraph);
@@ -413,6 +552,9 @@ int main(int argc, char **argv)
 
   if (filter_ptr)
   {
+    if (bGMS_prefilter)
+      filter_ptr->Set_GMS_prefilter(std::make_shared<GMS_PreFilter>());
+
     system::Timer timer;
     const double d_distance_ratio = 0.6;
 
@@ -479,6 +621,15 @@ int main(int argc, char **argv)
         map_GeometricMatches = filter_ptr->Get_geometric_matches();
       }
       break;
+      case KVLD_FILTER:
+      {
+        // The image scale-spaces are shared by the pairs
+        filter_ptr->Robust_model_estimation(
+          GeometricFilter_KVLD(std::make_shared<KVLD_ImageScaleCache>()),
+          map_PutativesMatches, bGuided_matching, d_distance_ratio, &progress);
+        map_GeometricMatches = filter_ptr->Get_geometric_matches();
+      }
+      break;
     }
 
     //---------------------------------------
@@ -507,7 +658,7 @@ int main(int argc, char **argv)
       std::set<IndexT> set_ViewIds;
       std::transform(sfm_data.GetViews().begin(), sfm_data.GetViews().end(),
         std::inserter(set_ViewIds, set_ViewIds.begin()), stl::RetrieveKey());
-      graph::indexedGraph putativeGraph(set_ViewIds, getPairs(map_GeometricMatches));
+      graph::CsrGraph putativeGraph(set_ViewIds, map_GeometricMatches);
       graph::exportToGraphvizData(
         stlplus::create_filespec(sMatchesDirectory, "geometric_matches"),
         putativeGraph);
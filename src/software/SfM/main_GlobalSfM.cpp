@@ -49,6 +49,8 @@ int main(int argc, char **argv)
   std::string sSfM_Data_Filename;
   std::string sMatchesDir, sMatchFilename;
   std::string sOutDir = "";
+  std::string sInitialPoses_SfM_Data_Filename;
+  std::string sRelativePoseCache_Filename;
   int iRotationAveragingMethod = int (ROTATION_AVERAGING_L2);
   int iTranslationAveragingMethod = int (TRANSLATION_AVERAGING_SOFTL1);
   std::string sIntrinsic_refinement_options = "ADJUST_ALL";
@@ -62,6 +64,8 @@ int main(int argc, char **argv)
   cmd.add( make_option('t', iTranslationAveragingMethod, "translationAveraging") );
   cmd.add( make_option('f', sIntrinsic_refinement_options, "refineIntrinsics") );
   cmd.add( make_switch('P', "prior_usage") );
+  cmd.add( make_option('I', sInitialPoses_SfM_Data_Filename, "initial_poses") );
+  cmd.add( make_option('R', sRelativePoseCache_Filename, "relative_pose_cache") );
 
   try {
     if (argc == 1) throw std::string("Invalid parameter.");
@@ -94,6 +98,11 @@ int main(int argc, char **argv)
       <<      "\t\t-> refine the principal point position & the distortion coefficient(s) (if any)\n"
     << "[-P|--prior_usage] Enable usage of motion priors (i.e GPS positions)\n"
     << "[-M|--match_file] path to the match file to use.\n"
+    << "[-I|--initial_poses] path to a previous SfM_Data reconstruction (i.e. of a subset of the views)\n"
+      << "\t used as initial solution for the rotation & translation averaging.\n"
+      << "\t (the relative motions are still estimated, use -R to reuse the ones of a previous run)\n"
+    << "[-R|--relative_pose_cache] path to a relative pose cache file (.bin)\n"
+      << "\t the relative poses found in the file are reused, the new ones are appended to it.\n"
     << std::endl;
 
     std::cerr << s << std::endl;
@@ -198,6 +207,22 @@ int main(int argc, char **argv)
   sfmEngine.SetTranslationAveragingMethod(
     ETranslationAveragingMethod(iTranslationAveragingMethod));
 
+  sfmEngine.SetRelativePoseCacheFilename(sRelativePoseCache_Filename);
+
+  // Configure the initial guess of the poses (if any)
+  if (!sInitialPoses_SfM_Data_Filename.empty())
+  {
+    SfM_Data previous_sfm_data;
+    if (!Load(previous_sfm_data, sInitialPoses_SfM_Data_Filename, ESfM_Data(VIEWS|EXTRINSICS)))
+    {
+      std::cerr << std::endl
+        << "The initial poses SfM_Data file \""<< sInitialPoses_SfM_Data_Filename << "\" cannot be read." << std::endl;
+      return EXIT_FAILURE;
+    }
+    std::cout << "Initial guess from #poses: "
+      << sfmEngine.SetInitialPoses(previous_sfm_data) << std::endl;
+  }
+
   if (sfmEngine.Process())
   {
     std::cout << std::endl << " Total Ac-Global-Sfm took (s): " << timer.elapsed() << std::endl;
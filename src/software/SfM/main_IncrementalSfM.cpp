@@ -92,6 +92,7 @@ int main(int argc, char **argv)
   cmd.add( make_option('c', i_User_camera_model, "camera_model") );
   cmd.add( make_option('f', sIntrinsic_refinement_options, "refineIntrinsics") );
   cmd.add( make_switch('P', "prior_usage") );
+  cmd.add( make_switch('d', "debug_ply_delta") );
 
   try {
     if (argc == 1) throw std::string("Invalid parameter.");
@@ -125,6 +126,7 @@ int main(int argc, char **argv)
       <<      "\t\t-> refine the principal point position & the distortion coefficient(s) (if any)\n"
     << "[-P|--prior_usage] Enable usage of motion priors (i.e GPS positions) (default: false)\n"
     << "[-M|--match_file] path to the match file to use.\n"
+    << "[-d|--debug_ply_delta] Write only the new poses and landmarks in the per resection group PLY files (default: false)\n"
     << std::endl;
 
     std::cerr << s << std::endl;
@@ -216,6 +218,7 @@ int main(int argc, char **argv)
   sfmEngine.SetUnknownCameraType(EINTRINSIC(i_User_camera_model));
   b_use_motion_priors = cmd.used('P');
   sfmEngine.Set_Use_Motion_Prior(b_use_motion_priors);
+  sfmEngine.SetDeltaDebugSnapshots(cmd.used('d'));
 
   // Handle Initial pair parameter
   if (!initialPairString.first.empty() && !initialPairString.second.empty())
@@ -73,6 +73,7 @@ int main(int argc, char **argv)
   std::string sOutDir = "";
   std::string sIntrinsic_refinement_options = "ADJUST_ALL";
   std::string sSfMInitializer_method = "STELLAR";
+  std::string sRelativePoseCache_Filename;
   int i_User_camera_model = PINHOLE_CAMERA_RADIAL3;
   bool b_use_motion_priors = false;
 
@@ -84,6 +85,7 @@ int main(int argc, char **argv)
   cmd.add( make_option('f', sIntrinsic_refinement_options, "refineIntrinsics") );
   cmd.add( make_option('S', sSfMInitializer_method, "sfm_initializer") );
   cmd.add( make_switch('P', "prior_usage") );
+  cmd.add( make_option('R', sRelativePoseCache_Filename, "relative_pose_cache") );
 
   try {
     if (argc == 1) throw std::string("Invalid parameter.");
@@ -120,6 +122,8 @@ int main(int argc, char **argv)
       <<      "\t\t-> refine the principal point position & the distortion coefficient(s) (if any)\n"
     << "[-P|--prior_usage] Enable usage of motion priors (i.e GPS positions) (default: false)\n"
     << "[-M|--match_file] path to the match file to use.\n"
+    << "[-R|--relative_pose_cache] path to a relative pose cache file (.bin)\n"
+      << "\t the relative poses found in the file are reused, the new ones are appended to it.\n"
     << std::endl;
 
     std::cerr << s << std::endl;
@@ -225,7 +229,8 @@ int main(int argc, char **argv)
     case ESfMSceneInitializer::INITIALIZE_STELLAR:
       scene_initializer.reset(new SfMSceneInitializerStellar(sfm_data,
         feats_provider.get(),
-        matches_provider.get()));
+        matches_provider.get(),
+        sRelativePoseCache_Filename));
     break;
     default:
       return EXIT_FAILURE;
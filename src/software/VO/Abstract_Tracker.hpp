@@ -26,7 +26,8 @@ struct Abstract_Tracker
     std::vector<bool> & status
   ) = 0;
 
-  // suggest new feature point for tracking (count point are kept)
+  // suggest new feature point for tracking (at most count point are kept)
+  // return false if no point can be suggested
   virtual bool detect
   (
     const image::Image<unsigned char> & ima,
@@ -10,6 +10,7 @@
 #define MONOCULAR_VO_HPP
 
 #include <deque>
+#include <future>
 #include <set>
 #include <numeric>
 
@@ -103,7 +104,16 @@ struct VO_Monocular
     const size_t frameId
   )
   {
+    // Detect the candidate new points while the points are tracked: the count
+    // of points to add is not known yet, so the largest count is asked and the
+    // detection is truncated once the tracking is done (the detectors return
+    // as many points as they can find, up to the asked count).
+    std::vector<features::PointFeature> new_pt;
+    std::future<bool> detection = std::async(std::launch::async,
+      [&]{ return tracker_->detect(ima, new_pt, maxTrackedFeatures_); });
+
     const bool bTrackerStatus = tracker_->track(ima, pt_to_track_, pt_tracked_, tracking_status_);
+    const bool bDetectionStatus = detection.get();
     std::cout << (int) bTrackerStatus  << " : tracker status" << std::endl;
     landmarkListPerFrame_.emplace_back(std::set<uint32_t>());
     if (landmarkListPerFrame_.size()==1 || bTrackerStatus)
@@ -178,13 +188,15 @@ struct VO_Monocular
 
         // add some new feature
         const size_t count = maxTrackedFeatures_ - countTracked;
-        std::vector<features::PointFeature> new_pt;
-        new_pt.reserve(maxTrackedFeatures_);
-        if (tracker_->detect(ima, new_pt, count))
+        // the detected points are either shuffled or sorted by decreasing corner
+        // response (GFTT), so the first ones are kept
+        if (new_pt.size() > count)
+          new_pt.resize(count);
+        if (bDetectionStatus)
         {
           std::cout << "#features added: " << new_pt.size() << std::endl;
           size_t j = 0;
-          for (size_t i = 0; i < tracking_status_.size(); ++i)
+          for (size_t i = 0; i < tracking_status_.size() && j < new_pt.size(); ++i)
           {
             if (!tracking_status_[i])
             {
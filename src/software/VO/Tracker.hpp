@@ -45,7 +45,10 @@ struct Tracker_fast_dipole : public Abstract_Tracker
 
       //-- Compute descriptors for the previous tracked point and perform matching
       std::vector<float> prev_descriptors(20*pt_to_track.size());
-      for (size_t i=0; i < pt_to_track.size(); ++i)
+      #ifdef OPENMVG_USE_OPENMP
+      #pragma omp parallel for
+      #endif
+      for (int i=0; i < (int)pt_to_track.size(); ++i)
       {
         features::PickASDipole(_prev_img, _prevPts[i].x(), _prevPts[i].y(), 10.5f, 0.0f, &prev_descriptors[i*20]);
       }
@@ -54,7 +57,10 @@ struct Tracker_fast_dipole : public Abstract_Tracker
       features::FastCornerDetector fastCornerDetector(9, 5);
       fastCornerDetector.detect(ima, current_feats);
       std::vector<float> current_descriptors(20*current_feats.size());
-      for (size_t i=0; i < current_feats.size(); ++i)
+      #ifdef OPENMVG_USE_OPENMP
+      #pragma omp parallel for
+      #endif
+      for (int i=0; i < (int)current_feats.size(); ++i)
       {
         features::PickASDipole(ima, current_feats[i].x(), current_feats[i].y(), 10.5f, 0.0f, &current_descriptors[i*20]);
       }
@@ -103,7 +109,7 @@ struct Tracker_fast_dipole : public Abstract_Tracker
     return (tracked_point_count != 0);
   }
 
-  // suggest new feature point for tracking (count point are kept)
+  // suggest new feature point for tracking (at most count point are kept)
   bool detect
   (
     const image::Image<unsigned char> & ima,
@@ -114,24 +120,21 @@ struct Tracker_fast_dipole : public Abstract_Tracker
     std::mt19937 gen(std::mt19937::default_seed);
     const std::vector<unsigned char> scores = {30, 20, 10, 5};
     // use a sequence of scores 'in order to deal with lighting change'
+    // (the points of the lowest score are kept if none gives enough points)
     features::PointFeatures feats;
     for (const unsigned char fast_score : scores)
     {
       features::FastCornerDetector fastCornerDetector(9, fast_score);
       fastCornerDetector.detect(ima, feats);
-
       if (feats.size() > count)
-      {
-        // shuffle to avoid to sample only in one bucket
-        std::shuffle(feats.begin(), feats.end(), gen);
-        feats.resize(count); // cut the array to keep only a given count of features
-        pt_to_track.swap(feats);
-
-        return true;
-      }
-      feats.clear();
+        break;
     }
-    return false; // Cannot compute a sufficient number of points for the given image
+    // shuffle to avoid to sample only in one bucket
+    std::shuffle(feats.begin(), feats.end(), gen);
+    if (feats.size() > count)
+      feats.resize(count); // cut the array to keep only a given count of features
+    pt_to_track.swap(feats);
+    return !pt_to_track.empty(); // Cannot compute any point for the given image
   }
 };
 
@@ -0,0 +1,364 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef TRACKER_KLT_VO_HPP
+#define TRACKER_KLT_VO_HPP
+
+#include <openMVG/features/fast/fast_detector.hpp>
+#include <openMVG/features/feature.hpp>
+#include <openMVG/features/feature_container.hpp>
+#include <openMVG/image/image_container.hpp>
+#include <openMVG/image/sample.hpp>
+#include <openMVG/numeric/eigen_alias_definition.hpp>
+
+#include <software/VO/Abstract_Tracker.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace openMVG  {
+namespace VO  {
+
+// Implement tracking by a pyramidal KLT (Lucas-Kanade) tracker:
+//  - Each tracked point is tracked thanks to the alignment of a translated patch
+//     between the previous and the current image, from the coarsest pyramid level
+//     to the finest one.
+//  - The points are processed in batch: the template patches and their gradients
+//     (computed with the Scharr operator) are stored per level as contiguous
+//     arrays, one block per point (structure of arrays).
+//  - All the samples of a translated patch share the same bilinear weights, so a
+//     patch warp is a 2x2 filter evaluated with vectorized row operations
+//     (the generic Sampler2d is used for the patches crossing the image border).
+struct Tracker_KLT : public Abstract_Tracker
+{
+  explicit Tracker_KLT
+  (
+    const int half_window_size = 7,
+    const int max_pyramid_levels = 4,
+    const int max_iterations = 20,
+    const float max_residual = 20.f
+  )
+  : half_window_size_(half_window_size),
+    window_size_(2 * half_window_size + 1),
+    max_pyramid_levels_(max_pyramid_levels),
+    max_iterations_(max_iterations),
+    max_residual_(max_residual)
+  {
+  }
+
+  /// Try to track current point set in the provided image
+  /// return false when tracking failed (=> to send frame to relocalization)
+  bool track
+  (
+    const image::Image<unsigned char> & ima,
+    const std::vector<features::PointFeature> & pt_to_track,
+    std::vector<features::PointFeature> & pt_tracked,
+    std::vector<bool> & status
+  ) override
+  {
+    BuildPyramid(ima, max_pyramid_levels_, window_size_, pyramid_);
+
+    if (!pt_to_track.empty() && !prev_pyramid_.empty())
+    {
+      const int nb_points = static_cast<int>(pt_to_track.size());
+      pt_tracked.resize(nb_points);
+      status.resize(nb_points);
+
+      const int nb_levels = static_cast<int>(std::min(pyramid_.size(), prev_pyramid_.size()));
+      const int area = window_size_ * window_size_;
+      templates_.resize(nb_points * area);
+      gradients_x_.resize(nb_points * area);
+      gradients_y_.resize(nb_points * area);
+      inv_hessians_xx_.resize(nb_points);
+      inv_hessians_xy_.resize(nb_points);
+      inv_hessians_yy_.resize(nb_points);
+      residuals_.resize(nb_points);
+
+      std::vector<Vec2f> flows(nb_points, Vec2f::Zero());
+      std::vector<unsigned char> valid(nb_points, 1), textured(nb_points);
+      for (int level = nb_levels - 1; level >= 0; --level)
+      {
+        const float scale = 1.f / (1 << level);
+        const image::Image<float> & prev_ima = prev_pyramid_[level];
+        const image::Image<float> & ima_level = pyramid_[level];
+
+        // Batch 1: template patches, gradients & inverse hessians
+        #ifdef OPENMVG_USE_OPENMP
+        #pragma omp parallel for schedule(dynamic, 64)
+        #endif
+        for (int i = 0; i < nb_points; ++i)
+        {
+          if (!valid[i])
+            continue;
+          textured[i] = ComputeTemplate(prev_ima, pt_to_track[i].coords() * scale, i);
+        }
+
+        // Batch 2: Gauss-Newton alignment of the patches
+        #ifdef OPENMVG_USE_OPENMP
+        #pragma omp parallel for schedule(dynamic, 64)
+        #endif
+        for (int i = 0; i < nb_points; ++i)
+        {
+          if (!valid[i])
+            continue;
+          if (!textured[i])
+          {
+            // Not enough texture to track the point at this level
+            if (level == 0)
+              valid[i] = false;
+            continue;
+          }
+          valid[i] = Align(ima_level, pt_to_track[i].coords() * scale, i, flows[i]);
+        }
+
+        if (level > 0)
+        {
+          for (auto & flow : flows)
+            flow *= 2.f;
+        }
+      }
+
+      for (int i = 0; i < nb_points; ++i)
+      {
+        const Vec2f pos = pt_to_track[i].coords() + flows[i];
+        status[i] = valid[i] && residuals_[i] < max_residual_ &&
+          pos.x() >= 0.f && pos.y() >= 0.f &&
+          pos.x() <= ima.Width() - 1.f && pos.y() <= ima.Height() - 1.f;
+        if (status[i])
+          pt_tracked[i].coords() = pos;
+      }
+    }
+    // swap frame for the next tracking iteration
+    prev_pyramid_.swap(pyramid_);
+
+    const size_t tracked_point_count = std::accumulate(status.begin(), status.end(), 0);
+    return (tracked_point_count != 0);
+  }
+
+  // suggest new feature point for tracking (at most count point are kept)
+  bool detect
+  (
+    const image::Image<unsigned char> & ima,
+    std::vector<features::PointFeature> & pt_to_track,
+    const size_t count
+  ) const override
+  {
+    std::mt19937 gen(std::mt19937::default_seed);
+    const std::vector<unsigned char> scores = {30, 20, 10, 5};
+    // the points too close to the border cannot be tracked
+    const float margin = half_window_size_ + 1.f;
+    // use a sequence of scores 'in order to deal with lighting change'
+    // (the points of the lowest score are kept if none gives enough points)
+    features::PointFeatures feats;
+    for (const unsigned char fast_score : scores)
+    {
+      features::FastCornerDetector fastCornerDetector(9, fast_score);
+      fastCornerDetector.detect(ima, feats);
+      feats.erase(std::remove_if(feats.begin(), feats.end(),
+        [&](const features::PointFeature & feat)
+        {
+          return feat.x() < margin || feat.y() < margin ||
+            feat.x() > ima.Width() - 1 - margin || feat.y() > ima.Height() - 1 - margin;
+        }), feats.end());
+      if (feats.size() > count)
+        break;
+    }
+    // shuffle to avoid to sample only in one bucket
+    std::shuffle(feats.begin(), feats.end(), gen);
+    if (feats.size() > count)
+      feats.resize(count); // cut the array to keep only a given count of features
+    pt_to_track.swap(feats);
+    return !pt_to_track.empty(); // Cannot compute any point for the given image
+  }
+
+private:
+
+  using Pyramid = std::vector<image::Image<float>>;
+
+  /// Build an image pyramid (2x2 box filter), a level is added while it is
+  ///  large enough to contain some windows (the level buffers are reused)
+  static void BuildPyramid
+  (
+    const image::Image<unsigned char> & ima,
+    const int max_levels,
+    const int window_size,
+    Pyramid & pyramid
+  )
+  {
+    int nb_levels = 1;
+    while (nb_levels < max_levels &&
+      std::min(ima.Width() >> nb_levels, ima.Height() >> nb_levels) >= 4 * window_size)
+    {
+      ++nb_levels;
+    }
+    pyramid.resize(nb_levels);
+    pyramid[0] = ima.GetMat().cast<float>();
+    for (int level = 1; level < nb_levels; ++level)
+    {
+      const image::Image<float> & src = pyramid[level - 1];
+      image::Image<float> & dst = pyramid[level];
+      dst.resize(src.Width() / 2, src.Height() / 2, false);
+      #ifdef OPENMVG_USE_OPENMP
+      #pragma omp parallel for
+      #endif
+      for (int y = 0; y < dst.Height(); ++y)
+      {
+        const float * row0 = &src(2 * y, 0);
+        const float * row1 = &src(2 * y + 1, 0);
+        float * out = &dst(y, 0);
+        for (int x = 0; x < dst.Width(); ++x)
+        {
+          out[x] = .25f * (row0[2 * x] + row0[2 * x + 1] + row1[2 * x] + row1[2 * x + 1]);
+        }
+      }
+    }
+  }
+
+  /// Bilinear sampling of a size x size patch whose top left sample is (x, y)
+  static void SamplePatch
+  (
+    const image::Image<float> & ima,
+    const float x,
+    const float y,
+    const int size,
+    float * patch
+  )
+  {
+    const int ix = static_cast<int>(std::floor(x));
+    const int iy = static_cast<int>(std::floor(y));
+    if (ix < 0 || iy < 0 || ix + size >= ima.Width() || iy + size >= ima.Height())
+    {
+      // The patch is crossing the image border
+      const image::Sampler2d<image::SamplerLinear> sampler;
+      for (int r = 0; r < size; ++r)
+        for (int c = 0; c < size; ++c)
+          patch[r * size + c] = sampler(ima, y + r, x + c);
+      return;
+    }
+    // Same sub-pixel offset for every sample of the patch
+    const float ax = x - ix, ay = y - iy;
+    const float
+      w00 = (1.f - ax) * (1.f - ay), w01 = ax * (1.f - ay),
+      w10 = (1.f - ax) * ay,         w11 = ax * ay;
+    using ConstRow = Eigen::Map<const Eigen::ArrayXf>;
+    for (int r = 0; r < size; ++r)
+    {
+      const ConstRow row0(&ima(iy + r, ix), size + 1);
+      const ConstRow row1(&ima(iy + r + 1, ix), size + 1);
+      Eigen::Map<Eigen::ArrayXf>(patch + r * size, size) =
+        w00 * row0.head(size) + w01 * row0.tail(size) +
+        w10 * row1.head(size) + w11 * row1.tail(size);
+    }
+  }
+
+  /// Sample the template of a point and its gradients, return false if the
+  ///  patch is not textured enough to be tracked
+  bool ComputeTemplate
+  (
+    const image::Image<float> & prev_ima,
+    const Vec2f & pos,
+    const int i
+  )
+  {
+    // sample a one pixel larger patch to compute the gradients
+    const int size = window_size_ + 2;
+    image::Image<float>::Base patch(size, size);
+    SamplePatch(prev_ima, pos.x() - half_window_size_ - 1, pos.y() - half_window_size_ - 1, size, patch.data());
+
+    const int area = window_size_ * window_size_;
+    Eigen::Map<image::Image<float>::Base> templ(&templates_[i * area], window_size_, window_size_);
+    Eigen::Map<image::Image<float>::Base> gx(&gradients_x_[i * area], window_size_, window_size_);
+    Eigen::Map<image::Image<float>::Base> gy(&gradients_y_[i * area], window_size_, window_size_);
+    templ = patch.block(1, 1, window_size_, window_size_);
+    // normalized Scharr derivatives (as ImageScharrX/YDerivative) of the window
+    const int w = window_size_;
+    gx = (3.f * (patch.block(0, 2, w, w) - patch.block(0, 0, w, w)) +
+          10.f * (patch.block(1, 2, w, w) - patch.block(1, 0, w, w)) +
+          3.f * (patch.block(2, 2, w, w) - patch.block(2, 0, w, w))) / 32.f;
+    gy = (3.f * (patch.block(2, 0, w, w) - patch.block(0, 0, w, w)) +
+          10.f * (patch.block(2, 1, w, w) - patch.block(0, 1, w, w)) +
+          3.f * (patch.block(2, 2, w, w) - patch.block(0, 2, w, w))) / 32.f;
+
+    const float hxx = gx.cwiseAbs2().sum();
+    const float hxy = gx.cwiseProduct(gy).sum();
+    const float hyy = gy.cwiseAbs2().sum();
+    // smallest eigen value of the (normalized) structure tensor
+    const float trace = (hxx + hyy) / 2.f;
+    const float min_eigen_value =
+      (trace - std::sqrt(trace * trace - (hxx * hyy - hxy * hxy))) / area;
+    if (!(min_eigen_value > 1e-2f))
+      return false;
+
+    const float inv_det = 1.f / (hxx * hyy - hxy * hxy);
+    inv_hessians_xx_[i] = hyy * inv_det;
+    inv_hessians_xy_[i] = -hxy * inv_det;
+    inv_hessians_yy_[i] = hxx * inv_det;
+    return true;
+  }
+
+  /// Align the template of a point to the image (update the flow),
+  ///  return false if the alignment is lost
+  bool Align
+  (
+    const image::Image<float> & ima,
+    const Vec2f & pos,
+    const int i,
+    Vec2f & flow
+  )
+  {
+    const int area = window_size_ * window_size_;
+    const Eigen::Map<const Eigen::ArrayXf> templ(&templates_[i * area], area);
+    const Eigen::Map<const Eigen::ArrayXf> gx(&gradients_x_[i * area], area);
+    const Eigen::Map<const Eigen::ArrayXf> gy(&gradients_y_[i * area], area);
+    Eigen::ArrayXf warped(area);
+    for (int iter = 0; iter < max_iterations_; ++iter)
+    {
+      const Vec2f corner = pos + flow - Vec2f::Constant(half_window_size_);
+      if (corner.x() < -half_window_size_ || corner.y() < -half_window_size_ ||
+          corner.x() > ima.Width() - half_window_size_ ||
+          corner.y() > ima.Height() - half_window_size_)
+      {
+        return false;
+      }
+      SamplePatch(ima, corner.x(), corner.y(), window_size_, warped.data());
+      const float bx = ((warped - templ) * gx).sum();
+      const float by = ((warped - templ) * gy).sum();
+      const Vec2f delta(
+        inv_hessians_xx_[i] * bx + inv_hessians_xy_[i] * by,
+        inv_hessians_xy_[i] * bx + inv_hessians_yy_[i] * by);
+      flow -= delta;
+      if (delta.squaredNorm() < 1e-4f)
+        break;
+    }
+    residuals_[i] = (warped - templ).abs().mean();
+    return true;
+  }
+
+  const int half_window_size_;
+  const int window_size_;
+  const int max_pyramid_levels_;
+  const int max_iterations_;
+  const float max_residual_;
+
+  // data for tracking
+  Pyramid prev_pyramid_, pyramid_;
+
+  // per point data (a window_size_^2 block per point for the patches)
+  std::vector<float> templates_, gradients_x_, gradients_y_;
+  std::vector<float> inv_hessians_xx_, inv_hessians_xy_, inv_hessians_yy_;
+  std::vector<float> residuals_;
+};
+
+} // namespace VO
+} // namespace openMVG
+
+
+#endif // TRACKER_KLT_VO_HPP
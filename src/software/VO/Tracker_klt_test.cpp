@@ -0,0 +1,149 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "software/VO/Monocular_VO.hpp"
+#include "software/VO/Tracker_klt.hpp"
+
+#include "testing/testing.h"
+
+#include <random>
+#include <vector>
+
+using namespace openMVG;
+using namespace openMVG::features;
+using namespace openMVG::VO;
+
+// Motion of the camera between two frames (pixels)
+static const Vec2f kShift(2.f, 1.f);
+
+// Synthetic sequence: a window sliding over a random block texture
+// (the scene moves by -kShift between two frames)
+struct SyntheticSequence
+{
+  const int width = 320, height = 240;
+  image::Image<unsigned char> texture;
+
+  SyntheticSequence()
+  {
+    std::mt19937 gen(std::mt19937::default_seed);
+    std::uniform_int_distribution<int> distrib(0, 255);
+    const int block_size = 6;
+    image::Image<unsigned char> blocks(width + 100, height + 100);
+    for (int y = 0; y < blocks.Height(); y += block_size)
+      for (int x = 0; x < blocks.Width(); x += block_size)
+      {
+        const unsigned char value = distrib(gen);
+        for (int j = y; j < std::min(y + block_size, blocks.Height()); ++j)
+          for (int i = x; i < std::min(x + block_size, blocks.Width()); ++i)
+            blocks(j, i) = value;
+      }
+    // 3x3 box filter (smoother gradients)
+    texture = blocks;
+    for (int y = 1; y < blocks.Height() - 1; ++y)
+      for (int x = 1; x < blocks.Width() - 1; ++x)
+      {
+        int sum = 0;
+        for (int j = -1; j <= 1; ++j)
+          for (int i = -1; i <= 1; ++i)
+            sum += blocks(y + j, x + i);
+        texture(y, x) = sum / 9;
+      }
+  }
+
+  image::Image<unsigned char> Frame(const int frame_id) const
+  {
+    return image::Image<unsigned char>(texture.GetMat().block(
+      static_cast<int>(kShift.y()) * frame_id + 1,
+      static_cast<int>(kShift.x()) * frame_id + 1, height, width));
+  }
+};
+
+TEST(Tracker_KLT, Track) {
+  const SyntheticSequence sequence;
+  Tracker_KLT tracker;
+
+  PointFeatures pt_to_track, pt_tracked;
+  std::vector<bool> status;
+  EXPECT_TRUE(tracker.detect(sequence.Frame(0), pt_to_track, 200));
+  EXPECT_EQ(200, pt_to_track.size());
+  // No previous frame
+  EXPECT_FALSE(tracker.track(sequence.Frame(0), pt_to_track, pt_tracked, status));
+
+  EXPECT_TRUE(tracker.track(sequence.Frame(1), pt_to_track, pt_tracked, status));
+  EXPECT_EQ(pt_to_track.size(), status.size());
+  size_t tracked_count = 0;
+  for (size_t i = 0; i < status.size(); ++i)
+  {
+    if (!status[i])
+      continue;
+    ++tracked_count;
+    EXPECT_NEAR(0., (pt_tracked[i].coords() - (pt_to_track[i].coords() - kShift)).norm(), 0.1);
+  }
+  EXPECT_TRUE(tracked_count > 0.9 * pt_to_track.size());
+}
+
+TEST(Tracker_KLT, Detect) {
+  const SyntheticSequence sequence;
+  const Tracker_KLT tracker;
+
+  // At most count points
+  PointFeatures points;
+  EXPECT_TRUE(tracker.detect(sequence.Frame(0), points, 10));
+  EXPECT_EQ(10, points.size());
+
+  // Fewer points are returned if not enough can be found
+  EXPECT_TRUE(tracker.detect(sequence.Frame(0), points, 1000000));
+  EXPECT_TRUE(points.size() > 10 && points.size() < 1000000);
+
+  // No point on an uniform image
+  EXPECT_FALSE(tracker.detect(image::Image<unsigned char>(64, 64, true, 128), points, 10));
+  EXPECT_TRUE(points.empty());
+}
+
+TEST(VO_Monocular, SyntheticSequence) {
+  const SyntheticSequence sequence;
+  Tracker_KLT tracker;
+  const uint32_t max_tracked_features = 150;
+  VO_Monocular monocular_vo(&tracker, max_tracked_features);
+
+  const int frame_count = 8;
+  for (int frame_id = 0; frame_id < frame_count; ++frame_id)
+  {
+    const bool tracked = monocular_vo.nextFrame(sequence.Frame(frame_id), frame_id);
+    EXPECT_EQ(frame_id > 0, tracked);
+    // The lost points are replaced (the detection is reused)
+    EXPECT_EQ(max_tracked_features, monocular_vo.landmarkListPerFrame_.back().size());
+  }
+  EXPECT_EQ(frame_count, monocular_vo.landmarkListPerFrame_.size());
+
+  // Most of the landmarks are tracked along the whole sequence
+  size_t long_track_count = 0, motion_count = 0, accurate_motion_count = 0;
+  for (const Landmark & landmark : monocular_vo.landmark_)
+  {
+    long_track_count += (landmark.obs_.size() == frame_count);
+    // The observations follow the motion of the scene
+    // (the accuracy is checked away from the border the points are leaving by)
+    for (size_t i = 1; i < landmark.obs_.size(); ++i)
+    {
+      const Measurement & a = landmark.obs_[i - 1], & b = landmark.obs_[i];
+      EXPECT_EQ(a.frameId_ + 1, b.frameId_);
+      if (b.pos_.x() < 16.f || b.pos_.y() < 16.f)
+        continue;
+      const float error = (b.pos_ - (a.pos_ - kShift)).norm();
+      EXPECT_TRUE(error < 1.f);
+      ++motion_count;
+      accurate_motion_count += (error < 0.1f);
+    }
+  }
+  EXPECT_TRUE(long_track_count > max_tracked_features / 2);
+  EXPECT_TRUE(accurate_motion_count > 0.95 * motion_count);
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
@@ -12,17 +12,20 @@
 #include "software/VO/CGlWindow.hpp"
 #include "software/VO/Monocular_VO.hpp"
 #include "software/VO/Tracker.hpp"
+#include "software/VO/Tracker_klt.hpp"
 #if defined HAVE_OPENCV
 #include "software/VO/Tracker_opencv_klt.hpp"
 #endif
 
 #include "openMVG/sfm/sfm_data.hpp"
 #include "openMVG/sfm/sfm_data_io.hpp"
+#include "openMVG/system/timer.hpp"
 
 #include "third_party/cmdLine/cmdLine.h"
 #include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
 
 #include <cstdlib>
+#include <future>
 #include <iostream>
 
 using namespace openMVG;
@@ -44,6 +47,7 @@ int main(int argc, char **argv)
   cmd.add( make_option('o', sOutFile, "output_file") );
   cmd.add( make_option('p', uTrackerPointCount, "point_count") );
   cmd.add( make_switch('d', "disable_tracking_display") );
+  cmd.add( make_switch('b', "benchmark") );
 
   try {
     if (argc == 1) throw std::string("Invalid command line parameter.");
@@ -57,8 +61,10 @@ int main(int argc, char **argv)
 #if defined HAVE_OPENCV
     << "\t 1: Feature tracking based tracking; Fast + KLT pyramidal tracking. \n"
 #endif
+    << "\t 2: Feature tracking based tracking; Fast + pyramidal KLT tracking (OpenMVG implementation). \n"
     << "[-p|--point_count] Number of points to track. (default: " << uTrackerPointCount << ")\n"
     << "[-d|--disable_tracking_display] Disable tracking display \n"
+    << "[-b|--benchmark] Headless mode: no display, report the processing frame rate \n"
     << std::endl;
 
     std::cerr << s << std::endl;
@@ -71,7 +77,8 @@ int main(int argc, char **argv)
             << "--output_file " << sOutFile << std::endl
             << "--point_count " << uTrackerPointCount << std::endl
             << "--tracker " << uTracker << std::endl
-            << "--disable_tracking_display " << static_cast<int>(cmd.used('d')) << std::endl;
+            << "--disable_tracking_display " << static_cast<int>(cmd.used('d')) << std::endl
+            << "--benchmark " << static_cast<int>(cmd.used('b')) << std::endl;
 
   if (sImaDirectory.empty() || !stlplus::is_folder(sImaDirectory))
   {
@@ -85,7 +92,8 @@ int main(int argc, char **argv)
     return EXIT_FAILURE;
   }
 
-  if ( !glfwInit() )
+  const bool benchmark = cmd.used('b');
+  if ( !benchmark && !glfwInit() )
   {
     return EXIT_FAILURE;
   }
@@ -136,6 +144,9 @@ int main(int argc, char **argv)
       tracker_ptr.reset(new Tracker_opencv_KLT);
     break;
 #endif
+    case 2:
+      tracker_ptr.reset(new Tracker_KLT);
+    break;
     default:
     std::cerr << "Unknow tracking method" << std::endl;
     return EXIT_FAILURE;
@@ -149,12 +160,41 @@ int main(int argc, char **argv)
   // Initialize the monocular tracking framework
   VO_Monocular monocular_vo(tracker_ptr.get(), uTrackerPointCount);
 
+  // The next frame is read while the current one is processed
+  const auto read_frame = [&](const size_t id)
+  {
+    image::Image<unsigned char> ima;
+    const std::string sImageFilename = stlplus::create_filespec( sImaDirectory, vec_image[id] );
+    const bool bRead = openMVG::image::ReadImage( sImageFilename.c_str(), &ima);
+    return std::make_pair(bRead, std::move(ima));
+  };
+  std::future<std::pair<bool, image::Image<unsigned char>>> next_frame;
+  if (!vec_image.empty())
+    next_frame = std::async(std::launch::async, read_frame, 0);
+
+  openMVG::system::Timer timer;
+  double processing_time = 0.0;
+  size_t processed_frame_count = 0;
+
   size_t frameId = 0;
   for (std::vector<std::string>::const_iterator iterFile = vec_image.begin();
     iterFile != vec_image.end(); ++iterFile, ++frameId)
   {
-    const std::string sImageFilename = stlplus::create_filespec( sImaDirectory, *iterFile );
-    if (openMVG::image::ReadImage( sImageFilename.c_str(), &currentImage))
+    std::pair<bool, image::Image<unsigned char>> frame = next_frame.get();
+    if (frameId + 1 < vec_image.size())
+      next_frame = std::async(std::launch::async, read_frame, frameId + 1);
+    if (!frame.first)
+      continue;
+    currentImage = std::move(frame.second);
+
+    if (benchmark)
+    {
+      timer.reset();
+      monocular_vo.nextFrame(currentImage, frameId);
+      processing_time += timer.elapsed();
+      ++processed_frame_count;
+    }
+    else
     {
       if (window._height < 0)
       {
@@ -263,12 +303,20 @@ int main(int argc, char **argv)
     }
   }
 
+  if (benchmark && processed_frame_count > 0)
+  {
+    std::cout << "\n#processed frames: " << processed_frame_count << "\n"
+      << "Processing time (s): " << processing_time << "\n"
+      << "Frame rate (fps): " << processed_frame_count / processing_time << std::endl;
+  }
+
   openMVG::sfm::SfM_Data sfm_data;
   ConvertVOLandmarkToSfMDataLandmark(monocular_vo.landmark_, sfm_data.structure);
   std::cout << "Found SFM #landmarks: " << sfm_data.structure.size() << std::endl;
   if (!Save(sfm_data, sOutFile, openMVG::sfm::ESfM_Data(openMVG::sfm::ALL)))
     return EXIT_FAILURE;
 
-  glfwTerminate();
+  if (!benchmark)
+    glfwTerminate();
   return 0;
 }
@@ -9,6 +9,7 @@
 #include "colorHarmonizeEngineGlobal.hpp"
 #include "software/SfM/SfMIOHelper.hpp"
 
+#include "openMVG/image/image_cache.hpp"
 #include "openMVG/image/image_io.hpp"
 //-- Feature matches
 #include <openMVG/matching/indMatch.hpp>
@@ -36,7 +37,10 @@
 #include <numeric>
 #include <iomanip>
 #include <iterator>
+#include <limits>
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <functional>
 #include <sstream>
 
@@ -52,6 +56,43 @@ using namespace openMVG::sfm;
 using FeatureT = features::SIOPointFeature;
 using featsT = std::vector< FeatureT >;
 
+/// Histograms of the RED, GREEN and BLUE channels
+using ChannelHistograms = std::array<std::vector<size_t>, 3>;
+
+/// Compute the channel histograms of the (masked) pixels of an image in a
+///  single pass (same 256 bins as Histogram<double>(0, 255, 256)).
+static void ComputeHistograms(
+  const Image< RGBColor > & image,
+  const Image< unsigned char > * mask,
+  ChannelHistograms & histograms)
+{
+  const size_t bin = 256;
+  const double bin_by_interval = bin / 255.0;
+  std::array<size_t, 256> bin_of;
+  for (size_t value = 0; value < 256; ++value)
+    bin_of[value] = static_cast<size_t>(value * bin_by_interval);
+
+  for (auto & histogram : histograms)
+    histogram.assign(bin + 1, 0); // (+1: overflow bin)
+
+  const int height = mask ? mask->Height() : image.Height();
+  const int width = mask ? mask->Width() : image.Width();
+  for (int j = 0; j < height; ++j)
+  {
+    for (int i = 0; i < width; ++i)
+    {
+      if (mask && (*mask)( j, i ) == 0)
+        continue;
+      const RGBColor & color = image( j, i );
+      ++histograms[0][bin_of[color.r()]];
+      ++histograms[1][bin_of[color.g()]];
+      ++histograms[2][bin_of[color.b()]];
+    }
+  }
+  for (auto & histogram : histograms)
+    histogram.resize(bin);
+}
+
 ColorHarmonizationEngineGlobal::ColorHarmonizationEngineGlobal(
   const std::string & sSfM_Data_Filename,
   const std::string & sMatchesPath,
@@ -195,133 +236,196 @@ bool ColorHarmonizationEngineGlobal::Process()
   std::cout << "\n Remaining cameras after CC filter : \n"
     << map_cameraIndexTocameraNode.size() << " from a total of " << _vec_fileNames.size() << std::endl;
 
-  size_t bin      = 256;
-  double minvalue = 0.0;
-  double maxvalue = 255.0;
+  // An image is shared by all its incident edges, so keep the decoded images
+  //  in memory to decode each of them once: an image is released after its
+  //  last use (no budget, else the images could be released before).
+  image::ImageCache image_cache(std::numeric_limits<std::size_t>::max());
 
-  // For each edge computes the selection masks and histograms (for the RGB channels)
-  std::vector<relativeColorHistogramEdge> map_relativeHistograms[3];
-  map_relativeHistograms[0].resize(_map_Matches.size());
-  map_relativeHistograms[1].resize(_map_Matches.size());
-  map_relativeHistograms[2].resize(_map_Matches.size());
+  enum EHistogramSelectionMethod
+  {
+      eHistogramHarmonizeFullFrame     = 0,
+      eHistogramHarmonizeMatchedPoints = 1,
+      eHistogramHarmonizeVLDSegment    = 2,
+  };
+  if (_selectionMethod < eHistogramHarmonizeFullFrame ||
+      _selectionMethod > eHistogramHarmonizeVLDSegment)
+  {
+    std::cout << "Selection method unsupported" << std::endl;
+    return false;
+  }
 
-  for (size_t i = 0; i < _map_Matches.size(); ++i)
+  // With the full frame selection the histograms only depend on the image:
+  //  compute them once per image.
+  std::map<size_t, ChannelHistograms> map_imageHistograms;
+  if (_selectionMethod == eHistogramHarmonizeFullFrame)
   {
-    matching::PairWiseMatches::const_iterator iter = _map_Matches.begin();
-    std::advance(iter, i);
+    const std::vector<size_t> vec_indexImage(set_indeximage.begin(), set_indeximage.end());
+    for (const size_t imaNum : vec_indexImage)
+      map_imageHistograms[imaNum];
+
+    std::atomic<bool> bOk(true); // (written by the worker threads)
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (int i = 0; i < static_cast<int>(vec_indexImage.size()); ++i)
+    {
+      const size_t imaNum = vec_indexImage[i];
+      const std::shared_ptr<const Image< RGBColor >> image =
+        image_cache.Get<RGBColor>( _vec_fileNames[ imaNum ] );
+      if (!image)
+      {
+        bOk = false;
+        continue;
+      }
+      ComputeHistograms( *image, nullptr, map_imageHistograms.at(imaNum) );
+      image_cache.Erase( _vec_fileNames[ imaNum ] );
+    }
+    if (!bOk)
+    {
+      std::cerr << "Cannot read the images." << std::endl;
+      return false;
+    }
+  }
+
+  // For each edge computes the selection masks and histograms (for the RGB channels).
+  // Only the histogram quantiles are kept (the data used by the gain/offset solver).
+  std::vector<relativeColorQuantileEdge> map_relativeQuantiles[3];
+  map_relativeQuantiles[0].resize(_map_Matches.size());
+  map_relativeQuantiles[1].resize(_map_Matches.size());
+  map_relativeQuantiles[2].resize(_map_Matches.size());
+
+  std::vector<matching::PairWiseMatches::const_iterator> vec_edges;
+  vec_edges.reserve(_map_Matches.size());
+  for (auto iter = _map_Matches.begin(); iter != _map_Matches.end(); ++iter)
+    vec_edges.push_back(iter);
+
+  // Number of edges that still have to use each image
+  std::vector<std::atomic<int>> vec_remainingUses(_vec_fileNames.size());
+  for (auto & remaining_uses : vec_remainingUses)
+    remaining_uses = 0;
+  for (const auto & iter : vec_edges)
+  {
+    ++vec_remainingUses[iter->first.first];
+    ++vec_remainingUses[iter->first.second];
+  }
+
+  C_Progress_display my_progress_bar_edges( vec_edges.size(),
+    std::cout, "\n- Compute the edges histograms -\n" );
+  std::atomic<bool> bOk(true);
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for schedule(dynamic)
+#endif
+  for (int i = 0; i < static_cast<int>(vec_edges.size()); ++i)
+  {
+    const matching::PairWiseMatches::const_iterator iter = vec_edges[i];
 
     const size_t I = iter->first.first;
     const size_t J = iter->first.second;
 
-    const std::vector<IndMatch> & vec_matchesInd = iter->second;
+    // Histograms of the edge, per channel (thread local)
+    ChannelHistograms histoI, histoJ;
+    if (_selectionMethod == eHistogramHarmonizeFullFrame)
+    {
+      histoI = map_imageHistograms.at(I);
+      histoJ = map_imageHistograms.at(J);
+    }
+    else
+    {
+      const std::vector<IndMatch> & vec_matchesInd = iter->second;
 
-    //-- Edges names:
-    std::pair<std::string, std::string> p_imaNames;
-    p_imaNames = make_pair( _vec_fileNames[ I ], _vec_fileNames[ J ] );
-    std::cout << "Current edge : "
-      << stlplus::filename_part(p_imaNames.first) << "\t"
-      << stlplus::filename_part(p_imaNames.second) << std::endl;
+      //-- Edges names:
+      std::pair<std::string, std::string> p_imaNames;
+      p_imaNames = make_pair( _vec_fileNames[ I ], _vec_fileNames[ J ] );
 
-    //-- Compute the masks from the data selection:
-    Image< unsigned char > maskI ( _vec_imageSize[ I ].first, _vec_imageSize[ I ].second );
-    Image< unsigned char > maskJ ( _vec_imageSize[ J ].first, _vec_imageSize[ J ].second );
+      //-- Compute the masks from the data selection:
+      Image< unsigned char > maskI ( _vec_imageSize[ I ].first, _vec_imageSize[ I ].second );
+      Image< unsigned char > maskJ ( _vec_imageSize[ J ].first, _vec_imageSize[ J ].second );
 
-    switch (_selectionMethod)
-    {
-      enum EHistogramSelectionMethod
+      switch (_selectionMethod)
       {
-          eHistogramHarmonizeFullFrame     = 0,
-          eHistogramHarmonizeMatchedPoints = 1,
-          eHistogramHarmonizeVLDSegment    = 2,
-      };
+        case eHistogramHarmonizeMatchedPoints:
+        {
+          int circleSize = 10;
+          color_harmonization::commonDataByPair_MatchedPoints dataSelector(
+            p_imaNames.first,
+            p_imaNames.second,
+            vec_matchesInd,
+            _map_feats.at( I ),
+            _map_feats.at( J ),
+            circleSize);
+          dataSelector.computeMask( maskI, maskJ );
+        }
+        break;
+        case eHistogramHarmonizeVLDSegment:
+        {
+          color_harmonization::commonDataByPair_VLDSegment dataSelector(
+            p_imaNames.first,
+            p_imaNames.second,
+            vec_matchesInd,
+            _map_feats.at( I ),
+            _map_feats.at( J ),
+            &image_cache);
+
+          dataSelector.computeMask( maskI, maskJ );
+        }
+        break;
+      }
 
-      case eHistogramHarmonizeFullFrame:
+      //-- Export the masks
+      bool bExportMask = false;
+      if (bExportMask)
       {
-        color_harmonization::commonDataByPair_FullFrame  dataSelector(
-          p_imaNames.first,
-          p_imaNames.second);
-        dataSelector.computeMask( maskI, maskJ );
+        std::string sEdge = _vec_fileNames[ I ] + "_" + _vec_fileNames[ J ];
+        sEdge = stlplus::create_filespec( _sOutDirectory, sEdge );
+        if ( !stlplus::folder_exists( sEdge ) )
+          stlplus::folder_create( sEdge );
+
+        std::string out_filename_I = "00_mask_I.png";
+        out_filename_I = stlplus::create_filespec( sEdge, out_filename_I );
+
+        std::string out_filename_J = "00_mask_J.png";
+        out_filename_J = stlplus::create_filespec( sEdge, out_filename_J );
+
+        WriteImage( out_filename_I.c_str(), maskI );
+        WriteImage( out_filename_J.c_str(), maskJ );
       }
-      break;
-      case eHistogramHarmonizeMatchedPoints:
+
+      //-- Compute the histograms
+      const std::shared_ptr<const Image< RGBColor >>
+        imageI = image_cache.Get<RGBColor>( p_imaNames.first ),
+        imageJ = image_cache.Get<RGBColor>( p_imaNames.second );
+      if ( !imageI || !imageJ )
       {
-        int circleSize = 10;
-        color_harmonization::commonDataByPair_MatchedPoints dataSelector(
-          p_imaNames.first,
-          p_imaNames.second,
-          vec_matchesInd,
-          _map_feats[ I ],
-          _map_feats[ J ],
-          circleSize);
-        dataSelector.computeMask( maskI, maskJ );
+        bOk = false;
+        continue;
       }
-      break;
-      case eHistogramHarmonizeVLDSegment:
+      ComputeHistograms( *imageI, &maskI, histoI );
+      ComputeHistograms( *imageJ, &maskJ, histoJ );
+
+      // Release the images after their last use
+      for (const size_t imaNum : {I, J})
       {
-        color_harmonization::commonDataByPair_VLDSegment dataSelector(
-          p_imaNames.first,
-          p_imaNames.second,
-          vec_matchesInd,
-          _map_feats[ I ],
-          _map_feats[ J ]);
-
-        dataSelector.computeMask( maskI, maskJ );
+        if (--vec_remainingUses[imaNum] == 0)
+          image_cache.Erase( _vec_fileNames[ imaNum ] );
       }
-      break;
-      default:
-        std::cout << "Selection method unsupported" << std::endl;
-        return false;
     }
 
-    //-- Export the masks
-    bool bExportMask = false;
-    if (bExportMask)
+    // Reduce the histograms to their quantiles (RED, GREEN and BLUE channels)
+    for (int channelIndex = 0; channelIndex < 3; ++channelIndex)
     {
-      std::string sEdge = _vec_fileNames[ I ] + "_" + _vec_fileNames[ J ];
-      sEdge = stlplus::create_filespec( _sOutDirectory, sEdge );
-      if ( !stlplus::folder_exists( sEdge ) )
-        stlplus::folder_create( sEdge );
-
-      std::string out_filename_I = "00_mask_I.png";
-      out_filename_I = stlplus::create_filespec( sEdge, out_filename_I );
-
-      std::string out_filename_J = "00_mask_J.png";
-      out_filename_J = stlplus::create_filespec( sEdge, out_filename_J );
-
-      WriteImage( out_filename_I.c_str(), maskI );
-      WriteImage( out_filename_J.c_str(), maskJ );
+      map_relativeQuantiles[channelIndex][i] = relativeColorQuantileEdge(
+        map_cameraNodeToCameraIndex.at(I), map_cameraNodeToCameraIndex.at(J),
+        histoI[channelIndex], histoJ[channelIndex]);
     }
-
-    //-- Compute the histograms
-    Image< RGBColor > imageI, imageJ;
-    ReadImage( p_imaNames.first.c_str(), &imageI );
-    ReadImage( p_imaNames.second.c_str(), &imageJ );
-
-    Histogram< double > histoI( minvalue, maxvalue, bin);
-    Histogram< double > histoJ( minvalue, maxvalue, bin);
-
-    int channelIndex = 0; // RED channel
-    color_harmonization::commonDataByPair::computeHisto( histoI, maskI, channelIndex, imageI );
-    color_harmonization::commonDataByPair::computeHisto( histoJ, maskJ, channelIndex, imageJ );
-    relativeColorHistogramEdge & edgeR = map_relativeHistograms[channelIndex][i];
-    edgeR = relativeColorHistogramEdge(map_cameraNodeToCameraIndex[I], map_cameraNodeToCameraIndex[J],
-      histoI.GetHist(), histoJ.GetHist());
-
-    histoI = histoJ = Histogram< double >( minvalue, maxvalue, bin);
-    channelIndex = 1; // GREEN channel
-    color_harmonization::commonDataByPair::computeHisto( histoI, maskI, channelIndex, imageI );
-    color_harmonization::commonDataByPair::computeHisto( histoJ, maskJ, channelIndex, imageJ );
-    relativeColorHistogramEdge & edgeG = map_relativeHistograms[channelIndex][i];
-    edgeG = relativeColorHistogramEdge(map_cameraNodeToCameraIndex[I], map_cameraNodeToCameraIndex[J],
-      histoI.GetHist(), histoJ.GetHist());
-
-    histoI = histoJ = Histogram< double >( minvalue, maxvalue, bin);
-    channelIndex = 2; // BLUE channel
-    color_harmonization::commonDataByPair::computeHisto( histoI, maskI, channelIndex, imageI );
-    color_harmonization::commonDataByPair::computeHisto( histoJ, maskJ, channelIndex, imageJ );
-    relativeColorHistogramEdge & edgeB = map_relativeHistograms[channelIndex][i];
-    edgeB = relativeColorHistogramEdge(map_cameraNodeToCameraIndex[I], map_cameraNodeToCameraIndex[J],
-      histoI.GetHist(), histoJ.GetHist());
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp critical
+#endif
+    ++my_progress_bar_edges;
+  }
+  if (!bOk)
+  {
+    std::cerr << "Cannot read the images of the edges." << std::endl;
+    return false;
   }
 
   std::cout << "\n -- \n SOLVE for color consistency with linear programming\n --" << std::endl;
@@ -341,7 +445,7 @@ bool ColorHarmonizationEngineGlobal::Process()
   {
     OSI_CLP_SolverWrapper lpSolver(vec_solution_r.size());
 
-    ConstraintBuilder_GainOffset cstBuilder(map_relativeHistograms[0], vec_indexToFix);
+    ConstraintBuilder_GainOffset cstBuilder(std::move(map_relativeQuantiles[0]), vec_indexToFix);
     LP_Constraints_Sparse constraint;
     cstBuilder.Build(constraint);
     lpSolver.setup(constraint);
@@ -352,7 +456,7 @@ bool ColorHarmonizationEngineGlobal::Process()
   {
     OSI_CLP_SolverWrapper lpSolver(vec_solution_g.size());
 
-    ConstraintBuilder_GainOffset cstBuilder(map_relativeHistograms[1], vec_indexToFix);
+    ConstraintBuilder_GainOffset cstBuilder(std::move(map_relativeQuantiles[1]), vec_indexToFix);
     LP_Constraints_Sparse constraint;
     cstBuilder.Build(constraint);
     lpSolver.setup(constraint);
@@ -363,7 +467,7 @@ bool ColorHarmonizationEngineGlobal::Process()
   {
     OSI_CLP_SolverWrapper lpSolver(vec_solution_b.size());
 
-    ConstraintBuilder_GainOffset cstBuilder(map_relativeHistograms[2], vec_indexToFix);
+    ConstraintBuilder_GainOffset cstBuilder(std::move(map_relativeQuantiles[2]), vec_indexToFix);
     LP_Constraints_Sparse constraint;
     cstBuilder.Build(constraint);
     lpSolver.setup(constraint);
@@ -417,7 +521,14 @@ bool ColorHarmonizationEngineGlobal::Process()
     }
 
     Image< RGBColor > image_c;
-    ReadImage( _vec_fileNames[ imaNum ].c_str(), &image_c );
+    {
+      const std::shared_ptr<const Image< RGBColor >> image_ptr =
+        image_cache.Get<RGBColor>( _vec_fileNames[ imaNum ] );
+      if ( image_ptr )
+        image_c = *image_ptr;
+      // The image is not used anymore
+      image_cache.Erase( _vec_fileNames[ imaNum ] );
+    }
 
 #ifdef OPENMVG_USE_OPENMP
 #pragma omp parallel for
@@ -0,0 +1,119 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2018 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "software/colorHarmonize/colorHarmonizeEngineGlobal.hpp"
+
+#include "openMVG/image/image_io.hpp"
+#include "openMVG/matching/indMatch_utils.hpp"
+#include "openMVG/sfm/sfm_data.hpp"
+#include "openMVG/sfm/sfm_data_io.hpp"
+
+#include "testing/testing.h"
+#include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
+
+#include <string>
+
+using namespace openMVG;
+using namespace openMVG::features;
+using namespace openMVG::image;
+using namespace openMVG::matching;
+using namespace openMVG::sfm;
+
+// A color harmonization scene: 4 images sharing 150 matched features
+// (all the pairs are connected).
+// The image of the view <missing_view> is not written on disk.
+struct HarmonizationScene
+{
+  const int width = 64, height = 48;
+  const IndexT view_count = 4;
+  std::string root, sfm_data_file, matches_file, out_dir;
+
+  explicit HarmonizationScene(const IndexT missing_view = UndefinedIndexT)
+  {
+    root = stlplus::create_filespec(stlplus::folder_current(), "colorHarmonize_test");
+    stlplus::folder_delete(root, true);
+    stlplus::folder_create(root);
+    sfm_data_file = stlplus::create_filespec(root, "sfm_data.json");
+    matches_file = stlplus::create_filespec(root, "matches.f.bin");
+    out_dir = stlplus::create_filespec(root, "out");
+
+    // Features on a grid (same positions in all the images)
+    std::vector<SIOPointFeature> features;
+    for (int i = 0; i < 150; ++i)
+      features.emplace_back(4.f + 4 * (i % 15), 4.f + 4 * (i / 15), 1.f, 0.f);
+    std::vector<IndMatch> matches;
+    for (IndexT i = 0; i < features.size(); ++i)
+      matches.emplace_back(i, i);
+
+    SfM_Data sfm_data;
+    sfm_data.s_root_path = root;
+    PairWiseMatches pairwise_matches;
+    for (IndexT i = 0; i < view_count; ++i)
+    {
+      const std::string image_name = "image_" + std::to_string(i) + ".png";
+      sfm_data.views[i] = std::make_shared<View>(image_name, i, 0, i, width, height);
+      saveFeatsToFile(
+        stlplus::create_filespec(root, "image_" + std::to_string(i), ".feat"), features);
+      for (IndexT j = i + 1; j < view_count; ++j)
+        pairwise_matches[{i, j}] = matches;
+
+      // Same content, different gains
+      if (i != missing_view)
+      {
+        Image<RGBColor> image(width, height);
+        for (int y = 0; y < height; ++y)
+          for (int x = 0; x < width; ++x)
+          {
+            const int value = (x * 3 + y * 2) / static_cast<int>(i + 1);
+            image(y, x) = RGBColor(value, value / 2, 255 - value);
+          }
+        WriteImage(stlplus::create_filespec(root, image_name).c_str(), image);
+      }
+    }
+    Save(sfm_data, sfm_data_file, ESfM_Data(VIEWS));
+    Save(pairwise_matches, matches_file);
+  }
+
+  ~HarmonizationScene()
+  {
+    stlplus::folder_delete(root, true);
+  }
+
+  bool Process(const int selection_method) const
+  {
+    ColorHarmonizationEngineGlobal engine(
+      sfm_data_file, root, matches_file, out_dir, selection_method, 0);
+    return engine.Process();
+  }
+};
+
+TEST(ColorHarmonizationEngineGlobal, FullFrame) {
+  const HarmonizationScene scene;
+  EXPECT_TRUE(scene.Process(0));
+}
+
+TEST(ColorHarmonizationEngineGlobal, MatchedPoints) {
+  const HarmonizationScene scene;
+  EXPECT_TRUE(scene.Process(1));
+}
+
+// A missing image is reported by the image loop (full frame histograms)
+TEST(ColorHarmonizationEngineGlobal, FullFrame_MissingImage) {
+  const HarmonizationScene scene(2);
+  EXPECT_FALSE(scene.Process(0));
+}
+
+// A missing image is reported by the edge loop (masked histograms)
+TEST(ColorHarmonizationEngineGlobal, MatchedPoints_MissingImage) {
+  const HarmonizationScene scene(2);
+  EXPECT_FALSE(scene.Process(1));
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */